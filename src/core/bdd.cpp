@@ -0,0 +1,498 @@
+/// @file
+/// Implementation of the BDD package and the PDAG conversion.
+
+#include "core/bdd.h"
+
+#include <cassert>
+
+#include <algorithm>
+#include <numeric>
+#include <span>
+#include <utility>
+
+namespace canopy::core {
+
+namespace {
+
+/// The initial number of buckets in the unique and computed tables.
+constexpr std::size_t kInitialTableSize = 1 << 12;
+
+/// The invalid edge for unfilled results.
+constexpr Bdd::Edge kNoEdge = std::numeric_limits<Bdd::Edge>::max();
+
+/// The max growth of the diagrams while a variable is sifted in one direction.
+constexpr double kMaxSiftGrowth = 1.2;
+
+/// The max number of the sifted variables with the most vertices.
+constexpr int kMaxSiftedVariables = 1000;
+
+}  // namespace
+
+Bdd::Bdd(const Pdag& graph, std::vector<int> order, std::size_t reorder_threshold)
+    : vertices_{{kTerminalLevel, kOne, kOne}},
+      unique_table_(kInitialTableSize, 0),
+      computed_table_(kInitialTableSize),
+      variables_(std::move(order)) {
+   if (variables_.empty()) {
+       variables_.resize(graph.num_variables());
+       std::iota(variables_.begin(), variables_.end(), 0);
+   }
+   assert(static_cast<int>(variables_.size()) == graph.num_variables() &&
+          "Incomplete variable order.");
+   levels_.resize(variables_.size());
+   for (int level = 0; level < static_cast<int>(variables_.size()); ++level)
+       levels_[variables_[level]] = level;
+
+   // Only the nodes reachable from the roots are converted.
+   std::vector<bool> reachable = graph.Reachable();
+
+   // The ascending node order guarantees converted args.
+   std::vector<Edge> edges(graph.size(), kNoEdge);
+   auto get_edge = [&edges](Pdag::Index index) {
+       assert(edges[std::abs(index)] != kNoEdge);
+       return edges[std::abs(index)] ^ (index < 0);
+   };
+   std::vector<Edge> args;
+   std::unordered_map<std::uint32_t, Edge> memo;
+   for (Pdag::Index index = 1; index < static_cast<Pdag::Index>(graph.size()); ++index) {
+       if (!reachable[index])
+           continue;
+       const Pdag::Node& node = graph.node(index);
+       switch (node.kind) {
+       case Pdag::NodeKind::kConstant:
+           edges[index] = kOne;
+           break;
+       case Pdag::NodeKind::kVariable:
+           edges[index] = Variable(node.first);
+           break;
+       case Pdag::NodeKind::kGate: {
+           args.clear();
+           for (Pdag::Index arg : graph.args(index))
+               args.push_back(get_edge(arg));
+           // Combining the args bottom-up keeps intermediate results small.
+           std::sort(args.begin(), args.end(), [this](Edge lhs, Edge rhs) {
+               return vertex(lhs).level > vertex(rhs).level;
+           });
+           Edge result = args.front();
+           switch (node.connective) {
+           case Connective::kAnd:
+               for (auto it = std::next(args.begin()); it != args.end(); ++it)
+                   result = And(result, *it);
+               break;
+           case Connective::kOr:
+               for (auto it = std::next(args.begin()); it != args.end(); ++it)
+                   result = Or(result, *it);
+               break;
+           case Connective::kXor:
+               assert(args.size() == 2);
+               result = Xor(args.front(), args.back());
+               break;
+           case Connective::kAtleast:
+               memo.clear();
+               result = Vote(args, node.min_number, &memo);
+               break;
+           default:
+               assert(false && "Unexpected connective in the PDAG.");
+           }
+           edges[index] = result;
+           if (reorder_threshold && vertices_.size() > reorder_threshold) {
+               Sift(edges);
+               reorder_threshold = std::max(reorder_threshold, 2 * vertices_.size());
+           }
+           break;
+       }
+       }
+   }
+   for (Pdag::Index root : graph.roots())
+       roots_.push_back(get_edge(root));
+}
+
+Bdd::Edge Bdd::Vote(std::span<const Edge> args, int min_number,
+                    std::unordered_map<std::uint32_t, Edge>* memo) {
+   if (min_number <= 0)
+       return kOne;
+   if (min_number > static_cast<int>(args.size()))
+       return kZero;
+   std::uint32_t key = (args.size() << 16) | min_number;
+   if (auto it = memo->find(key); it != memo->end())
+       return it->second;
+   // The Shannon decomposition on the first arg.
+   Edge result = Ite(args.front(), Vote(args.subspan(1), min_number - 1, memo),
+                     Vote(args.subspan(1), min_number, memo));
+   memo->emplace(key, result);
+   return result;
+}
+
+Bdd::Edge Bdd::Ite(Edge f, Edge g, Edge h) {
+   // The standard triples reduce to terminal cases or simpler forms.
+   if (f == kOne)
+       return g;
+   if (f == kZero)
+       return h;
+   if (g == f)
+       g = kOne;
+   else if (g == (f ^ 1))
+       g = kZero;
+   if (h == f)
+       h = kZero;
+   else if (h == (f ^ 1))
+       h = kOne;
+   if (g == h)
+       return g;
+   if (g == kOne && h == kZero)
+       return f;
+   if (g == kZero && h == kOne)
+       return f ^ 1;
+
+   // Normalization to regular f and g for better cache hits.
+   if (IsComplement(f)) {
+       f ^= 1;
+       std::swap(g, h);
+   }
+   Edge complement = g & 1;
+   g ^= complement;
+   h ^= complement;
+
+   std::size_t slot = Hash(f, g, h) & (computed_table_.size() - 1);
+   Computation& entry = computed_table_[slot];
+   if (entry.f == f && entry.g == g && entry.h == h)
+       return entry.result ^ complement;
+
+   int top = std::min({vertex(f).level, vertex(g).level, vertex(h).level});
+   Edge high = Ite(Cofactor(f, top, true), Cofactor(g, top, true), Cofactor(h, top, true));
+   Edge low = Ite(Cofactor(f, top, false), Cofactor(g, top, false), Cofactor(h, top, false));
+   Edge result = MakeVertex(top, high, low);
+   // The recursion may have grown and invalidated the table.
+   computed_table_[Hash(f, g, h) & (computed_table_.size() - 1)] = {f, g, h, result};
+   return result ^ complement;
+}
+
+Bdd::Edge Bdd::MakeVertex(int level, Edge high, Edge low) {
+   if (high == low)
+       return high;
+   Edge complement = high & 1;
+   high ^= complement;
+   low ^= complement;
+
+   std::size_t mask = unique_table_.size() - 1;
+   for (std::size_t slot = Hash(level, high, low) & mask;; slot = (slot + 1) & mask) {
+       std::uint32_t index = unique_table_[slot];
+       if (!index) {
+           index = vertices_.size();
+           vertices_.push_back({level, high, low});
+           unique_table_[slot] = index;
+           if (2 * vertices_.size() > unique_table_.size())
+               GrowUniqueTable();
+           return (index << 1) | complement;
+       }
+       const Vertex& record = vertices_[index];
+       if (record.level == level && record.high == high && record.low == low)
+           return (index << 1) | complement;
+   }
+}
+
+void Bdd::GrowUniqueTable() {
+   unique_table_.assign(2 * unique_table_.size(), 0);
+   std::size_t mask = unique_table_.size() - 1;
+   for (std::uint32_t index = 1; index < vertices_.size(); ++index) {
+       const Vertex& record = vertices_[index];
+       std::size_t slot = Hash(record.level, record.high, record.low) & mask;
+       while (unique_table_[slot])
+           slot = (slot + 1) & mask;
+       unique_table_[slot] = index;
+   }
+   // The computed table follows the size of the diagrams.
+   computed_table_.assign(unique_table_.size(), Computation());
+}
+
+void Bdd::Sift(std::span<Edge> edges) {
+   ++num_reorderings_;
+   Reordering reordering;
+   reordering.levels.resize(variables_.size());
+   reordering.references.assign(vertices_.size(), 0);
+   std::vector<std::uint32_t> stack;
+   auto reference = [&reordering, &stack](Edge edge) {
+       if (!IsTerminal(edge) && reordering.references[index(edge)]++ == 0)
+           stack.push_back(index(edge));
+   };
+   for (Edge edge : edges) {
+       if (edge != kNoEdge)
+           reference(edge);
+   }
+   while (!stack.empty()) {
+       std::uint32_t current = stack.back();
+       stack.pop_back();
+       const Vertex& record = vertices_[current];
+       reordering.levels[record.level].emplace(Key(record.high, record.low), current);
+       ++reordering.size;
+       reference(record.high);
+       reference(record.low);
+   }
+   for (std::uint32_t current = vertices_.size() - 1; current > 0; --current) {
+       if (!reordering.references[current])
+           reordering.free.push_back(current);
+   }
+
+   // The variables with more vertices are sifted first.
+   std::vector<int> variables = variables_;
+   std::stable_sort(variables.begin(), variables.end(), [&](int lhs, int rhs) {
+       return reordering.levels[levels_[lhs]].size() > reordering.levels[levels_[rhs]].size();
+   });
+   if (variables.size() > kMaxSiftedVariables)
+       variables.resize(kMaxSiftedVariables);
+   int num_levels = variables_.size();
+   for (int variable : variables) {
+       int level = levels_[variable];
+       int best_level = level;
+       std::size_t best_size = reordering.size;
+       auto update = [&] {
+           if (reordering.size < best_size) {
+               best_size = reordering.size;
+               best_level = level;
+           }
+       };
+       while (level + 1 < num_levels && reordering.size <= kMaxSiftGrowth * best_size) {
+           SwapLevels(level++, &reordering);
+           update();
+       }
+       while (level > 0 && reordering.size <= kMaxSiftGrowth * best_size) {
+           SwapLevels(--level, &reordering);
+           update();
+       }
+       while (level < best_level)
+           SwapLevels(level++, &reordering);
+       while (level > best_level)
+           SwapLevels(--level, &reordering);
+   }
+   Compact(reordering, edges);
+}
+
+void Bdd::SwapLevels(int level, Reordering* reordering) {
+   int next = level + 1;
+   // The vertices depending on both variables are rewritten in place
+   // from the cofactors taken before any changes.
+   struct Rewrite {
+       std::uint32_t vertex;
+       Edge high_high, high_low, low_high, low_low;
+   };
+   std::vector<Rewrite> rewrites;
+   std::vector<std::uint32_t> moved;  // The vertices independent of the next variable.
+   for (const auto& entry : reordering->levels[level]) {
+       const Vertex& record = vertices_[entry.second];
+       if (vertex(record.high).level != next && vertex(record.low).level != next) {
+           moved.push_back(entry.second);
+           continue;
+       }
+       rewrites.push_back({entry.second, Cofactor(record.high, next, true),
+                           Cofactor(record.high, next, false), Cofactor(record.low, next, true),
+                           Cofactor(record.low, next, false)});
+   }
+   auto& upper = reordering->levels[level];
+   auto& lower = reordering->levels[next];
+   upper.clear();
+   std::swap(upper, lower);
+   for (const auto& entry : upper)
+       vertices_[entry.second].level = level;
+   for (std::uint32_t current : moved) {
+       Vertex& record = vertices_[current];
+       record.level = next;
+       lower.emplace(Key(record.high, record.low), current);
+   }
+   for (const Rewrite& rewrite : rewrites) {
+       Edge high = AddVertex(next, rewrite.high_high, rewrite.low_high, reordering);
+       Edge low = AddVertex(next, rewrite.high_low, rewrite.low_low, reordering);
+       Vertex& record = vertices_[rewrite.vertex];
+       Edge old_high = record.high;
+       Edge old_low = record.low;
+       record = {level, high, low};  // The high edge stays regular.
+       upper.emplace(Key(high, low), rewrite.vertex);
+       Release(old_high, reordering);
+       Release(old_low, reordering);
+   }
+   std::swap(variables_[level], variables_[next]);
+   levels_[variables_[level]] = level;
+   levels_[variables_[next]] = next;
+}
+
+Bdd::Edge Bdd::AddVertex(int level, Edge high, Edge low, Reordering* reordering) {
+   auto reference = [reordering](Edge edge) {
+       if (!IsTerminal(edge))
+           ++reordering->references[index(edge)];
+   };
+   if (high == low) {
+       reference(high);
+       return high;
+   }
+   Edge complement = high & 1;
+   high ^= complement;
+   low ^= complement;
+   auto& table = reordering->levels[level];
+   if (auto it = table.find(Key(high, low)); it != table.end()) {
+       ++reordering->references[it->second];
+       return (it->second << 1) | complement;
+   }
+   std::uint32_t current = vertices_.size();
+   if (!reordering->free.empty()) {
+       current = reordering->free.back();
+       reordering->free.pop_back();
+       vertices_[current] = {level, high, low};
+       reordering->references[current] = 1;
+   } else {
+       vertices_.push_back({level, high, low});
+       reordering->references.push_back(1);
+   }
+   reference(high);
+   reference(low);
+   table.emplace(Key(high, low), current);
+   ++reordering->size;
+   return (current << 1) | complement;
+}
+
+void Bdd::Release(Edge edge, Reordering* reordering) {
+   std::vector<std::uint32_t> stack;
+   auto release = [reordering, &stack](Edge child) {
+       if (!IsTerminal(child) && --reordering->references[index(child)] == 0)
+           stack.push_back(index(child));
+   };
+   release(edge);
+   while (!stack.empty()) {
+       std::uint32_t current = stack.back();
+       stack.pop_back();
+       const Vertex& record = vertices_[current];
+       reordering->levels[record.level].erase(Key(record.high, record.low));
+       --reordering->size;
+       reordering->free.push_back(current);
+       release(record.high);
+       release(record.low);
+   }
+}
+
+void Bdd::Compact(const Reordering& reordering, std::span<Edge> edges) {
+   // Children are at lower levels than their parents.
+   std::vector<std::uint32_t> indices(vertices_.size(), 0);
+   std::vector<Vertex> vertices = {vertices_.front()};
+   vertices.reserve(reordering.size + 1);
+   auto renumber = [&indices](Edge edge) { return (indices[index(edge)] << 1) | (edge & 1); };
+   for (auto it = reordering.levels.rbegin(); it != reordering.levels.rend(); ++it) {
+       for (const auto& entry : *it) {
+           const Vertex& record = vertices_[entry.second];
+           indices[entry.second] = vertices.size();
+           vertices.push_back({record.level, renumber(record.high), renumber(record.low)});
+       }
+   }
+   vertices_ = std::move(vertices);
+   for (Edge& edge : edges) {
+       if (edge != kNoEdge)
+           edge = renumber(edge);
+   }
+
+   std::size_t table_size = kInitialTableSize;
+   while (2 * vertices_.size() > table_size)
+       table_size *= 2;
+   // The growth reinserts the vertices and resets the computed table.
+   unique_table_.assign(table_size / 2, 0);
+   GrowUniqueTable();
+}
+
+std::vector<std::uint32_t> Bdd::Collect(Edge root) const {
+   std::vector<std::uint32_t> collected;
+   if (IsTerminal(root))
+       return collected;
+   std::vector<bool> visited(vertices_.size(), false);
+   std::vector<std::uint32_t> stack = {index(root)};
+   visited[index(root)] = true;
+   while (!stack.empty()) {
+       std::uint32_t current = stack.back();
+       stack.pop_back();
+       collected.push_back(current);
+       for (Edge child : {vertices_[current].high, vertices_[current].low}) {
+           if (!IsTerminal(child) && !visited[index(child)]) {
+               visited[index(child)] = true;
+               stack.push_back(index(child));
+           }
+       }
+   }
+   std::sort(collected.begin(), collected.end());
+   return collected;
+}
+
+double Bdd::Probability(Edge root, std::span<const double> p) const {
+   std::vector<double> probabilities(vertices_.size());
+   return Probability(root, Collect(root), p, probabilities);
+}
+
+double Bdd::Probability(Edge root, std::span<const std::uint32_t> vertices,
+                        std::span<const double> p, std::span<double> probabilities) const {
+   Quantify(vertices, p, probabilities);
+   double value = probabilities[index(root)];
+   return IsComplement(root) ? 1 - value : value;
+}
+
+std::vector<double> Bdd::Probabilities(std::span<const double> p) const {
+   std::vector<bool> reachable(vertices_.size(), false);
+   for (Edge root : roots_)
+       reachable[index(root)] = true;
+   // Vertices follow their children in the index order.
+   std::vector<std::uint32_t> collected;
+   for (std::uint32_t current = vertices_.size() - 1; current > 0; --current) {
+       if (!reachable[current])
+           continue;
+       collected.push_back(current);
+       reachable[index(vertices_[current].high)] = true;
+       reachable[index(vertices_[current].low)] = true;
+   }
+   std::reverse(collected.begin(), collected.end());
+   std::vector<double> probabilities(vertices_.size());
+   Quantify(collected, p, probabilities);
+   std::vector<double> result;
+   for (Edge root : roots_) {
+       double value = probabilities[index(root)];
+       result.push_back(IsComplement(root) ? 1 - value : value);
+   }
+   return result;
+}
+
+std::vector<double> Bdd::Derivatives(Edge root, std::span<const double> p) const {
+   std::vector<double> derivatives(variables_.size(), 0);
+   std::vector<std::uint32_t> collected = Collect(root);
+   std::vector<double> probabilities(vertices_.size());
+   Quantify(collected, p, probabilities);
+   auto get = [&probabilities](Edge edge) {
+       double value = probabilities[index(edge)];
+       return IsComplement(edge) ? 1 - value : value;
+   };
+   // The sensitivity of the root probability to the vertex probabilities;
+   // the complement edges flip the sign.
+   std::vector<double> gradients(vertices_.size(), 0);
+   auto propagate = [&gradients](Edge edge, double gradient) {
+       gradients[index(edge)] += IsComplement(edge) ? -gradient : gradient;
+   };
+   propagate(root, 1);
+   for (auto it = collected.rbegin(); it != collected.rend(); ++it) {
+       double gradient = gradients[*it];
+       if (gradient == 0)
+           continue;
+       const Vertex& record = vertices_[*it];
+       int variable = variables_[record.level];
+       derivatives[variable] += gradient * (get(record.high) - get(record.low));
+       propagate(record.high, gradient * p[variable]);
+       propagate(record.low, gradient * (1 - p[variable]));
+   }
+   return derivatives;
+}
+
+void Bdd::Quantify(std::span<const std::uint32_t> vertices, std::span<const double> p,
+                   std::span<double> probabilities) const {
+   probabilities[0] = 1;
+   auto get = [&probabilities](Edge edge) {
+       double value = probabilities[index(edge)];
+       return IsComplement(edge) ? 1 - value : value;
+   };
+   for (std::uint32_t current : vertices) {
+       const Vertex& record = vertices_[current];
+       double p_var = p[variables_[record.level]];
+       probabilities[current] = p_var * get(record.high) + (1 - p_var) * get(record.low);
+   }
+}
+
+}  // namespace canopy::core
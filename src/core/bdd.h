@@ -0,0 +1,248 @@
+/// @file
+/// Reduced ordered binary decision diagrams with complement edges.
+
+#pragma once
+
+#include <cstdint>
+
+#include <limits>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "core/pdag.h"
+
+namespace canopy::core {
+
+/// Reduced ordered BDD package for exact quantification of PDAGs.
+///
+/// Edges are vertex indices with the complement flag in the low bit.
+/// The single terminal vertex is One,
+/// and Zero is the complemented edge to it.
+/// To keep the diagrams canonical, high edges are never complemented;
+/// complements are moved onto the edges into the vertices.
+///
+/// Vertices are hash-consed in an open-addressing unique table,
+/// and results of ITE operations are memoized
+/// in a direct-mapped, lossy computed table.
+/// Vertices are always created after their children,
+/// so the vertex index order is a topological order of the diagrams.
+///
+/// The variables can be reordered dynamically during the conversion
+/// with the sifting of Rudell:
+/// every variable is moved through all the levels
+/// with in-place swaps of adjacent levels
+/// and left at the level of the smallest diagrams.
+/// Only the vertices reachable from the converted nodes survive the reordering,
+/// and they are renumbered bottom-up by levels
+/// to restore the topological index order.
+class Bdd {
+ public:
+   using Edge = std::uint32_t;  ///< Vertex index and complement flag.
+
+   static constexpr Edge kOne = 0;  ///< The terminal One.
+   static constexpr Edge kZero = 1;  ///< The complement of One.
+
+   /// The level of the terminal vertex below all variables.
+   static constexpr int kTerminalLevel = std::numeric_limits<int>::max();
+
+   /// Decision vertex (if-then-else) on the variable at its level.
+   struct Vertex {
+       int level;  ///< The position of the variable in the order.
+       Edge high;  ///< The regular edge for the true variable.
+       Edge low;  ///< The possibly complemented edge for the false variable.
+   };
+
+   /// Builds the diagrams of the PDAG roots.
+   ///
+   /// @param[in] graph  The graph with the roots to convert.
+   /// @param[in] order  The variable ids in the order of BDD levels;
+   ///                   empty for the order of variables in the graph.
+   /// @param[in] reorder_threshold  The number of vertices
+   ///                               triggering the dynamic reordering,
+   ///                               doubled after every reordering;
+   ///                               0 to keep the initial order.
+   explicit Bdd(const Pdag& graph, std::vector<int> order = {},
+                std::size_t reorder_threshold = 0);
+
+   /// @returns The diagrams of the graph roots in the same order.
+   const std::vector<Edge>& roots() const { return roots_; }
+
+   /// @returns The number of vertices including the terminal.
+   std::size_t size() const { return vertices_.size(); }
+
+   /// Edge queries.
+   /// @{
+   static bool IsComplement(Edge edge) { return edge & 1; }
+   static bool IsTerminal(Edge edge) { return edge <= kZero; }
+   static std::uint32_t index(Edge edge) { return edge >> 1; }
+   const Vertex& vertex(Edge edge) const { return vertices_[index(edge)]; }
+   /// @}
+
+   /// @returns The variable id at the level.
+   int variable(int level) const { return variables_[level]; }
+
+   /// @returns The level of the variable.
+   int level(int variable) const { return levels_[variable]; }
+
+   /// @returns The variable ids in the order of levels
+   ///          after the dynamic reordering if any.
+   const std::vector<int>& order() const { return variables_; }
+
+   /// @returns The number of dynamic reorderings during the conversion.
+   int num_reorderings() const { return num_reorderings_; }
+
+   /// @returns The diagram of the variable.
+   Edge Variable(int variable) { return MakeVertex(levels_[variable], kOne, kZero); }
+
+   /// Applies the if-then-else operation (f AND g) OR (NOT f AND h).
+   Edge Ite(Edge f, Edge g, Edge h);
+
+   /// Boolean operations on diagrams.
+   /// @{
+   Edge And(Edge f, Edge g) { return Ite(f, g, kZero); }
+   Edge Or(Edge f, Edge g) { return Ite(f, kOne, g); }
+   Edge Xor(Edge f, Edge g) { return Ite(f, g ^ 1, g); }
+   /// @}
+
+   /// Collects the vertices of the diagram.
+   ///
+   /// @param[in] root  The diagram root.
+   ///
+   /// @returns The indices of the decision vertices
+   ///          in the topological (ascending) order.
+   std::vector<std::uint32_t> Collect(Edge root) const;
+
+   /// Computes the exact probability of the diagram
+   /// with the Shannon decomposition of every vertex.
+   ///
+   /// @param[in] root  The diagram root.
+   /// @param[in] p  The probabilities of the variables indexed by variable ids.
+   ///
+   /// @returns The probability of the diagram function to be true.
+   double Probability(Edge root, std::span<const double> p) const;
+
+   /// Computes the probability of the diagram with the vertices collected beforehand
+   /// for repeated quantification with different variable probabilities.
+   ///
+   /// @param[in] root  The diagram root.
+   /// @param[in] vertices  The vertices of the root from Collect.
+   /// @param[in] p  The probabilities of the variables indexed by variable ids.
+   /// @param[out] probabilities  The storage for the vertex probabilities
+   ///                            of the diagram size.
+   ///
+   /// @returns The probability of the diagram function to be true.
+   double Probability(Edge root, std::span<const std::uint32_t> vertices,
+                      std::span<const double> p, std::span<double> probabilities) const;
+
+   /// Computes the exact probabilities of all the roots
+   /// in one pass over the vertices shared by the roots.
+   ///
+   /// @param[in] p  The probabilities of the variables indexed by variable ids.
+   ///
+   /// @returns The probabilities of the roots in the same order.
+   std::vector<double> Probabilities(std::span<const double> p) const;
+
+   /// Computes the partial derivatives of the diagram probability
+   /// by the variable probabilities (the Birnbaum importance)
+   /// in a forward pass for the vertex probabilities
+   /// and a backward pass for the sensitivity of the root to every vertex.
+   ///
+   /// @param[in] root  The diagram root.
+   /// @param[in] p  The probabilities of the variables indexed by variable ids.
+   ///
+   /// @returns The derivatives indexed by variable ids.
+   std::vector<double> Derivatives(Edge root, std::span<const double> p) const;
+
+ private:
+   /// Computes the probabilities of the vertices bottom-up.
+   ///
+   /// @param[in] vertices  The decision vertices in the topological order.
+   /// @param[in] p  The probabilities of the variables indexed by variable ids.
+   /// @param[out] probabilities  The probabilities indexed by vertex indices.
+   void Quantify(std::span<const std::uint32_t> vertices, std::span<const double> p,
+                 std::span<double> probabilities) const;
+
+   /// Entry of the computed table.
+   struct Computation {
+       Edge f = std::numeric_limits<Edge>::max();  ///< Invalid for empty entries.
+       Edge g = 0;
+       Edge h = 0;
+       Edge result = 0;
+   };
+
+   /// Finds or creates the reduced vertex.
+   ///
+   /// @returns The canonical edge for the decision on the level.
+   Edge MakeVertex(int level, Edge high, Edge low);
+
+   /// @returns The cofactor of the edge for the variable level.
+   Edge Cofactor(Edge edge, int level, bool value) const {
+       const Vertex& record = vertex(edge);
+       if (record.level != level)
+           return edge;
+       return value ? record.high ^ (edge & 1) : record.low ^ (edge & 1);
+   }
+
+   /// Builds the k-out-of-n function of the args.
+   ///
+   /// @param[in] args  The diagrams of the args.
+   /// @param[in] min_number  The vote number.
+   /// @param[in,out] memo  The results keyed by the number of args and the vote number.
+   Edge Vote(std::span<const Edge> args, int min_number,
+             std::unordered_map<std::uint32_t, Edge>* memo);
+
+   /// Doubles the unique table and reinserts the vertices.
+   void GrowUniqueTable();
+
+   /// The state of the dynamic reordering.
+   struct Reordering {
+       /// The live vertices by levels keyed by their children.
+       std::vector<std::unordered_map<std::uint64_t, std::uint32_t>> levels;
+       std::vector<std::uint32_t> references;  ///< The reference counts of vertices.
+       std::vector<std::uint32_t> free;  ///< The indices of dead vertices for reuse.
+       std::size_t size = 0;  ///< The number of live vertices.
+   };
+
+   /// Sifts the variables and renumbers the live vertices.
+   ///
+   /// @param[in,out] edges  The external edges keeping vertices alive;
+   ///                       invalid edges are ignored.
+   void Sift(std::span<Edge> edges);
+
+   /// Swaps the variables of the level and the level below in place.
+   void SwapLevels(int level, Reordering* reordering);
+
+   /// Finds or creates the reduced vertex with one more reference.
+   Edge AddVertex(int level, Edge high, Edge low, Reordering* reordering);
+
+   /// Removes a reference to the edge and frees the dead vertices.
+   void Release(Edge edge, Reordering* reordering);
+
+   /// Rebuilds the vertices, the unique table, and the computed table
+   /// with only the live vertices in the topological order.
+   ///
+   /// @param[in,out] edges  The external edges to renumber.
+   void Compact(const Reordering& reordering, std::span<Edge> edges);
+
+   /// @returns The key of the vertex children in the level tables.
+   static std::uint64_t Key(Edge high, Edge low) { return (std::uint64_t{high} << 32) | low; }
+
+   /// @returns The unique table hash of the vertex.
+   static std::size_t Hash(int level, Edge high, Edge low) {
+       std::uint64_t key = (std::uint64_t{high} << 32) ^ low;
+       key = (key ^ (key >> 31) ^ (std::uint64_t(level) * 0x9E3779B97F4A7C15)) *
+             0xBF58476D1CE4E5B9;
+       return key ^ (key >> 29);
+   }
+
+   std::vector<Vertex> vertices_;  ///< All vertices with the terminal at 0.
+   std::vector<std::uint32_t> unique_table_;  ///< Vertex indices; 0 for empty.
+   std::vector<Computation> computed_table_;  ///< The lossy ITE cache.
+   std::vector<int> variables_;  ///< The variable ids by levels.
+   std::vector<int> levels_;  ///< The levels by variable ids.
+   std::vector<Edge> roots_;  ///< The diagrams of the graph roots.
+   int num_reorderings_ = 0;  ///< The number of dynamic reorderings.
+};
+
+}  // namespace canopy::core
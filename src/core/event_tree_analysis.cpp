@@ -0,0 +1,159 @@
+/// @file
+/// Implementation of the event tree analysis.
+
+#include "core/event_tree_analysis.h"
+
+#include <algorithm>
+#include <utility>
+#include <span>
+
+#include "core/modules.h"
+#include "core/preprocessor.h"
+#include "mef/openpsa/expr/numerical.h"
+
+namespace canopy::core {
+
+EventTreeAnalysis::EventTreeAnalysis(const mef::openpsa::InitiatingEvent& initiating_event,
+                                     const mef::openpsa::Settings& settings,
+                                     mef::openpsa::Context* context)
+    : initiating_event_(initiating_event),
+      settings_(settings),
+      context_(context),
+      program_(initiating_event, context),
+      graph_(settings.ccf_analysis()) {}
+
+void EventTreeAnalysis::Analyze() {
+   context_->Clear();
+   context_->initiating_event(initiating_event_.name_symbol());
+   conditions_ = program_.Hoist();
+   sequences_.assign(program_.sequences().size(), -1);
+   PathState path;
+   path.house_events.assign(program_.house_events().size(), -1);
+   Walk(program_.entry(), std::move(path));
+   context_->Clear();
+   graph_.SetHouseEvents({});
+
+   std::vector<int> graph_results;  // The results with the roots in the graph.
+   for (int i = 0; i < static_cast<int>(results_.size()); ++i) {
+       Result& result = results_[i];
+       result.expression_only = std::all_of(
+           paths_[i].begin(), paths_[i].end(),
+           [](const SequencePath& path) { return path.formulas.empty(); });
+       if (result.expression_only) {
+           // The paths into the sequence are mutually exclusive.
+           result.p_sequence = 0;
+           for (const SequencePath& path : paths_[i])
+               result.p_sequence += path.expression ? path.expression->value() : 1;
+           continue;
+       }
+       std::vector<Pdag::Index> args;
+       for (SequencePath& path : paths_[i]) {
+           if (path.expression)
+               path.formulas.push_back(graph_.AddVariable(*path.expression));
+           if (path.formulas.empty()) {
+               args.push_back(Pdag::kTrue);
+               continue;
+           }
+           args.push_back(graph_.AddGate(mef::openpsa::Connective::kAnd,
+                                         std::move(path.formulas)));
+       }
+       graph_.AddRoot(graph_.AddGate(mef::openpsa::Connective::kOr, std::move(args)));
+       graph_results.push_back(i);
+   }
+   paths_.clear();
+   if (graph_results.empty())
+       return;
+
+   Preprocessor(&graph_).Run();
+   std::vector<double> p_vars;
+   for (int variable = 0; variable < graph_.num_variables(); ++variable)
+       p_vars.push_back(graph_.p(variable));
+   std::vector<double> p_roots = ModularBdd(graph_, settings_).Probabilities(p_vars);
+   for (std::size_t i = 0; i < graph_results.size(); ++i)
+       results_[graph_results[i]].p_sequence = p_roots[i];
+}
+
+void EventTreeAnalysis::Walk(std::uint32_t position, PathState path) {
+   using OpCode = EventTreeProgram::OpCode;
+   std::span<const EventTreeProgram::Op> code = program_.code();
+   for (;;) {
+       const EventTreeProgram::Op& op = code[position++];
+       switch (op.code) {
+       case OpCode::kSetHouseEvent:
+           path.house_events[op.operand] = op.state;
+           break;
+       case OpCode::kCollectExpression:
+           path.expressions.push_back(op.operand);
+           break;
+       case OpCode::kCollectFormula:
+           path.formulas.push_back(op.operand);
+           break;
+       case OpCode::kLink:
+           path.link = op.target;
+           break;
+       case OpCode::kJumpIfFalse: {
+           std::int8_t hoisted = conditions_[op.operand];
+           if (hoisted < 0 ? !program_.conditions()[op.operand].expression->value() : !hoisted)
+               position = op.target;
+           break;
+       }
+       case OpCode::kJump:
+           position = op.target;
+           break;
+       case OpCode::kFork: {
+           const EventTreeProgram::Fork& fork = program_.forks()[op.operand];
+           mef::openpsa::Symbol state = context_->state(fork.functional_event);
+           for (std::uint32_t i = 0; i < fork.num_paths; ++i) {
+               const EventTreeProgram::Path& fork_path = program_.paths()[fork.first_path + i];
+               context_->state(fork.functional_event, fork_path.state);
+               Walk(fork_path.entry, path);
+           }
+           context_->state(fork.functional_event, state);
+           return;
+       }
+       case OpCode::kSequence:
+           if (path.link == EventTreeProgram::kNoTarget) {
+               AddPath(op.operand, path);
+               return;
+           }
+           position = std::exchange(path.link, EventTreeProgram::kNoTarget);
+           break;
+       }
+   }
+}
+
+void EventTreeAnalysis::AddPath(std::uint32_t sequence, const PathState& path) {
+   if (sequences_[sequence] < 0) {
+       sequences_[sequence] = results_.size();
+       results_.push_back({program_.sequences()[sequence], 0, true});
+       paths_.emplace_back();
+   }
+   SequencePath& sequence_path = paths_[sequences_[sequence]].emplace_back();
+
+   std::vector<std::pair<mef::openpsa::Symbol, bool>> house_events;
+   for (std::size_t i = 0; i < path.house_events.size(); ++i) {
+       if (path.house_events[i] >= 0)
+           house_events.emplace_back(program_.house_events()[i], path.house_events[i]);
+   }
+   graph_.SetHouseEvents(std::move(house_events));
+   for (std::uint32_t formula : path.formulas)
+       sequence_path.formulas.push_back(graph_.Add(*program_.formulas()[formula]));
+
+   switch (path.expressions.size()) {
+   case 0:
+       sequence_path.expression = nullptr;
+       break;
+   case 1:
+       sequence_path.expression = program_.expressions()[path.expressions.front()];
+       break;
+   default: {
+       std::vector<mef::openpsa::Expression*> factors;
+       for (std::uint32_t expression : path.expressions)
+           factors.push_back(program_.expressions()[expression]);
+       expressions_.push_back(std::make_unique<mef::openpsa::Mul>(std::move(factors)));
+       sequence_path.expression = expressions_.back().get();
+   }
+   }
+}
+
+}  // namespace canopy::core
@@ -0,0 +1,116 @@
+/// @file
+/// Event tree analysis of the sequences of initiating events.
+
+#pragma once
+
+#include <cstdint>
+
+#include <memory>
+#include <vector>
+
+#include "core/event_tree_program.h"
+#include "core/pdag.h"
+#include "mef/openpsa/event_tree.h"
+#include "mef/openpsa/expr/test_event.h"
+#include "mef/openpsa/settings.h"
+
+namespace canopy::core {
+
+/// Quantification of the sequences of an initiating event
+/// by walking its event tree.
+///
+/// The event tree is compiled into a program,
+/// and every path of the program from the initial state to a sequence
+/// collects the formulas, the expressions, and the house-event states
+/// of the instructions on its branches and forks;
+/// links continue the path into the initial states of the linked trees.
+/// The conditions independent of test events are evaluated once per walk.
+/// The path is the conjunction of its formulas
+/// with the product of its expressions as a variable,
+/// and the sequence is the disjunction of its paths.
+/// The sequences with only expressions on their paths
+/// are the sums of the path products.
+///
+/// The formulas of all the sequences are converted into a single PDAG,
+/// so the fault-tree logic shared by the sequences
+/// is converted once (per set of house-event states),
+/// and all the sequences are quantified with a single BDD
+/// in one pass over their shared vertices.
+class EventTreeAnalysis {
+ public:
+   /// The quantified sequence.
+   struct Result {
+       const mef::openpsa::Sequence* sequence;  ///< The end-state.
+       double p_sequence;  ///< The probability or frequency of the sequence.
+       bool expression_only;  ///< The absence of formulas on the paths.
+   };
+
+   /// @param[in] initiating_event  The initiating event with its event tree.
+   /// @param[in] settings  The analysis settings.
+   /// @param[in,out] context  The context of test-event expressions
+   ///                         updated along the walk.
+   ///
+   /// @pre The initiating event has an event tree.
+   EventTreeAnalysis(const mef::openpsa::InitiatingEvent& initiating_event,
+                     const mef::openpsa::Settings& settings,
+                     mef::openpsa::Context* context);
+
+   /// Walks the event tree and quantifies the reached sequences.
+   void Analyze();
+
+   /// @returns The initiating event under the analysis.
+   const mef::openpsa::InitiatingEvent& initiating_event() const {
+       return initiating_event_;
+   }
+
+   /// @returns The analysis settings.
+   const mef::openpsa::Settings& settings() const { return settings_; }
+
+   /// @returns The graph of the sequences with formulas.
+   const Pdag& graph() const { return graph_; }
+
+   /// @returns The sequences in the order of the walk.
+   const std::vector<Result>& results() const { return results_; }
+
+ private:
+   /// The instructions collected on a path of the walk.
+   struct PathState {
+       /// The house-event states by the program slots;
+       /// -1 for the model states.
+       std::vector<std::int8_t> house_events;
+       std::vector<std::uint32_t> formulas;  ///< The formula slots.
+       std::vector<std::uint32_t> expressions;  ///< The expression slots.
+       /// The entry of the linked tree to continue after the sequence.
+       std::uint32_t link = EventTreeProgram::kNoTarget;
+   };
+
+   /// The collected path into a sequence.
+   struct SequencePath {
+       std::vector<Pdag::Index> formulas;  ///< The converted formulas.
+       mef::openpsa::Expression* expression;  ///< The product or nullptr.
+   };
+
+   /// Runs the program from the code position down to the sequences.
+   ///
+   /// @param[in] position  The code position of the branch to apply.
+   /// @param[in] path  The instructions collected before the branch.
+   void Walk(std::uint32_t position, PathState path);
+
+   /// Converts the path collected into the sequence slot.
+   void AddPath(std::uint32_t sequence, const PathState& path);
+
+   const mef::openpsa::InitiatingEvent& initiating_event_;  ///< The analysis target.
+   const mef::openpsa::Settings& settings_;  ///< The analysis settings.
+   mef::openpsa::Context* context_;  ///< The test-event context.
+   EventTreeProgram program_;  ///< The compiled event tree.
+   std::vector<std::int8_t> conditions_;  ///< The hoisted conditions.
+   Pdag graph_;  ///< The formulas of the paths.
+   std::vector<Result> results_;  ///< The sequences by the walk order.
+   std::vector<std::vector<SequencePath>> paths_;  ///< The paths of the sequences.
+   /// The positions of the sequences in the results by the program slots.
+   std::vector<int> sequences_;
+   /// The products of the path expressions.
+   std::vector<std::unique_ptr<mef::openpsa::Expression>> expressions_;
+};
+
+}  // namespace canopy::core
@@ -0,0 +1,186 @@
+/// @file
+/// Implementation of the event-tree instruction compilation.
+
+#include "core/event_tree_program.h"
+
+#include <cassert>
+
+#include <unordered_map>
+#include <utility>
+#include <variant>
+
+namespace canopy::core {
+
+/// Lowering of the branches and their instructions into the program code.
+///
+/// The branches are compiled from a worklist,
+/// so the code of every branch is contiguous,
+/// and the references to the branches are patched at the end.
+class EventTreeProgram::Compiler : public mef::openpsa::InstructionVisitor {
+ public:
+   /// @param[in,out] program  The program to fill.
+   /// @param[in,out] context  The context to register the functional events.
+   Compiler(EventTreeProgram* program, mef::openpsa::Context* context)
+       : program_(*program), context_(*context) {}
+
+   /// Compiles the branch and all the branches reachable from it.
+   void Compile(const mef::openpsa::Branch& initial_state) {
+       std::vector<const mef::openpsa::Branch*> worklist = {&initial_state};
+       while (!worklist.empty()) {
+           const mef::openpsa::Branch* branch = worklist.back();
+           worklist.pop_back();
+           if (!entries_.emplace(branch, program_.code_.size()).second)
+               continue;
+           Emit(branch->instructions());
+           EmitTarget(branch->target(), &worklist);
+           worklist.insert(worklist.end(), links_.begin(), links_.end());
+           links_.clear();
+       }
+       for (auto [op, branch] : op_references_)
+           program_.code_[op].target = entries_.at(branch);
+       for (auto [path, branch] : path_references_)
+           program_.paths_[path].entry = entries_.at(branch);
+   }
+
+   void Visit(const mef::openpsa::SetHouseEvent* instruction) override {
+       Emit({OpCode::kSetHouseEvent, instruction->state(),
+             Slot(instruction->name_symbol(), &house_events_, &program_.house_events_),
+             kNoTarget});
+   }
+
+   void Visit(const mef::openpsa::CollectExpression* instruction) override {
+       Emit({OpCode::kCollectExpression, false,
+             Slot(&instruction->expression(), &expressions_, &program_.expressions_),
+             kNoTarget});
+   }
+
+   void Visit(const mef::openpsa::CollectFormula* instruction) override {
+       const mef::openpsa::Formula* formula = &instruction->formula();
+       Emit({OpCode::kCollectFormula, false,
+             Slot(formula, &formulas_, &program_.formulas_), kNoTarget});
+   }
+
+   void Visit(const mef::openpsa::Link* instruction) override {
+       links_.push_back(&instruction->event_tree().initial_state());
+       op_references_.emplace_back(program_.code_.size(), links_.back());
+       Emit({OpCode::kLink, false, 0, kNoTarget});
+   }
+
+   void Visit(const mef::openpsa::IfThenElse* instruction) override {
+       std::uint32_t condition = program_.conditions_.size();
+       program_.conditions_.push_back(
+           {instruction->expression(), !DependsOnTests(*instruction->expression())});
+       std::uint32_t jump = program_.code_.size();
+       Emit({OpCode::kJumpIfFalse, false, condition, kNoTarget});
+       instruction->then_instruction()->Accept(this);
+       if (instruction->else_instruction()) {
+           std::uint32_t skip = program_.code_.size();
+           Emit({OpCode::kJump, false, 0, kNoTarget});
+           program_.code_[jump].target = program_.code_.size();
+           instruction->else_instruction()->Accept(this);
+           program_.code_[skip].target = program_.code_.size();
+       } else {
+           program_.code_[jump].target = program_.code_.size();
+       }
+   }
+
+   using InstructionVisitor::Visit;  // Blocks and rules are inlined.
+
+ private:
+   /// Appends the operation to the code.
+   void Emit(const Op& op) { program_.code_.push_back(op); }
+
+   /// Appends the instructions to the code.
+   void Emit(const std::vector<mef::openpsa::Instruction*>& instructions) {
+       for (const mef::openpsa::Instruction* instruction : instructions)
+           instruction->Accept(this);
+   }
+
+   /// Appends the end of the branch code.
+   void EmitTarget(const mef::openpsa::Branch::Target& target,
+                   std::vector<const mef::openpsa::Branch*>* worklist) {
+       if (auto* const* sequence = std::get_if<mef::openpsa::Sequence*>(&target)) {
+           Emit((*sequence)->instructions());
+           Emit({OpCode::kSequence, false,
+                 Slot<const mef::openpsa::Sequence*>(*sequence, &sequences_,
+                                                     &program_.sequences_),
+                 kNoTarget});
+       } else if (auto* const* fork = std::get_if<mef::openpsa::Fork*>(&target)) {
+           std::uint32_t first_path = program_.paths_.size();
+           for (const mef::openpsa::Path& path : (*fork)->paths()) {
+               path_references_.emplace_back(program_.paths_.size(), &path);
+               program_.paths_.push_back({path.state_symbol(), kNoTarget});
+               worklist->push_back(&path);
+           }
+           Emit({OpCode::kFork, false, static_cast<std::uint32_t>(program_.forks_.size()),
+                 kNoTarget});
+           program_.forks_.push_back(
+               {context_.Register((*fork)->functional_event().name_symbol()), first_path,
+                static_cast<std::uint32_t>((*fork)->paths().size())});
+       } else {
+           const mef::openpsa::Branch* branch = std::get<mef::openpsa::NamedBranch*>(target);
+           op_references_.emplace_back(program_.code_.size(), branch);
+           Emit({OpCode::kJump, false, 0, kNoTarget});
+           worklist->push_back(branch);
+       }
+   }
+
+   /// @returns The slot of the key in the table, which is added if new.
+   template <typename T>
+   static std::uint32_t Slot(T key, std::unordered_map<T, std::uint32_t>* slots,
+                             std::vector<T>* table) {
+       auto [it, inserted] = slots->emplace(key, table->size());
+       if (inserted)
+           table->push_back(key);
+       return it->second;
+   }
+
+   /// @returns true if the expression value depends on the walk context.
+   bool DependsOnTests(mef::openpsa::Expression& expression) {
+       if (auto it = dependencies_.find(&expression); it != dependencies_.end())
+           return it->second;
+       bool result = dynamic_cast<mef::openpsa::TestEvent*>(&expression);
+       for (mef::openpsa::Expression* arg : expression.args()) {
+           if (result)
+               break;
+           result = DependsOnTests(*arg);
+       }
+       dependencies_.emplace(&expression, result);
+       return result;
+   }
+
+   EventTreeProgram& program_;  ///< The compiled program.
+   mef::openpsa::Context& context_;  ///< The functional-event slots.
+   /// The code positions of the branches.
+   std::unordered_map<const mef::openpsa::Branch*, std::uint32_t> entries_;
+   /// The jumps and links to the branches.
+   std::vector<std::pair<std::uint32_t, const mef::openpsa::Branch*>> op_references_;
+   /// The fork paths to the branches.
+   std::vector<std::pair<std::uint32_t, const mef::openpsa::Branch*>> path_references_;
+   /// The linked trees of the current branch to compile after it.
+   std::vector<const mef::openpsa::Branch*> links_;
+   /// The slots of the program tables.
+   /// @{
+   std::unordered_map<mef::openpsa::Symbol, std::uint32_t> house_events_;
+   std::unordered_map<const mef::openpsa::Formula*, std::uint32_t> formulas_;
+   std::unordered_map<mef::openpsa::Expression*, std::uint32_t> expressions_;
+   std::unordered_map<const mef::openpsa::Sequence*, std::uint32_t> sequences_;
+   /// @}
+   /// The memo of the test-event dependencies.
+   std::unordered_map<const mef::openpsa::Expression*, bool> dependencies_;
+};
+
+EventTreeProgram::EventTreeProgram(const mef::openpsa::InitiatingEvent& initiating_event,
+                                   mef::openpsa::Context* context) {
+   assert(initiating_event.event_tree() && "The initiating event without an event tree.");
+   Compiler(this, context).Compile(initiating_event.event_tree()->initial_state());
+}
+
+std::vector<std::int8_t> EventTreeProgram::Hoist() const {
+   std::vector<std::int8_t> values;
+   for (const Condition& condition : conditions_)
+       values.push_back(condition.invariant ? condition.expression->value() != 0 : -1);
+   return values;
+}
+
+}  // namespace canopy::core
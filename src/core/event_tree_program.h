@@ -0,0 +1,126 @@
+/// @file
+/// Compiled instruction programs of event-tree walks.
+
+#pragma once
+
+#include <cstdint>
+
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "mef/openpsa/event/event.h"
+#include "mef/openpsa/event/formula.h"
+#include "mef/openpsa/event_tree.h"
+#include "mef/openpsa/expr/test_event.h"
+#include "mef/openpsa/instruction.h"
+#include "mef/openpsa/symbol.h"
+
+namespace canopy::core {
+
+/// The event tree of an initiating event with the linked trees
+/// lowered into a flat bytecode for the walk interpreters.
+///
+/// The instructions of branches, fork paths, and sequences
+/// become straight-line code;
+/// blocks and rules are inlined,
+/// and conditional instructions become conditional jumps.
+/// Forks, named branches, and links refer to the entry points of the branch code,
+/// and every branch is compiled once regardless of the number of references.
+/// The house events, formulas, expressions, and sequences
+/// are resolved into dense slots of the program tables,
+/// and the functional events into the slots of the test-event context.
+///
+/// The conditions are marked invariant
+/// if they do not depend on test events,
+/// so the walks can hoist them out of the traversal
+/// and evaluate them once per walk.
+class EventTreeProgram {
+ public:
+   /// The operations of the walk.
+   enum class OpCode : std::uint8_t {
+       kSetHouseEvent = 0,  ///< Sets the house-event slot to the state.
+       kCollectExpression,  ///< Collects the expression slot into the path.
+       kCollectFormula,  ///< Collects the formula slot into the path.
+       kLink,  ///< Continues the path at the target after the sequence.
+       kJumpIfFalse,  ///< Jumps to the target if the condition slot is false.
+       kJump,  ///< Jumps to the target.
+       kFork,  ///< Walks the paths of the fork slot and ends the branch.
+       kSequence  ///< Ends the path in the sequence slot or follows the link.
+   };
+
+   /// The absent code position.
+   static constexpr std::uint32_t kNoTarget = std::numeric_limits<std::uint32_t>::max();
+
+   /// The instruction of the program.
+   struct Op {
+       OpCode code;  ///< The operation.
+       bool state;  ///< The state of kSetHouseEvent.
+       std::uint32_t operand;  ///< The slot in the program tables.
+       std::uint32_t target;  ///< The code position of jumps and links.
+   };
+
+   /// The fork of a functional event.
+   struct Fork {
+       int functional_event;  ///< The slot of the functional event in the context.
+       std::uint32_t first_path;  ///< The position of the first path.
+       std::uint32_t num_paths;  ///< The number of the paths.
+   };
+
+   /// The path of a fork.
+   struct Path {
+       mef::openpsa::Symbol state;  ///< The state of the functional event.
+       std::uint32_t entry;  ///< The code position of the path branch.
+   };
+
+   /// The condition of conditional instructions.
+   struct Condition {
+       mef::openpsa::Expression* expression;  ///< The tested expression.
+       bool invariant;  ///< The independence from test events.
+   };
+
+   /// Compiles the event tree of the initiating event.
+   ///
+   /// @param[in] initiating_event  The initiating event with the event tree.
+   /// @param[in,out] context  The test-event context
+   ///                         to register the functional events.
+   EventTreeProgram(const mef::openpsa::InitiatingEvent& initiating_event,
+                    mef::openpsa::Context* context);
+
+   /// @returns The code position of the initial state.
+   std::uint32_t entry() const { return 0; }
+
+   /// @returns The operations.
+   std::span<const Op> code() const { return code_; }
+
+   /// Program tables by slots.
+   /// @{
+   const std::vector<mef::openpsa::Symbol>& house_events() const { return house_events_; }
+   const std::vector<const mef::openpsa::Formula*>& formulas() const { return formulas_; }
+   const std::vector<mef::openpsa::Expression*>& expressions() const { return expressions_; }
+   const std::vector<const mef::openpsa::Sequence*>& sequences() const { return sequences_; }
+   const std::vector<Fork>& forks() const { return forks_; }
+   const std::vector<Path>& paths() const { return paths_; }
+   const std::vector<Condition>& conditions() const { return conditions_; }
+   /// @}
+
+   /// Evaluates the invariant conditions for the walk.
+   ///
+   /// @returns The truth values of the invariant conditions by slots,
+   ///          and -1 for the conditions to evaluate upon the traversal.
+   std::vector<std::int8_t> Hoist() const;
+
+ private:
+   class Compiler;  // The instruction visitor of the compilation.
+
+   std::vector<Op> code_;  ///< The operations of all the branches.
+   std::vector<mef::openpsa::Symbol> house_events_;  ///< The ids of the house events.
+   std::vector<const mef::openpsa::Formula*> formulas_;  ///< The collected formulas.
+   std::vector<mef::openpsa::Expression*> expressions_;  ///< The collected expressions.
+   std::vector<const mef::openpsa::Sequence*> sequences_;  ///< The end-states.
+   std::vector<Fork> forks_;  ///< The forks of the functional events.
+   std::vector<Path> paths_;  ///< The contiguous paths of the forks.
+   std::vector<Condition> conditions_;  ///< The conditions of the jumps.
+};
+
+}  // namespace canopy::core
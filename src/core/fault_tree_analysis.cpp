@@ -0,0 +1,213 @@
+/// @file
+/// Implementation of the fault tree analysis driver.
+
+#include "core/fault_tree_analysis.h"
+
+#include <algorithm>
+
+#include "core/preprocessor.h"
+#include "core/variable_ordering.h"
+
+namespace canopy::core {
+
+FaultTreeAnalysis::FaultTreeAnalysis(const mef::openpsa::Gate& top_event,
+                                     const mef::openpsa::Settings& settings)
+    : top_event_(top_event),
+      settings_(settings),
+      graph_(top_event, settings.ccf_analysis()) {
+   Preprocessor(&graph_).Run();
+   for (int variable = 0; variable < graph_.num_variables(); ++variable)
+       p_vars_.push_back(graph_.p(variable));
+}
+
+void FaultTreeAnalysis::Analyze() {
+   if (settings_.preprocessor)
+       return;  // Only the preprocessed graph is requested.
+   if (!settings_.skip_products())
+       AnalyzeProducts();
+   if (settings_.probability_analysis())
+       AnalyzeProbability();
+   if (settings_.importance_analysis())
+       AnalyzeImportance();
+   if (settings_.uncertainty_analysis())
+       AnalyzeUncertainty();
+   if (settings_.probability_analysis() && settings_.time_step() > 0)
+       AnalyzeTime();
+}
+
+void FaultTreeAnalysis::AnalyzeProducts() {
+   using mef::openpsa::Algorithm;
+   switch (settings_.algorithm()) {
+   case Algorithm::kBdd:
+       zbdd_ = std::make_unique<Zbdd>(GetBdd(), p_vars_, settings_);
+       break;
+   case Algorithm::kZbdd:
+   case Algorithm::kMocus:
+       // Prime implicants require the consensus of the BDD.
+       if (settings_.prime_implicants())
+           zbdd_ = std::make_unique<Zbdd>(GetBdd(), p_vars_, settings_);
+       else if (settings_.algorithm() == Algorithm::kMocus)
+           mocus_ = std::make_unique<Mocus>(graph_, p_vars_, settings_);
+       else
+           zbdd_ = std::make_unique<Zbdd>(graph_, p_vars_, settings_);
+       break;
+   case Algorithm::kDirect:
+       break;  // The graph is quantified directly without products.
+   }
+}
+
+void FaultTreeAnalysis::AnalyzeProbability() {
+   using mef::openpsa::Approximation;
+   switch (settings_.approximation()) {
+   case Approximation::kRareEvent:
+       if (zbdd_) {
+           p_total_ = std::min(1.0, zbdd_->RareEvent(zbdd_->roots().front()));
+           return;
+       }
+       if (mocus_) {
+           p_total_ = std::min(1.0, mocus_->RareEvent());
+           return;
+       }
+       break;
+   case Approximation::kMcub:
+       if (zbdd_) {
+           p_total_ = zbdd_->Mcub(zbdd_->roots().front());
+           return;
+       }
+       if (mocus_) {
+           p_total_ = mocus_->Mcub();
+           return;
+       }
+       break;
+   case Approximation::kMonteCarlo:
+       monte_carlo_ = std::make_unique<MonteCarlo>(graph_, p_vars_, settings_);
+       p_total_ = monte_carlo_->p_total();
+       return;
+   default:
+       break;
+   }
+   if (!bdd_) {  // The whole diagram is not needed for the products.
+       p_total_ = GetModularBdd()->Probability(p_vars_);
+       return;
+   }
+   p_total_ = bdd_->Probability(bdd_->roots().front(), p_vars_);
+}
+
+void FaultTreeAnalysis::AnalyzeImportance() {
+   using mef::openpsa::Approximation;
+   Approximation approximation = settings_.approximation();
+   if ((approximation == Approximation::kRareEvent || approximation == Approximation::kMcub) &&
+       (zbdd_ || mocus_)) {
+       bool mcub = approximation == Approximation::kMcub;
+       ProductImportance accumulator(p_vars_, mcub);
+       auto for_each_product = [this](auto&& visit) {
+           if (zbdd_) {
+               zbdd_->ForEachProduct(zbdd_->roots().front(), visit);
+           } else {
+               const ProductArena& products = mocus_->products();
+               for (std::size_t i = 0; i < products.size(); ++i)
+                   visit(products[i]);
+           }
+       };
+       if (mcub) {
+           for_each_product(
+               [&accumulator](std::span<const int> product) { accumulator.Prepare(product); });
+       }
+       for_each_product(
+           [&accumulator](std::span<const int> product) { accumulator.Add(product); });
+       importance_ = CalculateImportance(p_vars_, p_total_, accumulator.mif());
+       return;
+   }
+   // The simulation estimates are too noisy for derivatives.
+   if (!bdd_) {  // The whole diagram is not needed for the derivatives.
+       const ModularBdd* modular_bdd = GetModularBdd();
+       importance_ = CalculateImportance(p_vars_, modular_bdd->Probability(p_vars_),
+                                         modular_bdd->Derivatives(p_vars_));
+       return;
+   }
+   Bdd* bdd = bdd_.get();
+   Bdd::Edge root = bdd->roots().front();
+   importance_ = CalculateImportance(p_vars_, bdd->Probability(root, p_vars_),
+                                     bdd->Derivatives(root, p_vars_));
+}
+
+void FaultTreeAnalysis::AnalyzeUncertainty() {
+   uncertainty_ = std::make_unique<UncertaintyAnalysis>(graph_, MakeQuantifier(), settings_);
+}
+
+void FaultTreeAnalysis::AnalyzeTime() {
+   time_sweep_ = std::make_unique<TimeSweep>(graph_, MakeQuantifier(), settings_);
+   if (settings_.safety_integrity_levels())
+       safety_integrity_ = ComputeSafetyIntegrity(time_sweep_->p_time());
+}
+
+Quantifier FaultTreeAnalysis::MakeQuantifier() {
+   using mef::openpsa::Approximation;
+   Approximation approximation = settings_.approximation();
+   if ((approximation == Approximation::kRareEvent || approximation == Approximation::kMcub) &&
+       (zbdd_ || mocus_)) {
+       ProductArena products;
+       if (zbdd_) {
+           zbdd_->ForEachProduct(zbdd_->roots().front(),
+                                 [&products](std::span<const int> product) {
+                                     products.Add(product);
+                                 });
+       } else {
+           products = mocus_->products();
+       }
+       bool mcub = approximation == Approximation::kMcub;
+       return [products = std::move(products), mcub](std::span<const double> p,
+                                                     std::vector<double>*) {
+           double sum = 0;
+           double complement = 1;
+           for (std::size_t i = 0; i < products.size(); ++i) {
+               double p_product = 1;
+               for (int literal : products[i])
+                   p_product *= literal < 0 ? 1 - p[~literal] : p[literal];
+               sum += p_product;
+               complement *= 1 - p_product;
+           }
+           return mcub ? 1 - complement : std::min(1.0, sum);
+       };
+   }
+   // The simulation of every probability set would be too costly and noisy.
+   if (!bdd_) {
+       const ModularBdd* modular_bdd = GetModularBdd();
+       return [modular_bdd](std::span<const double> p, std::vector<double>* scratch) {
+           return modular_bdd->Probability(p, scratch);
+       };
+   }
+   const Bdd* bdd = bdd_.get();
+   Bdd::Edge root = bdd->roots().front();
+   return [bdd, root, vertices = bdd->Collect(root)](std::span<const double> p,
+                                                     std::vector<double>* scratch) {
+       scratch->resize(bdd->size());
+       return bdd->Probability(root, vertices, p, *scratch);
+   };
+}
+
+Bdd* FaultTreeAnalysis::GetBdd() {
+   if (!bdd_) {
+       bdd_ = std::make_unique<Bdd>(graph_, OrderVariables(graph_, settings_),
+                                    settings_.reorder_threshold());
+   }
+   return bdd_.get();
+}
+
+std::vector<std::string> FaultTreeAnalysis::variable_order() const {
+   std::vector<std::string> names;
+   std::vector<int> order = bdd_           ? bdd_->order()
+                            : modular_bdd_ ? modular_bdd_->order()
+                                           : OrderVariables(graph_, settings_);
+   for (int variable : order)
+       names.push_back(graph_.name(variable));
+   return names;
+}
+
+const ModularBdd* FaultTreeAnalysis::GetModularBdd() {
+   if (!modular_bdd_)
+       modular_bdd_ = std::make_unique<ModularBdd>(graph_, settings_);
+   return modular_bdd_.get();
+}
+
+}  // namespace canopy::core
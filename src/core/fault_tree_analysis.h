@@ -0,0 +1,155 @@
+/// @file
+/// Fault tree analysis driver over the analysis engines.
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "core/bdd.h"
+#include "core/importance.h"
+#include "core/mocus.h"
+#include "core/modules.h"
+#include "core/monte_carlo.h"
+#include "core/pdag.h"
+#include "core/quantifier.h"
+#include "core/safety_integrity.h"
+#include "core/time_sweep.h"
+#include "core/uncertainty_analysis.h"
+#include "core/zbdd.h"
+#include "mef/openpsa/event/gate.h"
+#include "mef/openpsa/settings.h"
+
+namespace canopy::core {
+
+/// Analysis of a single top event
+/// with the engines selected by the analysis settings.
+///
+/// The top event is converted into a PDAG once and preprocessed,
+/// and the engines share the graph and its variables.
+class FaultTreeAnalysis {
+ public:
+   /// @param[in] top_event  The top gate of the fault tree to analyze.
+   /// @param[in] settings  The analysis settings.
+   FaultTreeAnalysis(const mef::openpsa::Gate& top_event,
+                     const mef::openpsa::Settings& settings);
+
+   /// Runs the analyses requested by the settings
+   /// unless the analysis stops after the preprocessor.
+   void Analyze();
+
+   /// @returns The top event under the analysis.
+   const mef::openpsa::Gate& top_event() const { return top_event_; }
+
+   /// @returns The analysis settings.
+   const mef::openpsa::Settings& settings() const { return settings_; }
+
+   /// @returns The graph of the top event.
+   const Pdag& graph() const { return graph_; }
+
+   /// @returns The probabilities of the graph variables by variable ids.
+   const std::vector<double>& p_vars() const { return p_vars_; }
+
+   /// @returns The diagram of the top event after the analysis;
+   ///          nullptr if no BDD has been built.
+   const Bdd* bdd() const { return bdd_.get(); }
+
+   /// @returns The ZBDD products of the top event after the analysis;
+   ///          nullptr if the products are skipped or generated with MOCUS.
+   const Zbdd* zbdd() const { return zbdd_.get(); }
+
+   /// @returns The MOCUS products of the top event after the analysis;
+   ///          nullptr if the products are not generated with MOCUS.
+   const Mocus* mocus() const { return mocus_.get(); }
+
+   /// @returns The names of the variables in the order of the BDD levels
+   ///          after the dynamic reordering,
+   ///          the module orders combined from the top module
+   ///          if only the modular diagrams have been built,
+   ///          or the static order without diagrams,
+   ///          for the reuse with Settings::variable_order.
+   std::vector<std::string> variable_order() const;
+
+   /// @returns The modular diagrams of the top event after the analysis;
+   ///          nullptr if the whole BDD is built for the products
+   ///          or the exact probability is not requested.
+   const ModularBdd* modular_bdd() const { return modular_bdd_.get(); }
+
+   /// @returns The simulation of the top event after the analysis;
+   ///          nullptr if the probability is not simulated.
+   const MonteCarlo* monte_carlo() const { return monte_carlo_.get(); }
+
+   /// @returns The total probability of the top event.
+   double p_total() const { return p_total_; }
+
+   /// @returns The importance factors of the graph variables by variable ids;
+   ///          empty if the importance analysis is not requested.
+   const std::vector<ImportanceFactors>& importance() const { return importance_; }
+
+   /// @returns The distribution of the top-event probability;
+   ///          nullptr if the uncertainty analysis is not requested.
+   const UncertaintyAnalysis* uncertainty() const { return uncertainty_.get(); }
+
+   /// @returns The top-event probability over the mission time;
+   ///          nullptr without the time step in the settings.
+   const TimeSweep* time_sweep() const { return time_sweep_.get(); }
+
+   /// @returns The SIL metrics of the top event if requested.
+   const std::optional<SafetyIntegrity>& safety_integrity() const {
+       return safety_integrity_;
+   }
+
+ private:
+   /// Generates the minimal cut sets or prime implicants
+   /// with the algorithm in the settings.
+   void AnalyzeProducts();
+
+   /// Computes the top-event probability
+   /// with the approximation in the settings.
+   void AnalyzeProbability();
+
+   /// Computes the importance factors of all the variables at once
+   /// from the products of the approximations
+   /// or from the BDD for the exact probability,
+   /// which is modular unless the whole BDD is built for the products.
+   void AnalyzeImportance();
+
+   /// Samples the top-event probability
+   /// with the same quantification as the total probability.
+   void AnalyzeUncertainty();
+
+   /// Evaluates the top-event probability at the time steps
+   /// with the same quantification as the total probability
+   /// and derives the SIL metrics from the curve if requested.
+   void AnalyzeTime();
+
+   /// @returns The quantification of the top event
+   ///          with the products of the approximations
+   ///          or with the BDD for the exact probability.
+   Quantifier MakeQuantifier();
+
+   /// @returns The BDD of the top event built on demand.
+   Bdd* GetBdd();
+
+   /// @returns The modular BDD of the top event built on demand.
+   const ModularBdd* GetModularBdd();
+
+   const mef::openpsa::Gate& top_event_;  ///< The top event.
+   const mef::openpsa::Settings& settings_;  ///< The analysis settings.
+   Pdag graph_;  ///< The graph of the top event.
+   std::vector<double> p_vars_;  ///< The variable probabilities.
+   std::unique_ptr<Bdd> bdd_;  ///< The diagram of the top event.
+   std::unique_ptr<ModularBdd> modular_bdd_;  ///< The diagrams of the modules.
+   std::unique_ptr<Zbdd> zbdd_;  ///< The ZBDD products of the top event.
+   std::unique_ptr<Mocus> mocus_;  ///< The MOCUS products of the top event.
+   std::unique_ptr<MonteCarlo> monte_carlo_;  ///< The simulation of the top event.
+   double p_total_ = 0;  ///< The top-event probability.
+   std::vector<ImportanceFactors> importance_;  ///< The variable importance.
+   std::unique_ptr<UncertaintyAnalysis> uncertainty_;  ///< The probability distribution.
+   std::unique_ptr<TimeSweep> time_sweep_;  ///< The probability over the time.
+   std::optional<SafetyIntegrity> safety_integrity_;  ///< The SIL metrics.
+};
+
+}  // namespace canopy::core
@@ -0,0 +1,81 @@
+/// @file
+/// Implementation of the importance measures.
+
+#include "core/importance.h"
+
+#include <cassert>
+
+#include <limits>
+#include <utility>
+
+namespace canopy::core {
+
+namespace {
+
+/// @returns The ratio with the infinity for positive values over zero
+///          and the neutral 1 for the zero over zero.
+double Ratio(double numerator, double denominator) {
+   if (denominator > 0)
+       return numerator / denominator;
+   return numerator > 0 ? std::numeric_limits<double>::infinity() : 1;
+}
+
+}  // namespace
+
+std::vector<ImportanceFactors> CalculateImportance(std::span<const double> p_vars,
+                                                   double p_total,
+                                                   std::span<const double> mif) {
+   std::vector<ImportanceFactors> factors;
+   factors.reserve(p_vars.size());
+   for (std::size_t i = 0; i < p_vars.size(); ++i) {
+       double p_var = p_vars[i];
+       double p_true = p_total + (1 - p_var) * mif[i];  // P(top | var)
+       double p_false = p_total - p_var * mif[i];  // P(top | not var)
+       double raw = Ratio(p_true, p_total);
+       factors.push_back({.mif = mif[i],
+                          .cif = p_total > 0 ? p_var * mif[i] / p_total : 0,
+                          .dif = p_var * raw,
+                          .raw = raw,
+                          .rrw = Ratio(p_total, p_false)});
+   }
+   return factors;
+}
+
+double ProductImportance::Probability(std::span<const int> product) const {
+   double result = 1;
+   for (int literal : product)
+       result *= Probability(literal);
+   return result;
+}
+
+void ProductImportance::Add(std::span<const int> product) {
+   // The derivative of the product by a literal is the product of the others.
+   suffixes_.resize(product.size() + 1);
+   suffixes_.back() = 1;
+   for (int i = product.size() - 1; i >= 0; --i)
+       suffixes_[i] = suffixes_[i + 1] * Probability(product[i]);
+   // The sensitivity of the total to the product probability.
+   double weight = 1;
+   if (mcub_) {
+       assert(num_added_ < complements_.size() && "The product is not prepared.");
+       if (!num_added_) {
+           double suffix = 1;
+           for (auto it = complements_.rbegin(); it != complements_.rend(); ++it)
+               suffix *= std::exchange(*it, suffix);
+       }
+       weight = prefix_ * complements_[num_added_++];
+       prefix_ *= 1 - suffixes_.front();
+   }
+   double prefix = weight;
+   for (std::size_t i = 0; i < product.size(); ++i) {
+       int literal = product[i];
+       double derivative = prefix * suffixes_[i + 1];
+       if (literal < 0)
+           mif_[~literal] -= derivative;
+       else
+           mif_[literal] += derivative;
+       prefix *= Probability(literal);
+   }
+}
+
+}  // namespace canopy::core
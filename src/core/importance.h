@@ -0,0 +1,95 @@
+/// @file
+/// Importance measures of basic events.
+
+#pragma once
+
+#include <cstddef>
+
+#include <span>
+#include <vector>
+
+namespace canopy::core {
+
+/// The importance measures of a variable.
+struct ImportanceFactors {
+   double mif;  ///< Birnbaum marginal importance factor.
+   double cif;  ///< Criticality importance factor.
+   double dif;  ///< Fussell-Vesely diagnosis importance factor.
+   double raw;  ///< Risk achievement worth.
+   double rrw;  ///< Risk reduction worth.
+};
+
+/// Derives all the importance measures
+/// from the Birnbaum importance of the variables.
+///
+/// The conditional top-event probabilities follow from the linearity
+/// of the probability in every variable probability:
+/// P(top | var) = P + (1 - p) * MIF and P(top | not var) = P - p * MIF.
+///
+/// @param[in] p_vars  The probabilities of the variables.
+/// @param[in] p_total  The top-event probability.
+/// @param[in] mif  The Birnbaum importance of the variables.
+///
+/// @returns The importance factors indexed by variable ids.
+std::vector<ImportanceFactors> CalculateImportance(std::span<const double> p_vars,
+                                                   double p_total,
+                                                   std::span<const double> mif);
+
+/// Accumulator of the Birnbaum importance over the products
+/// of the rare-event or MCUB approximation of the top-event probability.
+///
+/// Every product contributes to the derivatives of all its variables
+/// in a single visit without any re-quantification.
+///
+/// The sensitivity of the MCUB to a product probability
+/// is the product of the complements of all the other products,
+/// which is kept explicitly as the prefix and suffix products
+/// rather than divided out of the total,
+/// so products with the probability 1 are exact.
+/// The MCUB accumulation takes two passes over the products in the same order:
+/// all the products are prepared before any is added.
+class ProductImportance {
+ public:
+   /// @param[in] p_vars  The probabilities of the variables.
+   /// @param[in] mcub  The min cut upper bound instead of the rare-event approximation.
+   ProductImportance(std::span<const double> p_vars, bool mcub)
+       : p_vars_(p_vars), mcub_(mcub), mif_(p_vars.size(), 0) {}
+
+   /// Registers the product complement for the MCUB weights.
+   ///
+   /// @param[in] product  The variable ids with ~id for complements.
+   void Prepare(std::span<const int> product) {
+       complements_.push_back(1 - Probability(product));
+   }
+
+   /// Adds the contributions of the product.
+   ///
+   /// @param[in] product  The variable ids with ~id for complements.
+   ///
+   /// @pre All the products are prepared for the MCUB.
+   void Add(std::span<const int> product);
+
+   /// @returns The derivatives of the approximation by the variable probabilities.
+   const std::vector<double>& mif() const { return mif_; }
+
+ private:
+   /// @returns The probability of the literal.
+   double Probability(int literal) const {
+       return literal < 0 ? 1 - p_vars_[~literal] : p_vars_[literal];
+   }
+
+   /// @returns The probability of the product.
+   double Probability(std::span<const int> product) const;
+
+   std::span<const double> p_vars_;  ///< The variable probabilities.
+   bool mcub_;  ///< The approximation of the total.
+   std::vector<double> mif_;  ///< The accumulated derivatives.
+   std::vector<double> suffixes_;  ///< The scratch products of literal suffixes.
+   /// The complements of the prepared products,
+   /// replaced with the products of the complements after them upon the first addition.
+   std::vector<double> complements_;
+   double prefix_ = 1;  ///< The product of the complements of the added products.
+   std::size_t num_added_ = 0;  ///< The number of the added products.
+};
+
+}  // namespace canopy::core
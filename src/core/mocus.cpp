@@ -0,0 +1,267 @@
+/// @file
+/// Implementation of the MOCUS cut set expansion.
+
+#include "core/mocus.h"
+
+#include <cassert>
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+namespace canopy::core {
+
+namespace {
+
+/// The branching depth up to which branches are scheduled as separate tasks.
+/// Deeper branches are expanded in the task of their parent
+/// to keep the scheduling overhead below the expansion work.
+constexpr int kMaxTaskDepth = 8;
+
+}  // namespace
+
+Mocus::Mocus(const Pdag& graph, std::span<const double> p_vars,
+             const mef::openpsa::Settings& settings)
+    : graph_(graph),
+      p_vars_(p_vars.begin(), p_vars.end()),
+      limit_order_(settings.limit_order()),
+      cut_off_(settings.cut_off()) {
+   assert(!graph.roots().empty());
+   ThreadPool pool(settings.num_threads());
+   pool_ = &pool;
+   arenas_.resize(pool.size() + 1);
+   pool.Submit([this] { Expand({{}, {graph_.roots().front()}}, 0); });
+   pool.Wait();
+   pool_ = nullptr;
+   Minimize();
+}
+
+Connective Mocus::Resolve(Pdag::Index gate, std::vector<Pdag::Index>* args,
+                          int* min_number) const {
+   const Pdag::Node& node = graph_.node(gate);
+   args->assign(graph_.args(gate).begin(), graph_.args(gate).end());
+   *min_number = node.min_number;
+   if (gate > 0)
+       return node.connective;
+   // The complement is pushed down to the args with De Morgan's law.
+   for (Pdag::Index& arg : *args)
+       arg = -arg;
+   switch (node.connective) {
+   case Connective::kAnd:
+       return Connective::kOr;
+   case Connective::kOr:
+       return Connective::kAnd;
+   case Connective::kAtleast:
+       *min_number = args->size() - *min_number + 1;
+       return Connective::kAtleast;
+   case Connective::kXor:
+       args->front() = -args->front();  // Only one complement is retained.
+       return Connective::kXor;
+   default:
+       assert(false && "Unexpected connective in the PDAG.");
+       return node.connective;
+   }
+}
+
+bool Mocus::IsSatisfied(Pdag::Index gate, const CutSet& cut_set) const {
+   std::vector<Pdag::Index> args;
+   int min_number = 0;
+   Connective connective = Resolve(gate, &args, &min_number);
+   if (connective == Connective::kOr)
+       min_number = 1;
+   else if (connective != Connective::kAtleast)
+       return false;
+   for (Pdag::Index arg : args) {
+       if (graph_.IsGate(arg))
+           continue;
+       // The constant True and the complemented variables are Unity.
+       bool unity = graph_.IsConstant(arg)
+                        ? arg > 0
+                        : arg < 0 || std::binary_search(cut_set.variables.begin(),
+                                                        cut_set.variables.end(),
+                                                        graph_.variable(arg));
+       if (unity && --min_number == 0)
+           return true;
+   }
+   return false;
+}
+
+void Mocus::Expand(CutSet cut_set, int depth) {
+   std::vector<Pdag::Index> args;
+   int min_number = 0;
+   for (;;) {
+       // Variables and AND gates are absorbed before any branching
+       // to prune the cut set as early as possible.
+       std::vector<Pdag::Index> deferred;
+       while (!cut_set.gates.empty()) {
+           Pdag::Index index = cut_set.gates.back();
+           cut_set.gates.pop_back();
+           const Pdag::Node& node = graph_.node(index);
+           switch (node.kind) {
+           case Pdag::NodeKind::kConstant:
+               if (index < 0)
+                   return;  // The cut set is impossible.
+               break;
+           case Pdag::NodeKind::kVariable: {
+               if (index < 0)
+                   break;  // Unity for the complement in minimal cut sets.
+               int variable = node.first;
+               auto it = std::lower_bound(cut_set.variables.begin(),
+                                          cut_set.variables.end(), variable);
+               if (it != cut_set.variables.end() && *it == variable)
+                   break;
+               cut_set.variables.insert(it, variable);
+               cut_set.p *= p_vars_[variable];
+               if (static_cast<int>(cut_set.variables.size()) > limit_order_ ||
+                   cut_set.p < cut_off_) {
+                   return;
+               }
+               break;
+           }
+           case Pdag::NodeKind::kGate:
+               if (Resolve(index, &args, &min_number) == Connective::kAnd)
+                   cut_set.gates.insert(cut_set.gates.end(), args.begin(), args.end());
+               else
+                   deferred.push_back(index);
+               break;
+           }
+       }
+
+       // The gates satisfied by the cut set would only produce its supersets.
+       std::sort(deferred.begin(), deferred.end());
+       deferred.erase(std::unique(deferred.begin(), deferred.end()), deferred.end());
+       std::erase_if(deferred, [this, &cut_set](Pdag::Index gate) {
+           return IsSatisfied(gate, cut_set);
+       });
+       if (deferred.empty())
+           break;
+
+       // The narrowest gate is expanded first to limit the branching.
+       auto narrowest = std::min_element(
+           deferred.begin(), deferred.end(), [this](Pdag::Index lhs, Pdag::Index rhs) {
+               return graph_.node(lhs).size < graph_.node(rhs).size;
+           });
+       Pdag::Index gate = *narrowest;
+       deferred.erase(narrowest);
+       cut_set.gates = std::move(deferred);
+
+       std::vector<std::vector<Pdag::Index>> branches;
+       switch (Resolve(gate, &args, &min_number)) {
+       case Connective::kOr:
+           for (Pdag::Index arg : args)
+               branches.push_back({arg});
+           break;
+       case Connective::kAtleast: {
+           // Every combination of min number args is a branch.
+           std::vector<bool> selection(args.size(), false);
+           std::fill_n(selection.begin(), min_number, true);
+           do {
+               std::vector<Pdag::Index>& branch = branches.emplace_back();
+               for (int i = 0; i < static_cast<int>(args.size()); ++i) {
+                   if (selection[i])
+                       branch.push_back(args[i]);
+               }
+           } while (std::prev_permutation(selection.begin(), selection.end()));
+           break;
+       }
+       case Connective::kXor:
+           branches = {{args.front(), -args.back()}, {-args.front(), args.back()}};
+           break;
+       default:
+           assert(false && "Unexpected connective in the PDAG.");
+       }
+       Branch(branches, &cut_set, depth++);
+   }
+   arenas_[pool_->worker_index() + 1].Add(cut_set.variables);
+}
+
+void Mocus::Branch(const std::vector<std::vector<Pdag::Index>>& branches, CutSet* cut_set,
+                   int depth) {
+   for (auto it = std::next(branches.begin()); it != branches.end(); ++it) {
+       CutSet branch = *cut_set;
+       branch.gates.insert(branch.gates.end(), it->begin(), it->end());
+       if (depth < kMaxTaskDepth) {
+           pool_->Submit([this, branch = std::move(branch), depth]() mutable {
+               Expand(std::move(branch), depth + 1);
+           });
+       } else {
+           Expand(std::move(branch), depth + 1);
+       }
+   }
+   cut_set->gates.insert(cut_set->gates.end(), branches.front().begin(),
+                         branches.front().end());
+}
+
+void Mocus::Minimize() {
+   std::vector<std::span<const int>> candidates;
+   for (const ProductArena& arena : arenas_) {
+       for (std::size_t i = 0; i < arena.size(); ++i)
+           candidates.push_back(arena[i]);
+   }
+   // Smaller cut sets come first to subsume their supersets.
+   std::sort(candidates.begin(), candidates.end(), [](const auto& lhs, const auto& rhs) {
+       if (lhs.size() != rhs.size())
+           return lhs.size() < rhs.size();
+       return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+   });
+   auto last = std::unique(candidates.begin(), candidates.end(),
+                           [](const auto& lhs, const auto& rhs) {
+                               return std::equal(lhs.begin(), lhs.end(), rhs.begin(),
+                                                 rhs.end());
+                           });
+   candidates.erase(last, candidates.end());
+
+   // The minimal cut sets that contain each variable.
+   std::vector<std::vector<std::uint32_t>> occurrences(graph_.num_variables());
+   std::vector<int> counts;  // The matched variables of the minimal cut sets.
+   std::vector<std::uint32_t> touched;
+   for (std::span<const int> candidate : candidates) {
+       bool subsumed = candidate.empty() && products_.size();
+       for (int variable : candidate) {
+           for (std::uint32_t product : occurrences[variable]) {
+               touched.push_back(product);
+               if (++counts[product] == static_cast<int>(products_[product].size()))
+                   subsumed = true;
+           }
+           if (subsumed)
+               break;
+       }
+       for (std::uint32_t product : touched)
+           counts[product] = 0;
+       touched.clear();
+       if (subsumed)
+           continue;
+       if (candidate.empty()) {  // The certain top event subsumes everything.
+           products_.Add(candidate);
+           break;
+       }
+       for (int variable : candidate)
+           occurrences[variable].push_back(products_.size());
+       products_.Add(candidate);
+       counts.push_back(0);
+   }
+   arenas_.clear();
+}
+
+double Mocus::p(std::span<const int> product) const {
+   double result = 1;
+   for (int variable : product)
+       result *= p_vars_[variable];
+   return result;
+}
+
+double Mocus::RareEvent() const {
+   double sum = 0;
+   for (std::size_t i = 0; i < products_.size(); ++i)
+       sum += p(products_[i]);
+   return sum;
+}
+
+double Mocus::Mcub() const {
+   double complement = 1;
+   for (std::size_t i = 0; i < products_.size(); ++i)
+       complement *= 1 - p(products_[i]);
+   return 1 - complement;
+}
+
+}  // namespace canopy::core
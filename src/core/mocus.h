@@ -0,0 +1,127 @@
+/// @file
+/// Top-down minimal cut set generation with the MOCUS algorithm.
+
+#pragma once
+
+#include <cstdint>
+
+#include <span>
+#include <vector>
+
+#include "core/pdag.h"
+#include "core/thread_pool.h"
+#include "mef/openpsa/settings.h"
+
+namespace canopy::core {
+
+/// Contiguous storage of products as sorted variable id sequences.
+class ProductArena {
+ public:
+   /// @returns The number of products.
+   std::size_t size() const { return offsets_.size() - 1; }
+
+   /// @returns The variable ids of the product in ascending order.
+   std::span<const int> operator[](std::size_t index) const {
+       return {literals_.data() + offsets_[index], offsets_[index + 1] - offsets_[index]};
+   }
+
+   /// Appends the product to the arena.
+   void Add(std::span<const int> product) {
+       literals_.insert(literals_.end(), product.begin(), product.end());
+       offsets_.push_back(literals_.size());
+   }
+
+ private:
+   std::vector<int> literals_;  ///< The products back to back.
+   std::vector<std::uint32_t> offsets_ = {0};  ///< The product boundaries.
+};
+
+/// Minimal cut set generation by the top-down expansion of gates
+/// (Method of Obtaining Cut Sets).
+///
+/// Partial cut sets hold variables and the gates yet to expand.
+/// Variables and AND gates extend the partial cut set in place,
+/// and only then the narrowest of OR, ATLEAST, and XOR gates branches it;
+/// the gates already satisfied by the variables are dropped without branching.
+/// The branches near the top of the graph are independent tasks
+/// on the work-stealing pool.
+/// Partial cut sets beyond the order limit or below the cut-off
+/// are dropped as soon as they appear.
+/// The complete cut sets of each worker go into its own arena
+/// and are minimized together at the end.
+///
+/// Complemented variables are treated as certain (Unity),
+/// so the results for non-coherent graphs are
+/// the minimal cut sets of their coherent approximation.
+class Mocus {
+ public:
+   /// Generates the minimal cut sets of the first graph root.
+   ///
+   /// @param[in] graph  The graph with the root.
+   /// @param[in] p_vars  The probabilities of the graph variables.
+   /// @param[in] settings  The limit order, the cut-off, and the number of threads.
+   Mocus(const Pdag& graph, std::span<const double> p_vars,
+         const mef::openpsa::Settings& settings);
+
+   /// @returns The minimal cut sets
+   ///          in the ascending order of their sizes.
+   const ProductArena& products() const { return products_; }
+
+   /// @returns The rare-event approximation of the top-event probability.
+   double RareEvent() const;
+
+   /// @returns The min cut upper bound of the top-event probability.
+   double Mcub() const;
+
+ private:
+   /// Partial cut set under the expansion.
+   struct CutSet {
+       std::vector<int> variables;  ///< The sorted variable ids.
+       std::vector<Pdag::Index> gates;  ///< The nodes to expand.
+       double p = 1;  ///< The probability of the variables.
+   };
+
+   /// Applies the complement of the gate to its connective and args.
+   ///
+   /// @param[in] gate  The signed index of the gate.
+   /// @param[out] args  The signed args of the gate without the complement.
+   /// @param[out] min_number  The vote number for ATLEAST gates.
+   ///
+   /// @returns The connective of the gate without the complement.
+   Connective Resolve(Pdag::Index gate, std::vector<Pdag::Index>* args,
+                      int* min_number) const;
+
+   /// @returns true if the cut set already satisfies the OR or ATLEAST gate.
+   bool IsSatisfied(Pdag::Index gate, const CutSet& cut_set) const;
+
+   /// Expands the partial cut set into complete cut sets.
+   ///
+   /// @param[in] cut_set  The partial cut set.
+   /// @param[in] depth  The number of branchings above the cut set.
+   void Expand(CutSet cut_set, int depth);
+
+   /// Branches the cut set into new cut sets for each group of nodes.
+   /// The first branch continues in the cut set.
+   ///
+   /// @param[in] branches  The nodes to add to the branches.
+   /// @param[in,out] cut_set  The partial cut set to branch.
+   /// @param[in] depth  The number of branchings above the cut set.
+   void Branch(const std::vector<std::vector<Pdag::Index>>& branches, CutSet* cut_set,
+               int depth);
+
+   /// @returns The probability of the product.
+   double p(std::span<const int> product) const;
+
+   /// Removes duplicates and supersets from the complete cut sets.
+   void Minimize();
+
+   const Pdag& graph_;  ///< The graph under the analysis.
+   std::vector<double> p_vars_;  ///< The variable probabilities.
+   int limit_order_;  ///< The max number of variables in cut sets.
+   double cut_off_;  ///< The min probability of cut sets.
+   ThreadPool* pool_ = nullptr;  ///< The workers during the expansion.
+   std::vector<ProductArena> arenas_;  ///< Per-worker complete cut sets.
+   ProductArena products_;  ///< The minimal cut sets.
+};
+
+}  // namespace canopy::core
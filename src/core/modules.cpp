@@ -0,0 +1,312 @@
+/// @file
+/// Implementation of the modular decomposition and quantification.
+
+#include "core/modules.h"
+
+#include <cassert>
+#include <cstdlib>
+
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+
+#include "core/thread_pool.h"
+#include "core/variable_ordering.h"
+#include "mef/openpsa/expr/constant.h"
+
+namespace canopy::core {
+
+namespace {
+
+/// The min number of nodes in a module for its own BDD;
+/// smaller modules are cheaper to convert inside their parents.
+constexpr std::size_t kMinModuleSize = 32;
+
+}  // namespace
+
+std::vector<bool> FindModules(const Pdag& graph) {
+   using Index = Pdag::Index;
+   // The visit times of the nodes; 0 for unvisited nodes.
+   std::vector<int> enter_time(graph.size(), 0);
+   std::vector<int> exit_time(graph.size(), 0);
+   std::vector<int> last_time(graph.size(), 0);
+   int time = 0;
+   std::vector<std::pair<Index, std::size_t>> stack;  // The gates and their next args.
+   auto visit = [&](Index index) {
+       if (enter_time[index]) {
+           last_time[index] = ++time;
+           return;
+       }
+       enter_time[index] = ++time;
+       if (graph.IsGate(index))
+           stack.emplace_back(index, 0);
+       else
+           exit_time[index] = enter_time[index];
+   };
+   for (Index root : graph.roots()) {
+       visit(std::abs(root));
+       while (!stack.empty()) {
+           auto& [gate, position] = stack.back();
+           std::span<const Index> args = graph.args(gate);
+           if (position == args.size()) {
+               exit_time[gate] = ++time;
+               stack.pop_back();
+               continue;
+           }
+           visit(std::abs(args[position++]));
+       }
+   }
+
+   // The earliest and the latest visits of the descendants
+   // are collected bottom-up in the node order.
+   std::vector<int> min_time(graph.size(), 0);
+   std::vector<int> max_time(graph.size(), 0);
+   std::vector<bool> modules(graph.size(), false);
+   for (Index index = 1; index < static_cast<Index>(graph.size()); ++index) {
+       if (!enter_time[index])
+           continue;
+       last_time[index] = std::max(last_time[index], exit_time[index]);
+       if (!graph.IsGate(index)) {
+           min_time[index] = enter_time[index];
+           max_time[index] = last_time[index];
+           continue;
+       }
+       int min_visit = time;
+       int max_visit = 0;
+       for (Index arg : graph.args(index)) {
+           min_visit = std::min({min_visit, enter_time[std::abs(arg)], min_time[std::abs(arg)]});
+           max_visit = std::max({max_visit, last_time[std::abs(arg)], max_time[std::abs(arg)]});
+       }
+       min_time[index] = min_visit;
+       max_time[index] = max_visit;
+       modules[index] = enter_time[index] < min_visit && max_visit < exit_time[index];
+   }
+   return modules;
+}
+
+ModularBdd::ModularBdd(const Pdag& graph, const mef::openpsa::Settings& settings)
+    : num_variables_(graph.num_variables()) {
+   using Index = Pdag::Index;
+   assert(!graph.roots().empty() && "The graph without roots.");
+   std::vector<bool> modules = FindModules(graph);
+   std::vector<bool> roots(graph.size(), false);
+   Index max_root = 0;
+   for (Index root : graph.roots()) {
+       roots[std::abs(root)] = true;
+       max_root = std::max(max_root, std::abs(root));
+   }
+   // The modules follow the order of the whole graph
+   // with the pseudo-variables at the first variables of their modules.
+   std::vector<int> ranks(graph.num_variables());
+   std::vector<int> order = OrderVariables(graph, settings);
+   for (int rank = 0; rank < static_cast<int>(order.size()); ++rank)
+       ranks[order[rank]] = rank;
+   std::vector<int> module_ranks;
+   std::vector<std::vector<int>> orders;
+   std::vector<int> positions(graph.size(), -1);  // The separated modules and roots.
+   // Only the modules are substituted with pseudo-variables;
+   // the roots dependent on other roots are expanded in their parents.
+   auto is_separated = [&positions, &modules](Index node) {
+       return positions[node] >= 0 && modules[node];
+   };
+   std::vector<Index> visited(graph.size(), 0);  // The last module of the visit.
+   std::vector<Index> part;
+   std::vector<Index> stack;
+   for (Index index = 1; index <= max_root; ++index) {
+       if (!roots[index] && (!modules[index] || !graph.IsGate(index)))
+           continue;
+       // The nodes of the module apart from its separated child modules.
+       part = {index};
+       stack = {index};
+       visited[index] = index;
+       while (!stack.empty()) {
+           Index gate = stack.back();
+           stack.pop_back();
+           if (!graph.IsGate(gate) || (gate != index && is_separated(gate)))
+               continue;
+           for (Index arg : graph.args(gate)) {
+               if (visited[std::abs(arg)] == index)
+                   continue;
+               visited[std::abs(arg)] = index;
+               part.push_back(std::abs(arg));
+               stack.push_back(std::abs(arg));
+           }
+       }
+       if (!roots[index] && part.size() < kMinModuleSize)
+           continue;
+
+       positions[index] = modules_.size();
+       Module& module = modules_.emplace_back();
+       std::sort(part.begin(), part.end());
+       std::unordered_map<Index, Index> nodes;  // The module nodes by graph nodes.
+       auto get_node = [&nodes](Index arg) {
+           Index node = nodes.at(std::abs(arg));
+           return arg < 0 ? -node : node;
+       };
+       for (Index node : part) {
+           if (graph.IsConstant(node)) {
+               nodes.emplace(node, Pdag::kTrue);
+           } else if (graph.IsVariable(node)) {
+               int variable = graph.variable(node);
+               nodes.emplace(node, module.graph.AddVariable(graph.expression(variable)));
+               module.variables.push_back(variable);
+           } else if (node != index && is_separated(node)) {
+               // The probability is substituted upon the quantification.
+               nodes.emplace(node,
+                             module.graph.AddVariable(mef::openpsa::ConstantExpression::kOne));
+               module.variables.push_back(~positions[node]);
+           } else {
+               const Pdag::Node& record = graph.node(node);
+               std::vector<Index> args;
+               for (Index arg : graph.args(node))
+                   args.push_back(get_node(arg));
+               nodes.emplace(node,
+                             module.graph.AddGate(record.connective, std::move(args),
+                                                  record.min_number));
+           }
+       }
+       module.graph.AddRoot(get_node(index));
+
+       std::vector<int> module_order(module.variables.size());
+       std::vector<int> variable_ranks;
+       for (int variable : module.variables)
+           variable_ranks.push_back(variable < 0 ? module_ranks[~variable] : ranks[variable]);
+       std::iota(module_order.begin(), module_order.end(), 0);
+       std::sort(module_order.begin(), module_order.end(), [&variable_ranks](int lhs, int rhs) {
+           return variable_ranks[lhs] < variable_ranks[rhs];
+       });
+       module_ranks.push_back(variable_ranks.empty() ? 0 : variable_ranks[module_order.front()]);
+       orders.push_back(std::move(module_order));
+   }
+   for (Index root : graph.roots())
+       roots_.push_back({positions[std::abs(root)], root < 0});
+
+   ThreadPool pool(settings.num_threads());
+   for (std::size_t i = 0; i < modules_.size(); ++i) {
+       pool.Submit([&module = modules_[i], &order = orders[i], &settings] {
+           module.bdd = std::make_unique<Bdd>(module.graph, std::move(order),
+                                              settings.reorder_threshold());
+           module.vertices = module.bdd->Collect(module.bdd->roots().front());
+       });
+   }
+   pool.Wait();
+
+   std::size_t max_variables = 0;
+   std::size_t max_vertices = 0;
+   for (const Module& module : modules_) {
+       max_variables = std::max(max_variables, module.variables.size());
+       max_vertices = std::max(max_vertices, module.bdd->size());
+   }
+   scratch_size_ = modules_.size() + max_variables + max_vertices;
+}
+
+std::size_t ModularBdd::size() const {
+   std::size_t result = 0;
+   for (const Module& module : modules_)
+       result += module.bdd->size();
+   return result;
+}
+
+std::vector<int> ModularBdd::order() const {
+   std::vector<int> result;
+   std::vector<bool> expanded(modules_.size(), false);
+   std::vector<bool> listed(num_variables_, false);  // The roots may share variables.
+   auto expand = [this, &result, &expanded, &listed](auto& self, int position) -> void {
+       if (expanded[position])
+           return;
+       expanded[position] = true;
+       const Module& module = modules_[position];
+       for (int variable : module.bdd->order()) {
+           int id = module.variables[variable];
+           if (id < 0) {
+               self(self, ~id);
+               continue;
+           }
+           if (listed[id])
+               continue;
+           listed[id] = true;
+           result.push_back(id);
+       }
+   };
+   for (const Root& root : roots_)
+       expand(expand, root.module);
+   for (int variable = 0; variable < num_variables_; ++variable) {
+       if (!listed[variable])
+           result.push_back(variable);
+   }
+   return result;
+}
+
+double ModularBdd::Probability(std::span<const double> p,
+                               std::vector<double>* scratch) const {
+   const Root& root = roots_.front();
+   double value = Quantify(root.module + 1, p, scratch)[root.module];
+   return root.complement ? 1 - value : value;
+}
+
+std::vector<double> ModularBdd::Probabilities(std::span<const double> p) const {
+   std::vector<double> scratch;
+   std::span<const double> p_modules = Quantify(modules_.size(), p, &scratch);
+   std::vector<double> result;
+   for (const Root& root : roots_)
+       result.push_back(root.complement ? 1 - p_modules[root.module] : p_modules[root.module]);
+   return result;
+}
+
+std::vector<double> ModularBdd::Derivatives(std::span<const double> p) const {
+   const Root& root = roots_.front();
+   std::vector<double> scratch;
+   std::span<const double> p_modules = Quantify(root.module + 1, p, &scratch);
+   std::vector<double> derivatives(p.size(), 0);
+   // The sensitivity of the root probability to the module probabilities.
+   std::vector<double> gradients(root.module + 1, 0);
+   gradients[root.module] = root.complement ? -1 : 1;
+   for (int i = root.module; i >= 0; --i) {
+       if (gradients[i] == 0)
+           continue;
+       const Module& module = modules_[i];
+       std::vector<double> module_derivatives = module.bdd->Derivatives(
+           module.bdd->roots().front(), GetVariableProbabilities(module, p, p_modules));
+       for (std::size_t j = 0; j < module.variables.size(); ++j) {
+           int variable = module.variables[j];
+           double derivative = gradients[i] * module_derivatives[j];
+           if (variable < 0)
+               gradients[~variable] += derivative;
+           else
+               derivatives[variable] += derivative;
+       }
+   }
+   return derivatives;
+}
+
+std::span<const double> ModularBdd::Quantify(std::size_t num_modules,
+                                             std::span<const double> p,
+                                             std::vector<double>* scratch) const {
+   scratch->resize(scratch_size_);
+   std::span<double> storage(*scratch);
+   std::span<double> p_modules = storage.first(modules_.size());
+   storage = storage.subspan(modules_.size());
+   for (std::size_t i = 0; i < num_modules; ++i) {
+       const Module& module = modules_[i];
+       std::span<double> p_vars = storage.first(module.variables.size());
+       for (std::size_t j = 0; j < module.variables.size(); ++j) {
+           int variable = module.variables[j];
+           p_vars[j] = variable < 0 ? p_modules[~variable] : p[variable];
+       }
+       p_modules[i] = module.bdd->Probability(module.bdd->roots().front(), module.vertices,
+                                              p_vars,
+                                              storage.subspan(module.variables.size()));
+   }
+   return p_modules;
+}
+
+std::vector<double> ModularBdd::GetVariableProbabilities(
+    const Module& module, std::span<const double> p, std::span<const double> p_modules) const {
+   std::vector<double> p_vars;
+   for (int variable : module.variables)
+       p_vars.push_back(variable < 0 ? p_modules[~variable] : p[variable]);
+   return p_vars;
+}
+
+}  // namespace canopy::core
@@ -0,0 +1,148 @@
+/// @file
+/// Modular decomposition of the PDAG and its modular quantification.
+
+#pragma once
+
+#include <cstdint>
+
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "core/bdd.h"
+#include "core/pdag.h"
+#include "mef/openpsa/settings.h"
+
+namespace canopy::core {
+
+/// Finds the modules of the graph,
+/// i.e., the gates whose sub-graphs share no nodes with the rest of the graph,
+/// with the linear-time algorithm of Dutuit and Rauzy.
+///
+/// The graph is visited depth-first from the roots
+/// with the times of the first, the last, and the exit visits of every node.
+/// A gate is a module if all its descendants are first visited
+/// after the gate and last visited before the exit from the gate.
+///
+/// @param[in] graph  The graph with the roots.
+///
+/// @returns The flags of the module gates by node indices;
+///          the roots are modules only if independent of each other.
+std::vector<bool> FindModules(const Pdag& graph);
+
+/// Exact quantification of the graph roots module by module.
+///
+/// Every root and every module large enough for the separation
+/// becomes its own graph
+/// with its child modules replaced by single pseudo-variables,
+/// and the BDDs of the modules are built independently on the thread pool.
+/// The smaller modules stay inside their parents.
+/// The variables of every module follow the order of the whole graph
+/// with the pseudo-variables in place of the first variables of their modules.
+/// The module probabilities are computed bottom-up
+/// and substituted for the pseudo-variables of the parents,
+/// which is exact because the modules are independent.
+/// The derivatives follow the chain rule top-down
+/// through the pseudo-variables.
+///
+/// The BDD of each module only depends on its own variables,
+/// so the diagrams stay small for highly modular fault trees.
+///
+/// @note The ZBDD and MOCUS products are generated over the whole graph
+///       since their cut-off pruning needs the probabilities of whole products,
+///       which are unknown for the products of pseudo-variables.
+class ModularBdd {
+ public:
+   /// Decomposes and converts all the graph roots.
+   ///
+   /// @param[in] graph  The graph with the roots.
+   /// @param[in] settings  The number of threads and the variable ordering.
+   ModularBdd(const Pdag& graph, const mef::openpsa::Settings& settings);
+
+   /// @returns The number of the separated modules including the roots.
+   int num_modules() const { return modules_.size(); }
+
+   /// @returns The total number of BDD vertices over the modules.
+   std::size_t size() const;
+
+   /// @returns The graph variable ids in the order of the module BDD levels
+   ///          after the dynamic reordering if any,
+   ///          with the child modules expanded in place of their pseudo-variables
+   ///          starting from the root modules,
+   ///          and the variables outside the roots last.
+   std::vector<int> order() const;
+
+   /// Computes the exact probability of the first root.
+   ///
+   /// @param[in] p  The probabilities of the graph variables by variable ids.
+   ///
+   /// @returns The probability of the root function to be true.
+   double Probability(std::span<const double> p) const {
+       std::vector<double> scratch;
+       return Probability(p, &scratch);
+   }
+
+   /// Computes the exact probability of the first root with the scratch storage
+   /// for repeated and concurrent quantification.
+   ///
+   /// @param[in] p  The probabilities of the graph variables by variable ids.
+   /// @param[in,out] scratch  The storage for the module and vertex probabilities.
+   ///
+   /// @returns The probability of the root function to be true.
+   double Probability(std::span<const double> p, std::vector<double>* scratch) const;
+
+   /// Computes the exact probabilities of all the roots
+   /// with the modules shared by the roots quantified once.
+   ///
+   /// @param[in] p  The probabilities of the graph variables by variable ids.
+   ///
+   /// @returns The probabilities of the roots in the same order.
+   std::vector<double> Probabilities(std::span<const double> p) const;
+
+   /// Computes the partial derivatives of the first root probability
+   /// by the variable probabilities (the Birnbaum importance).
+   ///
+   /// @param[in] p  The probabilities of the graph variables by variable ids.
+   ///
+   /// @returns The derivatives indexed by variable ids.
+   std::vector<double> Derivatives(std::span<const double> p) const;
+
+ private:
+   /// The separated module.
+   struct Module {
+       Pdag graph;  ///< The module with pseudo-variables for its child modules.
+       /// The graph variable ids by the module variable ids;
+       /// the complements of the child module positions for pseudo-variables.
+       std::vector<int> variables;
+       std::unique_ptr<Bdd> bdd;  ///< The diagram of the module.
+       std::vector<std::uint32_t> vertices;  ///< The vertices of the diagram.
+   };
+
+   /// The root of the graph.
+   struct Root {
+       int module;  ///< The position of the root module.
+       bool complement;  ///< The complement of the module function.
+   };
+
+   /// Computes the module probabilities bottom-up.
+   ///
+   /// @param[in] num_modules  The number of the first modules to quantify.
+   /// @param[in] p  The probabilities of the graph variables by variable ids.
+   /// @param[in,out] scratch  The storage for the module and vertex probabilities.
+   ///
+   /// @returns The probabilities of the modules by their positions.
+   std::span<const double> Quantify(std::size_t num_modules, std::span<const double> p,
+                                    std::vector<double>* scratch) const;
+
+   /// @returns The probabilities of the module variables.
+   std::vector<double> GetVariableProbabilities(const Module& module,
+                                                std::span<const double> p,
+                                                std::span<const double> p_modules) const;
+
+   std::vector<Module> modules_;  ///< The modules after their child modules.
+   std::vector<Root> roots_;  ///< The modules of the graph roots.
+   std::size_t scratch_size_ = 0;  ///< The storage for the quantification.
+   int num_variables_ = 0;  ///< The number of the graph variables.
+};
+
+}  // namespace canopy::core
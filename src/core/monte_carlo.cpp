@@ -0,0 +1,190 @@
+/// @file
+/// Implementation of the bit-parallel Monte Carlo simulation.
+
+#include "core/monte_carlo.h"
+
+#include <cassert>
+#include <cmath>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <limits>
+
+#include "core/thread_pool.h"
+#include "mef/openpsa/random_stream.h"
+
+namespace canopy::core {
+
+namespace {
+
+/// The stream ids of the variable states
+/// apart from the stream ids of random deviates.
+constexpr std::uint32_t kStateStreams = 1u << 31;
+
+/// The number of trials in a word.
+constexpr int kWordBits = 64;
+
+}  // namespace
+
+MonteCarlo::MonteCarlo(const Pdag& graph, std::span<const double> p_vars,
+                       const mef::openpsa::Settings& settings)
+    : graph_(graph),
+      rows_(graph.size(), -1),
+      seed_(settings.seed()),
+      batch_size_(std::max(settings.batch_size(), 1)),
+      num_trials_(std::max(settings.num_trials(), 0)) {
+   assert(!graph.roots().empty() && "The graph without roots.");
+   assert(static_cast<int>(p_vars.size()) == graph.num_variables());
+   std::vector<bool> reachable = graph.Reachable();
+   for (Pdag::Index index = 1; index < static_cast<Pdag::Index>(graph.size()); ++index) {
+       if (!reachable[index])
+           continue;
+       rows_[index] = nodes_.size();
+       nodes_.push_back(index);
+   }
+   // The 64-bit uniform draws below the threshold are failures,
+   // and the maximum threshold marks the certain failures.
+   for (double p : p_vars) {
+       thresholds_.push_back(
+           p >= 1 ? std::numeric_limits<std::uint64_t>::max()
+                  : static_cast<std::uint64_t>(std::nearbyint(std::ldexp(std::max(p, 0.0), 64))));
+   }
+
+   std::int64_t num_words = (num_trials_ + kWordBits - 1) / kWordBits;
+   std::int64_t num_batches = (num_words + batch_size_ - 1) / batch_size_;
+   if (!num_batches)
+       return;
+   ThreadPool pool(settings.num_threads());
+   std::atomic<std::int64_t> next_batch = 0;
+   std::atomic<std::int64_t> num_failures = 0;
+   int num_tasks = std::min<std::int64_t>(pool.size() + 1, num_batches);
+   for (int i = 0; i < num_tasks; ++i) {
+       pool.Submit([&, this] {
+           std::vector<Word> values(nodes_.size() * batch_size_);
+           std::int64_t count = 0;
+           for (std::int64_t batch; (batch = next_batch++) < num_batches;) {
+               std::int64_t first_word = batch * batch_size_;
+               count += Simulate(first_word,
+                                 std::min<std::int64_t>(batch_size_, num_words - first_word),
+                                 &values);
+           }
+           num_failures += count;
+       });
+   }
+   pool.Wait();
+   num_failures_ = num_failures;
+}
+
+double MonteCarlo::standard_error() const {
+   if (!num_trials_)
+       return 0;
+   double p = p_total();
+   return std::sqrt(p * (1 - p) / num_trials_);
+}
+
+std::int64_t MonteCarlo::Simulate(std::int64_t first_word, int num_words,
+                                  std::vector<Word>* values) const {
+   auto row = [values, num_words, this](Pdag::Index index) {
+       assert(rows_[std::abs(index)] >= 0);
+       return values->data() + rows_[std::abs(index)] * num_words;
+   };
+   // The complements of args are applied with the XOR mask.
+   auto mask = [](Pdag::Index index) { return index < 0 ? ~Word(0) : Word(0); };
+   std::vector<Word> counters;
+   for (Pdag::Index index : nodes_) {
+       Word* result = row(index);
+       const Pdag::Node& node = graph_.node(index);
+       switch (node.kind) {
+       case Pdag::NodeKind::kConstant:
+           std::fill_n(result, num_words, ~Word(0));
+           break;
+       case Pdag::NodeKind::kVariable:
+           for (int i = 0; i < num_words; ++i)
+               result[i] = Sample(node.first, first_word + i);
+           break;
+       case Pdag::NodeKind::kGate: {
+           std::span<const Pdag::Index> args = graph_.args(index);
+           const Word* first = row(args.front());
+           Word first_mask = mask(args.front());
+           switch (node.connective) {
+           case Connective::kAnd:
+           case Connective::kOr:
+           case Connective::kXor:
+               for (int i = 0; i < num_words; ++i)
+                   result[i] = first[i] ^ first_mask;
+               for (Pdag::Index arg : args.subspan(1)) {
+                   const Word* value = row(arg);
+                   Word arg_mask = mask(arg);
+                   if (node.connective == Connective::kAnd) {
+                       for (int i = 0; i < num_words; ++i)
+                           result[i] &= value[i] ^ arg_mask;
+                   } else if (node.connective == Connective::kOr) {
+                       for (int i = 0; i < num_words; ++i)
+                           result[i] |= value[i] ^ arg_mask;
+                   } else {
+                       for (int i = 0; i < num_words; ++i)
+                           result[i] ^= value[i] ^ arg_mask;
+                   }
+               }
+               break;
+           case Connective::kAtleast: {
+               // The bit-sliced counters of "at least j + 1 args are true".
+               int min_number = node.min_number;
+               counters.assign(min_number * num_words, 0);
+               for (Pdag::Index arg : args) {
+                   const Word* value = row(arg);
+                   Word arg_mask = mask(arg);
+                   for (int j = min_number - 1; j > 0; --j) {
+                       Word* counter = counters.data() + j * num_words;
+                       const Word* lower = counter - num_words;
+                       for (int i = 0; i < num_words; ++i)
+                           counter[i] |= lower[i] & (value[i] ^ arg_mask);
+                   }
+                   for (int i = 0; i < num_words; ++i)
+                       counters[i] |= value[i] ^ arg_mask;
+               }
+               std::copy_n(counters.data() + (min_number - 1) * num_words, num_words,
+                           result);
+               break;
+           }
+           default:
+               assert(false && "Unexpected connective in the PDAG.");
+           }
+           break;
+       }
+       }
+   }
+
+   Pdag::Index root = graph_.roots().front();
+   const Word* top = row(root);
+   Word root_mask = mask(root);
+   std::int64_t count = 0;
+   for (int i = 0; i < num_words; ++i) {
+       std::int64_t num_left = num_trials_ - (first_word + i) * kWordBits;
+       Word valid = num_left >= kWordBits ? ~Word(0) : (Word(1) << num_left) - 1;
+       count += std::popcount((top[i] ^ root_mask) & valid);
+   }
+   return count;
+}
+
+MonteCarlo::Word MonteCarlo::Sample(int variable, std::int64_t word) const {
+   std::uint64_t threshold = thresholds_[variable];
+   if (threshold == 0)
+       return 0;
+   if (threshold == std::numeric_limits<std::uint64_t>::max())
+       return ~Word(0);
+   auto high = static_cast<std::uint32_t>(threshold >> 32);
+   auto low = static_cast<std::uint32_t>(threshold);
+   mef::openpsa::RandomStream rng(seed_, word, kStateStreams | variable);
+   Word states = 0;
+   for (int bit = 0; bit < kWordBits; ++bit) {
+       // The low half of the 64-bit draw is only needed on the ties of the high halves.
+       std::uint32_t draw = rng();
+       bool failed = draw < high || (draw == high && rng() < low);
+       states |= static_cast<Word>(failed) << bit;
+   }
+   return states;
+}
+
+}  // namespace canopy::core
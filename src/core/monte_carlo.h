@@ -0,0 +1,87 @@
+/// @file
+/// Bit-parallel Monte Carlo simulation of the top-event probability.
+
+#pragma once
+
+#include <cstdint>
+
+#include <span>
+#include <vector>
+
+#include "core/pdag.h"
+#include "mef/openpsa/settings.h"
+
+namespace canopy::core {
+
+/// Direct simulation of the graph with 64 trials per machine word.
+///
+/// Each bit of a word is the state of a node in one trial.
+/// The variable words are sampled from their probabilities,
+/// and the gates are evaluated in the node order
+/// with bitwise AND, OR, XOR, and bit-sliced ATLEAST kernels,
+/// taking the complements of args with NOT.
+/// The failures of the root are counted with popcount.
+///
+/// The graph is swept for batches of batch_size words at once;
+/// the batches are independent tasks on the thread pool.
+/// The variable states come from counter-based random streams
+/// addressed by the seed, the word, and the variable,
+/// so the estimate does not depend on the batching or the number of threads.
+/// Non-coherent graphs are simulated exactly.
+class MonteCarlo {
+ public:
+   /// Simulates the first graph root.
+   ///
+   /// @param[in] graph  The graph with the root.
+   /// @param[in] p_vars  The probabilities of the graph variables.
+   /// @param[in] settings  The number of trials, the batch size,
+   ///                      the seed, and the number of threads.
+   MonteCarlo(const Pdag& graph, std::span<const double> p_vars,
+              const mef::openpsa::Settings& settings);
+
+   /// @returns The number of simulated trials.
+   std::int64_t num_trials() const { return num_trials_; }
+
+   /// @returns The number of trials with the root failure.
+   std::int64_t num_failures() const { return num_failures_; }
+
+   /// @returns The estimate of the root probability.
+   double p_total() const {
+       return num_trials_ ? static_cast<double>(num_failures_) / num_trials_ : 0;
+   }
+
+   /// @returns The standard error of the probability estimate.
+   double standard_error() const;
+
+ private:
+   using Word = std::uint64_t;  ///< The states of a node in 64 trials.
+
+   /// Simulates consecutive words of trials.
+   ///
+   /// @param[in] first_word  The global index of the first word.
+   /// @param[in] num_words  The number of words in the batch.
+   /// @param[in,out] values  The scratch rows of the node words.
+   ///
+   /// @returns The number of root failures in the words.
+   std::int64_t Simulate(std::int64_t first_word, int num_words,
+                         std::vector<Word>* values) const;
+
+   /// Samples the states of the variable in a word of trials.
+   ///
+   /// @param[in] variable  The variable id.
+   /// @param[in] word  The global index of the word.
+   ///
+   /// @returns The word with the failed trials set.
+   Word Sample(int variable, std::int64_t word) const;
+
+   const Pdag& graph_;  ///< The graph under the simulation.
+   std::vector<Pdag::Index> nodes_;  ///< The reachable nodes in the node order.
+   std::vector<int> rows_;  ///< The rows of the reachable nodes in the batch values.
+   std::vector<std::uint64_t> thresholds_;  ///< The variable probabilities scaled to 2^64.
+   std::uint64_t seed_;  ///< The seed of the random streams.
+   int batch_size_;  ///< The number of words per sweep.
+   std::int64_t num_trials_;  ///< The number of trials.
+   std::int64_t num_failures_ = 0;  ///< The number of root failures.
+};
+
+}  // namespace canopy::core
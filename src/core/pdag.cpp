@@ -0,0 +1,382 @@
+/// @file
+/// Implementation of the PDAG construction from MEF constructs.
+
+#include "core/pdag.h"
+
+#include <algorithm>
+#include <unordered_set>
+#include <variant>
+
+#include "mef/openpsa/algorithm.h"
+#include "mef/openpsa/expr/constant.h"
+#include "mef/openpsa/expr/numerical.h"
+
+namespace canopy::core {
+
+namespace {
+
+/// @returns The number of k-subsets of n elements.
+double Binomial(int n, int k) {
+   double result = 1;
+   for (int i = 1; i <= std::min(k, n - k); ++i)
+       result = result * (n - i + 1) / i;
+   return result;
+}
+
+}  // namespace
+
+Pdag::Pdag(bool ccf) : ccf_(ccf) {
+   nodes_.push_back({});  // The unused 0 index.
+   nodes_.push_back({NodeKind::kConstant, Connective::kNull, 0, 0, 0});
+}
+
+Pdag::Pdag(const mef::openpsa::FaultTree& fault_tree, bool ccf) : Pdag(ccf) {
+   if (ccf_) {
+       for (const mef::openpsa::Gate* top_event : fault_tree.top_events())
+           CollectCcfMembers(*top_event);
+   }
+   for (const mef::openpsa::Gate* top_event : fault_tree.top_events())
+       AddRoot(Add(*top_event));
+}
+
+Pdag::Pdag(const mef::openpsa::Gate& root, bool ccf) : Pdag(ccf) {
+   if (ccf_)
+       CollectCcfMembers(root);
+   AddRoot(Add(root));
+}
+
+Pdag::Index Pdag::Add(const mef::openpsa::Gate& gate) {
+   auto& gates = gates_[house_event_set_ && HasHouseEvents(gate) ? house_event_set_ : 0];
+   if (auto it = gates.find(&gate); it != gates.end())
+       return it->second;
+   Index index = Add(gate.formula());
+   gates.emplace(&gate, index);
+   return index;
+}
+
+bool Pdag::HasHouseEvents(const mef::openpsa::Gate& gate) {
+   if (auto it = house_gates_.find(&gate); it != house_gates_.end())
+       return it->second;
+   bool result = false;
+   for (const mef::openpsa::Formula::Arg& arg : gate.formula().args()) {
+       if (auto* child = std::get_if<mef::openpsa::Gate*>(&arg.event))
+           result = HasHouseEvents(**child);
+       else
+           result = std::holds_alternative<mef::openpsa::HouseEvent*>(arg.event);
+       if (result)
+           break;
+   }
+   house_gates_.emplace(&gate, result);
+   return result;
+}
+
+void Pdag::SetHouseEvents(std::vector<std::pair<mef::openpsa::Symbol, bool>> states) {
+   std::sort(states.begin(), states.end(), [](const auto& lhs, const auto& rhs) {
+       return lhs.first.id() < rhs.first.id();
+   });
+   auto it = std::find(house_event_sets_.begin(), house_event_sets_.end(), states);
+   house_event_set_ = it - house_event_sets_.begin();
+   if (it == house_event_sets_.end()) {
+       house_event_sets_.push_back(states);
+       gates_.emplace_back();
+   }
+   house_events_ = {states.begin(), states.end()};
+}
+
+Pdag::Index Pdag::Add(const mef::openpsa::BasicEvent& event) {
+   if (ccf_ && event.HasCcf())
+       return AddCcfMember(event);
+   if (auto it = basic_events_.find(&event); it != basic_events_.end())
+       return it->second;
+   Index index = NewVariable({.basic_event = &event,
+                              .expression = &event.expression(),
+                              .ccf_group = nullptr,
+                              .first_member = 0,
+                              .num_members = 0});
+   basic_events_.emplace(&event, index);
+   return index;
+}
+
+std::string Pdag::name(int variable) const {
+   const Variable& record = variables_[variable];
+   if (record.basic_event)
+       return record.basic_event->id();
+   if (!record.ccf_group)
+       return "";
+   return record.ccf_group->CcfEventName(ccf_members(variable));
+}
+
+void Pdag::CollectCcfMembers(const mef::openpsa::Gate& gate) {
+   std::unordered_set<const mef::openpsa::Gate*> visited = {&gate};
+   std::vector<const mef::openpsa::Gate*> stack = {&gate};
+   while (!stack.empty()) {
+       const mef::openpsa::Gate* next = stack.back();
+       stack.pop_back();
+       for (const mef::openpsa::Formula::Arg& arg : next->formula().args()) {
+           if (auto* child = std::get_if<mef::openpsa::Gate*>(&arg.event)) {
+               if (visited.insert(*child).second)
+                   stack.push_back(*child);
+           } else if (auto* event = std::get_if<mef::openpsa::BasicEvent*>(&arg.event)) {
+               if (!(*event)->HasCcf())
+                   continue;
+               const mef::openpsa::CcfGroup& group = (*event)->ccf_group();
+               CcfSubstitution& substitution = ccf_groups_[&group];
+               substitution.present.resize(group.members().size());
+               substitution.present[group.member_index(**event)] = true;
+           }
+       }
+   }
+}
+
+Pdag::Index Pdag::AddCcfMember(const mef::openpsa::BasicEvent& event) {
+   const mef::openpsa::CcfGroup& group = event.ccf_group();
+   int num_members = group.members().size();
+   CcfSubstitution& substitution = ccf_groups_[&group];
+   if (substitution.present.empty())  // Added without the collection.
+       substitution.present.assign(num_members, true);
+   assert(substitution.present[group.member_index(event)] &&
+          "The CCF group member is outside the collected graph.");
+   if (!substitution.members.empty())
+       return substitution.members[group.member_index(event)];
+
+   std::vector<int> present;
+   for (int i = 0; i < num_members; ++i) {
+       if (substitution.present[i])
+           present.push_back(i);
+   }
+   int num_present = present.size();
+   int max_level = std::min(num_present, group.probabilities().back().first);
+   std::vector<std::vector<Index>> member_args(num_members);
+   for (int level = 1; level <= max_level; ++level) {
+       mef::openpsa::Expression* p = CcfProbability(group, num_present, level);
+       if (!p)
+           continue;
+       mef::openpsa::for_each_combination(
+           present.begin(), std::next(present.begin(), level), present.end(),
+           [&](auto first, auto last) {
+               auto offset = ccf_members_.size();
+               ccf_members_.insert(ccf_members_.end(), first, last);
+               std::sort(std::next(ccf_members_.begin(), offset), ccf_members_.end());
+               Index index = NewVariable({.basic_event = nullptr,
+                                          .expression = p,
+                                          .ccf_group = &group,
+                                          .first_member = static_cast<std::uint32_t>(offset),
+                                          .num_members = static_cast<std::uint32_t>(level)});
+               for (auto it = first; it != last; ++it)
+                   member_args[*it].push_back(index);
+               return false;
+           });
+   }
+   substitution.members.assign(num_members, kFalse);
+   for (int member : present) {
+       if (!member_args[member].empty())
+           substitution.members[member] = AddGate(Connective::kOr, member_args[member]);
+   }
+   return substitution.members[group.member_index(event)];
+}
+
+mef::openpsa::Expression* Pdag::CcfProbability(const mef::openpsa::CcfGroup& group,
+                                               int num_present, int num_members) {
+   using mef::openpsa::ConstantExpression;
+   using mef::openpsa::Expression;
+   int num_absent = group.members().size() - num_present;
+   // The CCF events with the same members in the graph and any absent members.
+   std::vector<std::pair<Expression*, double>> events;
+   for (const std::pair<int, Expression*>& level_probability : group.probabilities()) {
+       int num_extra = level_probability.first - num_members;
+       if (num_extra >= 0 && num_extra <= num_absent)
+           events.emplace_back(level_probability.second, Binomial(num_absent, num_extra));
+   }
+   if (events.empty())
+       return nullptr;
+   if (events.size() == 1 && events.front().second == 1)
+       return events.front().first;
+
+   auto own = [this](std::unique_ptr<Expression> expression) {
+       expressions_.push_back(std::move(expression));
+       return expressions_.back().get();
+   };
+   std::vector<Expression*> factors;  // The probabilities of no events.
+   for (const std::pair<Expression*, double>& event : events) {
+       Expression* q = own(std::make_unique<mef::openpsa::Sub>(
+           std::vector<Expression*>{&ConstantExpression::kOne, event.first}));
+       if (event.second != 1) {
+           q = own(std::make_unique<mef::openpsa::Pow>(
+               q, own(std::make_unique<ConstantExpression>(event.second))));
+       }
+       factors.push_back(q);
+   }
+   Expression* none = factors.size() == 1
+                          ? factors.front()
+                          : own(std::make_unique<mef::openpsa::Mul>(std::move(factors)));
+   return own(std::make_unique<mef::openpsa::Sub>(
+       std::vector<Expression*>{&ConstantExpression::kOne, none}));
+}
+
+Pdag::Index Pdag::NewVariable(Variable variable) {
+   Index index = nodes_.size();
+   nodes_.push_back({NodeKind::kVariable, Connective::kNull, 0,
+                     static_cast<std::uint32_t>(variables_.size()), 0});
+   variable.node = index;
+   variables_.push_back(variable);
+   return index;
+}
+
+Pdag::Index Pdag::Add(const mef::openpsa::HouseEvent& event) const {
+   auto it = house_events_.find(event.id_symbol());
+   bool state = it == house_events_.end() ? event.state() : it->second;
+   return state ? kTrue : kFalse;
+}
+
+Pdag::Index Pdag::Add(const mef::openpsa::Formula& formula) {
+   std::vector<Index> args;
+   for (const mef::openpsa::Formula::Arg& arg : formula.args()) {
+       Index index = std::visit([this](auto* event) { return Add(*event); }, arg.event);
+       args.push_back(arg.complement ? -index : index);
+   }
+   return AddGate(formula.connective(), std::move(args), formula.min_number().value_or(0),
+                  formula.max_number().value_or(0));
+}
+
+Pdag::Index Pdag::AddGate(Connective connective, std::vector<Index> args, int min_number,
+                          int max_number) {
+   assert(!args.empty() && "Gates without arguments.");
+   switch (connective) {
+   case Connective::kNull:
+       return args.front();
+   case Connective::kNot:
+       return -args.front();
+   case Connective::kAnd: {
+       int num_args = args.size();
+       return AddVoteGate(std::move(args), num_args);
+   }
+   case Connective::kOr:
+       return AddVoteGate(std::move(args), 1);
+   case Connective::kAtleast:
+       return AddVoteGate(std::move(args), min_number);
+   case Connective::kNand:
+       return -AddGate(Connective::kAnd, std::move(args));
+   case Connective::kNor:
+       return -AddGate(Connective::kOr, std::move(args));
+   case Connective::kXor: {
+       Index result = args.front();
+       for (auto it = std::next(args.begin()); it != args.end(); ++it)
+           result = AddXorGate(result, *it);
+       return result;
+   }
+   case Connective::kIff:
+       return -AddGate(Connective::kXor, std::move(args));
+   case Connective::kImply:
+       assert(args.size() == 2);
+       return AddVoteGate({-args.front(), args.back()}, 1);
+   case Connective::kCardinality: {
+       // At least min and at most max args are true.
+       Index upper = AddVoteGate(args, max_number + 1);
+       Index lower = AddVoteGate(std::move(args), min_number);
+       return AddVoteGate({lower, -upper}, 2);
+   }
+   }
+   assert(false && "Unexpected connective.");
+   return kFalse;
+}
+
+Pdag::Index Pdag::AddVoteGate(std::vector<Index> args, int min_number) {
+   // The vote number is evaluated before the args are reduced,
+   // for the reductions below preserve the AND/OR semantics
+   // but not the relation of the vote number to the number of args.
+   bool is_and = min_number == static_cast<int>(args.size());
+   bool is_or = min_number == 1;
+
+   std::erase_if(args, [&min_number](Index arg) {
+       if (arg == kTrue)
+           --min_number;
+       return arg == kTrue || arg == kFalse;
+   });
+   std::sort(args.begin(), args.end(), [](Index lhs, Index rhs) {
+       return std::abs(lhs) < std::abs(rhs) || (std::abs(lhs) == std::abs(rhs) && lhs < rhs);
+   });
+   if (is_and || is_or) {  // Idempotent args.
+       auto last = std::unique(args.begin(), args.end());
+       if (is_and)
+           min_number -= args.end() - last;
+       args.erase(last, args.end());
+   }
+
+   // Exactly one arg of each complementary pair is true.
+   std::vector<Index> reduced;
+   for (auto it = args.begin(); it != args.end();) {
+       auto positive = std::find_if(it, args.end(), [it](Index arg) {
+           return std::abs(arg) != std::abs(*it) || arg > 0;
+       });
+       auto end = std::find_if(positive, args.end(),
+                               [it](Index arg) { return std::abs(arg) != std::abs(*it); });
+       int num_negative = positive - it;
+       int num_positive = end - positive;
+       int num_pairs = std::min(num_negative, num_positive);
+       min_number -= num_pairs;
+       reduced.insert(reduced.end(), it, positive - num_pairs);
+       reduced.insert(reduced.end(), positive + num_pairs, end);
+       it = end;
+   }
+
+   if (min_number <= 0)
+       return kTrue;
+   if (min_number > static_cast<int>(reduced.size()))
+       return kFalse;
+   if (reduced.size() == 1)
+       return reduced.front();
+   if (min_number == static_cast<int>(reduced.size()))
+       return NewGate(Connective::kAnd, reduced, 0);
+   if (min_number == 1)
+       return NewGate(Connective::kOr, reduced, 0);
+   return NewGate(Connective::kAtleast, reduced, min_number);
+}
+
+Pdag::Index Pdag::AddXorGate(Index first, Index second) {
+   if (IsConstant(first))
+       return first == kTrue ? -second : second;
+   if (IsConstant(second))
+       return second == kTrue ? -first : first;
+   if (first == second)
+       return kFalse;
+   if (first == -second)
+       return kTrue;
+   // The complements of the args are moved onto the gate.
+   bool complement = (first < 0) != (second < 0);
+   Index gate = NewGate(Connective::kXor,
+                        {std::min(std::abs(first), std::abs(second)),
+                         std::max(std::abs(first), std::abs(second))},
+                        0);
+   return complement ? -gate : gate;
+}
+
+std::vector<bool> Pdag::Reachable() const {
+   std::vector<bool> reachable(nodes_.size(), false);
+   for (Index root : roots_)
+       reachable[std::abs(root)] = true;
+   // Gates follow their args in the node order.
+   for (Index index = nodes_.size() - 1; index > 0; --index) {
+       if (!reachable[index] || !IsGate(index))
+           continue;
+       for (Index arg : args(index))
+           reachable[std::abs(arg)] = true;
+   }
+   return reachable;
+}
+
+Pdag::Index Pdag::NewGate(Connective connective, const std::vector<Index>& args,
+                          int min_number) {
+   assert(args.size() > 1);
+   if (connective == Connective::kXor ||
+       std::any_of(args.begin(), args.end(), [](Index arg) { return arg < 0; })) {
+       coherent_ = false;
+   }
+   Index index = nodes_.size();
+   nodes_.push_back({NodeKind::kGate, connective, static_cast<std::uint16_t>(min_number),
+                     static_cast<std::uint32_t>(args_.size()),
+                     static_cast<std::uint32_t>(args.size())});
+   args_.insert(args_.end(), args.begin(), args.end());
+   return index;
+}
+
+}  // namespace canopy::core
@@ -0,0 +1,298 @@
+/// @file
+/// Propositional directed acyclic graph of fault tree logic for analyses.
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+
+#include <memory>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "mef/openpsa/ccf_group.h"
+#include "mef/openpsa/event/event.h"
+#include "mef/openpsa/event/gate.h"
+#include "mef/openpsa/event/formula.h"
+#include "mef/openpsa/fault_tree.h"
+#include "mef/openpsa/symbol.h"
+
+namespace canopy::core {
+
+using mef::openpsa::Connective;
+
+/// Propositional directed acyclic graph (PDAG)
+/// as the common input of analysis engines.
+///
+/// Nodes are addressed with signed integer indices;
+/// negative indices denote the complements of the nodes.
+/// Gate arguments are kept in one contiguous array,
+/// and every gate is created after all its arguments,
+/// so the ascending index order is a topological order of the graph.
+///
+/// The graph is built from the MEF gates and formulas:
+///   - house events are folded into constants
+///     with their model states or the states set for the conversion,
+///   - constant arguments are propagated into the gates,
+///   - single-argument gates are replaced with their arguments,
+///   - negations (NOT, NAND, NOR, IFF) become complement edges,
+///   - IMPLY and CARDINALITY are expressed with OR, AND, and ATLEAST.
+///
+/// Consequently, gates have only AND, OR, ATLEAST, and XOR connectives.
+///
+/// In CCF analysis, the members of a CCF group are OR gates
+/// over implicit CCF variables, one per subset of the members in the graph
+/// up to the max level of the model.
+/// The CCF events of the group that differ only by the members
+/// absent from the graph are indistinguishable for the analysis,
+/// so they are lumped into a single variable with the closed-form probability
+/// 1 - prod_k (1 - Q_k)^C(n - m, k - t)
+/// for t members of the variable out of m present members and n group members.
+class Pdag {
+   friend class Preprocessor;  // Rebuilds the nodes in place.
+
+ public:
+   using Index = std::int32_t;  ///< Signed node index.
+
+   static constexpr Index kTrue = 1;  ///< The constant True node.
+   static constexpr Index kFalse = -kTrue;  ///< The constant False.
+
+   /// Kinds of graph nodes.
+   enum class NodeKind : std::uint8_t { kConstant = 0, kVariable, kGate };
+
+   /// Compact node record.
+   struct Node {
+       NodeKind kind;  ///< The kind of the node.
+       Connective connective;  ///< kAnd, kOr, kAtleast, or kXor for gates.
+       std::uint16_t min_number;  ///< The vote number of kAtleast gates.
+       std::uint32_t first;  ///< The variable id or the offset of the gate args.
+       std::uint32_t size;  ///< The number of gate args.
+   };
+
+   /// Creates a graph with only the constant node.
+   ///
+   /// @param[in] ccf  The flag to substitute CCF group members
+   ///                 with the CCF events of their groups.
+   explicit Pdag(bool ccf = false);
+
+   /// Creates a graph with the top events of the fault tree as roots.
+   ///
+   /// @param[in] fault_tree  The fault tree with collected top events.
+   /// @param[in] ccf  The flag to include CCF events.
+   explicit Pdag(const mef::openpsa::FaultTree& fault_tree, bool ccf = false);
+
+   /// Creates a graph with the single root gate.
+   ///
+   /// @param[in] root  The top gate of the graph.
+   /// @param[in] ccf  The flag to include CCF events.
+   explicit Pdag(const mef::openpsa::Gate& root, bool ccf = false);
+
+   /// Converts MEF constructs into the graph nodes.
+   /// Shared MEF gates and events are converted only once.
+   ///
+   /// @returns The signed index of the node equivalent to the construct.
+   /// @{
+   Index Add(const mef::openpsa::Gate& gate);
+   Index Add(const mef::openpsa::BasicEvent& event);
+   Index Add(const mef::openpsa::HouseEvent& event) const;
+   Index Add(const mef::openpsa::Formula& formula);
+   /// @}
+
+   /// Sets the house-event states for the subsequent conversions,
+   /// e.g., by event-tree instructions.
+   ///
+   /// The gates with house events below them are converted
+   /// once per distinct set of the states;
+   /// the gates without house events are shared by all the sets.
+   ///
+   /// @param[in] states  The house-event ids and their states
+   ///                    overriding the model states;
+   ///                    empty to restore the model states.
+   void SetHouseEvents(std::vector<std::pair<mef::openpsa::Symbol, bool>> states);
+
+   /// Creates a variable without a source event,
+   /// e.g., for event-tree sequence expressions.
+   ///
+   /// @param[in] expression  The probability of the variable
+   ///                        outliving the graph.
+   ///
+   /// @returns The index of the new variable node.
+   Index AddVariable(mef::openpsa::Expression& expression) {
+       return NewVariable({.basic_event = nullptr,
+                           .expression = &expression,
+                           .ccf_group = nullptr,
+                           .first_member = 0,
+                           .num_members = 0});
+   }
+
+   /// Creates a gate with constant folding and connective normalization.
+   ///
+   /// @param[in] connective  Any MEF connective.
+   /// @param[in] args  The signed indices of the arguments.
+   /// @param[in] min_number  The min number for ATLEAST and CARDINALITY.
+   /// @param[in] max_number  The max number for CARDINALITY.
+   ///
+   /// @returns The signed index of the node equivalent to the gate,
+   ///          which may be a constant, an argument, or a new gate.
+   Index AddGate(Connective connective, std::vector<Index> args, int min_number = 0,
+                 int max_number = 0);
+
+   /// Registers a node as an analysis target.
+   void AddRoot(Index index) { roots_.push_back(index); }
+
+   /// @returns The analysis targets
+   ///          in the order of the fault tree top events.
+   const std::vector<Index>& roots() const { return roots_; }
+
+   /// @returns The upper bound of node indices.
+   std::size_t size() const { return nodes_.size(); }
+
+   /// @returns The node record regardless of the complement.
+   const Node& node(Index index) const { return nodes_[std::abs(index)]; }
+
+   /// Node kind queries.
+   /// @{
+   bool IsConstant(Index index) const { return node(index).kind == NodeKind::kConstant; }
+   bool IsVariable(Index index) const { return node(index).kind == NodeKind::kVariable; }
+   bool IsGate(Index index) const { return node(index).kind == NodeKind::kGate; }
+   /// @}
+
+   /// @returns The signed indices of the gate arguments.
+   std::span<const Index> args(Index gate) const {
+       const Node& record = node(gate);
+       assert(record.kind == NodeKind::kGate);
+       return {args_.data() + record.first, record.size};
+   }
+
+   /// @returns The number of variables (basic and CCF events) in the graph.
+   int num_variables() const { return variables_.size(); }
+
+   /// @param[in] variable  The variable id in [0, num_variables).
+   ///
+   /// @returns The basic event of the variable
+   ///          or nullptr for CCF events and expression variables.
+   const mef::openpsa::BasicEvent* basic_event(int variable) const {
+       return variables_[variable].basic_event;
+   }
+
+   /// @returns The CCF group of the CCF event variable or nullptr.
+   const mef::openpsa::CcfGroup* ccf_group(int variable) const {
+       return variables_[variable].ccf_group;
+   }
+
+   /// @returns The member indices of the CCF event variable in its group.
+   std::span<const int> ccf_members(int variable) const {
+       const Variable& record = variables_[variable];
+       return {ccf_members_.data() + record.first_member, record.num_members};
+   }
+
+   /// @returns The probability expression of the variable.
+   mef::openpsa::Expression& expression(int variable) const {
+       return *variables_[variable].expression;
+   }
+
+   /// @returns The probability of the variable.
+   double p(int variable) const { return variables_[variable].expression->value(); }
+
+   /// @returns The reporting name of the variable
+   ///          generated on demand for CCF events;
+   ///          empty for expression variables.
+   std::string name(int variable) const;
+
+   /// @returns The node index of the variable.
+   Index variable_node(int variable) const { return variables_[variable].node; }
+
+   /// @returns The variable id of the variable node.
+   int variable(Index index) const {
+       assert(IsVariable(index));
+       return node(index).first;
+   }
+
+   /// @returns The flags of the nodes reachable from the roots
+   ///          by node indices.
+   std::vector<bool> Reachable() const;
+
+   /// @returns true if the graph has no complements or XOR gates.
+   bool coherent() const { return coherent_; }
+
+   /// @returns true if CCF events substitute the group members.
+   bool ccf() const { return ccf_; }
+
+ private:
+   /// Variable record.
+   struct Variable {
+       Index node = 0;  ///< The node index assigned upon the addition.
+       const mef::openpsa::BasicEvent* basic_event;  ///< The source basic event.
+       mef::openpsa::Expression* expression;  ///< The probability.
+       const mef::openpsa::CcfGroup* ccf_group;  ///< The group of CCF events.
+       std::uint32_t first_member;  ///< The offset of the CCF event members.
+       std::uint32_t num_members;  ///< The number of the CCF event members.
+   };
+
+   /// The substitution of the CCF group members with CCF events.
+   struct CcfSubstitution {
+       std::vector<bool> present;  ///< The members in the graph.
+       std::vector<Index> members;  ///< The member substitutes by member indices.
+   };
+
+   /// Marks the CCF group members reachable from the gate
+   /// before the conversion.
+   void CollectCcfMembers(const mef::openpsa::Gate& gate);
+
+   /// @returns true if the gate has house events below it.
+   bool HasHouseEvents(const mef::openpsa::Gate& gate);
+
+   /// @returns The substitute of the CCF group member.
+   Index AddCcfMember(const mef::openpsa::BasicEvent& event);
+
+   /// @returns The lumped probability of the CCF events
+   ///          with the given number of members in the graph,
+   ///          or nullptr if there are no such events.
+   mef::openpsa::Expression* CcfProbability(const mef::openpsa::CcfGroup& group,
+                                            int num_present, int num_members);
+
+   /// Appends a new variable node.
+   Index NewVariable(Variable variable);
+
+   /// Appends a new gate node without any folding.
+   Index NewGate(Connective connective, const std::vector<Index>& args, int min_number);
+
+   /// Creates the vote gate for AND, OR, and ATLEAST connectives
+   /// with at least min_number true args out of the args.
+   Index AddVoteGate(std::vector<Index> args, int min_number);
+
+   /// Creates the exclusive OR gate of two args.
+   Index AddXorGate(Index first, Index second);
+
+   bool ccf_;  ///< The substitution of CCF members with CCF events.
+   bool coherent_ = true;  ///< The absence of non-coherent logic.
+   std::vector<Node> nodes_;  ///< The nodes with unused 0 index.
+   std::vector<Index> args_;  ///< The contiguous args of the gates.
+   std::vector<Index> roots_;  ///< The analysis targets.
+   std::vector<Variable> variables_;  ///< The variable records.
+   std::vector<int> ccf_members_;  ///< The contiguous members of CCF events.
+   /// The CCF substitutions by the groups.
+   std::unordered_map<const mef::openpsa::CcfGroup*, CcfSubstitution> ccf_groups_;
+   /// The lumped CCF probability expressions.
+   std::vector<std::unique_ptr<mef::openpsa::Expression>> expressions_;
+   /// The distinct sets of house-event states sorted by ids;
+   /// the first set is empty for the model states.
+   std::vector<std::vector<std::pair<mef::openpsa::Symbol, bool>>> house_event_sets_ = {{}};
+   int house_event_set_ = 0;  ///< The current set of house-event states.
+   /// The current house-event states by ids.
+   std::unordered_map<mef::openpsa::Symbol, bool> house_events_;
+   /// The gates with house events below them.
+   std::unordered_map<const mef::openpsa::Gate*, bool> house_gates_;
+   /// The converted MEF constructs.
+   /// @{
+   /// The gates by the sets of house-event states.
+   std::vector<std::unordered_map<const mef::openpsa::Gate*, Index>> gates_ = {{}};
+   std::unordered_map<const mef::openpsa::BasicEvent*, Index> basic_events_;
+   /// @}
+};
+
+}  // namespace canopy::core
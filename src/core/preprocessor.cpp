@@ -0,0 +1,140 @@
+/// @file
+/// Implementation of the Boolean preprocessing of the PDAG.
+
+#include "core/preprocessor.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+
+#include <span>
+#include <utility>
+
+namespace canopy::core {
+
+std::size_t Preprocessor::GateHash::operator()(const std::vector<Pdag::Index>& key) const {
+   std::uint64_t hash = key.size();
+   for (Pdag::Index index : key)
+       hash = (hash ^ (hash >> 31) ^ (std::uint64_t(index) * 0x9E3779B97F4A7C15)) *
+              0xBF58476D1CE4E5B9;
+   return hash ^ (hash >> 29);
+}
+
+void Preprocessor::Run() {
+   using Index = Pdag::Index;
+   std::vector<bool> reachable = graph_.Reachable();
+   // The parents in the reachable graph with the roots as extra parents.
+   std::vector<int> num_parents(graph_.size(), 0);
+   for (Index root : graph_.roots())
+       ++num_parents[std::abs(root)];
+   for (Index index = 1; index < static_cast<Index>(graph_.size()); ++index) {
+       if (!reachable[index] || !graph_.IsGate(index))
+           continue;
+       for (Index arg : graph_.args(index))
+           ++num_parents[std::abs(arg)];
+   }
+
+   std::vector<Pdag::Node> nodes = std::move(graph_.nodes_);
+   std::vector<Index> args = std::move(graph_.args_);
+   graph_.nodes_ = {{}, nodes[Pdag::kTrue]};
+   graph_.args_.clear();
+   graph_.coherent_ = true;
+   gates_.clear();
+
+   std::vector<Index> map(nodes.size(), 0);  // The new signed indices.
+   map[Pdag::kTrue] = Pdag::kTrue;
+   // The variables precede all the gates in the new order.
+   for (Pdag::Variable& variable : graph_.variables_) {
+       map[variable.node] = graph_.nodes_.size();
+       graph_.nodes_.push_back(nodes[variable.node]);
+       variable.node = map[variable.node];
+   }
+   auto new_index = [&map](Index index) {
+       return index < 0 ? -map[-index] : map[index];
+   };
+
+   // All the gates are rebuilt for the converted MEF constructs;
+   // the unreachable gates are not coalesced into their parents.
+   std::vector<Index> gate_args;
+   for (Index index = 1; index < static_cast<Index>(nodes.size()); ++index) {
+       const Pdag::Node& node = nodes[index];
+       if (node.kind != Pdag::NodeKind::kGate)
+           continue;
+       gate_args.clear();
+       for (std::uint32_t i = node.first; i < node.first + node.size; ++i) {
+           Index arg = new_index(args[i]);
+           Connective coalesced = arg < 0 ? (node.connective == Connective::kAnd
+                                                 ? Connective::kOr
+                                                 : Connective::kAnd)
+                                          : node.connective;
+           if ((node.connective == Connective::kAnd || node.connective == Connective::kOr) &&
+               reachable[index] && num_parents[std::abs(args[i])] == 1 &&
+               graph_.IsGate(arg) && graph_.node(arg).connective == coalesced) {
+               for (Index grand_arg : graph_.args(arg))
+                   gate_args.push_back(arg < 0 ? -grand_arg : grand_arg);
+           } else {
+               gate_args.push_back(arg);
+           }
+       }
+       std::size_t size = graph_.nodes_.size();
+       Index result = 0;
+       switch (node.connective) {
+       case Connective::kAnd: {
+           int num_args = gate_args.size();
+           result = graph_.AddVoteGate(gate_args, num_args);
+           break;
+       }
+       case Connective::kOr:
+           result = graph_.AddVoteGate(gate_args, 1);
+           break;
+       case Connective::kAtleast:
+           result = graph_.AddVoteGate(gate_args, node.min_number);
+           break;
+       case Connective::kXor:
+           result = graph_.AddXorGate(gate_args.front(), gate_args.back());
+           break;
+       default:
+           assert(false && "Unexpected connective.");
+       }
+       map[index] = Intern(result, size);
+   }
+
+   for (Index& root : graph_.roots_)
+       root = new_index(root);
+   Remap(map);
+}
+
+Pdag::Index Preprocessor::Intern(Pdag::Index index, std::size_t size) {
+   if (graph_.nodes_.size() == size)
+       return index;  // No new gate.
+   assert(std::abs(index) + 1 == static_cast<Pdag::Index>(graph_.nodes_.size()) &&
+          "Only the last gate is new.");
+   const Pdag::Node& node = graph_.node(index);
+   std::span<const Pdag::Index> args = graph_.args(index);
+   std::vector<Pdag::Index> key = {static_cast<Pdag::Index>(node.connective), node.min_number};
+   key.insert(key.end(), args.begin(), args.end());
+   auto [it, inserted] = gates_.try_emplace(std::move(key), std::abs(index));
+   if (inserted)
+       return index;
+   graph_.args_.resize(node.first);
+   graph_.nodes_.pop_back();
+   return index < 0 ? -it->second : it->second;
+}
+
+void Preprocessor::Remap(const std::vector<Pdag::Index>& map) {
+   auto new_index = [&map](Pdag::Index index) {
+       return index < 0 ? -map[-index] : map[index];
+   };
+   for (auto& gates : graph_.gates_) {
+       for (auto& entry : gates)
+           entry.second = new_index(entry.second);
+   }
+   for (auto& entry : graph_.basic_events_)
+       entry.second = new_index(entry.second);
+   for (auto& entry : graph_.ccf_groups_) {
+       for (Pdag::Index& member : entry.second.members)
+           member = new_index(member);
+   }
+}
+
+}  // namespace canopy::core
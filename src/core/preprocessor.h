@@ -0,0 +1,65 @@
+/// @file
+/// Boolean preprocessing of the PDAG before the analyses.
+
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "core/pdag.h"
+
+namespace canopy::core {
+
+/// Simplification of the graph that preserves the root functions
+/// and the variables.
+///
+/// The graph is rebuilt bottom-up in a single pass
+/// with the constant folding and normalization of the graph construction
+/// (house-event constants are already folded upon the construction,
+/// including the states set by event-tree instructions,
+/// and NAND, NOR, IFF, IMPLY, and CARDINALITY are already normalized):
+///   - the AND/OR args with the same connective and no other parents
+///     are coalesced into their parents,
+///     and so are the complemented args with the dual connective,
+///   - the structurally identical gates are merged into one node,
+///     so the equal sub-graphs are shared.
+///
+/// XOR gates are kept as is,
+/// for the analysis engines handle them natively.
+/// The coalesced gates stay in the graph unreachable from the roots.
+class Preprocessor {
+ public:
+   /// @param[in,out] graph  The graph to simplify in place.
+   explicit Preprocessor(Pdag* graph) : graph_(*graph) {}
+
+   /// Runs the preprocessing.
+   ///
+   /// @post The node indices of the graph change,
+   ///       but the variable ids and the order of the roots are preserved.
+   /// @post The converted MEF constructs map to the new nodes,
+   ///       so the graph can be extended after the preprocessing.
+   void Run();
+
+ private:
+   /// Hash of the gate structure for the merge of identical gates.
+   struct GateHash {
+       std::size_t operator()(const std::vector<Pdag::Index>& key) const;
+   };
+
+   /// Merges the last created gate with the identical earlier gate if any.
+   ///
+   /// @param[in] index  The result of the gate creation.
+   /// @param[in] size  The number of nodes before the creation.
+   ///
+   /// @returns The signed index of the unique equivalent gate.
+   Pdag::Index Intern(Pdag::Index index, std::size_t size);
+
+   /// Remaps the converted MEF constructs to the rebuilt nodes.
+   void Remap(const std::vector<Pdag::Index>& map);
+
+   Pdag& graph_;  ///< The graph under the preprocessing.
+   /// The unique gates by their connectives, vote numbers, and args.
+   std::unordered_map<std::vector<Pdag::Index>, Pdag::Index, GateHash> gates_;
+};
+
+}  // namespace canopy::core
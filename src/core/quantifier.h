@@ -0,0 +1,19 @@
+/// @file
+/// Quantification of analysis targets with varying variable probabilities.
+
+#pragma once
+
+#include <functional>
+#include <span>
+#include <vector>
+
+namespace canopy::core {
+
+/// Computes the probability of the analysis target
+/// for the given probabilities of the graph variables.
+/// The function may be called concurrently,
+/// each caller with its own scratch storage.
+using Quantifier =
+    std::function<double(std::span<const double> p_vars, std::vector<double>* scratch)>;
+
+}  // namespace canopy::core
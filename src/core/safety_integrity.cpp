@@ -0,0 +1,71 @@
+/// @file
+/// Implementation of the SIL metrics.
+
+#include "core/safety_integrity.h"
+
+#include <algorithm>
+#include <array>
+
+namespace canopy::core {
+
+namespace {
+
+/// The bounds of the PFD bands from below SIL 4 up to above SIL 1.
+constexpr std::array<double, 7> kPfdBounds = {0, 1e-5, 1e-4, 1e-3, 1e-2, 1e-1, 1};
+
+/// The bounds of the PFH bands from below SIL 4 up to above SIL 1.
+constexpr std::array<double, 7> kPfhBounds = {0, 1e-9, 1e-8, 1e-7, 1e-6, 1e-5, 1};
+
+/// @param[in] bounds  The ascending bounds of the bands.
+///
+/// @returns The empty histogram with the bands between the bounds.
+SafetyIntegrity::Histogram MakeHistogram(const std::array<double, 7>& bounds) {
+   SafetyIntegrity::Histogram histogram;
+   for (std::size_t i = 0; i < histogram.size(); ++i)
+       histogram[i] = {bounds[i], bounds[i + 1], 0};
+   return histogram;
+}
+
+/// Adds the time to the band of the value.
+/// The values above all the bands go into the last band.
+void Count(double value, double time, SafetyIntegrity::Histogram* histogram) {
+   auto it = std::find_if(histogram->begin(), histogram->end(),
+                          [value](const SafetyIntegrity::Bin& bin) { return value < bin.upper; });
+   if (it == histogram->end())
+       it = std::prev(histogram->end());
+   it->fraction += time;
+}
+
+}  // namespace
+
+SafetyIntegrity ComputeSafetyIntegrity(std::span<const std::pair<double, double>> p_time) {
+   SafetyIntegrity sil{.pfd_fractions = MakeHistogram(kPfdBounds),
+                       .pfh_fractions = MakeHistogram(kPfhBounds)};
+   if (p_time.size() < 2)
+       return sil;
+   double duration = p_time.back().first - p_time.front().first;
+   if (duration <= 0)
+       return sil;
+   for (std::size_t i = 1; i < p_time.size(); ++i) {
+       auto [start, p_start] = p_time[i - 1];
+       auto [end, p_end] = p_time[i];
+       double step = end - start;
+       double pfd = (p_start + p_end) / 2;
+       double pfh = 0;
+       if (p_end > p_start && p_start < 1)
+           pfh = (p_end - p_start) / (1 - p_start) / step;
+       sil.pfd_avg += pfd * step;
+       sil.pfh_avg += pfh * step;
+       Count(pfd, step, &sil.pfd_fractions);
+       Count(pfh, step, &sil.pfh_fractions);
+   }
+   sil.pfd_avg /= duration;
+   sil.pfh_avg /= duration;
+   for (SafetyIntegrity::Histogram* histogram : {&sil.pfd_fractions, &sil.pfh_fractions}) {
+       for (SafetyIntegrity::Bin& bin : *histogram)
+           bin.fraction /= duration;
+   }
+   return sil;
+}
+
+}  // namespace canopy::core
@@ -0,0 +1,44 @@
+/// @file
+/// Safety integrity level metrics of the top-event probability over time.
+
+#pragma once
+
+#include <array>
+#include <span>
+#include <utility>
+
+namespace canopy::core {
+
+/// The SIL metrics of a safety function
+/// from its failure probability over the mission time.
+struct SafetyIntegrity {
+   /// The fraction of the mission time with the metric within the bounds.
+   struct Bin {
+       double lower;  ///< The inclusive lower bound of the metric.
+       double upper;  ///< The exclusive upper bound of the metric.
+       double fraction;  ///< The fraction of the time.
+   };
+   /// The bands from below SIL 4 up to above SIL 1.
+   using Histogram = std::array<Bin, 6>;
+
+   double pfd_avg = 0;  ///< The average probability of failure on demand.
+   double pfh_avg = 0;  ///< The average frequency of dangerous failures per hour.
+   Histogram pfd_fractions;  ///< The time in the PFD bands.
+   Histogram pfh_fractions;  ///< The time in the PFH bands.
+};
+
+/// Integrates the probability curve into the SIL metrics.
+///
+/// The PFD is the unavailability of the function,
+/// averaged with the trapezoidal rule.
+/// The PFH is the conditional failure intensity dP / (1 - P) / dt
+/// of every time step;
+/// the drops of the probability, e.g., on periodic tests, are not failures.
+/// Every time step falls into the bands of its average PFD and its PFH.
+///
+/// @param[in] p_time  The probabilities by the ascending time points from 0.
+///
+/// @returns The metrics; all zeros for curves shorter than a time step.
+SafetyIntegrity ComputeSafetyIntegrity(std::span<const std::pair<double, double>> p_time);
+
+}  // namespace canopy::core
@@ -0,0 +1,141 @@
+/// @file
+/// Implementation of the streaming estimators.
+
+#include "core/statistics.h"
+
+#include <cassert>
+#include <cmath>
+
+#include <numbers>
+
+namespace canopy::core {
+
+void RunningMoments::Merge(const RunningMoments& other) {
+   if (!other.count_)
+       return;
+   if (!count_) {
+       *this = other;
+       return;
+   }
+   std::int64_t count = count_ + other.count_;
+   double delta = other.mean_ - mean_;
+   mean_ += delta * other.count_ / count;
+   m2_ += other.m2_ + delta * delta * count_ / count * other.count_;
+   count_ = count;
+}
+
+QuantileSketch::QuantileSketch(double compression)
+    : compression_(compression), buffer_capacity_(5 * compression) {
+   buffer_.reserve(buffer_capacity_);
+}
+
+void QuantileSketch::Merge(const QuantileSketch& other) {
+   min_ = std::min(min_, other.min_);
+   max_ = std::max(max_, other.max_);
+   buffer_.insert(buffer_.end(), other.centroids_.begin(), other.centroids_.end());
+   buffer_.insert(buffer_.end(), other.buffer_.begin(), other.buffer_.end());
+   Compress();
+}
+
+void QuantileSketch::Compress() {
+   if (buffer_.empty())
+       return;
+   buffer_.insert(buffer_.end(), centroids_.begin(), centroids_.end());
+   std::sort(buffer_.begin(), buffer_.end(),
+             [](const Centroid& lhs, const Centroid& rhs) { return lhs.mean < rhs.mean; });
+   double total = 0;
+   for (const Centroid& centroid : buffer_)
+       total += centroid.weight;
+
+   // The arcsine scale k(q) admits a unit of k per centroid.
+   double k_max = compression_ / 4;
+   auto scale = [this](double q) {
+       return compression_ / (2 * std::numbers::pi) * std::asin(2 * q - 1);
+   };
+   auto weight_limit = [&](double weight) {
+       double k = scale(weight / total) + 1;
+       if (k >= k_max)
+           return total;
+       return total * (std::sin(k * 2 * std::numbers::pi / compression_) + 1) / 2;
+   };
+
+   centroids_.clear();
+   Centroid current = buffer_.front();
+   double weight = 0;  // The weight of the complete centroids.
+   double limit = weight_limit(weight);
+   for (auto it = std::next(buffer_.begin()); it != buffer_.end(); ++it) {
+       if (weight + current.weight + it->weight <= limit) {
+           current.weight += it->weight;
+           current.mean += (it->mean - current.mean) * it->weight / current.weight;
+           continue;
+       }
+       weight += current.weight;
+       centroids_.push_back(current);
+       limit = weight_limit(weight);
+       current = *it;
+   }
+   centroids_.push_back(current);
+   count_ = total;
+   buffer_.clear();
+}
+
+double QuantileSketch::Quantile(double q) const {
+   assert(buffer_.empty() && "The sketch is not compressed.");
+   if (centroids_.empty())
+       return 0;
+   // The values are interpolated between the centroid centers
+   // with the extremes at the ends of the cumulative weight.
+   double target = std::clamp(q, 0.0, 1.0) * count_;
+   double position = 0;
+   double value = min_;
+   double cumulative = 0;
+   for (const Centroid& centroid : centroids_) {
+       double center = cumulative + centroid.weight / 2;
+       if (target < center) {
+           double fraction = (target - position) / (center - position);
+           return value + fraction * (centroid.mean - value);
+       }
+       position = center;
+       value = centroid.mean;
+       cumulative += centroid.weight;
+   }
+   if (count_ <= position)
+       return max_;
+   return value + (target - position) / (count_ - position) * (max_ - value);
+}
+
+double QuantileSketch::Cdf(double x) const {
+   assert(buffer_.empty() && "The sketch is not compressed.");
+   if (centroids_.empty() || x < min_)
+       return 0;
+   if (x >= max_)
+       return 1;
+   double position = 0;
+   double value = min_;
+   double cumulative = 0;
+   for (const Centroid& centroid : centroids_) {
+       double center = cumulative + centroid.weight / 2;
+       if (x < centroid.mean) {
+           double fraction = (x - value) / (centroid.mean - value);
+           return (position + fraction * (center - position)) / count_;
+       }
+       position = center;
+       value = centroid.mean;
+       cumulative += centroid.weight;
+   }
+   return (position + (x - value) / (max_ - value) * (count_ - position)) / count_;
+}
+
+Histogram::Histogram(double lower, double upper, int num_bins)
+    : lower_(lower), upper_(upper), width_((upper - lower) / num_bins), counts_(num_bins) {
+   assert(lower <= upper && num_bins > 0);
+}
+
+void Histogram::Merge(const Histogram& other) {
+   assert(lower_ == other.lower_ && upper_ == other.upper_ &&
+          counts_.size() == other.counts_.size() && "Merging histograms of distinct bins.");
+   for (std::size_t i = 0; i < counts_.size(); ++i)
+       counts_[i] += other.counts_[i];
+}
+
+}  // namespace canopy::core
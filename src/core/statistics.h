@@ -0,0 +1,160 @@
+/// @file
+/// Streaming estimators of sample distributions with mergeable state.
+
+#pragma once
+
+#include <cstdint>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace canopy::core {
+
+/// Running count, mean, and variance of a sample
+/// with the numerically stable updates of Welford and Chan.
+class RunningMoments {
+ public:
+   /// Adds the value to the sample.
+   void Add(double value) {
+       ++count_;
+       double delta = value - mean_;
+       mean_ += delta / count_;
+       m2_ += delta * (value - mean_);
+   }
+
+   /// Combines the sample of another estimator into this one.
+   void Merge(const RunningMoments& other);
+
+   /// @returns The number of values in the sample.
+   std::int64_t count() const { return count_; }
+
+   /// @returns The sample mean.
+   double mean() const { return mean_; }
+
+   /// @returns The unbiased sample variance.
+   double variance() const { return count_ > 1 ? m2_ / (count_ - 1) : 0; }
+
+ private:
+   std::int64_t count_ = 0;  ///< The number of values.
+   double mean_ = 0;  ///< The mean of the values.
+   double m2_ = 0;  ///< The sum of squared deviations from the mean.
+};
+
+/// Merging t-digest of a sample distribution in bounded memory.
+///
+/// The values are buffered and periodically merged
+/// into weighted centroids sorted by their means.
+/// The arcsine scale function limits the centroid weights,
+/// so the centroids are small at the tails and large in the middle,
+/// and the relative accuracy of extreme quantiles stays high.
+/// The number of centroids is O(compression) regardless of the sample size.
+class QuantileSketch {
+ public:
+   /// @param[in] compression  The accuracy parameter;
+   ///                         about the max number of centroids.
+   explicit QuantileSketch(double compression = 200);
+
+   /// Adds the value to the sample.
+   void Add(double value) {
+       min_ = std::min(min_, value);
+       max_ = std::max(max_, value);
+       buffer_.push_back({value, 1});
+       if (buffer_.size() >= buffer_capacity_)
+           Compress();
+   }
+
+   /// Combines the sample of another sketch into this one.
+   ///
+   /// @post The sketch is compressed.
+   void Merge(const QuantileSketch& other);
+
+   /// Merges the buffered values into the centroids.
+   void Compress();
+
+   /// @returns The number of values in the sample.
+   double count() const { return count_; }
+
+   /// @returns The exact extremes of the sample.
+   /// @{
+   double min() const { return min_; }
+   double max() const { return max_; }
+   /// @}
+
+   /// @param[in] q  The probability level in [0, 1].
+   ///
+   /// @returns The estimate of the quantile at the level.
+   ///
+   /// @pre The sketch is compressed.
+   double Quantile(double q) const;
+
+   /// @param[in] value  The value of the sample variable.
+   ///
+   /// @returns The estimate of the cumulative distribution at the value.
+   ///
+   /// @pre The sketch is compressed.
+   double Cdf(double value) const;
+
+ private:
+   /// Cluster of close values.
+   struct Centroid {
+       double mean;  ///< The mean of the values.
+       double weight;  ///< The number of the values.
+   };
+
+   double compression_;  ///< The accuracy parameter.
+   std::size_t buffer_capacity_;  ///< The number of values between compressions.
+   double count_ = 0;  ///< The total weight of the centroids.
+   double min_ = std::numeric_limits<double>::infinity();  ///< The min value.
+   double max_ = -std::numeric_limits<double>::infinity();  ///< The max value.
+   std::vector<Centroid> centroids_;  ///< The compressed values by the means.
+   std::vector<Centroid> buffer_;  ///< The values since the last compression.
+};
+
+/// Counts of a sample in equal-width bins over a fixed range.
+///
+/// The range is fixed up front, e.g., from a pilot sample,
+/// so that the counts of separate estimators can be merged exactly.
+/// The values outside of the range are counted in the end bins.
+class Histogram {
+ public:
+   /// @param[in] lower  The lower bound of the range.
+   /// @param[in] upper  The upper bound of the range.
+   /// @param[in] num_bins  The number of the bins.
+   ///
+   /// @pre lower <= upper and num_bins > 0.
+   Histogram(double lower, double upper, int num_bins);
+
+   /// Adds the value to the sample.
+   void Add(double value) { ++counts_[bin(value)]; }
+
+   /// Combines the sample of another estimator over the same range into this one.
+   void Merge(const Histogram& other);
+
+   /// @returns The bounds of the range.
+   /// @{
+   double lower() const { return lower_; }
+   double upper() const { return upper_; }
+   /// @}
+
+   /// @returns The number of values in each bin.
+   const std::vector<std::int64_t>& counts() const { return counts_; }
+
+ private:
+   /// @returns The bin of the value.
+   int bin(double value) const {
+       int last = counts_.size() - 1;
+       if (!(value > lower_))  // Catches the zero width range as well.
+           return 0;
+       if (!(value < upper_))
+           return last;
+       return std::min(static_cast<int>((value - lower_) / width_), last);
+   }
+
+   double lower_;  ///< The lower bound of the range.
+   double upper_;  ///< The upper bound of the range.
+   double width_;  ///< The width of the bins.
+   std::vector<std::int64_t> counts_;  ///< The number of values by bins.
+};
+
+}  // namespace canopy::core
@@ -0,0 +1,107 @@
+/// @file
+/// Implementation of the work-stealing thread pool.
+
+#include "core/thread_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace canopy::core {
+
+ThreadPool::ThreadPool(int num_threads) {
+   std::size_t num_queues = num_threads ? num_threads : std::thread::hardware_concurrency();
+   num_queues = std::max<std::size_t>(num_queues, 1);
+   for (std::size_t i = 0; i < num_queues; ++i)
+       queues_.push_back(std::make_unique<Queue>());
+   // The last deque is only served by the waiting thread and the thieves.
+   std::size_t num_workers = num_queues - 1;
+   workers_.reserve(num_workers);
+   for (std::size_t i = 0; i < num_workers; ++i)
+       workers_.emplace_back([this, i] { Work(i); });
+}
+
+ThreadPool::~ThreadPool() {
+   {
+       std::lock_guard lock(mutex_);
+       stop_ = true;
+   }
+   condition_.notify_all();
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+   int index = worker_index();
+   if (index < 0)
+       index = next_queue_++ % queues_.size();
+   // The counters lead the deque so that they never underflow on steals.
+   ++num_pending_;
+   {
+       std::lock_guard lock(mutex_);
+       ++num_queued_;
+   }
+   {
+       std::lock_guard lock(queues_[index]->mutex);
+       queues_[index]->tasks.push_back(std::move(task));
+   }
+   condition_.notify_one();
+}
+
+void ThreadPool::Wait() {
+   while (num_pending_) {
+       if (RunTask(-1))
+           continue;
+       std::unique_lock lock(mutex_);
+       condition_.wait(lock, [this] { return !num_pending_ || num_queued_; });
+   }
+   std::lock_guard lock(mutex_);
+   if (error_)
+       std::rethrow_exception(std::exchange(error_, nullptr));
+}
+
+void ThreadPool::Work(int index) {
+   worker_pool_ = this;
+   worker_index_ = index;
+   for (;;) {
+       if (RunTask(index))
+           continue;
+       std::unique_lock lock(mutex_);
+       condition_.wait(lock, [this] { return stop_ || num_queued_; });
+       if (stop_)
+           return;
+   }
+}
+
+bool ThreadPool::RunTask(int index) {
+   std::function<void()> task;
+   // The own deque is served from the back, and the others are robbed from the front.
+   for (int i = 0; i < static_cast<int>(queues_.size()) && !task; ++i) {
+       int victim = index < 0 ? i : (index + i) % static_cast<int>(queues_.size());
+       Queue& queue = *queues_[victim];
+       std::lock_guard lock(queue.mutex);
+       if (queue.tasks.empty())
+           continue;
+       if (victim == index) {
+           task = std::move(queue.tasks.back());
+           queue.tasks.pop_back();
+       } else {
+           task = std::move(queue.tasks.front());
+           queue.tasks.pop_front();
+       }
+   }
+   if (!task)
+       return false;
+   --num_queued_;
+   try {
+       task();
+   } catch (...) {
+       std::lock_guard lock(mutex_);
+       if (!error_)
+           error_ = std::current_exception();
+   }
+   if (--num_pending_ == 0) {
+       std::lock_guard lock(mutex_);  // Orders the notification after the waiter check.
+       condition_.notify_all();
+   }
+   return true;
+}
+
+}  // namespace canopy::core
@@ -0,0 +1,98 @@
+/// @file
+/// Work-stealing thread pool for parallel analysis tasks.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace canopy::core {
+
+/// Fixed pool of workers with per-worker task deques.
+///
+/// The thread waiting for the tasks runs them as well,
+/// so the pool of N threads starts N - 1 workers,
+/// and the pool of a single thread runs all the tasks serially in Wait.
+///
+/// Tasks submitted from a worker go to the back of its own deque
+/// and are taken back in the LIFO order for locality;
+/// idle workers steal from the front of the other deques,
+/// taking the oldest and usually the largest pieces of work.
+/// Tasks may submit further tasks,
+/// and Wait covers all of them.
+class ThreadPool {
+ public:
+   /// Starts the workers.
+   ///
+   /// @param[in] num_threads  The number of threads to run the tasks
+   ///                         including the waiting thread;
+   ///                         0 for all the cores.
+   explicit ThreadPool(int num_threads);
+
+   /// Stops and joins the workers.
+   ///
+   /// @pre No task is pending.
+   ~ThreadPool();
+
+   ThreadPool(const ThreadPool&) = delete;
+   ThreadPool& operator=(const ThreadPool&) = delete;
+
+   /// @returns The number of workers besides the waiting thread.
+   int size() const { return workers_.size(); }
+
+   /// @returns The index of the current worker of this pool in [0, size);
+   ///          -1 for the threads outside of this pool,
+   ///          including the workers of other pools.
+   int worker_index() const { return worker_pool_ == this ? worker_index_ : -1; }
+
+   /// Schedules the task for execution.
+   ///
+   /// @param[in] task  The task to run on any worker.
+   void Submit(std::function<void()> task);
+
+   /// Blocks until all the submitted tasks are complete.
+   /// The calling thread executes tasks while waiting.
+   ///
+   /// @throws The first exception escaped from the tasks.
+   void Wait();
+
+ private:
+   /// The deque of a worker.
+   struct Queue {
+       std::mutex mutex;  ///< The guard of the tasks.
+       std::deque<std::function<void()>> tasks;  ///< The scheduled tasks.
+   };
+
+   /// Runs the worker loop.
+   void Work(int index);
+
+   /// Executes a single task from the own deque or a stolen one.
+   ///
+   /// @param[in] index  The worker index; -1 for the waiting thread.
+   ///
+   /// @returns false if no task is available.
+   bool RunTask(int index);
+
+   /// The pool of the current worker.
+   inline static thread_local const ThreadPool* worker_pool_ = nullptr;
+   inline static thread_local int worker_index_ = -1;  ///< The worker in its pool.
+
+   std::vector<std::unique_ptr<Queue>> queues_;  ///< The deques of the workers.
+   std::atomic<std::size_t> num_queued_ = 0;  ///< The tasks in the deques.
+   std::atomic<std::size_t> num_pending_ = 0;  ///< The tasks not yet complete.
+   std::atomic<std::size_t> next_queue_ = 0;  ///< The deque for external submissions.
+   std::mutex mutex_;  ///< The guard for the sleeping and the errors.
+   std::condition_variable condition_;  ///< The wake up of workers and waiters.
+   bool stop_ = false;  ///< The signal to the workers to exit.
+   std::exception_ptr error_;  ///< The first failure of the tasks.
+   std::vector<std::jthread> workers_;  ///< The worker threads.
+};
+
+}  // namespace canopy::core
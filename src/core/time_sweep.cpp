@@ -0,0 +1,78 @@
+/// @file
+/// Implementation of the time sweep of the top-event probability.
+
+#include "core/time_sweep.h"
+
+#include <cstdint>
+
+#include <algorithm>
+#include <span>
+
+#include "core/thread_pool.h"
+#include "mef/openpsa/expression_tape.h"
+
+namespace canopy::core {
+
+namespace {
+
+/// The number of time points per tape sweep.
+/// The tape keeps a vector of this size for every time-dependent expression.
+constexpr int kChunkSize = 256;
+
+/// The number of time points per worker task.
+constexpr int kBlockSize = 16;
+
+}  // namespace
+
+TimeSweep::TimeSweep(const Pdag& graph, const Quantifier& quantifier,
+                     const mef::openpsa::Settings& settings) {
+   double time_step = settings.time_step();
+   double mission_time = settings.mission_time();
+   if (time_step <= 0)
+       return;
+   std::vector<double> times;
+   std::int64_t num_steps = mission_time / time_step;
+   for (std::int64_t i = 0; i <= num_steps; ++i)
+       times.push_back(i * time_step);
+   if (times.back() < mission_time)
+       times.push_back(mission_time);
+   p_time_.resize(times.size());
+
+   using mef::openpsa::ExpressionTape;
+   int num_variables = graph.num_variables();
+   ExpressionTape tape;
+   std::vector<ExpressionTape::Slot> slots;
+   for (int variable = 0; variable < num_variables; ++variable)
+       slots.push_back(tape.Compile(&graph.expression(variable)));
+
+   ThreadPool pool(settings.num_threads());
+   std::vector<std::vector<double>> p_vars(pool.size() + 1);
+   std::vector<std::vector<double>> scratches(pool.size() + 1);
+   std::vector<std::span<const double>> series(num_variables);
+   for (std::size_t first = 0; first < times.size(); first += kChunkSize) {
+       std::span<const double> chunk = std::span(times).subspan(
+           first, std::min<std::size_t>(kChunkSize, times.size() - first));
+       tape.Sweep(chunk);
+       for (int variable = 0; variable < num_variables; ++variable)
+           series[variable] = tape.series(slots[variable]);
+       for (int block = 0; block < static_cast<int>(chunk.size()); block += kBlockSize) {
+           pool.Submit([&, first, chunk, block] {
+               int worker = pool.worker_index() + 1;
+               std::vector<double>& p = p_vars[worker];
+               p.resize(num_variables);
+               int end = std::min<int>(block + kBlockSize, chunk.size());
+               for (int i = block; i < end; ++i) {
+                   // The time-independent expressions have a single value.
+                   for (int variable = 0; variable < num_variables; ++variable) {
+                       std::span<const double> values = series[variable];
+                       p[variable] = std::clamp(values[values.size() > 1 ? i : 0], 0.0, 1.0);
+                   }
+                   p_time_[first + i] = {chunk[i], quantifier(p, &scratches[worker])};
+               }
+           });
+       }
+       pool.Wait();
+   }
+}
+
+}  // namespace canopy::core
@@ -0,0 +1,42 @@
+/// @file
+/// Probability of the top event over the mission time grid.
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "core/pdag.h"
+#include "core/quantifier.h"
+#include "mef/openpsa/settings.h"
+
+namespace canopy::core {
+
+/// Evaluation of the top-event probability
+/// at every time step from 0 up to the mission time.
+///
+/// The basic-event expressions are compiled into a tape
+/// and swept over chunks of the time grid at once,
+/// so that every time-dependent expression computes a vector of values
+/// and the time-independent expressions are evaluated only once per chunk.
+/// The time points of a chunk are then quantified in parallel.
+class TimeSweep {
+ public:
+   /// Runs the sweep.
+   ///
+   /// @param[in] graph  The graph with the variable probability expressions.
+   /// @param[in] quantifier  The quantification of the top event.
+   /// @param[in] settings  The mission time, the time step, and the number of threads.
+   ///                      No points are evaluated without the time step.
+   TimeSweep(const Pdag& graph, const Quantifier& quantifier,
+             const mef::openpsa::Settings& settings);
+
+   /// @returns The top-event probabilities by the time points
+   ///          in the ascending order of the time.
+   const std::vector<std::pair<double, double>>& p_time() const { return p_time_; }
+
+ private:
+   std::vector<std::pair<double, double>> p_time_;  ///< The (time, probability) points.
+};
+
+}  // namespace canopy::core
@@ -0,0 +1,134 @@
+/// @file
+/// Implementation of the uncertainty analysis.
+
+#include "core/uncertainty_analysis.h"
+
+#include <cmath>
+
+#include <algorithm>
+#include <optional>
+#include <span>
+
+#include "core/thread_pool.h"
+#include "mef/openpsa/expr/random_deviate.h"
+#include "mef/openpsa/expression.h"
+#include "mef/openpsa/expression_tape.h"
+
+namespace canopy::core {
+
+namespace {
+
+/// The number of trials per worker task.
+constexpr int kBlockSize = 256;
+
+/// The number of trials per round of tasks.
+/// The values of a round are added into the estimators in the trial order,
+/// and the first round is the pilot of the histogram range.
+constexpr int kRoundSize = 64 * kBlockSize;
+
+}  // namespace
+
+UncertaintyAnalysis::UncertaintyAnalysis(const Pdag& graph, const Quantifier& quantifier,
+                                         const mef::openpsa::Settings& settings) {
+   using mef::openpsa::ExpressionTape;
+   int num_variables = graph.num_variables();
+   ExpressionTape tape;
+   std::vector<ExpressionTape::Slot> slots;
+   for (int variable = 0; variable < num_variables; ++variable)
+       slots.push_back(tape.Compile(&graph.expression(variable)));
+   tape.Evaluate();
+   mef::openpsa::RandomDeviate::seed(settings.seed());
+
+   std::int64_t num_trials = std::max(settings.num_trials(), 0);
+   int num_bins = std::max(settings.num_bins(), 0);
+   ThreadPool pool(settings.num_threads());
+   // The caller thread takes the first context while waiting.
+   int num_workers = pool.size() + 1;
+   std::vector<mef::openpsa::SamplingContext> contexts;
+   for (int i = 0; i < num_workers; ++i)
+       contexts.emplace_back(tape.context_size());
+   std::vector<ExpressionTape::Batch> batches(num_workers);
+   std::vector<std::vector<double>> rows(num_workers);
+   std::vector<std::vector<double>> scratches(num_workers);
+
+   // Samples and quantifies the block of trials on a worker.
+   auto run = [&](std::int64_t first_trial, int size, double* values) {
+       int worker = pool.worker_index() + 1;
+       mef::openpsa::Expression::context(&contexts[worker]);
+       ExpressionTape::Batch& batch = batches[worker];
+       tape.SampleBatch(first_trial, size, &batch);
+       mef::openpsa::Expression::context(nullptr);
+
+       std::vector<double>& block = rows[worker];
+       block.resize(static_cast<std::size_t>(size) * num_variables);
+       for (int variable = 0; variable < num_variables; ++variable) {
+           std::span<const double> column = batch[slots[variable]];
+           std::size_t stride = column.size() > 1;  // 0 to broadcast the constants.
+           for (int i = 0; i < size; ++i) {
+               block[static_cast<std::size_t>(i) * num_variables + variable] =
+                   std::clamp(column[stride * i], 0.0, 1.0);
+           }
+       }
+       for (int i = 0; i < size; ++i) {
+           values[i] = quantifier({block.data() + static_cast<std::size_t>(i) * num_variables,
+                                   static_cast<std::size_t>(num_variables)},
+                                  &scratches[worker]);
+       }
+   };
+
+   // The workers only sample and quantify the trials,
+   // and the estimators take the values in the trial order,
+   // so the results do not depend on the number of threads.
+   QuantileSketch sketch;
+   std::optional<Histogram> histogram;
+   std::vector<double> values;  // The values of the round.
+   for (std::int64_t round = 0; round < num_trials; round += kRoundSize) {
+       values.resize(std::min<std::int64_t>(kRoundSize, num_trials - round));
+       for (std::int64_t block = 0; block < static_cast<std::int64_t>(values.size());
+            block += kBlockSize) {
+           pool.Submit([&run, &values, round, block] {
+               run(round + block,
+                   std::min<std::int64_t>(kBlockSize, values.size() - block),
+                   values.data() + block);
+           });
+       }
+       pool.Wait();
+       if (num_bins && !histogram) {
+           auto [min, max] = std::minmax_element(values.begin(), values.end());
+           histogram.emplace(*min, *max, num_bins);
+       }
+       for (double value : values) {
+           moments_.Add(value);
+           sketch.Add(value);
+           if (histogram)
+               histogram->Add(value);
+       }
+   }
+   sketch.Compress();
+
+   int num_quantiles = std::max(settings.num_quantiles(), 0);
+   for (int i = 1; i <= num_quantiles; ++i)
+       quantiles_.push_back(sketch.Quantile(static_cast<double>(i) / num_quantiles));
+
+   if (!histogram)
+       return;
+   // The end bins take the values outside of the pilot range.
+   double width = (histogram->upper() - histogram->lower()) / num_bins;
+   for (int i = 0; i < num_bins; ++i) {
+       double lower = i ? histogram->lower() + i * width : sketch.min();
+       double upper = i + 1 == num_bins ? sketch.max() : histogram->lower() + (i + 1) * width;
+       histogram_.push_back(
+           {lower, upper, static_cast<double>(histogram->counts()[i]) / moments_.count()});
+   }
+}
+
+double UncertaintyAnalysis::sigma() const { return std::sqrt(moments_.variance()); }
+
+std::pair<double, double> UncertaintyAnalysis::confidence_interval() const {
+   if (!moments_.count())
+       return {0, 0};
+   double delta = 1.96 * sigma() / std::sqrt(moments_.count());
+   return {mean() - delta, mean() + delta};
+}
+
+}  // namespace canopy::core
@@ -0,0 +1,77 @@
+/// @file
+/// Uncertainty analysis of the top-event probability with streaming statistics.
+
+#pragma once
+
+#include <cstdint>
+
+#include <utility>
+#include <vector>
+
+#include "core/pdag.h"
+#include "core/quantifier.h"
+#include "core/statistics.h"
+#include "mef/openpsa/settings.h"
+
+namespace canopy::core {
+
+/// Propagation of the uncertainties of basic-event probabilities
+/// to the top-event probability.
+///
+/// Every trial re-samples all the random deviates
+/// of the basic-event expressions through a compiled expression tape
+/// and re-quantifies the top event with the sampled probabilities.
+/// The results go into streaming estimators of bounded memory:
+/// the running moments, the quantile sketch, and the histogram
+/// with the bin range fixed by a pilot round of trials.
+///
+/// The workers sample blocks of trials in batches
+/// within their own sampling contexts and quantify the trials,
+/// and the estimators take the values of each round of blocks in the trial order,
+/// so the results are the same for any number of threads.
+class UncertaintyAnalysis {
+ public:
+   /// The bin of the histogram.
+   struct Bin {
+       double lower;  ///< The lower bound of the values.
+       double upper;  ///< The upper bound of the values.
+       double fraction;  ///< The fraction of the trials in the bin.
+   };
+
+   /// Runs the analysis.
+   ///
+   /// @param[in] graph  The graph with the variable probability expressions.
+   /// @param[in] quantifier  The quantification of the top event
+   ///                        with the sampled probabilities.
+   /// @param[in] settings  The number of trials, the seed, the number of threads,
+   ///                      the number of quantiles, and the number of bins.
+   UncertaintyAnalysis(const Pdag& graph, const Quantifier& quantifier,
+                       const mef::openpsa::Settings& settings);
+
+   /// @returns The number of trials.
+   std::int64_t num_trials() const { return moments_.count(); }
+
+   /// @returns The sample mean of the top-event probability.
+   double mean() const { return moments_.mean(); }
+
+   /// @returns The sample standard deviation of the top-event probability.
+   double sigma() const;
+
+   /// @returns The 95% confidence interval of the mean.
+   std::pair<double, double> confidence_interval() const;
+
+   /// @returns The quantiles of the top-event probability
+   ///          at the levels i / n for i in [1, n].
+   const std::vector<double>& quantiles() const { return quantiles_; }
+
+   /// @returns The equal-width bins over the range of the pilot trials;
+   ///          the end bins extend to the min and the max sampled values.
+   const std::vector<Bin>& histogram() const { return histogram_; }
+
+ private:
+   RunningMoments moments_;  ///< The moments of the top-event probability.
+   std::vector<double> quantiles_;  ///< The quantiles of the distribution.
+   std::vector<Bin> histogram_;  ///< The histogram of the distribution.
+};
+
+}  // namespace canopy::core
@@ -0,0 +1,184 @@
+/// @file
+/// Implementation of the variable ordering heuristics.
+
+#include "core/variable_ordering.h"
+
+#include <cstdlib>
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace canopy::core {
+
+namespace {
+
+/// The max number of FORCE iterations;
+/// the span usually converges within a few iterations.
+constexpr int kMaxForceIterations = 32;
+
+/// Visits the nodes reachable from the roots depth-first.
+///
+/// @param[in] graph  The graph with the roots.
+/// @param[in] weights  The weights of the nodes to visit heavier args first;
+///                     empty to visit the args in their order.
+///
+/// @returns The variable and gate nodes in the order of the first visits.
+std::vector<Pdag::Index> VisitDepthFirst(const Pdag& graph, const std::vector<double>& weights) {
+   std::vector<Pdag::Index> nodes;
+   std::vector<bool> visited(graph.size(), false);
+   std::vector<Pdag::Index> stack;
+   std::vector<Pdag::Index> args;
+   for (Pdag::Index root : graph.roots()) {
+       stack.push_back(std::abs(root));
+       while (!stack.empty()) {
+           Pdag::Index index = stack.back();
+           stack.pop_back();
+           if (visited[index] || graph.IsConstant(index))
+               continue;
+           visited[index] = true;
+           nodes.push_back(index);
+           if (!graph.IsGate(index))
+               continue;
+           args.clear();
+           for (Pdag::Index arg : graph.args(index))
+               args.push_back(std::abs(arg));
+           if (!weights.empty()) {
+               std::stable_sort(args.begin(), args.end(),
+                                [&weights](Pdag::Index lhs, Pdag::Index rhs) {
+                                    return weights[lhs] > weights[rhs];
+                                });
+           }
+           // The first arg is on top of the stack.
+           stack.insert(stack.end(), args.rbegin(), args.rend());
+       }
+   }
+   return nodes;
+}
+
+/// @returns The weights of the nodes shared evenly by the args of gates.
+std::vector<double> WeighFanIn(const Pdag& graph) {
+   std::vector<double> weights(graph.size(), 0);
+   for (Pdag::Index root : graph.roots())
+       weights[std::abs(root)] += 1;
+   // Gates follow their args in the node order.
+   for (Pdag::Index index = graph.size() - 1; index > 0; --index) {
+       if (weights[index] == 0 || !graph.IsGate(index))
+           continue;
+       std::span<const Pdag::Index> args = graph.args(index);
+       for (Pdag::Index arg : args)
+           weights[std::abs(arg)] += weights[index] / args.size();
+   }
+   return weights;
+}
+
+/// Places the nodes at the centers of gravity of their gates
+/// starting from the depth-first order.
+///
+/// @returns The variable and gate nodes in the order of their places.
+std::vector<Pdag::Index> PlaceByForce(const Pdag& graph) {
+   std::vector<Pdag::Index> nodes = VisitDepthFirst(graph, {});
+   std::vector<Pdag::Index> gates;
+   std::copy_if(nodes.begin(), nodes.end(), std::back_inserter(gates),
+                [&graph](Pdag::Index index) { return graph.IsGate(index); });
+   std::vector<double> positions(graph.size(), 0);
+   std::vector<double> sums(graph.size(), 0);
+   std::vector<int> counts(graph.size(), 0);
+   std::vector<Pdag::Index> best_nodes;
+   double best_span = std::numeric_limits<double>::infinity();
+   for (int iteration = 0; iteration < kMaxForceIterations; ++iteration) {
+       for (std::size_t i = 0; i < nodes.size(); ++i)
+           positions[nodes[i]] = i;
+       std::fill(sums.begin(), sums.end(), 0);
+       std::fill(counts.begin(), counts.end(), 0);
+       double span = 0;
+       for (Pdag::Index gate : gates) {
+           std::span<const Pdag::Index> args = graph.args(gate);
+           double min_position = positions[gate];
+           double max_position = positions[gate];
+           double total = positions[gate];
+           for (Pdag::Index arg : args) {
+               double position = positions[std::abs(arg)];
+               min_position = std::min(min_position, position);
+               max_position = std::max(max_position, position);
+               total += position;
+           }
+           span += max_position - min_position;
+           double center = total / (args.size() + 1);
+           sums[gate] += center;
+           ++counts[gate];
+           for (Pdag::Index arg : args) {
+               sums[std::abs(arg)] += center;
+               ++counts[std::abs(arg)];
+           }
+       }
+       if (span >= best_span)
+           break;
+       best_span = span;
+       best_nodes = nodes;
+       for (Pdag::Index index : nodes) {
+           if (counts[index])  // The nodes outside the gates stay in place.
+               positions[index] = sums[index] / counts[index];
+       }
+       std::stable_sort(nodes.begin(), nodes.end(),
+                        [&positions](Pdag::Index lhs, Pdag::Index rhs) {
+                            return positions[lhs] < positions[rhs];
+                        });
+   }
+   return best_nodes.empty() ? nodes : best_nodes;
+}
+
+}  // namespace
+
+std::vector<int> OrderVariables(const Pdag& graph, const mef::openpsa::Settings& settings) {
+   using mef::openpsa::VariableOrdering;
+   std::vector<Pdag::Index> nodes;
+   switch (settings.variable_ordering()) {
+   case VariableOrdering::kIdentity:
+       for (int variable = 0; variable < graph.num_variables(); ++variable)
+           nodes.push_back(graph.variable_node(variable));
+       break;
+   case VariableOrdering::kDepthFirst:
+       nodes = VisitDepthFirst(graph, {});
+       break;
+   case VariableOrdering::kFanIn:
+       nodes = VisitDepthFirst(graph, WeighFanIn(graph));
+       break;
+   case VariableOrdering::kForce:
+       nodes = PlaceByForce(graph);
+       break;
+   }
+
+   std::vector<int> order;
+   std::vector<bool> ordered(graph.num_variables(), false);
+   auto add = [&order, &ordered](int variable) {
+       if (ordered[variable])
+           return;
+       ordered[variable] = true;
+       order.push_back(variable);
+   };
+   if (!settings.variable_order().empty()) {
+       std::unordered_map<std::string, int> variables;
+       for (int variable = 0; variable < graph.num_variables(); ++variable) {
+           if (std::string name = graph.name(variable); !name.empty())
+               variables.emplace(std::move(name), variable);
+       }
+       for (const std::string& name : settings.variable_order()) {
+           if (auto it = variables.find(name); it != variables.end())
+               add(it->second);
+       }
+   }
+   for (Pdag::Index index : nodes) {
+       if (graph.IsVariable(index))
+           add(graph.variable(index));
+   }
+   for (int variable = 0; variable < graph.num_variables(); ++variable)
+       add(variable);
+   return order;
+}
+
+}  // namespace canopy::core
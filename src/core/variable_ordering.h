@@ -0,0 +1,38 @@
+/// @file
+/// Static heuristics for the order of BDD variables.
+
+#pragma once
+
+#include <vector>
+
+#include "core/pdag.h"
+#include "mef/openpsa/settings.h"
+
+namespace canopy::core {
+
+/// Orders the graph variables for the BDD levels
+/// with the heuristic of the settings:
+///   - identity keeps the order of the variable ids,
+///   - depth-first takes the variables as first visited
+///     in the depth-first traversal from the roots,
+///     so the variables of a sub-graph stay together,
+///   - fan-in distributes the weight of every gate evenly over its args
+///     top-down from the roots
+///     and visits the heavier args first in the depth-first traversal,
+///     so the variables with the largest influence on the roots come first,
+///   - FORCE starts from the depth-first order
+///     and moves every node to the mean center of gravity of its gates
+///     (the gate with its args) until the total span of the gates
+///     stops decreasing.
+///
+/// The variables given by names in the settings, e.g., the order reported
+/// by an earlier analysis, precede the others in their given order.
+/// The variables unreachable from the roots come last.
+///
+/// @param[in] graph  The graph with the roots.
+/// @param[in] settings  The heuristic and the given variable names.
+///
+/// @returns The variable ids in the order of BDD levels.
+std::vector<int> OrderVariables(const Pdag& graph, const mef::openpsa::Settings& settings);
+
+}  // namespace canopy::core
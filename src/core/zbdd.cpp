@@ -0,0 +1,435 @@
+/// @file
+/// Implementation of the ZBDD package and the product generation.
+
+#include "core/zbdd.h"
+
+#include <cassert>
+#include <cstdlib>
+
+#include <algorithm>
+#include <numeric>
+
+namespace canopy::core {
+
+namespace {
+
+/// The initial number of buckets in the unique and computed tables.
+constexpr std::size_t kInitialTableSize = 1 << 12;
+
+/// The invalid vertex for missing results.
+constexpr Zbdd::VertexIndex kNoVertex = std::numeric_limits<Zbdd::VertexIndex>::max();
+
+/// @returns The hash of the vertex for the unique table.
+std::size_t Hash(int literal, Zbdd::VertexIndex high, Zbdd::VertexIndex low) {
+   std::uint64_t key = (std::uint64_t{high} << 32) ^ low;
+   key = (key ^ (key >> 31) ^ (std::uint64_t(literal) * 0x9E3779B97F4A7C15)) *
+         0xBF58476D1CE4E5B9;
+   return key ^ (key >> 29);
+}
+
+/// @returns The identity order of the graph variables.
+std::vector<int> GetIdentityOrder(const Pdag& graph) {
+   std::vector<int> order(graph.num_variables());
+   std::iota(order.begin(), order.end(), 0);
+   return order;
+}
+
+}  // namespace
+
+Zbdd::Zbdd(std::vector<int> order, std::span<const double> p_vars,
+           const mef::openpsa::Settings& settings)
+    : limit_order_(settings.limit_order()),
+      cut_off_(settings.cut_off()),
+      prime_implicants_(settings.prime_implicants()),
+      p_vars_(p_vars.begin(), p_vars.end()),
+      variables_(std::move(order)),
+      vertices_{{kTerminalLiteral, kEmpty, kEmpty, 0, std::numeric_limits<double>::infinity()},
+                {kTerminalLiteral, kEmpty, kEmpty, 1, 1}},
+      unique_table_(kInitialTableSize, 0),
+      computed_table_(kInitialTableSize) {}
+
+Zbdd::Zbdd(const Pdag& graph, std::span<const double> p_vars,
+           const mef::openpsa::Settings& settings)
+    : Zbdd(GetIdentityOrder(graph), p_vars, settings) {
+   prime_implicants_ = false;  // Not supported by the bottom-up generation.
+   std::vector<VertexIndex> memo(2 * graph.size(), kNoVertex);
+   for (Pdag::Index root : graph.roots())
+       roots_.push_back(Convert(graph, root, &memo));
+}
+
+Zbdd::Zbdd(Bdd* bdd, std::span<const double> p_vars, const mef::openpsa::Settings& settings)
+    : Zbdd(bdd->order(), p_vars, settings) {
+   std::unordered_map<std::uint64_t, VertexIndex> memo;
+   for (Bdd::Edge root : bdd->roots())
+       roots_.push_back(Prune(Convert(bdd, root, limit_order_, &memo)));
+}
+
+Zbdd::VertexIndex Zbdd::Convert(const Pdag& graph, Pdag::Index index,
+                                std::vector<VertexIndex>* memo) {
+   VertexIndex& cached = (*memo)[2 * std::abs(index) + (index < 0)];
+   if (cached != kNoVertex)
+       return cached;
+
+   VertexIndex result = kEmpty;
+   const Pdag::Node& node = graph.node(index);
+   bool complement = index < 0;
+   switch (node.kind) {
+   case Pdag::NodeKind::kConstant:
+       result = complement ? kEmpty : kBase;
+       break;
+   case Pdag::NodeKind::kVariable:
+       if (complement)
+           result = kBase;  // Unity for the complement in minimal cut sets.
+       else if (limit_order_ > 0)
+           result = Prune(MakeVertex(2 * node.first, kBase, kEmpty));
+       break;
+   case Pdag::NodeKind::kGate: {
+       // The complement is pushed down to the args with De Morgan's law.
+       std::vector<Pdag::Index> args(graph.args(index).begin(), graph.args(index).end());
+       if (complement) {
+           for (Pdag::Index& arg : args)
+               arg = -arg;
+       }
+       Connective connective = node.connective;
+       int min_number = node.min_number;
+       if (complement) {
+           switch (connective) {
+           case Connective::kAnd:
+               connective = Connective::kOr;
+               break;
+           case Connective::kOr:
+               connective = Connective::kAnd;
+               break;
+           case Connective::kAtleast:
+               min_number = args.size() - min_number + 1;
+               break;
+           case Connective::kXor:
+               args.front() = -args.front();  // Only one complement is retained.
+               break;
+           default:
+               assert(false && "Unexpected connective in the PDAG.");
+           }
+       }
+       std::vector<VertexIndex> families;
+       for (Pdag::Index arg : args)
+           families.push_back(Convert(graph, arg, memo));
+       switch (connective) {
+       case Connective::kAnd:
+           result = kBase;
+           for (VertexIndex family : families)
+               result = Multiply(result, family, limit_order_);
+           result = Prune(Minimize(result));
+           break;
+       case Connective::kOr:
+           for (VertexIndex family : families)
+               result = Union(result, family);
+           result = Minimize(result);
+           break;
+       case Connective::kAtleast: {
+           std::unordered_map<std::uint32_t, VertexIndex> vote_memo;
+           result = Prune(Minimize(Vote(families, min_number, &vote_memo)));
+           break;
+       }
+       case Connective::kXor: {
+           VertexIndex first = Multiply(families.front(), Convert(graph, -args.back(), memo),
+                                       limit_order_);
+           VertexIndex second = Multiply(Convert(graph, -args.front(), memo), families.back(),
+                                        limit_order_);
+           result = Prune(Minimize(Union(first, second)));
+           break;
+       }
+       default:
+           assert(false && "Unexpected connective in the PDAG.");
+       }
+       break;
+   }
+   }
+   (*memo)[2 * std::abs(index) + (index < 0)] = result;  // The memo is stable.
+   return result;
+}
+
+Zbdd::VertexIndex Zbdd::Vote(std::span<const VertexIndex> args, int min_number,
+                             std::unordered_map<std::uint32_t, VertexIndex>* memo) {
+   if (min_number <= 0)
+       return kBase;
+   if (min_number > static_cast<int>(args.size()))
+       return kEmpty;
+   std::uint32_t key = (args.size() << 16) | min_number;
+   if (auto it = memo->find(key); it != memo->end())
+       return it->second;
+   VertexIndex result =
+       Union(Multiply(args.front(), Vote(args.subspan(1), min_number - 1, memo), limit_order_),
+             Vote(args.subspan(1), min_number, memo));
+   memo->emplace(key, result);
+   return result;
+}
+
+Zbdd::VertexIndex Zbdd::Convert(Bdd* bdd, Bdd::Edge edge, int limit,
+                                std::unordered_map<std::uint64_t, VertexIndex>* memo) {
+   if (edge == Bdd::kZero || limit < 0)
+       return kEmpty;
+   if (edge == Bdd::kOne)
+       return kBase;
+   std::uint64_t key = (std::uint64_t{edge} << 32) | limit;
+   if (auto it = memo->find(key); it != memo->end())
+       return it->second;
+
+   // The BDD operations may reallocate the vertices.
+   int literal = 2 * bdd->vertex(edge).level;
+   Bdd::Edge high = bdd->vertex(edge).high ^ Bdd::IsComplement(edge);
+   Bdd::Edge low = bdd->vertex(edge).low ^ Bdd::IsComplement(edge);
+   VertexIndex result = kEmpty;
+   if (prime_implicants_) {
+       // The prime implicants of the consensus are free of the variable,
+       // and the rest of the primes of the cofactors get the literals.
+       VertexIndex consensus = Convert(bdd, bdd->And(high, low), limit, memo);
+       VertexIndex positive = Difference(Convert(bdd, high, limit - 1, memo), consensus);
+       VertexIndex negative = Difference(Convert(bdd, low, limit - 1, memo), consensus);
+       result = MakeVertex(literal, positive, MakeVertex(literal + 1, negative, consensus));
+   } else {
+       VertexIndex without = Convert(bdd, low, limit, memo);
+       VertexIndex with = Subsume(Convert(bdd, high, limit - 1, memo), without);
+       result = MakeVertex(literal, with, without);
+   }
+   memo->emplace(key, result);
+   return result;
+}
+
+Zbdd::VertexIndex Zbdd::MakeVertex(int literal, VertexIndex high, VertexIndex low) {
+   if (high == kEmpty)
+       return low;
+   assert(literal < vertices_[high].literal && literal < vertices_[low].literal);
+   std::size_t mask = unique_table_.size() - 1;
+   for (std::size_t slot = Hash(literal, high, low) & mask;; slot = (slot + 1) & mask) {
+       VertexIndex index = unique_table_[slot];
+       if (!index) {
+           index = vertices_.size();
+           double p_literal = p(literal);
+           vertices_.push_back(
+               {literal, high, low,
+                std::max(p_literal * vertices_[high].max_p, vertices_[low].max_p),
+                std::min(p_literal * vertices_[high].min_p, vertices_[low].min_p)});
+           unique_table_[slot] = index;
+           if (2 * vertices_.size() > unique_table_.size())
+               GrowUniqueTable();
+           return index;
+       }
+       const Vertex& record = vertices_[index];
+       if (record.literal == literal && record.high == high && record.low == low)
+           return index;
+   }
+}
+
+void Zbdd::GrowUniqueTable() {
+   unique_table_.assign(2 * unique_table_.size(), 0);
+   std::size_t mask = unique_table_.size() - 1;
+   for (VertexIndex index = kBase + 1; index < vertices_.size(); ++index) {
+       const Vertex& record = vertices_[index];
+       std::size_t slot = Hash(record.literal, record.high, record.low) & mask;
+       while (unique_table_[slot])
+           slot = (slot + 1) & mask;
+       unique_table_[slot] = index;
+   }
+   computed_table_.assign(unique_table_.size(), Computation());
+}
+
+Zbdd::VertexIndex Zbdd::FindComputed(Operation operation, VertexIndex f, VertexIndex g,
+                                     int limit) const {
+   const Computation& entry = computed_table_[Slot(operation, f, g, limit)];
+   if (entry.operation == operation && entry.f == f && entry.g == g && entry.limit == limit)
+       return entry.result;
+   return kNoVertex;
+}
+
+void Zbdd::StoreComputed(Operation operation, VertexIndex f, VertexIndex g, int limit,
+                         VertexIndex result) {
+   computed_table_[Slot(operation, f, g, limit)] = {operation, limit, f, g, result};
+}
+
+Zbdd::VertexIndex Zbdd::Union(VertexIndex f, VertexIndex g) {
+   if (f == kEmpty || f == g)
+       return g;
+   if (g == kEmpty)
+       return f;
+   if (f > g)
+       std::swap(f, g);
+   if (VertexIndex result = FindComputed(Operation::kUnion, f, g, 0); result != kNoVertex)
+       return result;
+   Vertex one = vertices_[f];
+   Vertex two = vertices_[g];
+   VertexIndex result;
+   if (one.literal < two.literal) {
+       result = MakeVertex(one.literal, one.high, Union(one.low, g));
+   } else if (one.literal > two.literal) {
+       result = MakeVertex(two.literal, two.high, Union(f, two.low));
+   } else {
+       VertexIndex high = Union(one.high, two.high);
+       result = MakeVertex(one.literal, high, Union(one.low, two.low));
+   }
+   StoreComputed(Operation::kUnion, f, g, 0, result);
+   return result;
+}
+
+Zbdd::VertexIndex Zbdd::Multiply(VertexIndex f, VertexIndex g, int limit) {
+   if (f == kEmpty || g == kEmpty || limit < 0)
+       return kEmpty;
+   if (f == kBase && g == kBase)
+       return kBase;
+   if (limit == 0)
+       return HasEmpty(f) && HasEmpty(g) ? kBase : kEmpty;
+   if (f > g)
+       std::swap(f, g);
+   if (VertexIndex result = FindComputed(Operation::kMultiply, f, g, limit);
+       result != kNoVertex) {
+       return result;
+   }
+   // The vertices are copied for the recursion may reallocate them.
+   Vertex one = vertices_[f];
+   Vertex two = vertices_[g];
+   VertexIndex result;
+   if (one.literal < two.literal) {
+       VertexIndex high = Multiply(one.high, g, limit - 1);
+       result = MakeVertex(one.literal, high, Multiply(one.low, g, limit));
+   } else if (one.literal > two.literal) {
+       VertexIndex high = Multiply(f, two.high, limit - 1);
+       result = MakeVertex(two.literal, high, Multiply(f, two.low, limit));
+   } else {
+       VertexIndex high = Union(Multiply(one.high, two.high, limit - 1),
+                                Union(Multiply(one.high, two.low, limit - 1),
+                                      Multiply(one.low, two.high, limit - 1)));
+       result = MakeVertex(one.literal, high, Multiply(one.low, two.low, limit));
+   }
+   StoreComputed(Operation::kMultiply, f, g, limit, result);
+   return result;
+}
+
+Zbdd::VertexIndex Zbdd::Subsume(VertexIndex f, VertexIndex g) {
+   if (g == kEmpty)
+       return f;
+   if (f == kEmpty || f == g || HasEmpty(g))
+       return kEmpty;
+   if (f == kBase)
+       return kBase;
+   if (VertexIndex result = FindComputed(Operation::kSubsume, f, g, 0); result != kNoVertex)
+       return result;
+   Vertex one = vertices_[f];
+   Vertex two = vertices_[g];
+   VertexIndex result;
+   if (one.literal < two.literal) {
+       VertexIndex high = Subsume(one.high, g);
+       result = MakeVertex(one.literal, high, Subsume(one.low, g));
+   } else if (one.literal > two.literal) {
+       result = Subsume(f, two.low);
+   } else {
+       VertexIndex high = Subsume(Subsume(one.high, two.high), two.low);
+       result = MakeVertex(one.literal, high, Subsume(one.low, two.low));
+   }
+   StoreComputed(Operation::kSubsume, f, g, 0, result);
+   return result;
+}
+
+Zbdd::VertexIndex Zbdd::Minimize(VertexIndex f) {
+   if (f <= kBase)
+       return f;
+   if (VertexIndex result = FindComputed(Operation::kMinimize, f, 0, 0); result != kNoVertex)
+       return result;
+   Vertex record = vertices_[f];
+   VertexIndex low = Minimize(record.low);
+   VertexIndex high = Subsume(Minimize(record.high), low);
+   VertexIndex result = MakeVertex(record.literal, high, low);
+   StoreComputed(Operation::kMinimize, f, 0, 0, result);
+   return result;
+}
+
+Zbdd::VertexIndex Zbdd::Difference(VertexIndex f, VertexIndex g) {
+   if (f == kEmpty || f == g)
+       return kEmpty;
+   if (g == kEmpty)
+       return f;
+   if (f == kBase)
+       return HasEmpty(g) ? kEmpty : kBase;
+   if (VertexIndex result = FindComputed(Operation::kDifference, f, g, 0);
+       result != kNoVertex) {
+       return result;
+   }
+   Vertex one = vertices_[f];
+   Vertex two = vertices_[g];
+   VertexIndex result;
+   if (one.literal < two.literal) {
+       result = MakeVertex(one.literal, one.high, Difference(one.low, g));
+   } else if (one.literal > two.literal) {
+       result = Difference(f, two.low);
+   } else {
+       VertexIndex high = Difference(one.high, two.high);
+       result = MakeVertex(one.literal, high, Difference(one.low, two.low));
+   }
+   StoreComputed(Operation::kDifference, f, g, 0, result);
+   return result;
+}
+
+Zbdd::VertexIndex Zbdd::Prune(VertexIndex f, double factor) {
+   if (vertices_[f].min_p * factor >= cut_off_)
+       return f;
+   if (vertices_[f].max_p * factor < cut_off_)
+       return kEmpty;
+   assert(f > kBase);
+   if (auto it = pruned_.find({f, factor}); it != pruned_.end())
+       return it->second;
+   Vertex record = vertices_[f];
+   VertexIndex high = Prune(record.high, factor * p(record.literal));
+   VertexIndex result = MakeVertex(record.literal, high, Prune(record.low, factor));
+   pruned_.emplace(PruneKey{f, factor}, result);
+   return result;
+}
+
+std::vector<Zbdd::Product> Zbdd::products(VertexIndex root) const {
+   std::vector<Product> result;
+   ForEachProduct(root, [&result](std::span<const int> product) {
+       result.emplace_back(product.begin(), product.end());
+   });
+   return result;
+}
+
+double Zbdd::CountProducts(VertexIndex root) const { return SumProducts(root, false); }
+
+double Zbdd::RareEvent(VertexIndex root) const { return SumProducts(root, true); }
+
+double Zbdd::SumProducts(VertexIndex root, bool probability) const {
+   std::unordered_map<VertexIndex, double> sums = {{kEmpty, 0}, {kBase, 1}};
+   std::vector<VertexIndex> stack = {root};
+   while (!stack.empty()) {
+       VertexIndex index = stack.back();
+       if (sums.contains(index)) {
+           stack.pop_back();
+           continue;
+       }
+       const Vertex& record = vertices_[index];
+       auto high = sums.find(record.high);
+       auto low = sums.find(record.low);
+       if (high == sums.end() || low == sums.end()) {
+           // The children are summed before their parents.
+           if (high == sums.end())
+               stack.push_back(record.high);
+           if (low == sums.end())
+               stack.push_back(record.low);
+           continue;
+       }
+       double weight = probability ? p(record.literal) : 1;
+       sums.emplace(index, weight * high->second + low->second);
+       stack.pop_back();
+   }
+   return sums[root];
+}
+
+double Zbdd::Mcub(VertexIndex root) const {
+   double complement = 1;
+   ForEachProduct(root, [this, &complement](std::span<const int> product) {
+       double p_product = 1;
+       for (int id : product)
+           p_product *= id < 0 ? 1 - p_vars_[~id] : p_vars_[id];
+       complement *= 1 - p_product;
+   });
+   return 1 - complement;
+}
+
+}  // namespace canopy::core
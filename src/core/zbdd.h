@@ -0,0 +1,243 @@
+/// @file
+/// Zero-suppressed binary decision diagrams for products of fault trees.
+
+#pragma once
+
+#include <cstdint>
+
+#include <limits>
+#include <functional>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "core/bdd.h"
+#include "core/pdag.h"
+#include "mef/openpsa/settings.h"
+
+namespace canopy::core {
+
+/// Zero-suppressed BDD package for families of products,
+/// i.e., minimal cut sets or prime implicants.
+///
+/// Vertices decide on literals ordered by the variable levels
+/// with the positive literal of a variable before its complement.
+/// The terminal Empty is the empty family,
+/// and the terminal Base is the family with the empty product.
+///
+/// Products above the order limit are pruned during every operation,
+/// and products below the probability cut-off
+/// are pruned from the family of every gate and root,
+/// so that the intermediate families stay within the final size.
+/// The pruning is exact for the final products
+/// because gate products only grow in order and shrink in probability
+/// as they propagate up the graph.
+class Zbdd {
+ public:
+   using VertexIndex = std::uint32_t;  ///< The index of vertices.
+   using Product = std::vector<int>;  ///< Variable ids with ~id for complements.
+
+   static constexpr VertexIndex kEmpty = 0;  ///< The empty family.
+   static constexpr VertexIndex kBase = 1;  ///< The family of the empty product.
+
+   /// The literal of terminal vertices below all variables.
+   static constexpr int kTerminalLiteral = std::numeric_limits<int>::max();
+
+   /// Decision vertex on the literal.
+   struct Vertex {
+       int literal;  ///< Twice the level of the variable plus the complement flag.
+       VertexIndex high;  ///< The products with the literal.
+       VertexIndex low;  ///< The products without the literal.
+       double max_p;  ///< The max probability of the products.
+       double min_p;  ///< The min probability of the products.
+   };
+
+   /// Generates the minimal cut sets of the PDAG roots bottom-up.
+   /// Complemented variables are treated as certain (Unity)
+   /// to get the minimal cut sets of non-coherent graphs.
+   ///
+   /// @param[in] graph  The graph with the roots.
+   ///                   The variables are ordered as in the graph.
+   /// @param[in] p_vars  The probabilities of the graph variables.
+   /// @param[in] settings  The limit order and the cut-off for pruning.
+   Zbdd(const Pdag& graph, std::span<const double> p_vars,
+        const mef::openpsa::Settings& settings);
+
+   /// Converts the BDD roots into the prime implicants
+   /// or the minimal cut sets if prime implicants are not requested.
+   ///
+   /// @param[in,out] bdd  The BDD of the function for consensus operations.
+   /// @param[in] p_vars  The probabilities of the BDD variables.
+   /// @param[in] settings  The product type, the limit order and the cut-off.
+   Zbdd(Bdd* bdd, std::span<const double> p_vars, const mef::openpsa::Settings& settings);
+
+   /// @returns The product families of the roots in the same order.
+   const std::vector<VertexIndex>& roots() const { return roots_; }
+
+   /// @returns The number of vertices including the terminals.
+   std::size_t size() const { return vertices_.size(); }
+
+   /// @returns The vertex at the index.
+   const Vertex& vertex(VertexIndex index) const { return vertices_[index]; }
+
+   /// @returns The signed variable id of the literal (~id for complements).
+   int variable(int literal) const {
+       int id = variables_[literal >> 1];
+       return literal & 1 ? ~id : id;
+   }
+
+   /// Visits all the products of the family.
+   ///
+   /// @param[in] root  The family of products.
+   /// @param[in] visitor  The callback with the current product as std::span<const int>.
+   template <class Visitor>
+   void ForEachProduct(VertexIndex root, Visitor&& visitor) const {
+       std::vector<int> product;
+       VisitProducts(root, &product, visitor);
+   }
+
+   /// @returns All the products of the family.
+   std::vector<Product> products(VertexIndex root) const;
+
+   /// @returns The number of products in the family.
+   double CountProducts(VertexIndex root) const;
+
+   /// @returns The rare-event approximation of the family probability.
+   double RareEvent(VertexIndex root) const;
+
+   /// @returns The min cut upper bound of the family probability.
+   double Mcub(VertexIndex root) const;
+
+ private:
+   /// Operations of the computed table.
+   enum class Operation : std::uint8_t { kUnion, kMultiply, kSubsume, kMinimize, kDifference };
+
+   /// Entry of the computed table.
+   struct Computation {
+       Operation operation = Operation::kUnion;  ///< The cached operation.
+       int limit = 0;  ///< The order limit of the result.
+       VertexIndex f = std::numeric_limits<VertexIndex>::max();
+       VertexIndex g = 0;
+       VertexIndex result = 0;
+   };
+
+   /// Sets up the terminals and the variable order.
+   Zbdd(std::vector<int> order, std::span<const double> p_vars,
+        const mef::openpsa::Settings& settings);
+
+   /// @returns The probability of the literal.
+   double p(int literal) const {
+       double p_var = p_vars_[variables_[literal >> 1]];
+       return literal & 1 ? 1 - p_var : p_var;
+   }
+
+   /// Finds or creates the reduced vertex.
+   VertexIndex MakeVertex(int literal, VertexIndex high, VertexIndex low);
+
+   /// Family operations.
+   /// @{
+   VertexIndex Union(VertexIndex f, VertexIndex g);
+   VertexIndex Multiply(VertexIndex f, VertexIndex g, int limit);  ///< Cross product.
+   VertexIndex Subsume(VertexIndex f, VertexIndex g);  ///< Non-supersets of g in f.
+   VertexIndex Minimize(VertexIndex f);
+   VertexIndex Difference(VertexIndex f, VertexIndex g);
+   /// @}
+
+   /// The vertex with the probability of the literals above it
+   /// as the key of the pruned families.
+   using PruneKey = std::pair<VertexIndex, double>;
+
+   /// Hash of the pruned families.
+   struct PruneKeyHash {
+       std::size_t operator()(const PruneKey& key) const noexcept {
+           return std::hash<double>()(key.second) * 0x9E3779B97F4A7C15 ^ key.first;
+       }
+   };
+
+   /// Removes products below the cut-off.
+   ///
+   /// @param[in] f  The family of products.
+   /// @param[in] factor  The probability of the literals outside of the family.
+   VertexIndex Prune(VertexIndex f, double factor);
+
+   /// Applies the cut-off to the family of a gate or root if requested.
+   VertexIndex Prune(VertexIndex f) { return cut_off_ > 0 ? Prune(f, 1) : f; }
+
+   /// @returns The family of products of the graph node.
+   VertexIndex Convert(const Pdag& graph, Pdag::Index index, std::vector<VertexIndex>* memo);
+
+   /// @returns The k-out-of-n family of the arg families.
+   VertexIndex Vote(std::span<const VertexIndex> args, int min_number,
+                    std::unordered_map<std::uint32_t, VertexIndex>* memo);
+
+   /// @returns The prime implicants (or minimal cut sets) of the BDD function.
+   VertexIndex Convert(Bdd* bdd, Bdd::Edge edge, int limit,
+                       std::unordered_map<std::uint64_t, VertexIndex>* memo);
+
+   /// Sums the products of the family over the vertices reachable from the root.
+   ///
+   /// @param[in] root  The family of products.
+   /// @param[in] probability  The flag to weigh the products by their probabilities
+   ///                         instead of counting them.
+   ///
+   /// @returns The number or the total probability of the products.
+   double SumProducts(VertexIndex root, bool probability) const;
+
+   /// @returns true if the family contains the empty product.
+   bool HasEmpty(VertexIndex f) const {
+       while (f > kBase)
+           f = vertices_[f].low;
+       return f == kBase;
+   }
+
+   /// Looks up the computed table.
+   ///
+   /// @returns The cached result or the max vertex index if not found.
+   VertexIndex FindComputed(Operation operation, VertexIndex f, VertexIndex g, int limit) const;
+
+   /// Stores the result in the computed table.
+   void StoreComputed(Operation operation, VertexIndex f, VertexIndex g, int limit,
+                      VertexIndex result);
+
+   /// @returns The computed table slot of the operation.
+   std::size_t Slot(Operation operation, VertexIndex f, VertexIndex g, int limit) const {
+       std::uint64_t key = (std::uint64_t{f} << 32) ^ g ^ (std::uint64_t(limit) << 20) ^
+                           static_cast<std::uint64_t>(operation);
+       key = (key ^ (key >> 31)) * 0xBF58476D1CE4E5B9;
+       return (key ^ (key >> 29)) & (computed_table_.size() - 1);
+   }
+
+   /// Doubles the unique table and reinserts the vertices.
+   void GrowUniqueTable();
+
+   /// Recursive product enumeration for ForEachProduct.
+   template <class Visitor>
+   void VisitProducts(VertexIndex f, std::vector<int>* product, Visitor& visitor) const {
+       if (f == kEmpty)
+           return;
+       if (f == kBase) {
+           visitor(std::span<const int>(*product));
+           return;
+       }
+       const Vertex& record = vertices_[f];
+       product->push_back(variable(record.literal));
+       VisitProducts(record.high, product, visitor);
+       product->pop_back();
+       VisitProducts(record.low, product, visitor);
+   }
+
+   int limit_order_;  ///< The max number of literals in products.
+   double cut_off_;  ///< The min probability of products.
+   bool prime_implicants_;  ///< The generation of prime implicants.
+   std::vector<double> p_vars_;  ///< The variable probabilities.
+   std::vector<int> variables_;  ///< The variable ids by levels.
+   std::vector<Vertex> vertices_;  ///< All vertices with the terminals at 0 and 1.
+   std::vector<VertexIndex> unique_table_;  ///< Vertex indices; 0 for empty.
+   std::vector<Computation> computed_table_;  ///< The lossy operation cache.
+   /// The pruned families shared by the gates and roots.
+   std::unordered_map<PruneKey, VertexIndex, PruneKeyHash> pruned_;
+   std::vector<VertexIndex> roots_;  ///< The families of the roots.
+};
+
+}  // namespace canopy::core
@@ -7,17 +7,16 @@
 
 #pragma once
 
+#include <algorithm>
 #include <memory>
 #include <optional>
+#include <span>
 #include <string>
 #include <type_traits>
 #include <cmath>
 #include <utility>
 #include <vector>
 
-#include <boost/algorithm/string/join.hpp>
-#include <boost/range/adaptor/transformed.hpp>
-
 #include "mef/openpsa/expr/constant.h"
 #include "mef/openpsa/expr/numerical.h"
 #include "mef/openpsa/element.h"
@@ -26,53 +25,6 @@
 
 namespace mef::openpsa {
 
-class CcfGroup;  // CCF Events know their own groups.
-
-/// A basic event that represents a multiple failure of
-/// a group of events due to a common cause.
-/// This event is generated out of a common cause group.
-/// This class is a helper to report correctly the CCF events.
-class CcfEvent : public BasicEvent {
- public:
-   /// Constructs CCF event with specific name
-   /// that is used for internal purposes.
-   /// This name is formatted with the CcfGroup.
-   /// The creator CCF group and the member events of this specific CCF event
-   /// are saved for reporting.
-   ///
-   /// @param[in] members  The members that this CCF event
-   ///                     represents as multiple failure.
-   /// @param[in] ccf_group  The CCF group that created this event.
-   CcfEvent(std::vector<Gate*> members, const CcfGroup* ccf_group);
-
-   /// @returns The CCF group that created this CCF event.
-   const CcfGroup& ccf_group() const { return ccf_group_; }
-
-   /// @returns Members of this CCF event.
-   ///          The members also own this CCF event through parentship.
-   const std::vector<Gate*>& members() const { return members_; }
-
- private:
-   /// Creates a mangled name
-   /// that is specific to CCF events and unique per model.
-   ///
-   /// @param[in] members  The members that this CCF event represents.
-   ///
-   /// @returns The name string valid only for internal uses.
-   static std::string MakeName(const std::vector<Gate*>& members) {
-       return "[" +
-              boost::join(members | boost::adaptors::transformed(
-                                        [](const Gate* gate) -> decltype(auto) {
-                                            return gate->name();
-                                        }),
-                          " ") +
-              "]";
-   }
-
-   const CcfGroup& ccf_group_;  ///< The originating CCF group.
-   std::vector<Gate*> members_;  ///< Member parent gates of this CCF event.
-};
-
 /// Abstract base class for all common cause failure models.
 class CcfGroup : public Id {
  public:
@@ -83,9 +35,75 @@ class CcfGroup : public Id {
 
    virtual ~CcfGroup() = default;
 
+   /// Mapping expressions and their application levels.
+   using ExpressionMap = std::vector<std::pair<int, Expression*>>;
+
    /// @returns Members of the CCF group with original names as keys.
    const std::vector<BasicEvent*>& members() const { return members_; }
 
+   /// @returns The probability distribution of the events.
+   Expression* distribution() const { return distribution_; }
+
+   /// @returns CCF factors of the model.
+   const ExpressionMap& factors() const { return factors_; }
+
+   /// @returns The probabilities of a CCF event of specific members
+   ///          for each level of groupings in ascending order.
+   ///
+   /// @pre The model is applied.
+   const ExpressionMap& probabilities() const { return probabilities_; }
+
+   /// @param[in] member  A member basic event of this group.
+   ///
+   /// @returns The index of the member in the members container.
+   int member_index(const BasicEvent& member) const {
+       auto it = std::find(members_.begin(), members_.end(), &member);
+       assert(it != members_.end() && "Not a member of the CCF group.");
+       return it - members_.begin();
+   }
+
+   /// Creates the name of the CCF event for reporting.
+   /// The name is specific to CCF events and unique per model.
+   ///
+   /// @param[in] members  The member indices of the CCF event.
+   ///
+   /// @returns The member names in brackets.
+   std::string CcfEventName(std::span<const int> members) const {
+       std::string name = "[";
+       for (int index : members) {
+           if (name.size() > 1)
+               name += " ";
+           name += members_[index]->name();
+       }
+       return name + "]";
+   }
+
+   /// Enumerates the CCF events of the applied model on demand
+   /// without materializing them as basic events.
+   ///
+   /// @param[in] visitor  The callback with the ascending member indices
+   ///                     and the probability expression of a CCF event.
+   ///
+   /// @pre The model is applied.
+   template <class Visitor>
+   void ForEachCcfEvent(Visitor&& visitor) const {
+       std::vector<int> indices(members_.size());
+       for (int i = 0; i < static_cast<int>(indices.size()); ++i)
+           indices[i] = i;
+       std::vector<int> combination;
+       for (const std::pair<int, Expression*>& level_probability : probabilities_) {
+           for_each_combination(indices.begin(),
+                                std::next(indices.begin(), level_probability.first),
+                                indices.end(), [&](auto first, auto last) {
+                                    combination.assign(first, last);
+                                    std::sort(combination.begin(), combination.end());
+                                    visitor(std::span<const int>(combination),
+                                            level_probability.second);
+                                    return false;
+                                });
+       }
+   }
+
    /// Adds a basic event into this CCF group.
    /// This function asserts that each basic event has unique string id.
    ///
@@ -208,67 +226,20 @@ class CcfGroup : public Id {
    }
 
    /// Processes the given factors and members
-   /// to create common cause failure probabilities and new events
-   /// that can replace the members in a fault tree.
+   /// to create common cause failure probabilities
+   /// and assigns the group to the members,
+   /// so the analyses can replace the members in a fault tree
+   /// with the implicit CCF events of the group.
    ///
    /// @pre The CCF is validated.
    void ApplyModel() {
-       // Construct replacement proxy gates for member basic events.
-       std::vector<std::pair<Gate*, Formula::ArgSet>> proxy_gates;
-       for (BasicEvent* member : members_) {
-           auto new_gate = std::make_unique<Gate>(member->name(), member->base_path(),
-                                                  member->role());
-           assert(member->id() == new_gate->id());
-           proxy_gates.push_back({new_gate.get(), {}});
-           member->ccf_gate(std::move(new_gate));
-       }
-
-       ExpressionMap probabilities = this->CalculateProbabilities();
-       assert(probabilities.size() > 1);
-
-       for (const auto& level_prob_pair : probabilities) {
-           const auto& level = level_prob_pair.first;
-           const auto& prob = level_prob_pair.second;
-
-           using Iterator = decltype(proxy_gates)::iterator;
-           auto combination_visitor = [this, &level, &prob](Iterator it_begin, Iterator it_end)
-           {
-               std::vector<Gate*> combination;
-               for (auto it = it_begin; it != it_end; ++it)
-                   combination.push_back(it->first);
-
-               auto ccf_event = std::make_unique<CcfEvent>(std::move(combination), this);
-
-               for (auto it = it_begin; it != it_end; ++it)
-                   it->second.Add(ccf_event.get());
-
-               ccf_event->expression(prob);
-               ccf_events_.emplace_back(std::move(ccf_event));
-
-               return false;
-           };
-           for_each_combination(proxy_gates.begin(),
-                                     std::next(proxy_gates.begin(), level),
-                                     proxy_gates.end(), combination_visitor);
-       }
-
-       // Assign formulas to the proxy gates.
-       for (std::pair<Gate*, Formula::ArgSet>& gate : proxy_gates) {
-           assert(gate.second.size() >= 2);
-           gate.first->formula(std::make_unique<Formula>(kOr, std::move(gate.second)));
-       }
+       probabilities_ = this->CalculateProbabilities();
+       assert(probabilities_.size() > 1);
+       for (BasicEvent* member : members_)
+           member->ccf_group(this);
    }
 
  protected:
-   /// Mapping expressions and their application levels.
-   using ExpressionMap = std::vector<std::pair<int, Expression*>>;
-
-   /// @returns The probability distribution of the events.
-   Expression* distribution() const { return distribution_; }
-
-   /// @returns CCF factors of the model.
-   const ExpressionMap& factors() const { return factors_; }
-
    /// Registers a new expression for ownership by the group.
    /// @{
    template <class T, typename... Ts>
@@ -310,8 +281,8 @@ class CcfGroup : public Id {
    ExpressionMap factors_;  ///< CCF factors for models to get CCF probabilities.
    /// Collection of expressions created specifically for this group.
    std::vector<std::unique_ptr<Expression>> expressions_;
-   /// CCF events created by the group.
-   std::vector<std::unique_ptr<CcfEvent>> ccf_events_;
+   /// CCF event probabilities by the levels of the applied model.
+   ExpressionMap probabilities_;
 };
 
 /// Common cause failure model that assumes,
@@ -457,9 +428,4 @@ class PhiFactorModel : public CcfGroup {
    }
 };
 
-CcfEvent::CcfEvent(std::vector<Gate*> members, const CcfGroup* ccf_group)
-    : BasicEvent(MakeName(members), ccf_group->base_path(), ccf_group->role()),
-      ccf_group_(*ccf_group),
-      members_(std::move(members)) {}
-
 }  // namespace scram::mef
@@ -15,14 +15,12 @@
 #include <vector>
 
 #include <boost/iterator/iterator_facade.hpp>
-#include <boost/multi_index/hashed_index.hpp>
-#include <boost/multi_index/mem_fun.hpp>
-#include <boost/multi_index_container.hpp>
 #include <boost/noncopyable.hpp>
 
 #include "mef/openpsa/error.h"
+#include "mef/openpsa/flat_table.h"
 #include "mef/openpsa/linear_set.h"
-#include "mef/openpsa/multi_index.h"
+#include "mef/openpsa/symbol.h"
 
 namespace mef::openpsa {
 
@@ -144,10 +142,13 @@ class Element : public ContainerElement, private boost::noncopyable {
    explicit Element(std::string name) { Element::name(std::move(name)); }
 
    /// @returns The original name.
-   [[nodiscard]] const std::string& name() const { return name_; }
+   [[nodiscard]] const std::string& name() const { return name_.str(); }
+
+   /// @returns The string view to the name.
+   [[nodiscard]] std::string_view name_view() const { return name(); }
 
-   /// @returns The string view to the name for table keys.
-   [[nodiscard]] std::string_view name_view() const { return name_; }
+   /// @returns The interned name for table keys.
+   [[nodiscard]] Symbol name_symbol() const { return name_; }
 
    /// @returns The empty or preset label.
    /// @returns Empty string if the label has not been set.
@@ -175,7 +176,7 @@ class Element : public ContainerElement, private boost::noncopyable {
    ///          to existing attributes may get invalidated.
    [[maybe_unused]] void AddAttribute(Attribute attr) {
        if (!attributes_.insert(std::move(attr)).second) {
-           throw ValidityError("Duplicate attribute: "+name_+" "+attr.name());
+           throw ValidityError("Duplicate attribute: "+name()+" "+attr.name());
        }
    }
 
@@ -242,11 +243,11 @@ class Element : public ContainerElement, private boost::noncopyable {
            throw (LogicError("The element name cannot be empty"));
        if (name.find('.') != std::string::npos)
            throw (ValidityError("The element name is malformed."));
-       name_ = std::move(name);
+       name_ = Symbol(name);
    }
 
  private:
-   std::string name_;  ///< The original name of the element.
+   Symbol name_;  ///< The original name of the element.
    std::string label_;  ///< The label text for the element.
 
    /// Element attributes ordered by insertion time.
@@ -254,6 +255,15 @@ class Element : public ContainerElement, private boost::noncopyable {
    AttributeMap attributes_;
 };
 
+/// Name key extractor of element pointers.
+struct NameKey {
+   /// @returns The interned name of the pointee element.
+   template <typename T>
+   Symbol operator()(const T& element) const {
+       return element->name_symbol();
+   }
+};
+
 /// Table of elements with unique names.
 ///
 /// @tparam T  Value or (smart/raw) pointer type deriving from Element class.
@@ -261,11 +271,7 @@ class Element : public ContainerElement, private boost::noncopyable {
 /// @pre The element names are not modified
 ///      while it is in the container.
 template <typename T>
-using ElementTable = boost::multi_index_container<
-   T, boost::multi_index::indexed_by<boost::multi_index::hashed_unique<
-          boost::multi_index::const_mem_fun<Element, std::string_view,
-                                            &Element::name_view>,
-          std::hash<std::string_view>>>>;
+using ElementTable = FlatTable<T, NameKey, std::hash<Symbol>>;
 
 /// Role, access attributes for elements.
 enum class RoleSpecifier : std::uint8_t { kPublic, kPrivate };
@@ -286,11 +292,9 @@ class Role {
    /// @throws ValidityError  The base path string is malformed.
    /// @throws ValidityError  Private element at model/global scope.
    explicit Role(RoleSpecifier role = RoleSpecifier::kPublic,
-                 std::string base_path = "") : kBasePath_(std::move(base_path)), kRole_(role) {
-       if (!kBasePath_.empty() &&
-           (kBasePath_.front() == '.' || kBasePath_.back() == '.')) {
+                 std::string base_path = "") : kBasePath_(base_path), kRole_(role) {
+       if (!base_path.empty() && (base_path.front() == '.' || base_path.back() == '.'))
            throw(ValidityError("Element reference base path is malformed."));
-       }
        if (kRole_ == RoleSpecifier::kPrivate && kBasePath_.empty())
            throw(ValidityError("Elements cannot be private at model scope."));
    }
@@ -299,13 +303,16 @@ class Role {
    [[nodiscard]] RoleSpecifier role() const { return kRole_; }
 
    /// @returns The base path containing ancestor container names.
-   [[nodiscard]] const std::string& base_path() const { return kBasePath_; }
+   [[nodiscard]] const std::string& base_path() const { return kBasePath_.str(); }
+
+   /// @returns The interned base path.
+   [[nodiscard]] Symbol base_path_symbol() const { return kBasePath_; }
 
  protected:
    ~Role() = default;
 
  private:
-   const std::string kBasePath_;  ///< A series of ancestor containers.
+   const Symbol kBasePath_;  ///< A series of ancestor containers.
    const RoleSpecifier kRole_;  ///< The role of the element.
 };
 
@@ -321,6 +328,34 @@ std::string GetFullPath(const T* element) {
    return element->base_path() + "." + element->name();
 }
 
+/// The full path of an element as the interned base path and name,
+/// so lookups by relative references need no path concatenation.
+struct PathKey {
+   Symbol base_path;  ///< The series of ancestor containers.
+   Symbol name;  ///< The local name.
+
+   /// Equality by the symbols.
+   bool operator==(const PathKey&) const = default;
+};
+
+/// Full path key extractor of element pointers.
+struct PathKeyOf {
+   /// @returns The full path of the pointee element.
+   template <typename T>
+   PathKey operator()(const T& element) const {
+       return element->path_key();
+   }
+};
+
+/// Hash of full paths by the symbol ids.
+struct PathKeyHash {
+   /// @returns The hash of the combined symbol ids.
+   std::size_t operator()(const PathKey& key) const noexcept {
+       return std::hash<std::uint64_t>()(
+           (static_cast<std::uint64_t>(key.base_path.id()) << 32) | key.name.id());
+   }
+};
+
 /// Mixin class for assigning unique identifiers to elements.
 class Id : public Element, public Role {
  public:
@@ -338,16 +373,25 @@ class Id : public Element, public Role {
    }
 
    /// @returns The unique id that is set upon the construction of this element.
-   [[nodiscard]] const std::string& id() const {
-       return Role::role() == RoleSpecifier::kPublic ? Element::name()
-                                                     : full_path_;
-   }
+   [[nodiscard]] const std::string& id() const { return id_symbol().str(); }
 
-   /// @returns The string view to the id to be used as a table key.
+   /// @returns The string view to the id.
    [[nodiscard]] std::string_view id_view() const { return id(); }
 
-   /// @returns The string view to the unique full path for a table key.
-   [[maybe_unused]] [[nodiscard]] std::string_view full_path() const { return full_path_; }
+   /// @returns The interned id to be used as a table key.
+   [[nodiscard]] Symbol id_symbol() const {
+       return Role::role() == RoleSpecifier::kPublic ? Element::name_symbol() : full_path_;
+   }
+
+   /// @returns The string view to the unique full path.
+   [[maybe_unused]] [[nodiscard]] std::string_view full_path() const {
+       return full_path_.str();
+   }
+
+   /// @returns The unique full path as a table key.
+   [[nodiscard]] PathKey path_key() const {
+       return {Role::base_path_symbol(), Element::name_symbol()};
+   }
 
    /// Resets the element ID.
    ///
@@ -359,7 +403,7 @@ class Id : public Element, public Role {
    /// @throws ValidityError  The name is malformed.
    void id(const std::string& name) {
        Element::name(name);
-       full_path_ = GetFullPath(this);
+       full_path_ = Symbol(GetFullPath(this));
    }
 
    /// Produces unique name for the model element within the same type.
@@ -376,7 +420,16 @@ class Id : public Element, public Role {
    ~Id() = default;
 
  private:
-   std::string full_path_;  ///< Unique for all elements per certain type.
+   Symbol full_path_;  ///< Unique for all elements per certain type.
+};
+
+/// Id key extractor of element pointers.
+struct IdKey {
+   /// @returns The interned id of the pointee element.
+   template <typename T>
+   Symbol operator()(const T& element) const {
+       return element->id_symbol();
+   }
 };
 
 /// Table of elements with unique ids.
@@ -386,11 +439,7 @@ class Id : public Element, public Role {
 /// @pre The element IDs are not modified
 ///      while it is in the container.
 template <typename T>
-using IdTable = boost::multi_index_container<
-   T,
-   boost::multi_index::indexed_by<boost::multi_index::hashed_unique<
-       boost::multi_index::const_mem_fun<Id, std::string_view, &Id::id_view>,
-       std::hash<std::string_view>>>>;
+using IdTable = FlatTable<T, IdKey, std::hash<Symbol>>;
 
 /// Wraps the element container tables into ranges of plain references
 /// to hide the memory smart or raw pointers.
@@ -457,6 +506,18 @@ class TableRange {
    iterator cend() const { return table_.end(); }
    /// @}
 
+   /// Lookups by strings without interning for the symbol-keyed tables.
+   /// @{
+   std::size_t count(std::string_view key) const {
+       std::optional<Symbol> symbol = Symbol::Find(key);
+       return symbol ? table_.count(*symbol) : 0;
+   }
+   iterator find(std::string_view key) const {
+       std::optional<Symbol> symbol = Symbol::Find(key);
+       return symbol ? table_.find(*symbol) : table_.end();
+   }
+   /// @}
+
  private:
    T& table_;  ///< The associative table being wrapped by this range.
 };
@@ -495,17 +556,17 @@ class Container {
    ///
    /// @throws UndefinedElement  The element is not found.
    /// @{
-   const T& Get(const key_type& id) const {
-       auto it = table_.find(id);
-       if (it != table_.end())
-           return **it;
+   const T& Get(std::string_view id) const {
+       auto it = table().find(id);
+       if (it != table().end())
+           return *it;
 
        throw(UndefinedElement());
            //<< errinfo_element(std::string(id), T::kTypeString)
            //<< errinfo_container(Id::unique_name(static_cast<const Self&>(*this)),
           //                      Self::kTypeString);
    }
-   T& Get(const key_type& id) {
+   T& Get(std::string_view id) {
        return const_cast<T&>(std::as_const(*this).Get(id));
    }
    /// @}
@@ -536,11 +597,11 @@ class Container {
    /// @throws UndefinedElement  The element cannot be found in the container.
    /// @throws LogicError  The element in the container is not the same object.
    [[maybe_unused]] Pointer Remove(T* element) {
-       const std::string& key = [element]() -> decltype(auto) {
+       Symbol key = [element] {
            if constexpr (ById) {
-               return element->id();
+               return element->id_symbol();
            } else {
-               return element->name();
+               return element->name_symbol();
            }
        }();
 
@@ -559,7 +620,7 @@ class Container {
            throw;
        }
        element->container(nullptr);
-       return extract(it, &table_);  // no-throw.
+       return table_.extract(it);  // no-throw.
    }
 
  protected:
@@ -639,12 +700,12 @@ class Composite : public Ts... {
    /// @{
    template <class T,
              class ContainerType = typename detail::container_of<T, Ts...>::type>
-   const T& Get(const typename ContainerType::key_type& id) const {
+   const T& Get(std::string_view id) const {
        return ContainerType::Get(id);
    }
    template <class T,
              class ContainerType = typename detail::container_of<T, Ts...>::type>
-   T& Get(const typename ContainerType::key_type& id) {
+   T& Get(std::string_view id) {
        return ContainerType::Get(id);
    }
    /// @}
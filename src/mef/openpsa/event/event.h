@@ -35,8 +35,11 @@ class HouseEvent : public Event {
  public:
    static constexpr const char* kTypeString = "house event";  ///< In errors.
 
+   /// The literal events named with the symbols reserved in every symbol table.
+   /// @{
    static HouseEvent kTrue;  ///< Literal True event.
    static HouseEvent kFalse;  ///< Literal False event.
+   /// @}
 
    using Event::Event;
 
@@ -57,6 +60,7 @@ class HouseEvent : public Event {
 };
 
 class Gate;
+class CcfGroup;  // The source of CCF events for members.
 
 /// Representation of a basic event in a fault tree.
 class BasicEvent : public Event {
@@ -105,24 +109,24 @@ class BasicEvent : public Event {
    /// Indicates if this basic event has been set to be in a CCF group.
    ///
    /// @returns true if in a CCF group.
-   [[nodiscard]] bool HasCcf() const { return ccf_gate_ != nullptr; }
+   [[nodiscard]] bool HasCcf() const { return ccf_group_ != nullptr; }
 
-   /// @returns CCF group gate representing this basic event.
-   [[nodiscard]] const Gate& ccf_gate() const {
-       assert(ccf_gate_);
-       return *ccf_gate_;
+   /// @returns The CCF group with the model for this basic event.
+   [[nodiscard]] const CcfGroup& ccf_group() const {
+       assert(ccf_group_);
+       return *ccf_group_;
    }
 
-   /// Sets the common cause failure group gate
-   /// that can represent this basic event
+   /// Sets the common cause failure group
+   /// whose implicit CCF events can represent this basic event
    /// in analysis with common cause information.
    /// This information is expected to be provided by
    /// CCF group application.
    ///
-   /// @param[in] gate  CCF group gate.
-   void ccf_gate(std::unique_ptr<Gate> gate) {
-       assert(!ccf_gate_);
-       ccf_gate_ = std::move(gate);
+   /// @param[in] ccf_group  The CCF group with the applied model.
+   void ccf_group(const CcfGroup* ccf_group) {
+       assert(!ccf_group_);
+       ccf_group_ = ccf_group;
    }
 
  private:
@@ -131,9 +135,9 @@ class BasicEvent : public Event {
    Expression* expression_ = nullptr;
 
    /// If this basic event is in a common cause group,
-   /// CCF gate can serve as a replacement for the basic event
+   /// the CCF events of the group can serve as a replacement for the basic event
    /// for common cause analysis.
-   std::unique_ptr<Gate> ccf_gate_;
+   const CcfGroup* ccf_group_ = nullptr;
 };
 
 class Formula;  // To describe a gate's formula.
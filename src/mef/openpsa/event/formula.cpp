@@ -31,32 +31,15 @@
 
 #include <boost/range/algorithm.hpp>
 
+#include "mef/openpsa/event/event.h"
 #include "mef/openpsa/event/formula.h"
+#include "mef/openpsa/event/gate.h"
 #include "mef/openpsa/error.h"
 #include "mef/openpsa/algorithm.h"
 #include "mef/openpsa/variant.h"
 
 namespace mef::openpsa {
 
-Event::~Event() = default;
-
-HouseEvent HouseEvent::kTrue = []() {
-    HouseEvent house_event("__true__");
-    house_event.state(true);
-    return house_event;
-}();
-HouseEvent HouseEvent::kFalse("__false__");
-
-[[maybe_unused]] void BasicEvent::Validate() const {
-    assert(expression_ && "The basic event's expression is not set.");
-    try {
-        EnsureProbability(expression_);
-    } catch (DomainError& err) {
-        //err << errinfo_element(Event::name(), kTypeString);
-        throw;
-    }
-}
-
 void Formula::ArgSet::Add(ArgEvent event, bool complement) {
     auto* base = variant::as<Event*>(event);
     if (any_of(args_, [&base](const Arg& arg) {
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "mef/openpsa/event/event.h"
+
 namespace mef::openpsa {
 /// Boolean formula with connectives and arguments.
 /// Formulas are not expected to be shared.
@@ -26,6 +26,7 @@
 #pragma once
 
 #include "mef/openpsa/event/event.h"
+#include "mef/openpsa/event/formula.h"
 namespace mef::openpsa {
 /// A representation of a gate in a fault tree.
 class Gate : public Event, public NodeMark {
@@ -110,16 +110,19 @@ class Path : public Branch {
    /// @param[in] state  State identifier string for functional event.
    ///
    /// @throws LogicError  The string is empty or malformed.
-   explicit Path(std::string state) : state_(std::move(state)) {
+   explicit Path(std::string state) : state_(state) {
        if (state_.empty())
            throw(LogicError("The state string for functional events cannot be empty"));
    }
 
    /// @returns The state of a functional event.
-   const std::string& state() const { return state_; }
+   const std::string& state() const { return state_.str(); }
+
+   /// @returns The interned state of a functional event.
+   Symbol state_symbol() const { return state_; }
 
  private:
-   std::string state_;  ///< The state identifier.
+   Symbol state_;  ///< The state identifier.
 };
 
 /// Functional event forks.
@@ -0,0 +1,212 @@
+/// @file
+/// Implementation of the expressions with exponential formulas.
+
+#include "mef/openpsa/expr/exponential.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mef::openpsa {
+
+Exponential::Exponential(Expression* lambda, Expression* t)
+    : ExpressionFormula({lambda, t}), lambda_(*lambda), time_(*t) {}
+
+void Exponential::Validate() const {
+   EnsureNonNegative(&lambda_, "Rate of failure");
+   EnsureNonNegative(&time_, "Mission time");
+}
+
+double Exponential::Compute(double lambda, double time) noexcept {
+   return 1 - std::exp(-(lambda * time));
+}
+
+Glm::Glm(Expression* gamma, Expression* lambda, Expression* mu, Expression* t)
+    : ExpressionFormula({gamma, lambda, mu, t}),
+      gamma_(*gamma),
+      lambda_(*lambda),
+      mu_(*mu),
+      time_(*t) {}
+
+void Glm::Validate() const {
+   EnsureProbability(&gamma_, "failure on demand");
+   EnsurePositive(&lambda_, "Rate of failure");
+   EnsureNonNegative(&mu_, "Rate of repair");
+   EnsureNonNegative(&time_, "Mission time");
+}
+
+double Glm::Compute(double gamma, double lambda, double mu, double time) noexcept {
+   double r = lambda + mu;
+   return (lambda - (lambda - gamma * r) * std::exp(-r * time)) / r;
+}
+
+Weibull::Weibull(Expression* alpha, Expression* beta, Expression* t0, Expression* time)
+    : ExpressionFormula({alpha, beta, t0, time}),
+      alpha_(*alpha),
+      beta_(*beta),
+      t0_(*t0),
+      time_(*time) {}
+
+void Weibull::Validate() const {
+   EnsurePositive(&alpha_, "Scale parameter for Weibull distribution");
+   EnsurePositive(&beta_, "Shape parameter for Weibull distribution");
+   EnsureNonNegative(&t0_, "Time shift");
+   EnsureNonNegative(&time_, "Mission time");
+}
+
+double Weibull::Compute(double alpha, double beta, double t0, double time) noexcept {
+   return time <= t0 ? 0 : 1 - std::exp(-std::pow((time - t0) / alpha, beta));
+}
+
+PeriodicTest::PeriodicTest(Expression* lambda, Expression* tau, Expression* theta,
+                           Expression* time)
+    : Expression({lambda, tau, theta, time}),
+      flavor_(std::make_unique<InstantRepair>(lambda, tau, theta, time)) {}
+
+PeriodicTest::PeriodicTest(Expression* lambda, Expression* mu, Expression* tau,
+                           Expression* theta, Expression* time)
+    : Expression({lambda, mu, tau, theta, time}),
+      flavor_(std::make_unique<InstantTest>(lambda, mu, tau, theta, time)) {}
+
+PeriodicTest::PeriodicTest(Expression* lambda, Expression* lambda_test, Expression* mu,
+                           Expression* tau, Expression* theta, Expression* gamma,
+                           Expression* test_duration, Expression* available_at_test,
+                           Expression* sigma, Expression* omega, Expression* time)
+    : Expression({lambda, lambda_test, mu, tau, theta, gamma, test_duration,
+                  available_at_test, sigma, omega, time}),
+      flavor_(std::make_unique<Complete>(lambda, lambda_test, mu, tau, theta, gamma,
+                                         test_duration, available_at_test, sigma, omega,
+                                         time)) {}
+
+namespace {
+
+/// The probabilities of the component states.
+struct State {
+   double up;  ///< The component is functioning.
+   double repair;  ///< The failure is detected and under repair.
+
+   /// @returns The unavailability of the component.
+   double failed() const { return 1 - up; }
+};
+
+/// Evolves the states over the time with the failures and repairs.
+/// The undetected failures stay failed until the next test.
+///
+/// @param[in] state  The initial state.
+/// @param[in] lambda  The failure rate.
+/// @param[in] mu  The repair rate.
+/// @param[in] time  The duration of the evolution.
+///
+/// @returns The state after the time.
+State Evolve(State state, double lambda, double mu, double time) noexcept {
+   double up = std::exp(-lambda * time) * state.up;
+   if (state.repair) {
+       // The repaired components start failing again.
+       double repaired = lambda == mu ? mu * time * std::exp(-lambda * time)
+                                      : mu * (std::exp(-mu * time) - std::exp(-lambda * time)) /
+                                            (lambda - mu);
+       up += state.repair * repaired;
+   }
+   return {up, state.repair * std::exp(-mu * time)};
+}
+
+}  // namespace
+
+void PeriodicTest::InstantRepair::Validate() const {
+   EnsurePositive(&lambda_, "Failure rate");
+   EnsurePositive(&tau_, "Time between tests");
+   EnsureNonNegative(&theta_, "Time before tests");
+   EnsureNonNegative(&time_, "Mission time");
+}
+
+double PeriodicTest::InstantRepair::value() noexcept {
+   return Compute(lambda_.value(), tau_.value(), theta_.value(), time_.value());
+}
+
+double PeriodicTest::InstantRepair::Sample() noexcept {
+   return Compute(lambda_.Sample(), tau_.Sample(), theta_.Sample(), time_.Sample());
+}
+
+double PeriodicTest::InstantRepair::Compute(double lambda, double tau, double theta,
+                                            double time) noexcept {
+   // Every test renews the component.
+   double time_after_test = time <= theta ? time : std::fmod(time - theta, tau);
+   return 1 - std::exp(-lambda * time_after_test);
+}
+
+void PeriodicTest::InstantTest::Validate() const {
+   InstantRepair::Validate();
+   EnsurePositive(&mu_, "Repair rate");
+}
+
+double PeriodicTest::InstantTest::value() noexcept {
+   return Compute(lambda_.value(), mu_.value(), tau_.value(), theta_.value(), time_.value());
+}
+
+double PeriodicTest::InstantTest::Sample() noexcept {
+   return Compute(lambda_.Sample(), mu_.Sample(), tau_.Sample(), theta_.Sample(),
+                  time_.Sample());
+}
+
+double PeriodicTest::InstantTest::Compute(double lambda, double mu, double tau, double theta,
+                                          double time) noexcept {
+   if (time <= theta)
+       return Evolve({1, 0}, lambda, mu, time).failed();
+   State state = Evolve({1, 0}, lambda, mu, theta);
+   int num_tests = (time - theta) / tau;  // The tests before the last one.
+   for (int i = 0; i < num_tests; ++i) {
+       state.repair = state.failed();  // The test detects all the failures.
+       state = Evolve(state, lambda, mu, tau);
+   }
+   state.repair = state.failed();
+   return Evolve(state, lambda, mu, time - theta - num_tests * tau).failed();
+}
+
+void PeriodicTest::Complete::Validate() const {
+   InstantTest::Validate();
+   EnsureNonNegative(&lambda_test_, "Failure rate under test");
+   EnsureProbability(&gamma_, "failure at test start");
+   EnsureNonNegative(&test_duration_, "Test duration");
+   EnsureProbability(&available_at_test_, "availability at test");
+   EnsureProbability(&sigma_, "failure detection upon test");
+   EnsureProbability(&omega_, "failure at restart");
+   if (test_duration_.value() > tau_.value())
+       throw(ValidityError("The test duration must be less than the time between tests."));
+}
+
+double PeriodicTest::Complete::value() noexcept {
+   return Compute(lambda_.value(), lambda_test_.value(), mu_.value(), tau_.value(),
+                  theta_.value(), gamma_.value(), test_duration_.value(),
+                  available_at_test_.value(), sigma_.value(), omega_.value(), time_.value());
+}
+
+double PeriodicTest::Complete::Sample() noexcept {
+   return Compute(lambda_.Sample(), lambda_test_.Sample(), mu_.Sample(), tau_.Sample(),
+                  theta_.Sample(), gamma_.Sample(), test_duration_.Sample(),
+                  available_at_test_.Sample(), sigma_.Sample(), omega_.Sample(),
+                  time_.Sample());
+}
+
+double PeriodicTest::Complete::Compute(double lambda, double lambda_test, double mu,
+                                       double tau, double theta, double gamma,
+                                       double test_duration, bool available_at_test,
+                                       double sigma, double omega, double time) noexcept {
+   if (time <= theta)
+       return Evolve({1, 0}, lambda, mu, time).failed();
+   State state = Evolve({1, 0}, lambda, mu, theta);
+   for (double start = theta;; start += tau) {
+       // The test may fail the component, and it detects the failures with sigma.
+       state.up *= 1 - gamma;
+       state.repair += sigma * (state.failed() - state.repair);
+       double test_time = std::min(test_duration, time - start);
+       state = Evolve(state, lambda_test, mu, test_time);
+       if (time - start <= test_duration)
+           return available_at_test ? state.failed() : 1;
+       state.up *= 1 - omega;  // The restart after the test.
+       double function_time = std::min(tau - test_duration, time - start - test_duration);
+       state = Evolve(state, lambda, mu, function_time);
+       if (time - start <= tau)
+           return state.failed();
+   }
+}
+
+}  // namespace mef::openpsa
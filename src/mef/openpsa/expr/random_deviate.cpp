@@ -0,0 +1,357 @@
+/// @file
+/// Implementation of the deviate expressions and their batch sampling.
+///
+/// The scalar and the batch sampling of a deviate in the same trial
+/// draw the same words of the same random stream
+/// and transform them with the same operations,
+/// so both give the same value.
+///
+/// The batch kernels separate the random bit generation
+/// from the floating-point transforms,
+/// so that both loops run over contiguous arrays
+/// without dependencies between iterations.
+/// Only the conversion of the bits into uniform variates is vectorized;
+/// the transforms call the scalar std::log and std::cos of the math library.
+
+#include "mef/openpsa/expr/random_deviate.h"
+
+#include <cmath>
+#include <cstdint>
+
+#include <array>
+#include <limits>
+
+#include <boost/math/constants/constants.hpp>
+#include <boost/math/distributions/beta.hpp>
+#include <boost/math/distributions/gamma.hpp>
+#include <boost/math/distributions/lognormal.hpp>
+#include <boost/math/special_functions/erf.hpp>
+
+#include "mef/openpsa/error.h"
+
+namespace mef::openpsa {
+
+std::uint64_t RandomDeviate::seed_ = 0;
+thread_local std::uint64_t RandomDeviate::trial_ = 0;
+
+namespace {  // Sampling kernels.
+
+/// The number of samples transformed per chunk of random bits.
+constexpr std::size_t kChunkSize = 256;
+
+/// Fills the samples with uniform variates in the open interval (0, 1).
+///
+/// @param[in] key  The key of the random streams.
+/// @param[in] first_trial  The trial of the first sample.
+/// @param[in] stream  The id of the sampled deviate.
+/// @param[out] samples  The samples for the consecutive trials.
+/// @param[out] extra  Optional second variates of the trials.
+void FillCanonical(RandomStream::Key key, std::uint64_t first_trial, std::uint32_t stream,
+                   std::span<double> samples, double* extra = nullptr) noexcept {
+   std::array<RandomStream::Block, kChunkSize> blocks;
+   for (std::size_t start = 0; start < samples.size(); start += kChunkSize) {
+       std::size_t size = std::min(kChunkSize, samples.size() - start);
+       for (std::size_t i = 0; i < size; ++i) {
+           std::uint64_t trial = first_trial + start + i;
+           blocks[i] = RandomStream::Philox({0, stream, static_cast<std::uint32_t>(trial),
+                                             static_cast<std::uint32_t>(trial >> 32)},
+                                            key);
+       }
+       for (std::size_t i = 0; i < size; ++i)
+           samples[start + i] = RandomStream::ToCanonical(blocks[i][0], blocks[i][1]);
+       if (extra) {
+           for (std::size_t i = 0; i < size; ++i)
+               extra[start + i] = RandomStream::ToCanonical(blocks[i][2], blocks[i][3]);
+       }
+   }
+}
+
+/// The Box-Muller transform of two uniform variates into a normal variate.
+///
+/// @param[in] mean  The mean of the distribution.
+/// @param[in] sigma  The standard deviation of the distribution.
+/// @param[in] radius  The uniform variate for the radius.
+/// @param[in] angle  The uniform variate for the angle.
+///
+/// @returns The normal variate.
+inline double BoxMuller(double mean, double sigma, double radius, double angle) noexcept {
+   constexpr double kTwoPi = boost::math::constants::two_pi<double>();
+   return mean + sigma * std::sqrt(-2 * std::log(radius)) * std::cos(kTwoPi * angle);
+}
+
+/// Fills the samples with normal variates using the Box-Muller transform.
+///
+/// @copydetails FillCanonical
+/// @param[in] mean  The mean of the distribution.
+/// @param[in] sigma  The standard deviation of the distribution.
+void FillNormal(RandomStream::Key key, std::uint64_t first_trial, std::uint32_t stream,
+                double mean, double sigma, std::span<double> samples) noexcept {
+   std::vector<double> angles(samples.size());
+   FillCanonical(key, first_trial, stream, samples, angles.data());
+   for (std::size_t i = 0; i < samples.size(); ++i)
+       samples[i] = BoxMuller(mean, sigma, samples[i], angles[i]);
+}
+
+/// Draws a normal variate from the first words of the stream
+/// like the batch kernel of the trial.
+///
+/// @param[in] mean  The mean of the distribution.
+/// @param[in] sigma  The standard deviation of the distribution.
+/// @param[in,out] stream  The random stream of the deviate in the trial.
+///
+/// @returns The normal variate.
+double SampleNormal(double mean, double sigma, RandomStream stream) noexcept {
+   double radius = stream.Canonical();
+   return BoxMuller(mean, sigma, radius, stream.Canonical());
+}
+
+/// @param[in] ef  The error factor of the log-normal distribution.
+/// @param[in] level  The confidence level of the error factor.
+///
+/// @returns The scale of the log-normal distribution.
+double GetLognormalScale(double ef, double level) noexcept {
+   double z = -std::sqrt(2) * boost::math::erfc_inv(2 * level);
+   return std::log(ef) / z;
+}
+
+}  // namespace
+
+void RandomDeviate::SampleBatch(std::span<double> samples) noexcept {
+   std::uint64_t first_trial = trial_;
+   for (double& sample : samples) {
+       Expression::StartTrial();
+       sample = Expression::Sample();
+       ++trial_;
+   }
+   Expression::StartTrial();
+   trial_ = first_trial;
+}
+
+UniformDeviate::UniformDeviate(Expression* min, Expression* max)
+    : RandomDeviate({min, max}), min_(*min), max_(*max) {}
+
+void UniformDeviate::Validate() const {
+   if (min_.value() >= max_.value())
+       throw(ValidityError("Min value is more than max for Uniform distribution."));
+}
+
+double UniformDeviate::DoSample() noexcept {
+   double min = min_.Sample();
+   double range = max_.Sample() - min;
+   return min + range * rng().Canonical();
+}
+
+void UniformDeviate::SampleBatch(std::span<double> samples) noexcept {
+   if (HasDeviateArgs())
+       return RandomDeviate::SampleBatch(samples);
+   double min = min_.value();
+   double range = max_.value() - min;
+   FillCanonical(RandomStream::MakeKey(seed()), trial(), stream_id(), samples);
+   for (double& sample : samples)
+       sample = min + range * sample;
+}
+
+NormalDeviate::NormalDeviate(Expression* mean, Expression* sigma)
+    : RandomDeviate({mean, sigma}), mean_(*mean), sigma_(*sigma) {}
+
+void NormalDeviate::Validate() const { EnsurePositive(&sigma_, "Standard deviation"); }
+
+double NormalDeviate::DoSample() noexcept {
+   return SampleNormal(mean_.Sample(), sigma_.Sample(), rng());
+}
+
+void NormalDeviate::SampleBatch(std::span<double> samples) noexcept {
+   if (HasDeviateArgs())
+       return RandomDeviate::SampleBatch(samples);
+   FillNormal(RandomStream::MakeKey(seed()), trial(), stream_id(), mean_.value(), sigma_.value(),
+              samples);
+}
+
+LognormalDeviate::LognormalDeviate(Expression* mean, Expression* ef, Expression* level)
+    : RandomDeviate({mean, ef, level}),
+      flavor_(std::make_unique<Logarithmic>(mean, ef, level)) {}
+
+LognormalDeviate::LognormalDeviate(Expression* mu, Expression* sigma)
+    : RandomDeviate({mu, sigma}), flavor_(std::make_unique<Normal>(mu, sigma)) {}
+
+double LognormalDeviate::Logarithmic::scale() noexcept {
+   return GetLognormalScale(ef_.value(), level_.value());
+}
+
+double LognormalDeviate::Logarithmic::location() noexcept {
+   return std::log(mean_.value()) - std::pow(scale(), 2) / 2;
+}
+
+std::pair<double, double> LognormalDeviate::Logarithmic::Sample() noexcept {
+   double scale = GetLognormalScale(ef_.Sample(), level_.Sample());
+   return {std::log(mean_.Sample()) - std::pow(scale, 2) / 2, scale};
+}
+
+void LognormalDeviate::Logarithmic::Validate() const {
+   EnsureWithin(&level_, Interval::open(0, 1), "The confidence level");
+   EnsureWithin(&ef_, Interval::left_open(1, std::numeric_limits<double>::infinity()),
+                "The error factor");
+   EnsurePositive(&mean_, "The mean of Lognormal distribution");
+}
+
+double LognormalDeviate::Normal::mean() noexcept {
+   return std::exp(location() + std::pow(scale(), 2) / 2);
+}
+
+void LognormalDeviate::Normal::Validate() const {
+   EnsurePositive(&sigma_, "Standard deviation");
+}
+
+Interval LognormalDeviate::interval() noexcept {
+   boost::math::lognormal_distribution<double> distribution(flavor_->location(),
+                                                            flavor_->scale());
+   return Interval::closed(0, boost::math::quantile(distribution, 0.999));
+}
+
+double LognormalDeviate::DoSample() noexcept {
+   auto [location, scale] = flavor_->Sample();
+   return std::exp(SampleNormal(location, scale, rng()));
+}
+
+void LognormalDeviate::SampleBatch(std::span<double> samples) noexcept {
+   if (HasDeviateArgs())
+       return RandomDeviate::SampleBatch(samples);
+   FillNormal(RandomStream::MakeKey(seed()), trial(), stream_id(), flavor_->location(),
+              flavor_->scale(), samples);
+   for (double& sample : samples)
+       sample = std::exp(sample);
+}
+
+GammaDeviate::GammaDeviate(Expression* k, Expression* theta)
+    : RandomDeviate({k, theta}), k_(*k), theta_(*theta) {}
+
+void GammaDeviate::Validate() const {
+   EnsurePositive(&k_, "The k shape parameter for Gamma distribution");
+   EnsurePositive(&theta_, "The theta scale parameter for Gamma distribution");
+}
+
+Interval GammaDeviate::interval() noexcept {
+   boost::math::gamma_distribution<double> distribution(k_.value(), theta_.value());
+   return Interval::closed(0, boost::math::quantile(distribution, 0.99));
+}
+
+double GammaDeviate::DoSample() noexcept {
+   RandomStream stream = rng();
+   return std::gamma_distribution<double>(k_.Sample(), theta_.Sample())(stream);
+}
+
+void GammaDeviate::SampleBatch(std::span<double> samples) noexcept {
+   if (HasDeviateArgs())
+       return RandomDeviate::SampleBatch(samples);
+   // The rejection sampling does not map onto vector lanes;
+   // the batch only hoists the distribution setup out of the loop.
+   std::gamma_distribution<double> distribution(k_.value(), theta_.value());
+   for (std::size_t i = 0; i < samples.size(); ++i) {
+       RandomStream stream = rng(trial() + i);
+       distribution.reset();  // Drops the cached state of the previous trial.
+       samples[i] = distribution(stream);
+   }
+}
+
+BetaDeviate::BetaDeviate(Expression* alpha, Expression* beta)
+    : RandomDeviate({alpha, beta}), alpha_(*alpha), beta_(*beta) {}
+
+void BetaDeviate::Validate() const {
+   EnsurePositive(&alpha_, "The alpha shape parameter for Beta distribution");
+   EnsurePositive(&beta_, "The beta shape parameter for Beta distribution");
+}
+
+Interval BetaDeviate::interval() noexcept {
+   boost::math::beta_distribution<double> distribution(alpha_.value(), beta_.value());
+   return Interval::closed(0, boost::math::quantile(distribution, 0.99));
+}
+
+double BetaDeviate::DoSample() noexcept {
+   // The same draws of the same stream as the batch kernel.
+   RandomStream stream = rng();
+   double x = std::gamma_distribution<double>(alpha_.Sample())(stream);
+   return x / (x + std::gamma_distribution<double>(beta_.Sample())(stream));
+}
+
+void BetaDeviate::SampleBatch(std::span<double> samples) noexcept {
+   if (HasDeviateArgs())
+       return RandomDeviate::SampleBatch(samples);
+   std::gamma_distribution<double> gamma_alpha(alpha_.value());
+   std::gamma_distribution<double> gamma_beta(beta_.value());
+   for (std::size_t i = 0; i < samples.size(); ++i) {
+       RandomStream stream = rng(trial() + i);
+       gamma_alpha.reset();
+       gamma_beta.reset();
+       double x = gamma_alpha(stream);
+       samples[i] = x / (x + gamma_beta(stream));
+   }
+}
+
+Histogram::Histogram(std::vector<Expression*> boundaries, std::vector<Expression*> weights)
+    : RandomDeviate(std::move(boundaries)) {
+   std::size_t num_intervals = Expression::args().size() - 1;
+   if (weights.size() != num_intervals) {
+       throw(ValidityError("The number of weights is not equal "
+                           "to the number of intervals."));
+   }
+   for (Expression* weight : weights)
+       Expression::AddArg(weight);
+   auto it_begin = Expression::args().begin();
+   boundaries_ = IteratorRange(it_begin, std::next(it_begin, num_intervals + 1));
+   weights_ = IteratorRange(boundaries_.end(), Expression::args().end());
+}
+
+void Histogram::Validate() const {
+   for (auto it = std::next(boundaries_.begin()); it != boundaries_.end(); ++it) {
+       if ((*std::prev(it))->value() >= (*it)->value())
+           throw(ValidityError("Histogram upper boundaries are not strictly increasing."));
+   }
+   for (Expression* weight : weights_)
+       EnsureNonNegative(weight, "Histogram weight");
+}
+
+double Histogram::value() noexcept {
+   double sum_weights = 0;
+   double sum_product = 0;
+   auto it_bound = boundaries_.begin();
+   double lower_bound = (*it_bound)->value();
+   for (Expression* weight : weights_) {
+       double upper_bound = (*++it_bound)->value();
+       double weight_value = weight->value();
+       sum_product += (upper_bound + lower_bound) * weight_value;
+       sum_weights += weight_value;
+       lower_bound = upper_bound;
+   }
+   return sum_product / (2 * sum_weights);
+}
+
+double Histogram::DoSample() noexcept {
+   std::vector<double> boundaries;
+   for (Expression* boundary : boundaries_)
+       boundaries.push_back(boundary->Sample());
+   std::vector<double> weights;
+   for (Expression* weight : weights_)
+       weights.push_back(weight->Sample());
+   RandomStream stream = rng();
+   return std::piecewise_constant_distribution<double>(boundaries.begin(), boundaries.end(),
+                                                       weights.begin())(stream);
+}
+
+void Histogram::SampleBatch(std::span<double> samples) noexcept {
+   if (HasDeviateArgs())
+       return RandomDeviate::SampleBatch(samples);
+   std::vector<double> boundaries;
+   for (Expression* boundary : boundaries_)
+       boundaries.push_back(boundary->value());
+   std::vector<double> weights;
+   for (Expression* weight : weights_)
+       weights.push_back(weight->value());
+   std::piecewise_constant_distribution<double> distribution(
+       boundaries.begin(), boundaries.end(), weights.begin());
+   for (std::size_t i = 0; i < samples.size(); ++i) {
+       RandomStream stream = rng(trial() + i);
+       samples[i] = distribution(stream);
+   }
+}
+
+}  // namespace mef::openpsa
@@ -4,43 +4,115 @@
 
 #pragma once
 
+#include <cassert>
+#include <cstdint>
+
+#include <limits>
 #include <memory>
 #include <random>
+#include <span>
+#include <utility>
 #include <vector>
 
 #include <boost/range/iterator_range.hpp>
 
 #include "mef/openpsa/expression.h"
+#include "mef/openpsa/random_stream.h"
 
 namespace mef::openpsa {
 
 /// Abstract base class for all deviate expressions.
 /// These expressions provide quantification for uncertainty and sensitivity.
 ///
-/// @note Only single RNG is embedded for convenience.
-///       All the distributions share this RNG.
-///       This is not suitable for parallelized simulations!!!
-///
-/// @todo Parametrize with RNG (requires mef::Expression interface change).
+/// The random numbers come from counter-based streams
+/// addressed by the global seed, the current trial of the calling thread,
+/// and the stream id of the deviate.
+/// Any thread can sample any trial independently,
+/// and the samples do not depend on the evaluation order.
 class RandomDeviate : public Expression {
  public:
    using Expression::Expression;
 
    bool IsDeviate() noexcept override { return true; }
 
-   /// Sets the seed of the underlying random number generator.
+   /// Sets the seed of the random number streams.
    ///
    /// @param[in] seed  The seed for RNGs.
    ///
    /// @note This is static! Used by all the deriving deviates.
-   static void seed(unsigned seed) noexcept { rng_.seed(seed); }
+   static void seed(std::uint64_t seed) noexcept { seed_ = seed; }
+
+   /// @returns The seed of the random number streams.
+   static std::uint64_t seed() noexcept { return seed_; }
+
+   /// Sets the trial to sample on the calling thread.
+   ///
+   /// @param[in] index  The index of the trial.
+   ///
+   /// @note The trial is thread-local;
+   ///       the caller is responsible for Expression::StartTrial().
+   static void trial(std::uint64_t index) noexcept { trial_ = index; }
+
+   /// @returns The trial sampled on the calling thread.
+   static std::uint64_t trial() noexcept { return trial_; }
+
+   /// The stream id of the deviates outside the analyzed model.
+   static constexpr std::uint32_t kNoStream = std::numeric_limits<std::uint32_t>::max();
+
+   /// @returns The id of the random stream of this deviate within trials.
+   ///
+   /// @pre The stream id is assigned.
+   std::uint32_t stream_id() const {
+       assert(stream_id_ != kNoStream && "The deviate stream id is not assigned.");
+       return stream_id_;
+   }
+
+   /// Assigns the random stream id of this deviate.
+   /// The ids are assigned upon the model setup for analysis
+   /// in the canonical order of the model elements,
+   /// so the samples do not depend on how the model is loaded.
+   ///
+   /// @param[in] id  The unique id among the model deviates.
+   void stream_id(std::uint32_t id) { stream_id_ = id; }
+
+   /// Draws independent samples of the deviate in bulk
+   /// to amortize the per-sample overhead over the batch.
+   /// Sample i belongs to the trial (trial() + i).
+   ///
+   /// The distribution parameters are taken at their mean values
+   /// unless they are uncertain themselves,
+   /// in which case each sample is drawn
+   /// with the realization of the parameters in its trial.
+   ///
+   /// @param[out] samples  The destination for the samples.
+   ///
+   /// @post A new trial is started if the parameters are uncertain.
+   virtual void SampleBatch(std::span<double> samples) noexcept;
 
  protected:
-   /// @returns RNG to be used by derived classes.
-   std::mt19937& rng() { return rng_; }
+   /// @returns The random stream of this deviate in the current trial.
+   ///
+   /// @note The stream restarts with every call;
+   ///       a single sampling must draw all its numbers from one stream.
+   RandomStream rng() const noexcept { return rng(trial_); }
+
+   /// @param[in] trial  The index of the trial.
+   ///
+   /// @returns The random stream of this deviate in the given trial.
+   RandomStream rng(std::uint64_t trial) const noexcept {
+       return RandomStream(seed_, trial, stream_id());
+   }
+
+   /// @returns true if any distribution parameter is uncertain.
+   bool HasDeviateArgs() noexcept {
+       return any_of(Expression::args(), [](Expression* arg) { return arg->IsDeviate(); });
+   }
 
  private:
-   static std::mt19937 rng_;  ///< The random number generator.
+   static std::uint64_t seed_;  ///< The seed of all the random streams.
+   static thread_local std::uint64_t trial_;  ///< The trial of the thread.
+
+   std::uint32_t stream_id_ = kNoStream;  ///< The stream within trials.
 };
 
 /// Uniform distribution.
@@ -60,6 +132,8 @@ class UniformDeviate : public RandomDeviate {
        return Interval::closed(min_.value(), max_.value());
    }
 
+   void SampleBatch(std::span<double> samples) noexcept override;
+
  private:
    double DoSample() noexcept override;
 
@@ -87,6 +161,8 @@ class NormalDeviate : public RandomDeviate {
        return Interval::closed(mean - delta, mean + delta);
    }
 
+   void SampleBatch(std::span<double> samples) noexcept override;
+
  private:
    double DoSample() noexcept override;
 
@@ -122,6 +198,8 @@ class LognormalDeviate : public RandomDeviate {
    /// The high is 99.9 percentile estimate.
    Interval interval() noexcept override;
 
+   void SampleBatch(std::span<double> samples) noexcept override;
+
  private:
    double DoSample() noexcept override;
 
@@ -134,6 +212,8 @@ class LognormalDeviate : public RandomDeviate {
        virtual double location() noexcept = 0;
        /// @returns The mean value of the distribution.
        virtual double mean() noexcept = 0;
+       /// @returns The location and scale parameters sampled in the current trial.
+       virtual std::pair<double, double> Sample() noexcept = 0;
        /// @copydoc Expression::Validate
        virtual void Validate() const = 0;
    };
@@ -147,6 +227,7 @@ class LognormalDeviate : public RandomDeviate {
        double scale() noexcept override;
        double location() noexcept override;
        double mean() noexcept override { return mean_.value(); }
+       std::pair<double, double> Sample() noexcept override;
        /// @throws DomainError  (mean <= 0) or (ef <= 0) or invalid level.
        void Validate() const override;
 
@@ -165,6 +246,9 @@ class LognormalDeviate : public RandomDeviate {
        double scale() noexcept override { return sigma_.value(); }
        double location() noexcept override { return mu_.value(); }
        double mean() noexcept override;
+       std::pair<double, double> Sample() noexcept override {
+           return {mu_.Sample(), sigma_.Sample()};
+       }
        /// @throws DomainError  (sigma <= 0).
        void Validate() const override;
 
@@ -192,6 +276,8 @@ class GammaDeviate : public RandomDeviate {
    /// The high is 99 percentile.
    Interval interval() noexcept override;
 
+   void SampleBatch(std::span<double> samples) noexcept override;
+
  private:
    double DoSample() noexcept override;
 
@@ -219,6 +305,8 @@ class BetaDeviate : public RandomDeviate {
    /// @returns 99 percentile.
    Interval interval() noexcept override;
 
+   void SampleBatch(std::span<double> samples) noexcept override;
+
  private:
    double DoSample() noexcept override;
 
@@ -252,6 +340,8 @@ class Histogram : public RandomDeviate {
                                (*std::prev(boundaries_.end()))->value());
    }
 
+   void SampleBatch(std::span<double> samples) noexcept override;
+
  private:
    /// Access to args.
    using IteratorRange =
@@ -3,20 +3,70 @@
 
 #pragma once
 
+#include <cassert>
+
+#include <algorithm>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
-#include "mef/openpsa/algorithm.h"
 #include "mef/openpsa/expression.h"
-#include "mef/openpsa/find_iterator.h"
+#include "mef/openpsa/symbol.h"
 
 namespace mef::openpsa {
 
 /// The context for test-event expressions.
-struct Context {
-   std::string initiating_event;  ///< The name of the initiating event.
-   /// The functional event names and states.
-   std::unordered_map<std::string, std::string> functional_events;
+///
+/// The functional events are resolved into dense slots
+/// when the test events are created,
+/// so the tests are single loads and comparisons of interned symbols
+/// upon event-tree walks.
+/// The states of the context are plain arrays of symbols
+/// to snapshot and restore cheaply.
+class Context {
+ public:
+   /// @returns The name of the initiating event; empty outside the walks.
+   Symbol initiating_event() const { return initiating_event_; }
+
+   /// Sets the initiating event of the walk.
+   void initiating_event(Symbol name) { initiating_event_ = name; }
+
+   /// @param[in] functional_event  The name of the functional event.
+   ///
+   /// @returns The slot of the functional event state,
+   ///          which is assigned on the first request.
+   int Register(Symbol functional_event) {
+       auto [it, inserted] = slots_.emplace(functional_event, states_.size());
+       if (inserted)
+           states_.emplace_back();
+       return it->second;
+   }
+
+   /// @returns The state in the slot; empty if the event has not occurred.
+   Symbol state(int slot) const { return states_[slot]; }
+
+   /// Sets the state of the functional event in the slot.
+   void state(int slot, Symbol state) { states_[slot] = state; }
+
+   /// @returns The states of the functional events by slots.
+   const std::vector<Symbol>& states() const { return states_; }
+
+   /// Restores the snapshot of the functional-event states.
+   void states(const std::vector<Symbol>& states) {
+       assert(states.size() == states_.size());
+       std::copy(states.begin(), states.end(), states_.begin());
+   }
+
+   /// Resets the initiating event and the functional-event states.
+   void Clear() {
+       initiating_event_ = {};
+       std::fill(states_.begin(), states_.end(), Symbol());
+   }
+
+ private:
+   Symbol initiating_event_;  ///< The initiating event of the walk.
+   std::vector<Symbol> states_;  ///< The functional event states by slots.
+   std::unordered_map<Symbol, int> slots_;  ///< The slots of the functional events.
 };
 
 /// The abstract base class for non-deviate test-event expressions.
@@ -41,15 +91,16 @@ class TestInitiatingEvent : public TestEvent {
    /// @copydoc TestEvent::TestEvent
    /// @param[in] name  The public element name of the initiating event to test.
    TestInitiatingEvent(std::string name, const Context* context)
-       : TestEvent(context), name_(std::move(name)) {}
+       : TestEvent(context), name_(name) {}
+
+   /// @returns The name of the initiating event to test.
+   const std::string& name() const { return name_.str(); }
 
    /// @returns true if the initiating event has occurred in the event-tree walk.
-   double value() noexcept override {
-       return context_.initiating_event == name_;
-   }
+   double value() noexcept override { return context_.initiating_event() == name_; }
 
  private:
-   std::string name_;  ///< The name of the initiating event.
+   Symbol name_;  ///< The name of the initiating event.
 };
 
 /// Upon event-tree walk, tests whether a functional event has occurred.
@@ -58,20 +109,25 @@ class TestFunctionalEvent : public TestEvent {
    /// @copydoc TestEvent::TestEvent
    /// @param[in] name  The public element name of the functional event to test.
    /// @param[in] state  One of the valid states of the functional event.
-   TestFunctionalEvent(std::string name, std::string state,
-                       const Context* context)
-       : TestEvent(context), name_(std::move(name)), state_(std::move(state)) {}
+   TestFunctionalEvent(std::string name, std::string state, Context* context)
+       : TestEvent(context),
+         name_(name),
+         state_(state),
+         slot_(context->Register(name_)) {}
+
+   /// @returns The name of the functional event to test.
+   const std::string& name() const { return name_.str(); }
+
+   /// @returns The state of the functional event to test.
+   const std::string& state() const { return state_.str(); }
 
    /// @returns true if the functional event has occurred and is in given state.
-   double value() noexcept override {
-       if (auto it = find(context_.functional_events, name_))
-           return it->second == state_;
-       return false;
-   }
+   double value() noexcept override { return context_.state(slot_) == state_; }
 
  private:
-   std::string name_;  ///< The name of the functional event.
-   std::string state_;  ///< The state of the functional event.
+   Symbol name_;  ///< The name of the functional event.
+   Symbol state_;  ///< The state of the functional event.
+   int slot_;  ///< The slot of the functional event state in the context.
 };
 
 }  // namespace scram::mef
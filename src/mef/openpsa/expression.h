@@ -4,7 +4,12 @@
 
 #pragma once
 
+#include <cassert>
+#include <cstdint>
+
 #include <algorithm>
+#include <atomic>
+#include <limits>
 #include <utility>
 #include <vector>
 
@@ -42,6 +47,41 @@ inline bool IsPositive(const Interval& interval) {
    return IsNonNegative(interval) && !Contains(interval, 0);
 }
 
+/// The sampled value of an expression in a trial.
+struct SampledValue {
+   double value = 0;  ///< The sampled value.
+   std::uint64_t epoch = 0;  ///< The trial epoch of the value (0 for none).
+};
+
+/// The storage of the sampled expression values
+/// for the trials run concurrently with other contexts.
+///
+/// Expressions cache their samples in their own slots by default,
+/// which is only valid for a single sampling thread.
+/// A thread that samples the same expressions concurrently with others
+/// installs its own context with Expression::context(),
+/// and the expressions cache the samples in the context slots instead.
+/// The slots are indexed by the dense indices of the model expressions.
+class SamplingContext {
+ public:
+   /// @param[in] size  The number of the expression indices to sample,
+   ///                  e.g., ExpressionTape::context_size().
+   explicit SamplingContext(std::uint32_t size) : slots_(size) {}
+
+   /// @param[in] index  The index of the expression.
+   ///
+   /// @returns The slot of the expression sample in this context.
+   ///
+   /// @pre The index is less than the context size.
+   SampledValue* slot(std::uint32_t index) noexcept {
+       assert(index < slots_.size() && "The expression is not indexed for the context.");
+       return &slots_[index];
+   }
+
+ private:
+   std::vector<SampledValue> slots_;  ///< The samples by expression indices.
+};
+
 /// Abstract base class for all sorts of expressions to describe events.
 /// This class also acts like a connector for parameter nodes
 /// and may create cycles.
@@ -55,14 +95,25 @@ class Expression : private boost::noncopyable {
    /// to register their arguments.
    ///
    /// @param[in] args  Arguments of this expression.
-   explicit Expression(std::vector<Expression*> args = {})
-       : args_(std::move(args)), sampled_value_(0), sampled_(false) {}
+   explicit Expression(std::vector<Expression*> args = {}) : args_(std::move(args)) {}
 
    virtual ~Expression() = default;
 
+   /// The index of the expressions outside the analyzed models.
+   static constexpr std::uint32_t kNoIndex = std::numeric_limits<std::uint32_t>::max();
+
    /// @returns A set of arguments of the expression.
    [[nodiscard]] const std::vector<Expression*>& args() const { return args_; }
 
+   /// @returns The index of the expression samples in sampling contexts.
+   std::uint32_t index() const { return index_; }
+
+   /// Sets the index of the expression samples in sampling contexts.
+   /// The indices are assigned densely per model upon the setup for analysis.
+   ///
+   /// @param[in] index  The unique index among the model expressions.
+   void index(std::uint32_t index) { index_ = index; }
+
    /// Validates the expression.
    /// This late validation is due to parameters that are defined late.
    ///
@@ -94,23 +145,44 @@ class Expression : private boost::noncopyable {
        return any_of(args_, [](Expression* arg) { return arg->IsDeviate(); });
    }
 
-   /// @returns A sampled value of this expression.
+   /// @returns A sampled value of this expression in the current trial.
    double Sample() noexcept {
-       if (!sampled_) {
-           sampled_ = true;
-           sampled_value_ = this->DoSample();
-       }
-       return sampled_value_;
+       if (SampledValue* sample = sampled(); sample->epoch == epoch_)
+           return sample->value;
+       double value = this->DoSample();
+       *sampled() = {value, epoch_};
+       return value;
    }
 
-   /// This routine resets the sampling to get new values.
-   /// All the arguments are called to reset themselves.
-   /// If this expression was not sampled,
+   /// Starts a new sampling trial on the calling thread.
+   /// All the values sampled before become stale in O(1)
+   /// without traversing the expressions.
+   ///
+   /// @note Epochs are unique across threads,
+   ///       so trials on different threads never share sampled values;
+   ///       however, the threads sampling concurrently
+   ///       must keep the samples in their own contexts.
+   static void StartTrial() noexcept { epoch_ = ++last_epoch_; }
+
+   /// Sets the context to keep the samples of the calling thread.
+   ///
+   /// @param[in] context  The context owned by the thread;
+   ///                     nullptr for the slots of the expressions themselves.
+   ///
+   /// @pre The expressions sampled in the context are indexed.
+   static void context(SamplingContext* context) noexcept { context_ = context; }
+
+   /// This routine resets the sampling of this expression
+   /// and its arguments within the current trial to get new values.
+   /// If this expression was not sampled in the current trial,
    /// its arguments are not going to get any calls.
+   ///
+   /// @note Prefer StartTrial() to reset all the expressions at once.
    void Reset() noexcept {
-       if (!sampled_)
+       SampledValue* sample = sampled();
+       if (sample->epoch != epoch_)
            return;
-       sampled_ = false;
+       sample->epoch = 0;
        for (Expression* arg : args_) {
            arg->Reset();
        }
@@ -129,9 +201,22 @@ class Expression : private boost::noncopyable {
    /// @returns A sampled value of this expression.
    virtual double DoSample() noexcept = 0;
 
+   /// @returns The slot of the sample in the context of the calling thread,
+   ///          or the own slot of the expressions without an index.
+   SampledValue* sampled() noexcept {
+       return context_ && index_ != kNoIndex ? context_->slot(index_) : &sampled_;
+   }
+
    std::vector<Expression*> args_;  ///< Expression's arguments.
-   double sampled_value_;  ///< The sampled value.
-   bool sampled_;  ///< Indication if the expression is already sampled.
+   std::uint32_t index_ = kNoIndex;  ///< The index of the slots in the sampling contexts.
+   SampledValue sampled_;  ///< The sample in the absence of the thread context.
+
+   /// The source of unique trial epochs across threads.
+   inline static std::atomic<std::uint64_t> last_epoch_ = 0;
+   /// The current trial epoch of the thread.
+   inline static thread_local std::uint64_t epoch_ = ++last_epoch_;
+   /// The sampling context of the thread.
+   inline static thread_local SamplingContext* context_ = nullptr;
 };
 
 /// CRTP for Expressions with the same formula to evaluate and sample.
@@ -0,0 +1,391 @@
+/// @file
+/// Implementation of the expression tape compiler and interpreter.
+
+#include "mef/openpsa/expression_tape.h"
+
+#include <cassert>
+#include <cmath>
+
+#include <algorithm>
+#include <functional>
+#include <typeindex>
+
+#include "mef/openpsa/parameter.h"
+#include "mef/openpsa/expr/boolean.h"
+#include "mef/openpsa/expr/conditional.h"
+#include "mef/openpsa/expr/constant.h"
+#include "mef/openpsa/expr/exponential.h"
+#include "mef/openpsa/expr/numerical.h"
+#include "mef/openpsa/expr/random_deviate.h"
+
+namespace mef::openpsa {
+
+enum class ExpressionTape::Opcode : std::uint8_t {
+   kCall,  ///< Opaque call to the source expression.
+   kNeg,
+   kAdd,
+   kSub,
+   kMul,
+   kDiv,
+   kAbs,
+   kAcos,
+   kAsin,
+   kAtan,
+   kCos,
+   kSin,
+   kTan,
+   kCosh,
+   kSinh,
+   kTanh,
+   kExp,
+   kLog,
+   kLog10,
+   kMod,
+   kPow,
+   kSqrt,
+   kCeil,
+   kFloor,
+   kMin,
+   kMax,
+   kMean,
+   kNot,
+   kAnd,
+   kOr,
+   kEq,
+   kDf,
+   kLt,
+   kGt,
+   kLeq,
+   kGeq,
+   kIte,
+   kSwitch,
+   kExponential,
+   kGlm,
+   kWeibull
+};
+
+ExpressionTape::Opcode ExpressionTape::GetOpcode(const Expression& expression) {
+   static const std::unordered_map<std::type_index, Opcode> opcodes = {
+       {typeid(Neg), Opcode::kNeg},
+       {typeid(Add), Opcode::kAdd},
+       {typeid(Sub), Opcode::kSub},
+       {typeid(Mul), Opcode::kMul},
+       {typeid(Div), Opcode::kDiv},
+       {typeid(Abs), Opcode::kAbs},
+       {typeid(Acos), Opcode::kAcos},
+       {typeid(Asin), Opcode::kAsin},
+       {typeid(Atan), Opcode::kAtan},
+       {typeid(Cos), Opcode::kCos},
+       {typeid(Sin), Opcode::kSin},
+       {typeid(Tan), Opcode::kTan},
+       {typeid(Cosh), Opcode::kCosh},
+       {typeid(Sinh), Opcode::kSinh},
+       {typeid(Tanh), Opcode::kTanh},
+       {typeid(Exp), Opcode::kExp},
+       {typeid(Log), Opcode::kLog},
+       {typeid(Log10), Opcode::kLog10},
+       {typeid(Mod), Opcode::kMod},
+       {typeid(Pow), Opcode::kPow},
+       {typeid(Sqrt), Opcode::kSqrt},
+       {typeid(Ceil), Opcode::kCeil},
+       {typeid(Floor), Opcode::kFloor},
+       {typeid(Min), Opcode::kMin},
+       {typeid(Max), Opcode::kMax},
+       {typeid(Mean), Opcode::kMean},
+       {typeid(Not), Opcode::kNot},
+       {typeid(And), Opcode::kAnd},
+       {typeid(Or), Opcode::kOr},
+       {typeid(Eq), Opcode::kEq},
+       {typeid(Df), Opcode::kDf},
+       {typeid(Lt), Opcode::kLt},
+       {typeid(Gt), Opcode::kGt},
+       {typeid(Leq), Opcode::kLeq},
+       {typeid(Geq), Opcode::kGeq},
+       {typeid(Ite), Opcode::kIte},
+       {typeid(Switch), Opcode::kSwitch},
+       {typeid(Exponential), Opcode::kExponential},
+       {typeid(Glm), Opcode::kGlm},
+       {typeid(Weibull), Opcode::kWeibull}};
+   auto it = opcodes.find(typeid(expression));
+   return it == opcodes.end() ? Opcode::kCall : it->second;
+}
+
+ExpressionTape::Slot ExpressionTape::AddSlot(double value) {
+   slots_.push_back(value);
+   time_dependent_.push_back(false);
+   series_offsets_.push_back(kNoSeries);
+   deviate_columns_.push_back(kNoSeries);
+   return slots_.size() - 1;
+}
+
+ExpressionTape::Slot ExpressionTape::Compile(Expression* expression) {
+   if (auto it = compiled_.find(expression); it != compiled_.end())
+       return it->second;
+
+   Slot slot;
+   if (auto* parameter = dynamic_cast<Parameter*>(expression)) {
+       assert(parameter->expression() && "Compiling undefined parameters.");
+       slot = Compile(parameter->expression());
+   } else if (dynamic_cast<ConstantExpression*>(expression)) {
+       slot = AddSlot(expression->value());
+   } else {
+       Instruction instruction{GetOpcode(*expression), 0, 0, 0, expression};
+       bool time_dependent = false;
+       if (instruction.opcode != Opcode::kCall) {
+           std::vector<Slot> operands;
+           for (Expression* arg : expression->args())
+               operands.push_back(Compile(arg));
+           instruction.first_operand = operands_.size();
+           instruction.num_operands = operands.size();
+           operands_.insert(operands_.end(), operands.begin(), operands.end());
+           for (Slot operand : operands)
+               time_dependent |= time_dependent_[operand];
+       } else {
+           time_dependent = DependsOnTime(expression);
+       }
+       slot = instruction.result = AddSlot(0);
+       program_.push_back(instruction);
+       if (expression->IsDeviate()) {
+           deviate_columns_[slot] = deviate_program_.size();
+           deviate_program_.push_back(instruction);
+       }
+       if (time_dependent) {
+           time_dependent_[slot] = true;
+           time_program_.push_back(instruction);
+       }
+   }
+   compiled_.emplace(expression, slot);
+   return slot;
+}
+
+bool ExpressionTape::DependsOnTime(Expression* expression) {
+   if (auto it = opaque_time_dependent_.find(expression); it != opaque_time_dependent_.end())
+       return it->second;
+   // The memoization visits every mission time and expression index once.
+   if (expression->index() != Expression::kNoIndex)
+       context_size_ = std::max(context_size_, expression->index() + 1);
+   auto* mission_time = dynamic_cast<MissionTime*>(expression);
+   if (mission_time)
+       mission_times_.push_back(mission_time);
+   bool result = mission_time != nullptr;
+   for (Expression* arg : expression->args())
+       result = DependsOnTime(arg) || result;
+   opaque_time_dependent_.emplace(expression, result);
+   return result;
+}
+
+void ExpressionTape::Evaluate() noexcept { Run<false>(program_); }
+
+void ExpressionTape::Sample() noexcept {
+   Expression::StartTrial();
+   Run<true>(deviate_program_);
+}
+
+void ExpressionTape::SampleBatch(std::uint64_t first_trial, std::size_t num_trials,
+                                 Batch* batch) const {
+   batch->tape_ = this;
+   batch->size_ = num_trials;
+   batch->values_.resize(deviate_program_.size() * num_trials);
+
+   std::vector<const double*> columns;
+   std::vector<std::size_t> strides;  // 0 to broadcast the scalar operands.
+   for (const Instruction& instruction : deviate_program_) {
+       double* result = batch->values_.data() + deviate_columns_[instruction.result] * num_trials;
+       if (instruction.opcode == Opcode::kCall) {
+           if (auto* deviate = dynamic_cast<RandomDeviate*>(instruction.node)) {
+               RandomDeviate::trial(first_trial);
+               deviate->SampleBatch({result, num_trials});
+               continue;
+           }
+           for (std::size_t i = 0; i < num_trials; ++i) {
+               RandomDeviate::trial(first_trial + i);
+               Expression::StartTrial();
+               result[i] = instruction.node->Sample();
+           }
+           continue;
+       }
+       columns.clear();
+       strides.clear();
+       for (std::uint32_t k = 0; k < instruction.num_operands; ++k) {
+           Slot operand = operands_[instruction.first_operand + k];
+           columns.push_back((*batch)[operand].data());
+           strides.push_back(deviate_columns_[operand] != kNoSeries);
+       }
+       for (std::size_t i = 0; i < num_trials; ++i) {
+           result[i] = Apply(instruction, [&columns, &strides, i](std::uint32_t k) {
+               return columns[k][strides[k] * i];
+           });
+       }
+   }
+   RandomDeviate::trial(first_trial);
+}
+
+void ExpressionTape::Sweep(std::span<const double> times) {
+   Run<false>(program_);
+   num_times_ = times.size();
+   series_offsets_.assign(slots_.size(), kNoSeries);
+   series_.clear();
+   for (const Instruction& instruction : time_program_) {
+       series_offsets_[instruction.result] = series_.size();
+       series_.resize(series_.size() + num_times_);
+   }
+
+   std::vector<double> mission_time_values;
+   for (MissionTime* mission_time : mission_times_)
+       mission_time_values.push_back(mission_time->value());
+   std::vector<const double*> columns;
+   std::vector<std::size_t> strides;  // 0 to broadcast the scalar operands.
+   for (const Instruction& instruction : time_program_) {
+       double* result = series_.data() + series_offsets_[instruction.result];
+       if (instruction.opcode == Opcode::kCall) {
+           if (dynamic_cast<MissionTime*>(instruction.node)) {
+               std::copy(times.begin(), times.end(), result);
+               continue;
+           }
+           for (std::size_t i = 0; i < num_times_; ++i) {
+               for (MissionTime* mission_time : mission_times_)
+                   mission_time->value(times[i]);
+               result[i] = instruction.node->value();
+           }
+           continue;
+       }
+       columns.clear();
+       strides.clear();
+       for (std::uint32_t k = 0; k < instruction.num_operands; ++k) {
+           Slot operand = operands_[instruction.first_operand + k];
+           bool vector = series_offsets_[operand] != kNoSeries;
+           columns.push_back(vector ? series_.data() + series_offsets_[operand]
+                                    : &slots_[operand]);
+           strides.push_back(vector);
+       }
+       for (std::size_t i = 0; i < num_times_; ++i) {
+           result[i] = Apply(instruction, [&columns, &strides, i](std::uint32_t k) {
+               return columns[k][strides[k] * i];
+           });
+       }
+   }
+   for (std::size_t i = 0; i < mission_times_.size(); ++i)
+       mission_times_[i]->value(mission_time_values[i]);
+}
+
+template <bool Sampling>
+void ExpressionTape::Run(const std::vector<Instruction>& program) noexcept {
+   double* slots = slots_.data();
+   const Slot* operands = operands_.data();
+   for (const Instruction& instruction : program) {
+       const Slot* args = operands + instruction.first_operand;
+       if (instruction.opcode == Opcode::kCall) {
+           slots[instruction.result] =
+               Sampling ? instruction.node->Sample() : instruction.node->value();
+           continue;
+       }
+       slots[instruction.result] =
+           Apply(instruction, [slots, args](std::uint32_t i) { return slots[args[i]]; });
+   }
+}
+
+template <class Getter>
+double ExpressionTape::Apply(const Instruction& instruction, Getter&& arg) noexcept {
+   std::uint32_t num_args = instruction.num_operands;
+   // Left fold of the arguments with the binary operation.
+   auto fold = [&arg, num_args](auto&& op) {
+       double result = arg(0);
+       for (std::uint32_t i = 1; i < num_args; ++i)
+           result = op(result, arg(i));
+       return result;
+   };
+   switch (instruction.opcode) {
+   case Opcode::kCall:
+       assert(false && "Opaque calls have no operation.");
+       return 0;
+   case Opcode::kNeg:
+       return -arg(0);
+   case Opcode::kAdd:
+       return fold(std::plus<>());
+   case Opcode::kSub:
+       return fold(std::minus<>());
+   case Opcode::kMul:
+       return fold(std::multiplies<>());
+   case Opcode::kDiv:
+       return fold(std::divides<>());
+   case Opcode::kAbs:
+       return std::abs(arg(0));
+   case Opcode::kAcos:
+       return std::acos(arg(0));
+   case Opcode::kAsin:
+       return std::asin(arg(0));
+   case Opcode::kAtan:
+       return std::atan(arg(0));
+   case Opcode::kCos:
+       return std::cos(arg(0));
+   case Opcode::kSin:
+       return std::sin(arg(0));
+   case Opcode::kTan:
+       return std::tan(arg(0));
+   case Opcode::kCosh:
+       return std::cosh(arg(0));
+   case Opcode::kSinh:
+       return std::sinh(arg(0));
+   case Opcode::kTanh:
+       return std::tanh(arg(0));
+   case Opcode::kExp:
+       return std::exp(arg(0));
+   case Opcode::kLog:
+       return std::log(arg(0));
+   case Opcode::kLog10:
+       return std::log10(arg(0));
+   case Opcode::kMod:
+       return std::modulus<int>()(arg(0), arg(1));
+   case Opcode::kPow:
+       return std::pow(arg(0), arg(1));
+   case Opcode::kSqrt:
+       return std::sqrt(arg(0));
+   case Opcode::kCeil:
+       return std::ceil(arg(0));
+   case Opcode::kFloor:
+       return std::floor(arg(0));
+   case Opcode::kMin:
+       return fold([](double lhs, double rhs) { return std::fmin(lhs, rhs); });
+   case Opcode::kMax:
+       return fold([](double lhs, double rhs) { return std::fmax(lhs, rhs); });
+   case Opcode::kMean:
+       return fold(std::plus<>()) / num_args;
+   case Opcode::kNot:
+       return !arg(0);
+   case Opcode::kAnd:
+       return fold(std::logical_and<>());
+   case Opcode::kOr:
+       return fold(std::logical_or<>());
+   case Opcode::kEq:
+       return arg(0) == arg(1);
+   case Opcode::kDf:
+       return arg(0) != arg(1);
+   case Opcode::kLt:
+       return arg(0) < arg(1);
+   case Opcode::kGt:
+       return arg(0) > arg(1);
+   case Opcode::kLeq:
+       return arg(0) <= arg(1);
+   case Opcode::kGeq:
+       return arg(0) >= arg(1);
+   case Opcode::kIte:
+       return arg(0) ? arg(1) : arg(2);
+   case Opcode::kSwitch:
+       // The default value is followed by the condition-value pairs.
+       for (std::uint32_t i = 1; i < num_args; i += 2) {
+           if (arg(i))
+               return arg(i + 1);
+       }
+       return arg(0);
+   case Opcode::kExponential:
+       return static_cast<Exponential*>(instruction.node)->Compute(arg(0), arg(1));
+   case Opcode::kGlm:
+       return static_cast<Glm*>(instruction.node)->Compute(arg(0), arg(1), arg(2), arg(3));
+   case Opcode::kWeibull:
+       return static_cast<Weibull*>(instruction.node)
+           ->Compute(arg(0), arg(1), arg(2), arg(3));
+   }
+   return 0;
+}
+
+}  // namespace mef::openpsa
@@ -0,0 +1,209 @@
+/// @file
+/// Compilation of expression graphs into flat evaluation tapes.
+
+#pragma once
+
+#include <cstdint>
+
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "mef/openpsa/expression.h"
+
+namespace mef::openpsa {
+
+class MissionTime;  // The time argument of time-dependent expressions.
+
+/// Linear program equivalent to a collection of expression DAGs.
+///
+/// Expressions are compiled in topological order into instructions
+/// that read and write contiguous value slots;
+/// a single sweep over the instructions evaluates all compiled expressions
+/// without virtual calls through the expression graph.
+/// Parameters are compiled into aliases of their expressions,
+/// and constants are preloaded into their slots.
+///
+/// Expressions without a tape instruction
+/// (random deviates, periodic tests, the mission time, test events,
+/// and extern functions)
+/// are called as opaque leaves through their own value and sampling routines.
+///
+/// @note Unlike the expression graph,
+///       the tape evaluates all arms of conditional expressions.
+///
+/// @pre The compiled expressions are validated
+///      and do not change while the tape is in use.
+class ExpressionTape {
+ public:
+   /// The index of the value slot of a compiled expression.
+   using Slot = std::uint32_t;
+
+   /// The values of the compiled expressions in a batch of consecutive trials.
+   class Batch {
+    public:
+       /// @param[in] slot  The slot of a compiled expression.
+       ///
+       /// @returns The values of the expression in the trials of the batch;
+       ///          the single value for the expressions independent of deviates.
+       std::span<const double> operator[](Slot slot) const {
+           std::size_t column = tape_->deviate_columns_[slot];
+           if (column == kNoSeries)
+               return {&tape_->slots_[slot], 1};
+           return {values_.data() + column * size_, size_};
+       }
+
+       /// @returns The number of trials in the batch.
+       std::size_t size() const { return size_; }
+
+    private:
+       friend class ExpressionTape;
+
+       const ExpressionTape* tape_ = nullptr;  ///< The sampled tape.
+       std::vector<double> values_;  ///< The columns of the deviate-dependent slots.
+       std::size_t size_ = 0;  ///< The number of trials.
+   };
+
+   /// Compiles the expression and its arguments into the tape.
+   /// Expressions are compiled only once
+   /// no matter how many times they appear in the graphs.
+   ///
+   /// @param[in] expression  The expression to evaluate with the tape.
+   ///
+   /// @returns The slot with the value of the expression.
+   Slot Compile(Expression* expression);
+
+   /// @returns The number of instructions in the tape.
+   [[nodiscard]] std::size_t size() const { return program_.size(); }
+
+   /// @returns The size of the sampling contexts
+   ///          covering the indices of the expressions under the opaque leaves,
+   ///          which are sampled through the expressions themselves.
+   [[nodiscard]] std::uint32_t context_size() const { return context_size_; }
+
+   /// Evaluates all the compiled expressions with mean values.
+   /// This is the tape analog of Expression::value.
+   void Evaluate() noexcept;
+
+   /// Samples all the compiled expressions in a new trial.
+   /// This is the tape analog of Expression::StartTrial
+   /// followed by Expression::Sample.
+   ///
+   /// Only the instructions depending on deviates are executed;
+   /// the rest of the slots retain their values from the last evaluation.
+   ///
+   /// @pre The tape is evaluated after the last compilation
+   ///      and after any change to the mission time or test-event context.
+   void Sample() noexcept;
+
+   /// Samples all the compiled expressions in consecutive trials in one pass.
+   /// The deviate leaves fill their columns with RandomDeviate::SampleBatch,
+   /// the other opaque leaves depending on deviates are sampled trial by trial,
+   /// and every deviate-dependent instruction computes the column of its values
+   /// from the columns of its operands.
+   /// The counter-based random streams give a deviate the same value
+   /// in a trial however it is sampled.
+   ///
+   /// The tape itself is not modified,
+   /// so threads can sample it concurrently into their own batches
+   /// with their own sampling contexts.
+   ///
+   /// @param[in] first_trial  The index of the first trial.
+   /// @param[in] num_trials  The number of the trials.
+   /// @param[out] batch  The destination for the values in the trials.
+   ///
+   /// @pre The tape is evaluated after the last compilation
+   ///      and after any change to the mission time or test-event context.
+   void SampleBatch(std::uint64_t first_trial, std::size_t num_trials, Batch* batch) const;
+
+   /// Evaluates all the compiled expressions over the time grid in one pass.
+   /// Every time-dependent instruction computes the whole series of its values
+   /// from the series of its operands;
+   /// the slots independent of the time are evaluated only once.
+   /// Opaque leaves depending on the mission time
+   /// are called at every time point with the mission time set to the point.
+   ///
+   /// @param[in] times  The time points in hours.
+   ///
+   /// @post The mission time expressions keep their values before the sweep.
+   void Sweep(std::span<const double> times);
+
+   /// @param[in] slot  The slot of a compiled expression.
+   ///
+   /// @returns The value of the expression after the last sweep.
+   double operator[](Slot slot) const { return slots_[slot]; }
+
+   /// @param[in] slot  The slot of a compiled expression.
+   ///
+   /// @returns The values of the expression at the time points of the last time sweep;
+   ///          the single value for the expressions independent of the time.
+   std::span<const double> series(Slot slot) const {
+       if (series_offsets_[slot] == kNoSeries)
+           return {&slots_[slot], 1};
+       return {series_.data() + series_offsets_[slot], num_times_};
+   }
+
+ private:
+   /// Operations of tape instructions.
+   enum class Opcode : std::uint8_t;
+
+   /// Single operation over the slots.
+   struct Instruction {
+       Opcode opcode;  ///< The operation to perform.
+       Slot result;  ///< The slot to store the result into.
+       std::uint32_t first_operand;  ///< The start of operand slots.
+       std::uint32_t num_operands;  ///< The number of operand slots.
+       Expression* node;  ///< The source expression for opaque calls and formulas.
+   };
+
+   /// The offset of slots without time series.
+   static constexpr std::size_t kNoSeries = static_cast<std::size_t>(-1);
+
+   /// @returns The tape operation for the expression type;
+   ///          Opcode::kCall for expressions without direct kernels.
+   static Opcode GetOpcode(const Expression& expression);
+
+   /// Executes the program over the slots.
+   ///
+   /// @tparam Sampling  The flag to sample instead of taking mean values.
+   ///
+   /// @param[in] program  The instructions to execute in order.
+   template <bool Sampling>
+   void Run(const std::vector<Instruction>& program) noexcept;
+
+   /// Applies the operation of a non-opaque instruction.
+   ///
+   /// @param[in] instruction  The instruction to execute.
+   /// @param[in] arg  The getter of the operand values by operand positions.
+   ///
+   /// @returns The result of the operation.
+   template <class Getter>
+   static double Apply(const Instruction& instruction, Getter&& arg) noexcept;
+
+   /// Registers the mission times reachable from the opaque expression,
+   /// including the ones under the opaque arguments,
+   /// and extends the context size to the indices of the reached expressions.
+   ///
+   /// @returns true if the opaque expression depends on the mission time.
+   bool DependsOnTime(Expression* expression);
+
+   /// @returns A new slot initialized with the value.
+   Slot AddSlot(double value);
+
+   std::vector<double> slots_;  ///< The values of compiled expressions.
+   std::vector<Slot> operands_;  ///< The operand slots of all instructions.
+   std::vector<Instruction> program_;  ///< All instructions in topological order.
+   std::vector<Instruction> deviate_program_;  ///< The deviate-dependent instructions.
+   std::vector<std::size_t> deviate_columns_;  ///< The slot columns in sampled batches.
+   std::unordered_map<const Expression*, Slot> compiled_;  ///< Expression slots.
+   std::vector<Instruction> time_program_;  ///< The time-dependent instructions.
+   std::vector<bool> time_dependent_;  ///< The time dependence of slots.
+   std::unordered_map<const Expression*, bool> opaque_time_dependent_;  ///< Leaf dependence.
+   std::vector<MissionTime*> mission_times_;  ///< The unique mission times of the expressions.
+   std::vector<std::size_t> series_offsets_;  ///< The slot series in the time series.
+   std::vector<double> series_;  ///< The time series of time-dependent slots.
+   std::size_t num_times_ = 0;  ///< The number of points in the last time sweep.
+   std::uint32_t context_size_ = 0;  ///< The sampling context size of the opaque leaves.
+};
+
+}  // namespace mef::openpsa
@@ -11,6 +11,7 @@
 #include "mef/openpsa/ccf_group.h"
 #include "mef/openpsa/element.h"
 #include "mef/openpsa/event/event.h"
+#include "mef/openpsa/event/gate.h"
 #include "mef/openpsa/parameter.h"
 
 namespace mef::openpsa {
@@ -0,0 +1,279 @@
+/// @file
+/// Flat open-addressing hash table of unique elements with intrusive keys.
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+#include <bit>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace mef::openpsa {
+
+/// Hash set of values unique by the keys extracted from the values,
+/// laid out like Swiss tables.
+///
+/// The values are stored in a single slot array without per-entry nodes.
+/// Each slot has a control byte with 7 bits of the key hash
+/// or the empty and deleted markers.
+/// Lookups probe groups of 16 control bytes at once
+/// (with SSE2 if available)
+/// and compare the keys only for the matching hash bits.
+///
+/// @tparam T  The default-constructible and movable value type,
+///            i.e., (smart) pointers to elements.
+/// @tparam KeyOf  The functor to extract keys from values.
+/// @tparam Hash  The hash of the keys.
+///
+/// @note Any insertion or erasure invalidates the iterators.
+template <class T, class KeyOf, class Hash>
+class FlatTable {
+ public:
+   using value_type = T;  ///< The stored values.
+   /// The key type of the table.
+   using key_type = std::decay_t<std::invoke_result_t<KeyOf, const T&>>;
+
+   /// Forward iterator over the values.
+   class const_iterator {
+       friend class FlatTable;
+
+     public:
+       using iterator_category = std::forward_iterator_tag;
+       using value_type = T;
+       using difference_type = std::ptrdiff_t;
+       using pointer = const T*;
+       using reference = const T&;
+
+       const_iterator() = default;
+
+       /// Standard forward iterator functionality.
+       /// @{
+       reference operator*() const { return table_->slots_[index_]; }
+       pointer operator->() const { return &**this; }
+       const_iterator& operator++() {
+           index_ = table_->NextFull(index_ + 1);
+           return *this;
+       }
+       const_iterator operator++(int) {
+           const_iterator it = *this;
+           ++*this;
+           return it;
+       }
+       bool operator==(const const_iterator& other) const { return index_ == other.index_; }
+       /// @}
+
+     private:
+       /// @param[in] table  The host table.
+       /// @param[in] index  The full slot or the capacity for the end.
+       const_iterator(const FlatTable* table, std::size_t index)
+           : table_(table), index_(index) {}
+
+       const FlatTable* table_ = nullptr;  ///< The host table.
+       std::size_t index_ = 0;  ///< The slot index.
+   };
+
+   using iterator = const_iterator;  ///< The values are immutable keys.
+
+   FlatTable() = default;
+
+   /// Takes the values of the other table
+   /// and leaves it empty and valid for reuse.
+   ///
+   /// @param[in,out] other  The table to move from.
+   /// @{
+   FlatTable(FlatTable&& other) noexcept
+       : slots_(std::exchange(other.slots_, {})),
+         control_(std::exchange(other.control_, nullptr)),
+         size_(std::exchange(other.size_, 0)),
+         num_deleted_(std::exchange(other.num_deleted_, 0)) {}
+   FlatTable& operator=(FlatTable&& other) noexcept {
+       slots_ = std::exchange(other.slots_, {});
+       control_ = std::exchange(other.control_, nullptr);
+       size_ = std::exchange(other.size_, 0);
+       num_deleted_ = std::exchange(other.num_deleted_, 0);
+       return *this;
+   }
+   /// @}
+
+   /// @returns The number of values.
+   std::size_t size() const { return size_; }
+
+   /// @returns true if the table has no values.
+   bool empty() const { return size_ == 0; }
+
+   /// @returns The range of the values in the slot order.
+   /// @{
+   const_iterator begin() const { return {this, NextFull(0)}; }
+   const_iterator end() const { return {this, capacity()}; }
+   /// @}
+
+   /// @returns The iterator to the value with the key or the end.
+   const_iterator find(const key_type& key) const {
+       if (!size_)
+           return end();
+       std::uint64_t hash = Mix(key);
+       std::int8_t tag = Tag(hash);
+       std::size_t mask = num_groups() - 1;
+       std::size_t group = Group(hash) & mask;
+       for (std::size_t step = 1;; group = (group + step++) & mask) {
+           const std::int8_t* control = control_.get() + group * kGroupWidth;
+           for (std::uint32_t match = Match(control, tag); match; match &= match - 1) {
+               std::size_t index = group * kGroupWidth + std::countr_zero(match);
+               if (KeyOf()(slots_[index]) == key)
+                   return {this, index};
+           }
+           if (MatchEmpty(control))
+               return end();
+       }
+   }
+
+   /// @returns 1 if the key is in the table, 0 otherwise.
+   std::size_t count(const key_type& key) const { return find(key) != end(); }
+
+   /// Inserts the value if its key is new.
+   ///
+   /// @returns The iterator to the value with the key
+   ///          and true if the value has been inserted.
+   std::pair<const_iterator, bool> insert(T value) {
+       key_type key = KeyOf()(value);
+       if (const_iterator it = find(key); it != end())
+           return {it, false};
+       if ((size_ + num_deleted_ + 1) * 8 > capacity() * 7)
+           Rehash(size_ + 1 > capacity() / 2 ? std::max<std::size_t>(2 * capacity(), kGroupWidth)
+                                              : capacity());
+       std::uint64_t hash = Mix(key);
+       std::size_t index = FindFree(hash);
+       if (control_[index] == kDeleted)
+           --num_deleted_;
+       control_[index] = Tag(hash);
+       slots_[index] = std::move(value);
+       ++size_;
+       return {{this, index}, true};
+   }
+
+   /// Removes the value from the table.
+   ///
+   /// @param[in] it  The valid iterator to a value.
+   ///
+   /// @returns The removed value.
+   T extract(const_iterator it) {
+       assert(it != end() && control_[it.index_] >= 0);
+       T value = std::move(slots_[it.index_]);
+       slots_[it.index_] = T();
+       control_[it.index_] = kDeleted;
+       ++num_deleted_;
+       --size_;
+       return value;
+   }
+
+ private:
+   static constexpr std::size_t kGroupWidth = 16;  ///< The slots per probe.
+   static constexpr std::int8_t kEmpty = -128;  ///< The never used slot.
+   static constexpr std::int8_t kDeleted = -2;  ///< The tombstone of erasure.
+
+   /// @returns The well-mixed hash of the key.
+   static std::uint64_t Mix(const key_type& key) {
+       return static_cast<std::uint64_t>(Hash()(key)) * 0x9e3779b97f4a7c15ULL;
+   }
+
+   /// @returns The 7 control bits of the hash.
+   static std::int8_t Tag(std::uint64_t hash) { return hash >> 57; }
+
+   /// @returns The start group of the hash.
+   static std::size_t Group(std::uint64_t hash) { return hash >> 7; }
+
+   /// @returns The bit mask of the control bytes equal to the tag.
+   static std::uint32_t Match(const std::int8_t* control, std::int8_t tag) {
+#if defined(__SSE2__)
+       __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(control));
+       return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(tag)));
+#else
+       std::uint32_t mask = 0;
+       for (std::size_t i = 0; i < kGroupWidth; ++i)
+           mask |= static_cast<std::uint32_t>(control[i] == tag) << i;
+       return mask;
+#endif
+   }
+
+   /// @returns The bit mask of the empty control bytes.
+   static std::uint32_t MatchEmpty(const std::int8_t* control) {
+       return Match(control, kEmpty);
+   }
+
+   /// @returns The bit mask of the empty or deleted control bytes.
+   static std::uint32_t MatchFree(const std::int8_t* control) {
+#if defined(__SSE2__)
+       return _mm_movemask_epi8(
+           _mm_loadu_si128(reinterpret_cast<const __m128i*>(control)));
+#else
+       std::uint32_t mask = 0;
+       for (std::size_t i = 0; i < kGroupWidth; ++i)
+           mask |= static_cast<std::uint32_t>(control[i] < 0) << i;
+       return mask;
+#endif
+   }
+
+   /// @returns The number of slots.
+   std::size_t capacity() const { return slots_.size(); }
+
+   /// @returns The number of probe groups.
+   std::size_t num_groups() const { return capacity() / kGroupWidth; }
+
+   /// @returns The first full slot at or after the index or the capacity.
+   std::size_t NextFull(std::size_t index) const {
+       while (index < capacity() && control_[index] < 0)
+           ++index;
+       return index;
+   }
+
+   /// @returns The first free slot on the probe sequence of the hash.
+   ///
+   /// @pre The table has free slots.
+   std::size_t FindFree(std::uint64_t hash) const {
+       std::size_t mask = num_groups() - 1;
+       std::size_t group = Group(hash) & mask;
+       for (std::size_t step = 1;; group = (group + step++) & mask) {
+           if (std::uint32_t free = MatchFree(control_.get() + group * kGroupWidth))
+               return group * kGroupWidth + std::countr_zero(free);
+       }
+   }
+
+   /// Moves the values into new slots without tombstones.
+   ///
+   /// @param[in] capacity  The power-of-two multiple of the group width.
+   void Rehash(std::size_t capacity) {
+       assert(capacity % kGroupWidth == 0 && std::has_single_bit(capacity));
+       std::vector<T> slots = std::move(slots_);
+       std::unique_ptr<std::int8_t[]> control = std::move(control_);
+       slots_ = std::vector<T>(capacity);
+       control_ = std::make_unique<std::int8_t[]>(capacity);
+       std::memset(control_.get(), kEmpty, capacity);
+       num_deleted_ = 0;
+       for (std::size_t i = 0; i < slots.size(); ++i) {
+           if (control[i] < 0)
+               continue;
+           std::uint64_t hash = Mix(KeyOf()(slots[i]));
+           std::size_t index = FindFree(hash);
+           control_[index] = Tag(hash);
+           slots_[index] = std::move(slots[i]);
+       }
+   }
+
+   std::vector<T> slots_;  ///< The values in the full slots.
+   std::unique_ptr<std::int8_t[]> control_;  ///< The control bytes of the slots.
+   std::size_t size_ = 0;  ///< The number of full slots.
+   std::size_t num_deleted_ = 0;  ///< The number of tombstones.
+};
+
+}  // namespace mef::openpsa
@@ -3,9 +3,15 @@
 
 #include "mef/openpsa/initializer.h"
 
-#include <functional>  // std::mem_fn
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <optional>
 #include <sstream>
+#include <thread>
 #include <type_traits>
+#include <unordered_set>
 
 #include <boost/exception/errinfo_at_line.hpp>
 #include <boost/exception/errinfo_file_name.hpp>
@@ -15,11 +21,14 @@
 #include <boost/range/adaptor/indirected.hpp>
 #include <boost/range/algorithm.hpp>
 
+#include <libxml/parser.h>
+
 #include "mef/openpsa/cycle.h"
 #include "mef/openpsa/env.h"
 #include "mef/openpsa/error.h"
 #include "mef/openpsa/algorithm.h"
 #include "mef/openpsa/find_iterator.h"
+#include "mef/openpsa/model_cache.h"
 
 #include "mef/openpsa/expr/boolean.h"
 #include "mef/openpsa/expr/conditional.h"
@@ -249,43 +258,121 @@ void Initializer::CheckDuplicateFiles(
    }
 }
 
+void Initializer::ParseInputFiles(const std::vector<std::string>& xml_files) {
+   if (xml_files.empty())
+       return;
+   std::size_t num_workers = settings_.num_threads() ? settings_.num_threads()
+                                                     : std::thread::hardware_concurrency();
+   num_workers = std::clamp<std::size_t>(num_workers, 1, xml_files.size());
+
+   if (num_workers == 1) {
+       io::xml::Validator validator(env::input_schema());
+       for (const auto& xml_file : xml_files) {
+//           CLOCK(parse_time);
+//           LOG(DEBUG3) << "Parsing " << xml_file << " ...";
+           io::xml::Document document(xml_file, &validator);
+           if (extra_validator_)
+               extra_validator_->validate(document);
+           documents_.emplace_back(std::move(document));
+//           LOG(DEBUG3) << "Parsed " << xml_file << " in " << DUR(parse_time);
+       }
+       return;
+   }
+
+   xmlInitParser();  // The global parser state must be set up before threads.
+   std::vector<io::xml::Validator> validators;
+   validators.reserve(num_workers);
+   for (std::size_t i = 0; i < num_workers; ++i)
+       validators.emplace_back(env::input_schema());
+
+   std::vector<std::optional<io::xml::Document>> parsed(xml_files.size());
+   std::vector<std::exception_ptr> errors(xml_files.size());
+   std::atomic<std::size_t> next_file = 0;
+   // The files are claimed in the input order,
+   // so all the files before the first failure are parsed to completion
+   // and only the files after it are cancelled.
+   std::atomic<std::size_t> first_failure = xml_files.size();
+   {
+       std::vector<std::jthread> workers;
+       workers.reserve(num_workers);
+       for (std::size_t i = 0; i < num_workers; ++i) {
+           workers.emplace_back([&, validator = &validators[i]] {
+               for (std::size_t index = next_file++; index < first_failure;
+                    index = next_file++) {
+                   try {
+                       parsed[index].emplace(xml_files[index], validator);
+                   } catch (...) {
+                       errors[index] = std::current_exception();
+                       std::size_t failure = first_failure;
+                       while (index < failure &&
+                              !first_failure.compare_exchange_weak(failure, index)) {
+                       }
+                   }
+               }
+           });
+       }
+   }  // Joins the workers.
+
+   // Reports errors and registers documents deterministically in the input order.
+   for (std::size_t i = 0; i < xml_files.size(); ++i) {
+       if (errors[i])
+           std::rethrow_exception(errors[i]);
+       if (extra_validator_)
+           extra_validator_->validate(*parsed[i]);
+       documents_.emplace_back(std::move(*parsed[i]));
+   }
+}
+
 void Initializer::ProcessInputFiles(const std::vector<std::string>& xml_files) {
    // Expand wildcards before proceeding
    std::vector<std::string> expanded_files = ExpandWildcards(xml_files);
 
-   io::xml::Validator validator(env::input_schema());
-
 //   CLOCK(input_time);
 //   LOG(DEBUG1) << "Processing input files";
    CheckFileExistence(expanded_files);
    CheckDuplicateFiles(expanded_files);
-   for (const auto& xml_file : expanded_files) {
-//       CLOCK(parse_time);
-//       LOG(DEBUG3) << "Parsing " << xml_file << " ...";
-       io::xml::Document document(xml_file, &validator);
-       if (extra_validator_)
-           extra_validator_->validate(document);
-       documents_.emplace_back(std::move(document));
-//       LOG(DEBUG3) << "Parsed " << xml_file << " in " << DUR(parse_time);
+
+   std::optional<ModelCache> cache;
+   std::string cache_key;
+   // Snapshots skip the extra validation of the documents.
+   if (!settings_.model_cache().empty() && !extra_validator_) {
+       cache.emplace(settings_.model_cache());
+       cache_key = ModelCache::Key(expanded_files, settings_);
+       model_ = cache->Load(cache_key);
    }
-//   CLOCK(def_time);
-   for (const io::xml::Document& document : documents_) {
-       try {
-           ProcessInputFile(document);
-       } catch (ValidityError& err) {
-           //err << boost::errinfo_file_name();
-           throw;
+   if (model_) {
+       // The snapshot is already validated; only the analysis setup remains.
+       model_->mission_time().value(settings_.mission_time());
+   } else {
+       ParseInputFiles(expanded_files);
+//       CLOCK(def_time);
+       for (const io::xml::Document& document : documents_) {
+           try {
+               ProcessInputFile(document);
+           } catch (ValidityError& err) {
+               //err << boost::errinfo_file_name();
+               throw;
+           }
        }
-   }
-   ProcessTbdElements();
-//   LOG(DEBUG2) << "Element definition time " << DUR(def_time);
-//   LOG(DEBUG1) << "Input files are processed in " << DUR(input_time);
+       ProcessTbdElements();
+//       LOG(DEBUG2) << "Element definition time " << DUR(def_time);
+//       LOG(DEBUG1) << "Input files are processed in " << DUR(input_time);
+
+//       CLOCK(valid_time);
+//       LOG(DEBUG1) << "Validating the initialization";
+       // Check if the initialization is successful.
+       ValidateInitialization();
+//       LOG(DEBUG1) << "Validation is finished in " << DUR(valid_time);
 
-//   CLOCK(valid_time);
-//   LOG(DEBUG1) << "Validating the initialization";
-   // Check if the initialization is successful.
-   ValidateInitialization();
-//   LOG(DEBUG1) << "Validation is finished in " << DUR(valid_time);
+       if (cache && ModelCache::IsCacheable(*model_)) {
+           try {
+               cache->Store(cache_key, *model_, expanded_files);
+           } catch (const IOError&) {
+               // The cache is an optimization; the analysis proceeds without it.
+//               LOG(WARNING) << "Failed to store the model snapshot: " << err.what();
+           }
+       }
+   }
 
 //   CLOCK(setup_time);
 //   LOG(DEBUG1) << "Setting up for the analysis";
@@ -1224,11 +1311,11 @@ Expression* Initializer::GetExpression(const io::xml::Element& expr_element,
    };
    if (expr_type == "int") {
        int val = *expr_element.attribute<int>("value");
-       return register_expression(std::make_unique<ConstantExpression>(val));
+       return model_->AddConstant(val);
    }
    if (expr_type == "float") {
        double val = *expr_element.attribute<double>("value");
-       return register_expression(std::make_unique<ConstantExpression>(val));
+       return model_->AddConstant(val);
    }
    if (expr_type == "bool") {
        bool val = *expr_element.attribute<bool>("value");
@@ -1277,10 +1364,13 @@ Expression* Initializer::GetExpression(const io::xml::Element& expr_element,
        return expression;
 
    try {
-       Expression* expression = register_expression(kExpressionExtractors_.at(
-           expr_type)(expr_element.children(), base_path, this));
-       // Register for late validation after ensuring no cycles.
-       expressions_.emplace_back(expression, expr_element);
+       std::unique_ptr<Expression> extracted =
+           kExpressionExtractors_.at(expr_type)(expr_element.children(), base_path, this);
+       Expression* address = extracted.get();
+       Expression* expression = model_->Intern(std::move(extracted));
+       // Register new expressions for late validation after ensuring no cycles.
+       if (expression == address)
+           expressions_.emplace_back(expression, expr_element);
        return expression;
    } catch (ValidityError& err) {
        //err << boost::errinfo_at_line(expr_element.line());
@@ -1351,6 +1441,39 @@ void Initializer::DefineCcfFactor(const io::xml::Element& factor_node,
    }
 }
 
+namespace {
+
+/// Finds the full path of the reference without interning new strings.
+///
+/// @param[in] base_path  The base path of the local scope or empty.
+/// @param[in] reference  The reference relative to the base path.
+///
+/// @returns The full path key if its base path and name have been interned,
+///          i.e., there may be an element with the full path.
+std::optional<PathKey> FindPathKey(std::string_view base_path,
+                                   std::string_view reference) {
+   std::size_t dot = reference.rfind('.');
+   std::optional<Symbol> name = Symbol::Find(reference.substr(dot + 1));
+   if (!name)
+       return {};
+   std::optional<Symbol> prefix;
+   if (dot == std::string_view::npos) {
+       prefix = Symbol::Find(base_path);
+   } else if (base_path.empty()) {
+       prefix = Symbol::Find(reference.substr(0, dot));
+   } else {
+       std::string path(base_path);
+       path += '.';
+       path += reference.substr(0, dot);
+       prefix = Symbol::Find(path);
+   }
+   if (!prefix)
+       return {};
+   return PathKey{*prefix, *name};
+}
+
+}  // namespace
+
 Parameter* Initializer::GetParameter(std::string_view entity_reference,
                                     const std::string& base_path) {
    return GetEntity(entity_reference, base_path, model_->table<Parameter>(),
@@ -1382,24 +1505,22 @@ T* Initializer::GetEntity(std::string_view entity_reference,
                          const TableRange<PathTable<T>>& path_container) {
    assert(!entity_reference.empty());
    if (!base_path.empty()) {  // Check the local scope.
-       std::string full_path = base_path + ".";
-       full_path.append(entity_reference.data(), entity_reference.size());
-       if (auto it = find(path_container, full_path))
-           return &*it;
+       if (std::optional<PathKey> key = FindPathKey(base_path, entity_reference)) {
+           if (auto it = find(path_container, *key))
+               return &*it;
+       }
    }
 
-   auto at = [&entity_reference, &base_path](const auto& reference_container) {
-       if (auto it = find(reference_container, entity_reference))
+   if (entity_reference.find('.') == std::string_view::npos) {  // Public entity.
+       if (auto it = find(container, entity_reference))
            return &*it;
-       throw(UndefinedElement());
-          // << errinfo_reference(std::string(entity_reference))
-          // << errinfo_base_path(base_path) << errinfo_element_type(T::kTypeString);
-   };
-
-   if (entity_reference.find('.') == std::string_view::npos)  // Public entity.
-       return at(container);
-
-   return at(path_container);  // Direct access.
+   } else if (std::optional<PathKey> key = FindPathKey("", entity_reference)) {
+       if (auto it = find(path_container, *key))  // Direct access.
+           return &*it;
+   }
+   throw(UndefinedElement());
+      // << errinfo_reference(std::string(entity_reference))
+      // << errinfo_base_path(base_path) << errinfo_element_type(T::kTypeString);
 }
 
 /// Helper macro for Initializer::GetEvent event discovery.
@@ -1420,18 +1541,18 @@ Formula::ArgEvent Initializer::GetEvent(std::string_view entity_reference,
    // The semantics for local lookup with the base type is different.
    assert(!entity_reference.empty());
    if (!base_path.empty()) {  // Check the local scope.
-       std::string full_path = base_path + ".";
-       full_path.append(entity_reference.data(), entity_reference.size());
-       GET_EVENT(TableRange(path_gates_), TableRange(path_basic_events_),
-                 TableRange(path_house_events_), full_path);
+       if (std::optional<PathKey> key = FindPathKey(base_path, entity_reference)) {
+           GET_EVENT(TableRange(path_gates_), TableRange(path_basic_events_),
+                     TableRange(path_house_events_), *key);
+       }
    }
 
    if (entity_reference.find('.') == std::string_view::npos) {  // Public entity.
        GET_EVENT(model_->table<Gate>(), model_->table<BasicEvent>(),
                  model_->table<HouseEvent>(), entity_reference);
-   } else {  // Direct access.
+   } else if (std::optional<PathKey> key = FindPathKey("", entity_reference)) {
        GET_EVENT(TableRange(path_gates_), TableRange(path_basic_events_),
-                 TableRange(path_house_events_), entity_reference);
+                 TableRange(path_house_events_), *key);  // Direct access.
    }
    throw(UndefinedElement());
        //<< errinfo_reference(std::string(entity_reference))
@@ -1900,6 +2021,104 @@ void Initializer::SetupForAnalysis() {
        for (CcfGroup& group : model_->table<CcfGroup>())
            group.ApplyModel();
    }
+
+   IndexExpressions();
+}
+
+void Initializer::IndexExpressions() {
+   auto sorted = [](auto&& table, auto key) {
+       std::vector<const std::decay_t<decltype(*table.begin())>*> elements;
+       for (const auto& element : table)
+           elements.push_back(&element);
+       std::sort(elements.begin(), elements.end(),
+                 [&key](const auto* lhs, const auto* rhs) { return key(*lhs) < key(*rhs); });
+       return elements;
+   };
+   auto by_id = [](const auto& element) -> const std::string& { return element.id(); };
+   auto by_name = [](const auto& element) -> const std::string& { return element.name(); };
+   std::uint32_t next_index = 0;
+   std::uint32_t next_id = 0;
+   std::unordered_set<Expression*> visited;
+   std::vector<Expression*> stack;
+   auto assign = [&](Expression* root) {
+       stack.push_back(root);
+       while (!stack.empty()) {
+           Expression* expression = stack.back();
+           stack.pop_back();
+           if (!visited.insert(expression).second)
+               continue;
+           // The shared constants of all the models never need a slot.
+           if (expression == &ConstantExpression::kOne ||
+               expression == &ConstantExpression::kZero ||
+               expression == &ConstantExpression::kPi) {
+               continue;
+           }
+           expression->index(next_index++);
+           if (auto* deviate = dynamic_cast<RandomDeviate*>(expression))
+               deviate->stream_id(next_id++);
+           const std::vector<Expression*>& args = expression->args();
+           stack.insert(stack.end(), args.rbegin(), args.rend());  // Preorder.
+       }
+   };
+   for (const BasicEvent* basic_event : sorted(model_->basic_events(), by_id)) {
+       if (basic_event->HasExpression())
+           assign(&basic_event->expression());
+   }
+   for (const CcfGroup* group : sorted(model_->ccf_groups(), by_id)) {
+       if (group->distribution())
+           assign(group->distribution());
+       for (const auto& [level, factor] : group->factors())
+           assign(factor);
+       for (const auto& [level, probability] : group->probabilities())
+           assign(probability);
+   }
+   for (const Parameter* parameter : sorted(model_->parameters(), by_id)) {
+       if (parameter->expression())
+           assign(parameter->expression());
+   }
+
+   // The expressions only reachable from the event-tree instructions,
+   // e.g., initiating-event frequencies and conditions.
+   // Linked event trees, named branches, sequences, and rules
+   // are walked on their own in the order of their names.
+   struct Walker : public NullVisitor {
+       void Visit(const CollectExpression* collect) override {
+           assign(&collect->expression());
+       }
+       void Visit(const IfThenElse* ite) override {
+           assign(ite->expression());
+           NullVisitor::Visit(ite);
+       }
+       void Visit(const Rule*) override {}
+
+       void operator()(const std::vector<Instruction*>& instructions) {
+           for (const Instruction* instruction : instructions)
+               instruction->Accept(this);
+       }
+       void operator()(const Sequence*) {}
+       void operator()(const NamedBranch*) {}
+       void operator()(const Branch* branch) {
+           (*this)(branch->instructions());
+           std::visit(*this, branch->target());
+       }
+       void operator()(const Fork* fork) {
+           for (const Path& fork_path : fork->paths())
+               (*this)(&fork_path);
+       }
+
+       std::function<void(Expression*)> assign;
+   } walker;
+   walker.assign = assign;
+
+   for (const EventTree* event_tree : sorted(model_->event_trees(), by_name)) {
+       walker(&event_tree->initial_state());
+       for (const NamedBranch* branch : sorted(event_tree->branches(), by_name))
+           walker(branch);
+   }
+   for (const Sequence* sequence : sorted(model_->sequences(), by_name))
+       walker(sequence->instructions());
+   for (const Rule* rule : sorted(model_->rules(), by_name))
+       walker(rule->instructions());
 }
 
 }  // namespace scram::mef
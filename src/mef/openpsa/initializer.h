@@ -12,10 +12,6 @@
 #include <variant>
 #include <vector>
 
-#include <boost/multi_index/hashed_index.hpp>
-#include <boost/multi_index/mem_fun.hpp>
-#include <boost/multi_index_container.hpp>
-
 #include "io/xml/xml.h"
 
 #include "mef/openpsa/alignment.h"
@@ -83,11 +79,7 @@ class Initializer : private boost::noncopyable {
    ///
    /// @tparam T  The element type.
    template <typename T>
-   using PathTable = boost::multi_index_container<
-       T*, boost::multi_index::indexed_by<boost::multi_index::hashed_unique<
-                boost::multi_index::const_mem_fun<Id, std::string_view,
-                                                  &Id::full_path>,
-                std::hash<std::string_view>>>>;
+   using PathTable = FlatTable<T*, PathKeyOf, PathKeyHash>;
 
    /// @tparam T  Type of an expression.
    /// @tparam N  The number of arguments for the expression.
@@ -161,6 +153,19 @@ class Initializer : private boost::noncopyable {
    /// @throws IllegalOperation     If loading external libraries is disallowed.
    void ProcessInputFiles(const std::vector<std::string>& xml_files);
 
+   /// Parses and validates the input files into documents_.
+   /// The files are distributed over the worker threads
+   /// requested by the settings;
+   /// each worker owns its schema validator
+   /// since validation contexts are not shareable between threads.
+   /// The documents are stored in the order of the input files
+   /// regardless of the completion order.
+   ///
+   /// @param[in] xml_files  Existing, unique input files.
+   ///
+   /// @throws io::xml::Error  The first failure in the order of the files.
+   void ParseInputFiles(const std::vector<std::string>& xml_files);
+
    /// Reads one input XML file document with the structure of analysis entities.
    /// Initializes the analysis from the given document.
    /// Puts all events into their appropriate containers.
@@ -478,6 +483,18 @@ class Initializer : private boost::noncopyable {
    /// is applied to analysis.
    void SetupForAnalysis();
 
+   /// Assigns the dense sampling indices of the model expressions
+   /// and the random stream ids of the deviates
+   /// in the depth-first order of the expressions
+   /// from the basic events, CCF groups, and parameters sorted by ids,
+   /// and then from the instructions of the event trees, sequences, and rules
+   /// sorted by names,
+   /// so the samples are reproducible
+   /// regardless of the input processing or the model snapshot.
+   ///
+   /// @pre All CCF groups are applied.
+   void IndexExpressions();
+
    /// Ensures that non-declarative substitutions do not contain CCF events.
    ///
    /// @throws ValidityError  Hypothesis, source, or target event is in CCF.
@@ -40,16 +40,19 @@ class SetHouseEvent : public Visitable<SetHouseEvent> {
    /// @param[in] name  Non-empty public house-event name.
    /// @param[in] state  The new state for the given house-event.
    SetHouseEvent(std::string name, bool state)
-       : name_(std::move(name)), state_(state) {}
+       : name_(name), state_(state) {}
 
    /// @returns The name of the house-event to apply this instruction.
-   [[nodiscard]] const std::string& name() const { return name_; }
+   [[nodiscard]] const std::string& name() const { return name_.str(); }
+
+   /// @returns The interned name of the house-event.
+   [[nodiscard]] Symbol name_symbol() const { return name_; }
 
    /// @returns The state of the target house-event to be changed into.
    [[nodiscard]] bool state() const { return state_; }
 
  private:
-   std::string name_;  ///< The public name of the house event.
+   Symbol name_;  ///< The public name of the house event.
    bool state_;  ///< The state for the house event.
 };
 
@@ -3,29 +3,43 @@
 
 #pragma once
 
+#include <bit>
+#include <cstdint>
+#include <deque>
 #include <memory>
 #include <string>
 #include <string_view>
+#include <typeindex>
+#include <unordered_map>
 #include <vector>
 
 #include "mef/openpsa/alignment.h"
 #include "mef/openpsa/ccf_group.h"
 #include "mef/openpsa/element.h"
 #include "mef/openpsa/event/event.h"
+#include "mef/openpsa/event/gate.h"
 #include "mef/openpsa/event_tree.h"
 #include "mef/openpsa/expression.h"
+#include "mef/openpsa/expr/constant.h"
 #include "mef/openpsa/expr/extern.h"
+#include "mef/openpsa/expr/random_deviate.h"
 #include "mef/openpsa/expr/test_event.h"
 #include "mef/openpsa/fault_tree.h"
+#include "mef/openpsa/find_iterator.h"
 #include "mef/openpsa/instruction.h"
 #include "mef/openpsa/parameter.h"
 #include "mef/openpsa/substitution.h"
+#include "mef/openpsa/symbol.h"
 
 namespace mef::openpsa {
 
 /// This class represents a risk analysis model.
+///
+/// The model owns the symbols of its elements,
+/// which are released with the last live model.
 class Model
-   : public Element,
+   : private SymbolOwner,
+     public Element,
      public MultiContainer<Model, InitiatingEvent, EventTree, Sequence, Rule,
                            Alignment, Substitution, FaultTree, BasicEvent,
                            Gate, HouseEvent, Parameter, CcfGroup,
@@ -118,6 +132,54 @@ class Model
    }
    /// @}
 
+   /// @param[in] value  The value of a numerical literal.
+   ///
+   /// @returns The constant expression shared by all the equal literals
+   ///          and allocated in the chunked storage of the model.
+   Expression* AddConstant(double value) {
+       auto [it, inserted] = constants_.try_emplace(std::bit_cast<std::uint64_t>(value));
+       if (inserted)
+           it->second = &constant_arena_.emplace_back(value);
+       return it->second;
+   }
+
+   /// Adds an expression with structural sharing and constant folding.
+   ///
+   /// Expressions of the same type with the same arguments are shared.
+   /// Random deviates are never shared,
+   /// for every deviate in the model is an independent random variable,
+   /// and neither are the test events
+   /// whose values depend on the event-tree walk rather than the arguments.
+   /// Expressions with only literal constant arguments
+   /// are validated and folded into constants.
+   ///
+   /// @param[in] expression  A new expression of a deterministic formula
+   ///                        fully defined by its type and arguments.
+   ///
+   /// @returns The equivalent expression in the model,
+   ///          which is the argument only if it is a new one.
+   ///
+   /// @throws ValidityError  The folded expression is invalid.
+   Expression* Intern(std::unique_ptr<Expression> expression) {
+       Expression* address = expression.get();
+       if (dynamic_cast<RandomDeviate*>(address) || dynamic_cast<TestEvent*>(address)) {
+           Add(std::move(expression));
+           return address;
+       }
+       const std::vector<Expression*>& args = address->args();
+       if (!args.empty() && std::all_of(args.begin(), args.end(), [](Expression* arg) {
+               return dynamic_cast<ConstantExpression*>(arg) != nullptr;
+           })) {
+           address->Validate();
+           return AddConstant(address->value());
+       }
+       auto [it, inserted] =
+           shared_expressions_.try_emplace({typeid(*address), args}, address);
+       if (inserted)
+           Add(std::move(expression));
+       return it->second;
+   }
+
    /// Convenience function to retrieve an event with its ID.
    ///
    /// @param[in] id  The valid ID string of the event.
@@ -136,6 +198,26 @@ class Model
    }
 
  private:
+   /// The structure of a shared expression.
+   struct ExpressionKey {
+       std::type_index type;  ///< The formula type.
+       std::vector<Expression*> args;  ///< The arguments of the formula.
+
+       /// Structural equality.
+       bool operator==(const ExpressionKey&) const = default;
+   };
+
+   /// Hash of the expression structure.
+   struct ExpressionKeyHash {
+       /// @returns The combined hash of the type and the argument addresses.
+       std::size_t operator()(const ExpressionKey& key) const noexcept {
+           std::size_t hash = key.type.hash_code();
+           for (Expression* arg : key.args)
+               hash ^= std::hash<Expression*>()(arg) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+           return hash;
+       }
+   };
+
    /// @copydoc Model::Add(std::unique_ptr<BasicEvent>).
    template <class T>
    void AddEvent(std::unique_ptr<T> element) {
@@ -160,6 +242,13 @@ class Model
    std::vector<std::unique_ptr<Instruction>> instructions_;
    /// @}
 
+   /// The literal constants with stable addresses.
+   std::deque<ConstantExpression> constant_arena_;
+   /// The shared literal constants by the bits of their values.
+   std::unordered_map<std::uint64_t, ConstantExpression*> constants_;
+   /// The shared expressions by their structure.
+   std::unordered_map<ExpressionKey, Expression*, ExpressionKeyHash> shared_expressions_;
+
    std::unique_ptr<MissionTime> mission_time_;  ///< The system mission time.
    Context context_;  ///< The context to be used by test-event expressions.
 };
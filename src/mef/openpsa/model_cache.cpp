@@ -0,0 +1,1636 @@
+/// @file
+/// Implementation of binary model snapshots.
+///
+/// A snapshot is a flat sequence of sections
+/// mirroring the order of the model construction:
+/// the elements without cross-references come first,
+/// then the shared expression and instruction pools in post-order,
+/// and then the definitions that tie the elements together.
+/// Cross-references are indices into the preceding sections.
+
+#include "mef/openpsa/model_cache.h"
+
+#include <cstring>
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <typeindex>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/exceptions.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+#include <libxml/uri.h>
+#include <libxml/xinclude.h>
+
+#include "mef/openpsa/error.h"
+#include "mef/openpsa/expr/boolean.h"
+#include "mef/openpsa/expr/conditional.h"
+#include "mef/openpsa/expr/constant.h"
+#include "mef/openpsa/expr/exponential.h"
+#include "mef/openpsa/expr/numerical.h"
+#include "mef/openpsa/expr/random_deviate.h"
+#include "mef/openpsa/expr/test_event.h"
+
+namespace mef::openpsa {
+
+namespace {  // Snapshot format facilities.
+
+/// The leading bytes of snapshot files.
+constexpr std::string_view kMagic = "canopy-mef-model";
+
+/// References to other snapshot records.
+using Index = std::uint32_t;
+
+/// The reference to an absent record.
+constexpr Index kNoIndex = std::numeric_limits<Index>::max();
+
+/// Expression types in snapshots.
+enum class ExpressionKind : std::uint8_t {
+   kConstant = 0,
+   kOne,
+   kZero,
+   kPi,
+   kMissionTime,
+   kParameter,
+   kTestInitiatingEvent,
+   kTestFunctionalEvent,
+   kExponential,
+   kGlm,
+   kWeibull,
+   kPeriodicTest,
+   kUniformDeviate,
+   kNormalDeviate,
+   kLognormalDeviate,
+   kGammaDeviate,
+   kBetaDeviate,
+   kHistogram,
+   kNeg,
+   kAdd,
+   kSub,
+   kMul,
+   kDiv,
+   kAbs,
+   kAcos,
+   kAsin,
+   kAtan,
+   kCos,
+   kSin,
+   kTan,
+   kCosh,
+   kSinh,
+   kTanh,
+   kExp,
+   kLog,
+   kLog10,
+   kMod,
+   kPow,
+   kSqrt,
+   kCeil,
+   kFloor,
+   kMin,
+   kMax,
+   kMean,
+   kNot,
+   kAnd,
+   kOr,
+   kEq,
+   kDf,
+   kLt,
+   kGt,
+   kLeq,
+   kGeq,
+   kIte,
+   kSwitch,
+   kNumKinds  ///< The number of expression kinds (not a kind).
+};
+
+/// Instruction types in snapshots.
+enum class InstructionKind : std::uint8_t {
+   kSetHouseEvent = 0,
+   kCollectExpression,
+   kCollectFormula,
+   kIfThenElse,
+   kBlock,
+   kRule,
+   kLink,
+   kNumKinds  ///< The number of instruction kinds (not a kind).
+};
+
+/// Formula argument event types in snapshots.
+enum class EventKind : std::uint8_t {
+   kGate = 0,
+   kBasicEvent,
+   kHouseEvent,
+   kTrue,  ///< The literal True house event.
+   kFalse,  ///< The literal False house event.
+   kNumKinds  ///< The number of event kinds (not a kind).
+};
+
+/// Branch target types in snapshots.
+enum class TargetKind : std::uint8_t { kSequence = 0, kFork, kNamedBranch, kNumKinds };
+
+/// CCF model types in snapshots.
+enum class CcfModel : std::uint8_t { kBetaFactor = 0, kMgl, kAlphaFactor, kPhiFactor, kNumKinds };
+
+/// @returns The snapshot kinds of concrete expression types.
+///
+/// @note Parameters, the mission time, and the constant singletons
+///       are identified by their addresses instead.
+const std::unordered_map<std::type_index, ExpressionKind>& GetExpressionKinds() {
+   static const std::unordered_map<std::type_index, ExpressionKind> kinds = {
+       {typeid(ConstantExpression), ExpressionKind::kConstant},
+       {typeid(TestInitiatingEvent), ExpressionKind::kTestInitiatingEvent},
+       {typeid(TestFunctionalEvent), ExpressionKind::kTestFunctionalEvent},
+       {typeid(Exponential), ExpressionKind::kExponential},
+       {typeid(Glm), ExpressionKind::kGlm},
+       {typeid(Weibull), ExpressionKind::kWeibull},
+       {typeid(PeriodicTest), ExpressionKind::kPeriodicTest},
+       {typeid(UniformDeviate), ExpressionKind::kUniformDeviate},
+       {typeid(NormalDeviate), ExpressionKind::kNormalDeviate},
+       {typeid(LognormalDeviate), ExpressionKind::kLognormalDeviate},
+       {typeid(GammaDeviate), ExpressionKind::kGammaDeviate},
+       {typeid(BetaDeviate), ExpressionKind::kBetaDeviate},
+       {typeid(Histogram), ExpressionKind::kHistogram},
+       {typeid(Neg), ExpressionKind::kNeg},
+       {typeid(Add), ExpressionKind::kAdd},
+       {typeid(Sub), ExpressionKind::kSub},
+       {typeid(Mul), ExpressionKind::kMul},
+       {typeid(Div), ExpressionKind::kDiv},
+       {typeid(Abs), ExpressionKind::kAbs},
+       {typeid(Acos), ExpressionKind::kAcos},
+       {typeid(Asin), ExpressionKind::kAsin},
+       {typeid(Atan), ExpressionKind::kAtan},
+       {typeid(Cos), ExpressionKind::kCos},
+       {typeid(Sin), ExpressionKind::kSin},
+       {typeid(Tan), ExpressionKind::kTan},
+       {typeid(Cosh), ExpressionKind::kCosh},
+       {typeid(Sinh), ExpressionKind::kSinh},
+       {typeid(Tanh), ExpressionKind::kTanh},
+       {typeid(Exp), ExpressionKind::kExp},
+       {typeid(Log), ExpressionKind::kLog},
+       {typeid(Log10), ExpressionKind::kLog10},
+       {typeid(Mod), ExpressionKind::kMod},
+       {typeid(Pow), ExpressionKind::kPow},
+       {typeid(Sqrt), ExpressionKind::kSqrt},
+       {typeid(Ceil), ExpressionKind::kCeil},
+       {typeid(Floor), ExpressionKind::kFloor},
+       {typeid(Min), ExpressionKind::kMin},
+       {typeid(Max), ExpressionKind::kMax},
+       {typeid(Mean), ExpressionKind::kMean},
+       {typeid(Not), ExpressionKind::kNot},
+       {typeid(And), ExpressionKind::kAnd},
+       {typeid(Or), ExpressionKind::kOr},
+       {typeid(Eq), ExpressionKind::kEq},
+       {typeid(Df), ExpressionKind::kDf},
+       {typeid(Lt), ExpressionKind::kLt},
+       {typeid(Gt), ExpressionKind::kGt},
+       {typeid(Leq), ExpressionKind::kLeq},
+       {typeid(Geq), ExpressionKind::kGeq},
+       {typeid(Ite), ExpressionKind::kIte},
+       {typeid(Switch), ExpressionKind::kSwitch}};
+   return kinds;
+}
+
+/// Growing byte buffer of a snapshot under construction.
+class Buffer {
+ public:
+   /// Appends arithmetic or enum values in the host byte order.
+   template <typename T>
+   void Write(T value) {
+       static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>);
+       data_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+   }
+
+   /// Appends raw bytes without the size.
+   void WriteBytes(std::string_view bytes) { data_.append(bytes); }
+
+   /// Appends a size-prefixed string.
+   void WriteString(std::string_view value) {
+       Write<std::uint32_t>(value.size());
+       data_.append(value);
+   }
+
+   /// Appends a size-prefixed list of references.
+   void WriteIndices(const std::vector<Index>& indices) {
+       Write<std::uint32_t>(indices.size());
+       for (Index index : indices)
+           Write(index);
+   }
+
+   /// Appends an optional integer.
+   void WriteOptional(std::optional<int> value) {
+       Write<std::uint8_t>(value.has_value());
+       if (value)
+           Write<std::int32_t>(*value);
+   }
+
+   /// Appends the contents of another buffer.
+   void Append(const Buffer& other) { data_ += other.data_; }
+
+   /// @returns The accumulated data.
+   std::string str() && { return std::move(data_); }
+
+ private:
+   std::string data_;  ///< The accumulated bytes.
+};
+
+/// Bounds-checked reader of snapshot data.
+class Cursor {
+ public:
+   /// @param[in] begin  The start of the data.
+   /// @param[in] end  The end of the data.
+   Cursor(const char* begin, const char* end) : pos_(begin), end_(end) {}
+
+   /// @returns true if all the data is consumed.
+   bool AtEnd() const { return pos_ == end_; }
+
+   /// Reads arithmetic values.
+   ///
+   /// @throws IOError  The data is truncated.
+   template <typename T>
+   T Read() {
+       static_assert(std::is_arithmetic_v<T>);
+       Require(sizeof(T));
+       T value;
+       std::memcpy(&value, pos_, sizeof(value));
+       pos_ += sizeof(value);
+       return value;
+   }
+
+   /// Reads enum values.
+   ///
+   /// @tparam E  The enum type with its kNumKinds or the given bound.
+   ///
+   /// @throws IOError  The value is out of the enum range.
+   template <typename E>
+   E ReadEnum(std::underlying_type_t<E> bound = static_cast<std::underlying_type_t<E>>(E::kNumKinds)) {
+       auto value = Read<std::underlying_type_t<E>>();
+       if (value >= bound)
+           throw(IOError("Invalid enum value in the model snapshot."));
+       return static_cast<E>(value);
+   }
+
+   /// Reads Boolean flags.
+   bool ReadBool() { return Read<std::uint8_t>() != 0; }
+
+   /// Reads raw bytes without the size.
+   std::string_view ReadBytes(std::size_t size) {
+       Require(size);
+       std::string_view bytes(pos_, size);
+       pos_ += size;
+       return bytes;
+   }
+
+   /// Reads size-prefixed strings.
+   std::string ReadString() { return std::string(ReadBytes(Read<std::uint32_t>())); }
+
+   /// Reads size-prefixed lists of references.
+   std::vector<Index> ReadIndices() {
+       auto size = Read<std::uint32_t>();
+       Require(static_cast<std::size_t>(size) * sizeof(Index));
+       std::vector<Index> indices(size);
+       for (Index& index : indices)
+           index = Read<Index>();
+       return indices;
+   }
+
+   /// Reads optional integers.
+   std::optional<int> ReadOptional() {
+       if (!ReadBool())
+           return {};
+       return Read<std::int32_t>();
+   }
+
+ private:
+   /// @throws IOError  Fewer bytes than requested are left.
+   void Require(std::size_t size) const {
+       if (static_cast<std::size_t>(end_ - pos_) < size)
+           throw(IOError("The model snapshot is truncated."));
+   }
+
+   const char* pos_;  ///< The current position.
+   const char* end_;  ///< The end of the data.
+};
+
+/// 64-bit FNV-1a hash of the snapshot input.
+class InputHash {
+ public:
+   /// Mixes the bytes into the hash.
+   void Mix(const char* data, std::size_t size) {
+       for (std::size_t i = 0; i < size; ++i) {
+           hash_ ^= static_cast<unsigned char>(data[i]);
+           hash_ *= 1099511628211ULL;
+       }
+   }
+
+   /// Mixes arithmetic values in the host byte order.
+   template <typename T>
+   void MixValue(T value) {
+       static_assert(std::is_arithmetic_v<T>);
+       Mix(reinterpret_cast<const char*>(&value), sizeof(value));
+   }
+
+   /// Mixes the file contents delimited by the file size.
+   ///
+   /// @returns false if the file cannot be read.
+   bool MixFile(const std::string& path) {
+       std::ifstream stream(path, std::ios::binary);
+       if (!stream)
+           return false;
+       std::vector<char> chunk(1 << 16);
+       std::uint64_t file_size = 0;
+       while (stream.read(chunk.data(), chunk.size()) || stream.gcount()) {
+           Mix(chunk.data(), stream.gcount());
+           file_size += stream.gcount();
+       }
+       MixValue(file_size);
+       return true;
+   }
+
+   /// @returns The current hash value.
+   std::uint64_t value() const { return hash_; }
+
+ private:
+   std::uint64_t hash_ = 14695981039346656037ULL;  ///< The FNV offset basis.
+};
+
+/// @returns The content hash of the file or nothing if the file cannot be read.
+std::optional<std::uint64_t> HashFile(const std::string& path) {
+   InputHash hash;
+   if (!hash.MixFile(path))
+       return {};
+   return hash.value();
+}
+
+/// Collects the files included with XInclude by the input file recursively,
+/// including the alternative files of fallbacks.
+///
+/// @param[in] xml_file  The XML file with the include elements.
+/// @param[in,out] includes  The included files in the order of discovery.
+void CollectIncludes(const std::string& xml_file, std::vector<std::string>* includes) {
+   std::unique_ptr<xmlDoc, decltype(&xmlFreeDoc)> document(
+       xmlReadFile(xml_file.c_str(), nullptr,
+                   XML_PARSE_NONET | XML_PARSE_HUGE | XML_PARSE_NOERROR | XML_PARSE_NOWARNING),
+       &xmlFreeDoc);
+   if (!document)
+       return;  // Missing files are recorded by their includers.
+   std::vector<xmlNode*> nodes;
+   if (xmlNode* root = xmlDocGetRootElement(document.get()))
+       nodes.push_back(root);
+   while (!nodes.empty()) {
+       xmlNode* node = nodes.back();
+       nodes.pop_back();
+       for (xmlNode* child = node->children; child; child = child->next) {
+           if (child->type == XML_ELEMENT_NODE)
+               nodes.push_back(child);
+       }
+       if (!node->ns || xmlStrcmp(node->name, XINCLUDE_NODE) ||
+           (xmlStrcmp(node->ns->href, XINCLUDE_NS) && xmlStrcmp(node->ns->href, XINCLUDE_OLD_NS))) {
+           continue;
+       }
+       auto get = [node](const char* name) -> std::optional<std::string> {
+           xmlChar* value = xmlGetProp(node, BAD_CAST name);
+           if (!value)
+               return {};
+           std::string result(reinterpret_cast<const char*>(value));
+           xmlFree(value);
+           return result;
+       };
+       std::optional<std::string> href = get("href");
+       if (!href || href->empty())
+           continue;  // The document includes itself.
+       xmlChar* base = xmlNodeGetBase(document.get(), node);
+       xmlChar* uri = xmlBuildURI(BAD_CAST href->c_str(), base);
+       xmlFree(base);
+       if (!uri)
+           continue;
+       std::string path(reinterpret_cast<const char*>(uri));
+       xmlFree(uri);
+       if (path.starts_with("file://"))
+           path.erase(0, std::strlen("file://"));
+       if (std::find(includes->begin(), includes->end(), path) != includes->end())
+           continue;
+       includes->push_back(path);
+       if (get("parse").value_or("xml") == "xml")
+           CollectIncludes(path, includes);
+   }
+}
+
+/// Resolves snapshot references.
+///
+/// @throws IOError  The reference is out of range.
+template <class T>
+T* Lookup(const std::vector<T*>& records, Index index) {
+   if (index >= records.size())
+       throw(IOError("Dangling reference in the model snapshot."));
+   return records[index];
+}
+
+/// Constructs expressions with a fixed number of arguments.
+///
+/// @throws IOError  The number of arguments does not match.
+/// @{
+template <class T, std::size_t... Is>
+std::unique_ptr<Expression> MakeExpression(const std::vector<Expression*>& args,
+                                           std::index_sequence<Is...>) {
+   if (args.size() != sizeof...(Is))
+       throw(IOError("Invalid number of expression arguments in the model snapshot."));
+   return std::make_unique<T>(args[Is]...);
+}
+template <class T, std::size_t N>
+std::unique_ptr<Expression> MakeExpression(const std::vector<Expression*>& args) {
+   return MakeExpression<T>(args, std::make_index_sequence<N>());
+}
+/// @}
+
+/// Constructs expressions from their kinds and arguments.
+///
+/// @param[in] kind  The kind of an expression with arguments.
+/// @param[in] args  The arguments in the order of Expression::args().
+///
+/// @returns The new expression.
+///
+/// @throws IOError  The arguments are invalid for the expression.
+/// @throws ValidityError  The expression rejects the arguments.
+std::unique_ptr<Expression> BuildExpression(ExpressionKind kind,
+                                            std::vector<Expression*> args) {
+   switch (kind) {
+   case ExpressionKind::kExponential:
+       return MakeExpression<Exponential, 2>(args);
+   case ExpressionKind::kGlm:
+       return MakeExpression<Glm, 4>(args);
+   case ExpressionKind::kWeibull:
+       return MakeExpression<Weibull, 4>(args);
+   case ExpressionKind::kPeriodicTest:
+       switch (args.size()) {
+       case 4:
+           return MakeExpression<PeriodicTest, 4>(args);
+       case 5:
+           return MakeExpression<PeriodicTest, 5>(args);
+       default:
+           return MakeExpression<PeriodicTest, 11>(args);
+       }
+   case ExpressionKind::kUniformDeviate:
+       return MakeExpression<UniformDeviate, 2>(args);
+   case ExpressionKind::kNormalDeviate:
+       return MakeExpression<NormalDeviate, 2>(args);
+   case ExpressionKind::kLognormalDeviate:
+       if (args.size() == 3)
+           return MakeExpression<LognormalDeviate, 3>(args);
+       return MakeExpression<LognormalDeviate, 2>(args);
+   case ExpressionKind::kGammaDeviate:
+       return MakeExpression<GammaDeviate, 2>(args);
+   case ExpressionKind::kBetaDeviate:
+       return MakeExpression<BetaDeviate, 2>(args);
+   case ExpressionKind::kHistogram: {
+       // The boundaries are followed by the weights of the intervals.
+       if (args.size() < 3 || args.size() % 2 == 0)
+           throw(IOError("Invalid histogram in the model snapshot."));
+       auto midpoint = std::next(args.begin(), (args.size() + 1) / 2);
+       return std::make_unique<Histogram>(std::vector<Expression*>(args.begin(), midpoint),
+                                          std::vector<Expression*>(midpoint, args.end()));
+   }
+   case ExpressionKind::kNeg:
+       return MakeExpression<Neg, 1>(args);
+   case ExpressionKind::kAdd:
+       return std::make_unique<Add>(std::move(args));
+   case ExpressionKind::kSub:
+       return std::make_unique<Sub>(std::move(args));
+   case ExpressionKind::kMul:
+       return std::make_unique<Mul>(std::move(args));
+   case ExpressionKind::kDiv:
+       return std::make_unique<Div>(std::move(args));
+   case ExpressionKind::kAbs:
+       return MakeExpression<Abs, 1>(args);
+   case ExpressionKind::kAcos:
+       return MakeExpression<Acos, 1>(args);
+   case ExpressionKind::kAsin:
+       return MakeExpression<Asin, 1>(args);
+   case ExpressionKind::kAtan:
+       return MakeExpression<Atan, 1>(args);
+   case ExpressionKind::kCos:
+       return MakeExpression<Cos, 1>(args);
+   case ExpressionKind::kSin:
+       return MakeExpression<Sin, 1>(args);
+   case ExpressionKind::kTan:
+       return MakeExpression<Tan, 1>(args);
+   case ExpressionKind::kCosh:
+       return MakeExpression<Cosh, 1>(args);
+   case ExpressionKind::kSinh:
+       return MakeExpression<Sinh, 1>(args);
+   case ExpressionKind::kTanh:
+       return MakeExpression<Tanh, 1>(args);
+   case ExpressionKind::kExp:
+       return MakeExpression<Exp, 1>(args);
+   case ExpressionKind::kLog:
+       return MakeExpression<Log, 1>(args);
+   case ExpressionKind::kLog10:
+       return MakeExpression<Log10, 1>(args);
+   case ExpressionKind::kMod:
+       return MakeExpression<Mod, 2>(args);
+   case ExpressionKind::kPow:
+       return MakeExpression<Pow, 2>(args);
+   case ExpressionKind::kSqrt:
+       return MakeExpression<Sqrt, 1>(args);
+   case ExpressionKind::kCeil:
+       return MakeExpression<Ceil, 1>(args);
+   case ExpressionKind::kFloor:
+       return MakeExpression<Floor, 1>(args);
+   case ExpressionKind::kMin:
+       return std::make_unique<Min>(std::move(args));
+   case ExpressionKind::kMax:
+       return std::make_unique<Max>(std::move(args));
+   case ExpressionKind::kMean:
+       return std::make_unique<Mean>(std::move(args));
+   case ExpressionKind::kNot:
+       return MakeExpression<Not, 1>(args);
+   case ExpressionKind::kAnd:
+       return std::make_unique<And>(std::move(args));
+   case ExpressionKind::kOr:
+       return std::make_unique<Or>(std::move(args));
+   case ExpressionKind::kEq:
+       return MakeExpression<Eq, 2>(args);
+   case ExpressionKind::kDf:
+       return MakeExpression<Df, 2>(args);
+   case ExpressionKind::kLt:
+       return MakeExpression<Lt, 2>(args);
+   case ExpressionKind::kGt:
+       return MakeExpression<Gt, 2>(args);
+   case ExpressionKind::kLeq:
+       return MakeExpression<Leq, 2>(args);
+   case ExpressionKind::kGeq:
+       return MakeExpression<Geq, 2>(args);
+   case ExpressionKind::kIte:
+       return MakeExpression<Ite, 3>(args);
+   case ExpressionKind::kSwitch: {
+       // The default value is followed by the condition-value pairs.
+       if (args.empty() || args.size() % 2 == 0)
+           throw(IOError("Invalid switch in the model snapshot."));
+       std::vector<Switch::Case> cases;
+       for (auto it = std::next(args.begin()); it != args.end(); it += 2)
+           cases.push_back({**it, **std::next(it)});
+       return std::make_unique<Switch>(std::move(cases), args.front());
+   }
+   default:
+       throw(IOError("Unexpected expression kind in the model snapshot."));
+   }
+}
+
+/// Serializer of models into snapshots.
+class SnapshotWriter : public InstructionVisitor {
+ public:
+   /// @param[in] model  The validated model before the analysis setup.
+   explicit SnapshotWriter(const Model& model) : model_(model) {}
+
+   /// @param[in] key  The key of the input.
+   ///
+   /// @returns The snapshot data.
+   ///
+   /// @throws IOError  The model contains constructs unsupported by snapshots.
+   std::string Write(const std::string& key, const std::vector<std::string>& includes) && {
+       Buffer snapshot;
+       snapshot.WriteBytes(kMagic);
+       snapshot.Write(ModelCache::kVersion);
+       snapshot.WriteString(key);
+       // The included files are not in the key
+       // for the key is computed before the parsing.
+       snapshot.Write<std::uint32_t>(includes.size());
+       for (const std::string& include : includes) {
+           snapshot.WriteString(include);
+           std::optional<std::uint64_t> hash = HashFile(include);
+           snapshot.Write<std::uint8_t>(hash.has_value());
+           snapshot.Write<std::uint64_t>(hash.value_or(0));
+       }
+
+       Buffer elements;
+       WriteElements(&elements);
+       Buffer definitions;
+       WriteDefinitions(&definitions);  // Populates the shared pools.
+
+       snapshot.Append(elements);
+       snapshot.Write<Index>(num_expressions_);
+       snapshot.Append(expressions_);
+       snapshot.Write<Index>(num_instructions_);
+       snapshot.Append(instructions_);
+       snapshot.Append(definitions);
+       return std::move(snapshot).str();
+   }
+
+ private:
+   /// Indices of snapshot records.
+   template <class T>
+   using IndexMap = std::unordered_map<const T*, Index>;
+
+   /// Serializes the pool instructions.
+   /// @{
+   void Visit(const SetHouseEvent* instruction) override {
+       Buffer record;
+       record.Write(InstructionKind::kSetHouseEvent);
+       record.WriteString(instruction->name());
+       record.Write<std::uint8_t>(instruction->state());
+       AddInstruction(instruction, record);
+   }
+
+   void Visit(const CollectExpression* instruction) override {
+       Index expression = GetExpression(&instruction->expression());
+       Buffer record;
+       record.Write(InstructionKind::kCollectExpression);
+       record.Write(expression);
+       AddInstruction(instruction, record);
+   }
+
+   void Visit(const CollectFormula* instruction) override {
+       Buffer record;
+       record.Write(InstructionKind::kCollectFormula);
+       WriteFormula(instruction->formula(), &record);
+       AddInstruction(instruction, record);
+   }
+
+   void Visit(const Link* instruction) override {
+       Buffer record;
+       record.Write(InstructionKind::kLink);
+       record.Write(event_tree_indices_.at(&instruction->event_tree()));
+       AddInstruction(instruction, record);
+   }
+
+   void Visit(const IfThenElse* instruction) override {
+       Index expression = GetExpression(instruction->expression());
+       Index then_instruction = GetInstruction(instruction->then_instruction());
+       Index else_instruction = instruction->else_instruction()
+                                    ? GetInstruction(instruction->else_instruction())
+                                    : kNoIndex;
+       Buffer record;
+       record.Write(InstructionKind::kIfThenElse);
+       record.Write(expression);
+       record.Write(then_instruction);
+       record.Write(else_instruction);
+       AddInstruction(instruction, record);
+   }
+
+   void Visit(const Block* instruction) override {
+       std::vector<Index> instructions = GetInstructions(instruction->instructions());
+       Buffer record;
+       record.Write(InstructionKind::kBlock);
+       record.WriteIndices(instructions);
+       AddInstruction(instruction, record);
+   }
+
+   void Visit(const Rule* instruction) override {
+       Buffer record;
+       record.Write(InstructionKind::kRule);
+       record.Write(rule_indices_.at(instruction));
+       AddInstruction(instruction, record);
+   }
+   /// @}
+
+   /// Registers a serialized instruction in the pool.
+   void AddInstruction(const Instruction* instruction, const Buffer& record) {
+       instructions_.Append(record);
+       instruction_indices_.emplace(instruction, num_instructions_++);
+   }
+
+   /// @returns The pool index of the instruction serialized in post-order.
+   Index GetInstruction(const Instruction* instruction) {
+       if (auto it = instruction_indices_.find(instruction); it != instruction_indices_.end())
+           return it->second;
+       instruction->Accept(this);
+       return instruction_indices_.at(instruction);
+   }
+
+   /// @returns The pool indices of the instructions.
+   std::vector<Index> GetInstructions(const std::vector<Instruction*>& instructions) {
+       std::vector<Index> indices;
+       for (const Instruction* instruction : instructions)
+           indices.push_back(GetInstruction(instruction));
+       return indices;
+   }
+
+   /// @returns The pool index of the expression serialized in post-order.
+   ///          kNoIndex for nullptr.
+   ///
+   /// @throws IOError  The expression type is not supported.
+   Index GetExpression(Expression* expression) {
+       if (!expression)
+           return kNoIndex;
+       if (auto it = expression_indices_.find(expression); it != expression_indices_.end())
+           return it->second;
+
+       Buffer record;
+       if (expression == &ConstantExpression::kOne) {
+           record.Write(ExpressionKind::kOne);
+       } else if (expression == &ConstantExpression::kZero) {
+           record.Write(ExpressionKind::kZero);
+       } else if (expression == &ConstantExpression::kPi) {
+           record.Write(ExpressionKind::kPi);
+       } else if (expression == &model_.mission_time()) {
+           record.Write(ExpressionKind::kMissionTime);
+       } else if (auto* parameter = dynamic_cast<const Parameter*>(expression)) {
+           record.Write(ExpressionKind::kParameter);
+           record.Write(parameter_indices_.at(parameter));
+       } else {
+           const Expression& concrete = *expression;
+           auto it = GetExpressionKinds().find(typeid(concrete));
+           if (it == GetExpressionKinds().end())
+               throw(IOError("Unsupported expression type for model snapshots."));
+           record.Write(it->second);
+           switch (it->second) {
+           case ExpressionKind::kConstant:
+               record.Write(expression->value());
+               break;
+           case ExpressionKind::kTestInitiatingEvent:
+               record.WriteString(static_cast<const TestInitiatingEvent&>(concrete).name());
+               break;
+           case ExpressionKind::kTestFunctionalEvent: {
+               const auto& test_event = static_cast<const TestFunctionalEvent&>(concrete);
+               record.WriteString(test_event.name());
+               record.WriteString(test_event.state());
+               break;
+           }
+           default: {
+               std::vector<Index> args;
+               for (Expression* arg : expression->args())
+                   args.push_back(GetExpression(arg));
+               record.WriteIndices(args);
+           }
+           }
+       }
+       expressions_.Append(record);
+       expression_indices_.emplace(expression, num_expressions_);
+       return num_expressions_++;
+   }
+
+   /// Serializes the common data of elements.
+   void WriteElement(const Element& element, Buffer* out) {
+       out->WriteString(element.name());
+       out->WriteString(element.label());
+       out->Write<std::uint32_t>(element.attributes().size());
+       for (const Attribute& attribute : element.attributes()) {
+           out->WriteString(attribute.name());
+           out->WriteString(attribute.value());
+           out->WriteString(attribute.type());
+       }
+   }
+
+   /// Serializes the common data of elements with roles.
+   void WriteRole(const Element& element, const Role& role, Buffer* out) {
+       WriteElement(element, out);
+       out->WriteString(role.base_path());
+       out->Write(role.role());
+   }
+
+   /// Serializes Boolean formulas.
+   void WriteFormula(const Formula& formula, Buffer* out) {
+       out->Write(formula.connective());
+       out->WriteOptional(formula.min_number());
+       out->WriteOptional(formula.max_number());
+       out->Write<std::uint32_t>(formula.args().size());
+       for (const Formula::Arg& arg : formula.args()) {
+           out->Write<std::uint8_t>(arg.complement);
+           if (const auto* gate = std::get_if<Gate*>(&arg.event)) {
+               out->Write(EventKind::kGate);
+               out->Write(gate_indices_.at(*gate));
+           } else if (const auto* basic_event = std::get_if<BasicEvent*>(&arg.event)) {
+               out->Write(EventKind::kBasicEvent);
+               out->Write(basic_event_indices_.at(*basic_event));
+           } else {
+               HouseEvent* house_event = std::get<HouseEvent*>(arg.event);
+               if (house_event == &HouseEvent::kTrue) {
+                   out->Write(EventKind::kTrue);
+                   out->Write(kNoIndex);
+               } else if (house_event == &HouseEvent::kFalse) {
+                   out->Write(EventKind::kFalse);
+                   out->Write(kNoIndex);
+               } else {
+                   out->Write(EventKind::kHouseEvent);
+                   out->Write(house_event_indices_.at(house_event));
+               }
+           }
+       }
+   }
+
+   /// Serializes branches of event trees.
+   void WriteBranch(const Branch& branch, Buffer* out) {
+       out->WriteIndices(GetInstructions(branch.instructions()));
+       if (auto* const* sequence = std::get_if<Sequence*>(&branch.target())) {
+           out->Write(TargetKind::kSequence);
+           out->Write(sequence_indices_.at(*sequence));
+       } else if (auto* const* fork = std::get_if<Fork*>(&branch.target())) {
+           out->Write(TargetKind::kFork);
+           out->Write(fork_indices_.at(*fork));
+       } else {
+           out->Write(TargetKind::kNamedBranch);
+           out->Write(named_branch_indices_.at(std::get<NamedBranch*>(branch.target())));
+       }
+   }
+
+   /// Gathers the forks reachable from the branch in post-order.
+   void CollectForks(const Branch& branch, std::vector<const Fork*>* forks) {
+       auto* const* fork = std::get_if<Fork*>(&branch.target());
+       if (!fork || fork_indices_.count(*fork))
+           return;
+       for (const Path& path : (*fork)->paths())
+           CollectForks(path, forks);
+       fork_indices_.emplace(*fork, forks->size());
+       forks->push_back(*fork);
+   }
+
+   /// Serializes the elements without cross-references.
+   void WriteElements(Buffer* out) {
+       WriteElement(model_, out);
+       out->Write<std::uint8_t>(model_.HasDefaultName());
+
+       out->Write<Index>(model_.house_events().size());
+       for (const HouseEvent& event : model_.house_events()) {
+           house_event_indices_.emplace(&event, house_event_indices_.size());
+           WriteRole(event, event, out);
+           out->Write<std::uint8_t>(event.state());
+           out->Write<std::uint8_t>(event.usage());
+       }
+       out->Write<Index>(model_.basic_events().size());
+       for (const BasicEvent& event : model_.basic_events()) {
+           basic_event_indices_.emplace(&event, basic_event_indices_.size());
+           WriteRole(event, event, out);
+           out->Write<std::uint8_t>(event.usage());
+       }
+       out->Write<Index>(model_.gates().size());
+       for (const Gate& gate : model_.gates()) {
+           gate_indices_.emplace(&gate, gate_indices_.size());
+           WriteRole(gate, gate, out);
+           out->Write<std::uint8_t>(gate.usage());
+       }
+       out->Write<Index>(model_.parameters().size());
+       for (const Parameter& parameter : model_.parameters()) {
+           parameter_indices_.emplace(&parameter, parameter_indices_.size());
+           WriteRole(parameter, parameter, out);
+           out->Write(parameter.unit());
+           out->Write<std::uint8_t>(parameter.usage());
+       }
+       out->Write<Index>(model_.sequences().size());
+       for (const Sequence& sequence : model_.sequences()) {
+           sequence_indices_.emplace(&sequence, sequence_indices_.size());
+           WriteElement(sequence, out);
+           out->Write<std::uint8_t>(sequence.usage());
+       }
+       out->Write<Index>(model_.rules().size());
+       for (const Rule& rule : model_.rules()) {
+           rule_indices_.emplace(&rule, rule_indices_.size());
+           WriteElement(rule, out);
+           out->Write<std::uint8_t>(rule.usage());
+       }
+       out->Write<Index>(model_.event_trees().size());
+       for (const EventTree& event_tree : model_.event_trees()) {
+           event_tree_indices_.emplace(&event_tree, event_tree_indices_.size());
+           WriteElement(event_tree, out);
+           out->Write<std::uint8_t>(event_tree.usage());
+           std::vector<Index> sequences;
+           for (const Sequence& sequence : event_tree.table<Sequence>())
+               sequences.push_back(sequence_indices_.at(&sequence));
+           out->WriteIndices(sequences);
+           out->Write<Index>(event_tree.functional_events().size());
+           Index num_functional_events = 0;
+           for (const FunctionalEvent& event : event_tree.functional_events()) {
+               functional_event_indices_.emplace(&event, num_functional_events++);
+               WriteElement(event, out);
+               out->Write<std::int32_t>(event.order());
+               out->Write<std::uint8_t>(event.usage());
+           }
+           out->Write<Index>(event_tree.branches().size());
+           Index num_branches = 0;
+           for (const NamedBranch& branch : event_tree.branches()) {
+               named_branch_indices_.emplace(&branch, num_branches++);
+               WriteElement(branch, out);
+               out->Write<std::uint8_t>(branch.usage());
+           }
+       }
+       out->Write<Index>(model_.initiating_events().size());
+       for (const InitiatingEvent& event : model_.initiating_events()) {
+           WriteElement(event, out);
+           out->Write<std::uint8_t>(event.usage());
+           out->Write(event.event_tree() ? event_tree_indices_.at(event.event_tree()) : kNoIndex);
+       }
+   }
+
+   /// Serializes the definitions of the elements.
+   void WriteDefinitions(Buffer* out) {
+       for (const BasicEvent& event : model_.basic_events())
+           out->Write(event.HasExpression() ? GetExpression(&event.expression()) : kNoIndex);
+       for (const Parameter& parameter : model_.parameters())
+           out->Write(GetExpression(parameter.expression()));
+       for (const Gate& gate : model_.gates()) {
+           out->Write<std::uint8_t>(gate.HasFormula());
+           if (gate.HasFormula())
+               WriteFormula(gate.formula(), out);
+       }
+       for (const Rule& rule : model_.rules())
+           out->WriteIndices(GetInstructions(rule.instructions()));
+       for (const Sequence& sequence : model_.sequences())
+           out->WriteIndices(GetInstructions(sequence.instructions()));
+
+       for (const EventTree& event_tree : model_.event_trees()) {
+           std::vector<const Fork*> forks;
+           for (const NamedBranch& branch : event_tree.branches())
+               CollectForks(branch, &forks);
+           CollectForks(event_tree.initial_state(), &forks);
+           out->Write<Index>(forks.size());
+           for (const Fork* fork : forks) {
+               out->Write(functional_event_indices_.at(&fork->functional_event()));
+               out->Write<std::uint32_t>(fork->paths().size());
+               for (const Path& path : fork->paths()) {
+                   out->WriteString(path.state());
+                   WriteBranch(path, out);
+               }
+           }
+           for (const NamedBranch& branch : event_tree.branches())
+               WriteBranch(branch, out);
+           WriteBranch(event_tree.initial_state(), out);
+       }
+
+       out->Write<Index>(model_.ccf_groups().size());
+       for (const CcfGroup& group : model_.ccf_groups()) {
+           ccf_group_indices_.emplace(&group, ccf_group_indices_.size());
+           WriteRole(group, group, out);
+           if (dynamic_cast<const BetaFactorModel*>(&group)) {
+               out->Write(CcfModel::kBetaFactor);
+           } else if (dynamic_cast<const MglModel*>(&group)) {
+               out->Write(CcfModel::kMgl);
+           } else if (dynamic_cast<const AlphaFactorModel*>(&group)) {
+               out->Write(CcfModel::kAlphaFactor);
+           } else if (dynamic_cast<const PhiFactorModel*>(&group)) {
+               out->Write(CcfModel::kPhiFactor);
+           } else {
+               throw(IOError("Unsupported CCF model for model snapshots."));
+           }
+           std::vector<Index> members;
+           for (const BasicEvent* member : group.members())
+               members.push_back(basic_event_indices_.at(member));
+           out->WriteIndices(members);
+           out->Write(GetExpression(group.distribution()));
+           out->Write<std::uint32_t>(group.factors().size());
+           for (const auto& [level, factor] : group.factors()) {
+               out->Write<std::int32_t>(level);
+               out->Write(GetExpression(factor));
+           }
+       }
+
+       out->Write<Index>(model_.substitutions().size());
+       for (const Substitution& substitution : model_.substitutions()) {
+           WriteElement(substitution, out);
+           WriteFormula(substitution.hypothesis(), out);
+           std::vector<Index> source;
+           for (const BasicEvent* event : substitution.source())
+               source.push_back(basic_event_indices_.at(event));
+           out->WriteIndices(source);
+           if (const bool* constant = std::get_if<bool>(&substitution.target())) {
+               out->Write<std::uint8_t>(false);
+               out->Write<std::uint8_t>(*constant);
+           } else {
+               out->Write<std::uint8_t>(true);
+               out->Write(basic_event_indices_.at(std::get<BasicEvent*>(substitution.target())));
+           }
+       }
+
+       out->Write<Index>(model_.alignments().size());
+       for (const Alignment& alignment : model_.alignments()) {
+           WriteElement(alignment, out);
+           out->Write<std::uint32_t>(alignment.phases().size());
+           for (const Phase& phase : alignment.phases()) {
+               WriteElement(phase, out);
+               out->Write(phase.time_fraction());
+               std::vector<Index> instructions;
+               for (const SetHouseEvent* instruction : phase.instructions())
+                   instructions.push_back(GetInstruction(instruction));
+               out->WriteIndices(instructions);
+           }
+       }
+
+       out->Write<Index>(model_.fault_trees().size());
+       for (const FaultTree& fault_tree : model_.fault_trees()) {
+           WriteElement(fault_tree, out);
+           WriteComponent(fault_tree, out);
+       }
+   }
+
+   /// Serializes the members of fault tree components recursively.
+   void WriteComponent(const Component& component, Buffer* out) {
+       // CCF group members are added to the component with their groups.
+       std::unordered_set<const BasicEvent*> ccf_members;
+       std::vector<Index> ccf_groups;
+       for (const CcfGroup& group : component.ccf_groups()) {
+           ccf_members.insert(group.members().begin(), group.members().end());
+           ccf_groups.push_back(ccf_group_indices_.at(&group));
+       }
+       std::vector<Index> gates;
+       for (const Gate& gate : component.gates())
+           gates.push_back(gate_indices_.at(&gate));
+       std::vector<Index> basic_events;
+       for (const BasicEvent& event : component.basic_events()) {
+           if (!ccf_members.count(&event))
+               basic_events.push_back(basic_event_indices_.at(&event));
+       }
+       std::vector<Index> house_events;
+       for (const HouseEvent& event : component.house_events())
+           house_events.push_back(house_event_indices_.at(&event));
+       std::vector<Index> parameters;
+       for (const Parameter& parameter : component.parameters())
+           parameters.push_back(parameter_indices_.at(&parameter));
+
+       out->WriteIndices(gates);
+       out->WriteIndices(basic_events);
+       out->WriteIndices(house_events);
+       out->WriteIndices(parameters);
+       out->WriteIndices(ccf_groups);
+       out->Write<std::uint32_t>(component.components().size());
+       for (const Component& sub_component : component.components()) {
+           WriteRole(sub_component, sub_component, out);
+           WriteComponent(sub_component, out);
+       }
+   }
+
+   const Model& model_;  ///< The model to serialize.
+
+   Buffer expressions_;  ///< The expression pool.
+   Buffer instructions_;  ///< The instruction pool.
+   Index num_expressions_ = 0;  ///< The number of pool expressions.
+   Index num_instructions_ = 0;  ///< The number of pool instructions.
+
+   /// The record indices of the model constructs.
+   /// Event tree members are indexed within their event trees.
+   /// @{
+   IndexMap<Expression> expression_indices_;
+   IndexMap<Instruction> instruction_indices_;
+   IndexMap<HouseEvent> house_event_indices_;
+   IndexMap<BasicEvent> basic_event_indices_;
+   IndexMap<Gate> gate_indices_;
+   IndexMap<Parameter> parameter_indices_;
+   IndexMap<Sequence> sequence_indices_;
+   IndexMap<Rule> rule_indices_;
+   IndexMap<EventTree> event_tree_indices_;
+   IndexMap<FunctionalEvent> functional_event_indices_;
+   IndexMap<NamedBranch> named_branch_indices_;
+   IndexMap<Fork> fork_indices_;
+   IndexMap<CcfGroup> ccf_group_indices_;
+   /// @}
+};
+
+/// The common data of elements.
+struct ElementData {
+   std::string name;  ///< The element name.
+   std::string label;  ///< The optional label.
+   std::vector<Attribute> attributes;  ///< The element attributes.
+   std::string base_path;  ///< The base path of elements with roles.
+   RoleSpecifier role = RoleSpecifier::kPublic;  ///< The role of elements with roles.
+};
+
+/// Deserializer of models from snapshots.
+///
+/// @note The reader mirrors SnapshotWriter section by section.
+class SnapshotReader {
+ public:
+   /// @param[in,out] cursor  The snapshot data after the header.
+   explicit SnapshotReader(Cursor* cursor) : cursor_(*cursor) {}
+
+   /// @returns The model equivalent to the serialized one.
+   ///
+   /// @throws Error  The snapshot is malformed.
+   std::unique_ptr<Model> Read() && {
+       ReadElements();
+       auto num_expressions = cursor_.Read<Index>();
+       for (Index i = 0; i < num_expressions; ++i)
+           expressions_.push_back(ReadExpression());
+       auto num_instructions = cursor_.Read<Index>();
+       for (Index i = 0; i < num_instructions; ++i)
+           instructions_.push_back(ReadInstruction());
+       ReadDefinitions();
+       if (!cursor_.AtEnd())
+           throw(IOError("Trailing data in the model snapshot."));
+       return std::move(model_);
+   }
+
+ private:
+   /// Reads the common data of elements.
+   ElementData ReadElement() {
+       ElementData data;
+       data.name = cursor_.ReadString();
+       data.label = cursor_.ReadString();
+       auto num_attributes = cursor_.Read<std::uint32_t>();
+       for (std::uint32_t i = 0; i < num_attributes; ++i) {
+           std::string name = cursor_.ReadString();
+           std::string value = cursor_.ReadString();
+           data.attributes.emplace_back(std::move(name), std::move(value),
+                                        cursor_.ReadString());
+       }
+       return data;
+   }
+
+   /// Reads the common data of elements with roles.
+   ElementData ReadRole() {
+       ElementData data = ReadElement();
+       data.base_path = cursor_.ReadString();
+       data.role = cursor_.ReadEnum<RoleSpecifier>(2);
+       return data;
+   }
+
+   /// Assigns the label and attributes to the element.
+   static void AttachLabelAndAttributes(ElementData* data, Element* element) {
+       element->label(std::move(data->label));
+       for (Attribute& attribute : data->attributes)
+           element->AddAttribute(std::move(attribute));
+   }
+
+   /// Constructs elements from their serialized common data.
+   /// @{
+   template <class T>
+   std::unique_ptr<T> ConstructElement() {
+       ElementData data = ReadElement();
+       auto element = std::make_unique<T>(std::move(data.name));
+       AttachLabelAndAttributes(&data, element.get());
+       return element;
+   }
+   template <class T>
+   std::unique_ptr<T> ConstructRole() {
+       ElementData data = ReadRole();
+       auto element = std::make_unique<T>(std::move(data.name),
+                                          std::move(data.base_path), data.role);
+       AttachLabelAndAttributes(&data, element.get());
+       return element;
+   }
+   /// @}
+
+   /// @returns The pool expression; nullptr for kNoIndex.
+   Expression* GetExpression(Index index) {
+       return index == kNoIndex ? nullptr : Lookup(expressions_, index);
+   }
+
+   /// @returns The pool instructions.
+   std::vector<Instruction*> GetInstructions(const std::vector<Index>& indices) {
+       std::vector<Instruction*> instructions;
+       for (Index index : indices)
+           instructions.push_back(Lookup(instructions_, index));
+       return instructions;
+   }
+
+   /// Registers a new expression in the model.
+   Expression* Register(std::unique_ptr<Expression> expression) {
+       Expression* address = expression.get();
+       model_->Add(std::move(expression));
+       return address;
+   }
+
+   /// Registers a new instruction in the model.
+   Instruction* Register(std::unique_ptr<Instruction> instruction) {
+       Instruction* address = instruction.get();
+       model_->Add(std::move(instruction));
+       return address;
+   }
+
+   /// Reads the next expression of the pool.
+   /// The constants and formulas are shared and folded in the model
+   /// the same way as upon the initialization.
+   Expression* ReadExpression() {
+       auto kind = cursor_.ReadEnum<ExpressionKind>();
+       switch (kind) {
+       case ExpressionKind::kConstant:
+           return model_->AddConstant(cursor_.Read<double>());
+       case ExpressionKind::kOne:
+           return &ConstantExpression::kOne;
+       case ExpressionKind::kZero:
+           return &ConstantExpression::kZero;
+       case ExpressionKind::kPi:
+           return &ConstantExpression::kPi;
+       case ExpressionKind::kMissionTime:
+           return &model_->mission_time();
+       case ExpressionKind::kParameter:
+           return Lookup(parameters_, cursor_.Read<Index>());
+       case ExpressionKind::kTestInitiatingEvent:
+           return Register(std::make_unique<TestInitiatingEvent>(cursor_.ReadString(),
+                                                                 model_->context()));
+       case ExpressionKind::kTestFunctionalEvent: {
+           std::string name = cursor_.ReadString();
+           std::string state = cursor_.ReadString();
+           return Register(std::make_unique<TestFunctionalEvent>(
+               std::move(name), std::move(state), model_->context()));
+       }
+       default: {
+           std::vector<Expression*> args;
+           for (Index index : cursor_.ReadIndices())
+               args.push_back(Lookup(expressions_, index));
+           return model_->Intern(BuildExpression(kind, std::move(args)));
+       }
+       }
+   }
+
+   /// Reads the next instruction of the pool.
+   Instruction* ReadInstruction() {
+       switch (cursor_.ReadEnum<InstructionKind>()) {
+       case InstructionKind::kSetHouseEvent: {
+           std::string name = cursor_.ReadString();
+           return Register(std::make_unique<SetHouseEvent>(std::move(name), cursor_.ReadBool()));
+       }
+       case InstructionKind::kCollectExpression:
+           return Register(std::make_unique<CollectExpression>(
+               Lookup(expressions_, cursor_.Read<Index>())));
+       case InstructionKind::kCollectFormula:
+           return Register(std::make_unique<CollectFormula>(ReadFormula()));
+       case InstructionKind::kIfThenElse: {
+           Expression* expression = Lookup(expressions_, cursor_.Read<Index>());
+           Instruction* then_instruction = Lookup(instructions_, cursor_.Read<Index>());
+           auto else_index = cursor_.Read<Index>();
+           Instruction* else_instruction =
+               else_index == kNoIndex ? nullptr : Lookup(instructions_, else_index);
+           return Register(std::make_unique<IfThenElse>(expression, then_instruction,
+                                                        else_instruction));
+       }
+       case InstructionKind::kBlock:
+           return Register(std::make_unique<Block>(GetInstructions(cursor_.ReadIndices())));
+       case InstructionKind::kRule:
+           return Lookup(rules_, cursor_.Read<Index>());
+       case InstructionKind::kLink:
+           return Register(
+               std::make_unique<Link>(*Lookup(event_trees_, cursor_.Read<Index>())));
+       default:
+           throw(IOError("Unexpected instruction kind in the model snapshot."));
+       }
+   }
+
+   /// Reads Boolean formulas.
+   std::unique_ptr<Formula> ReadFormula() {
+       auto connective = cursor_.ReadEnum<Connective>(kNumConnectives);
+       std::optional<int> min_number = cursor_.ReadOptional();
+       std::optional<int> max_number = cursor_.ReadOptional();
+       Formula::ArgSet args;
+       auto num_args = cursor_.Read<std::uint32_t>();
+       for (std::uint32_t i = 0; i < num_args; ++i) {
+           bool complement = cursor_.ReadBool();
+           auto kind = cursor_.ReadEnum<EventKind>();
+           auto index = cursor_.Read<Index>();
+           switch (kind) {
+           case EventKind::kGate:
+               args.Add(Lookup(gates_, index), complement);
+               break;
+           case EventKind::kBasicEvent:
+               args.Add(Lookup(basic_events_, index), complement);
+               break;
+           case EventKind::kHouseEvent:
+               args.Add(Lookup(house_events_, index), complement);
+               break;
+           case EventKind::kTrue:
+               args.Add(&HouseEvent::kTrue, complement);
+               break;
+           default:
+               args.Add(&HouseEvent::kFalse, complement);
+           }
+       }
+       return std::make_unique<Formula>(connective, std::move(args), min_number,
+                                        max_number);
+   }
+
+   /// Reads branches of event trees.
+   void ReadBranch(const std::vector<Fork*>& forks,
+                   const std::vector<NamedBranch*>& named_branches, Branch* branch) {
+       branch->instructions(GetInstructions(cursor_.ReadIndices()));
+       auto kind = cursor_.ReadEnum<TargetKind>();
+       auto index = cursor_.Read<Index>();
+       switch (kind) {
+       case TargetKind::kSequence:
+           branch->target(Lookup(sequences_, index));
+           break;
+       case TargetKind::kFork:
+           branch->target(Lookup(forks, index));
+           break;
+       default:
+           branch->target(Lookup(named_branches, index));
+       }
+   }
+
+   /// Reads the elements without cross-references.
+   void ReadElements() {
+       ElementData model_data = ReadElement();
+       model_ = std::make_unique<Model>(cursor_.ReadBool() ? "" : model_data.name);
+       AttachLabelAndAttributes(&model_data, model_.get());
+
+       for (Index i = 0, n = cursor_.Read<Index>(); i < n; ++i) {
+           auto event = ConstructRole<HouseEvent>();
+           event->state(cursor_.ReadBool());
+           event->usage(cursor_.ReadBool());
+           house_events_.push_back(event.get());
+           model_->Add(std::move(event));
+       }
+       for (Index i = 0, n = cursor_.Read<Index>(); i < n; ++i) {
+           auto event = ConstructRole<BasicEvent>();
+           event->usage(cursor_.ReadBool());
+           basic_events_.push_back(event.get());
+           model_->Add(std::move(event));
+       }
+       for (Index i = 0, n = cursor_.Read<Index>(); i < n; ++i) {
+           auto gate = ConstructRole<Gate>();
+           gate->usage(cursor_.ReadBool());
+           gates_.push_back(gate.get());
+           model_->Add(std::move(gate));
+       }
+       for (Index i = 0, n = cursor_.Read<Index>(); i < n; ++i) {
+           auto parameter = ConstructRole<Parameter>();
+           parameter->unit(cursor_.ReadEnum<Units>(kNumUnits));
+           parameter->usage(cursor_.ReadBool());
+           parameters_.push_back(parameter.get());
+           model_->Add(std::move(parameter));
+       }
+       for (Index i = 0, n = cursor_.Read<Index>(); i < n; ++i) {
+           auto sequence = ConstructElement<Sequence>();
+           sequence->usage(cursor_.ReadBool());
+           sequences_.push_back(sequence.get());
+           model_->Add(std::move(sequence));
+       }
+       for (Index i = 0, n = cursor_.Read<Index>(); i < n; ++i) {
+           auto rule = ConstructElement<Rule>();
+           rule->usage(cursor_.ReadBool());
+           rules_.push_back(rule.get());
+           model_->Add(std::move(rule));
+       }
+       for (Index i = 0, n = cursor_.Read<Index>(); i < n; ++i) {
+           auto event_tree = ConstructElement<EventTree>();
+           event_tree->usage(cursor_.ReadBool());
+           for (Index index : cursor_.ReadIndices())
+               event_tree->Add(Lookup(sequences_, index));
+           std::vector<FunctionalEvent*>& functional_events = functional_events_.emplace_back();
+           for (Index j = 0, m = cursor_.Read<Index>(); j < m; ++j) {
+               auto event = ConstructElement<FunctionalEvent>();
+               event->order(cursor_.Read<std::int32_t>());
+               event->usage(cursor_.ReadBool());
+               functional_events.push_back(event.get());
+               event_tree->Add(std::move(event));
+           }
+           std::vector<NamedBranch*>& named_branches = named_branches_.emplace_back();
+           for (Index j = 0, m = cursor_.Read<Index>(); j < m; ++j) {
+               auto branch = ConstructElement<NamedBranch>();
+               branch->usage(cursor_.ReadBool());
+               named_branches.push_back(branch.get());
+               event_tree->Add(std::move(branch));
+           }
+           event_trees_.push_back(event_tree.get());
+           model_->Add(std::move(event_tree));
+       }
+       for (Index i = 0, n = cursor_.Read<Index>(); i < n; ++i) {
+           auto event = ConstructElement<InitiatingEvent>();
+           event->usage(cursor_.ReadBool());
+           if (auto index = cursor_.Read<Index>(); index != kNoIndex)
+               event->event_tree(Lookup(event_trees_, index));
+           model_->Add(std::move(event));
+       }
+   }
+
+   /// Reads the definitions of the elements.
+   void ReadDefinitions() {
+       for (BasicEvent* event : basic_events_)
+           event->expression(GetExpression(cursor_.Read<Index>()));
+       for (Parameter* parameter : parameters_) {
+           if (Expression* expression = GetExpression(cursor_.Read<Index>()))
+               parameter->expression(expression);
+       }
+       for (Gate* gate : gates_) {
+           if (cursor_.ReadBool())
+               gate->formula(ReadFormula());
+       }
+       for (Rule* rule : rules_) {
+           std::vector<Instruction*> instructions = GetInstructions(cursor_.ReadIndices());
+           if (!instructions.empty())
+               rule->instructions(std::move(instructions));
+       }
+       for (Sequence* sequence : sequences_)
+           sequence->instructions(GetInstructions(cursor_.ReadIndices()));
+
+       for (std::size_t i = 0; i < event_trees_.size(); ++i) {
+           EventTree* event_tree = event_trees_[i];
+           const std::vector<NamedBranch*>& named_branches = named_branches_[i];
+           std::vector<Fork*> forks;  // In post-order.
+           for (Index j = 0, n = cursor_.Read<Index>(); j < n; ++j) {
+               const FunctionalEvent& functional_event =
+                   *Lookup(functional_events_[i], cursor_.Read<Index>());
+               std::vector<Path> paths;
+               for (std::uint32_t k = 0, m = cursor_.Read<std::uint32_t>(); k < m; ++k) {
+                   Path path(cursor_.ReadString());
+                   ReadBranch(forks, named_branches, &path);
+                   paths.push_back(std::move(path));
+               }
+               auto fork = std::make_unique<Fork>(functional_event, std::move(paths));
+               forks.push_back(fork.get());
+               event_tree->Add(std::move(fork));
+           }
+           for (NamedBranch* branch : named_branches)
+               ReadBranch(forks, named_branches, branch);
+           Branch initial_state;
+           ReadBranch(forks, named_branches, &initial_state);
+           event_tree->initial_state(std::move(initial_state));
+       }
+
+       for (Index i = 0, n = cursor_.Read<Index>(); i < n; ++i) {
+           ElementData data = ReadRole();
+           std::unique_ptr<CcfGroup> group = [&data, this]() -> std::unique_ptr<CcfGroup> {
+               switch (cursor_.ReadEnum<CcfModel>()) {
+               case CcfModel::kBetaFactor:
+                   return std::make_unique<BetaFactorModel>(data.name, data.base_path, data.role);
+               case CcfModel::kMgl:
+                   return std::make_unique<MglModel>(data.name, data.base_path, data.role);
+               case CcfModel::kAlphaFactor:
+                   return std::make_unique<AlphaFactorModel>(data.name, data.base_path, data.role);
+               default:
+                   return std::make_unique<PhiFactorModel>(data.name, data.base_path, data.role);
+               }
+           }();
+           AttachLabelAndAttributes(&data, group.get());
+           for (Index index : cursor_.ReadIndices())
+               group->AddMember(Lookup(basic_events_, index));
+           group->AddDistribution(Lookup(expressions_, cursor_.Read<Index>()));
+           for (std::uint32_t j = 0, m = cursor_.Read<std::uint32_t>(); j < m; ++j) {
+               int level = cursor_.Read<std::int32_t>();
+               group->AddFactor(Lookup(expressions_, cursor_.Read<Index>()), level);
+           }
+           ccf_groups_.push_back(group.get());
+           model_->Add(std::move(group));
+       }
+
+       for (Index i = 0, n = cursor_.Read<Index>(); i < n; ++i) {
+           auto substitution = ConstructElement<Substitution>();
+           substitution->hypothesis(ReadFormula());
+           for (Index index : cursor_.ReadIndices())
+               substitution->Add(Lookup(basic_events_, index));
+           if (cursor_.ReadBool()) {
+               substitution->target(Lookup(basic_events_, cursor_.Read<Index>()));
+           } else {
+               substitution->target(cursor_.ReadBool());
+           }
+           model_->Add(std::move(substitution));
+       }
+
+       for (Index i = 0, n = cursor_.Read<Index>(); i < n; ++i) {
+           auto alignment = ConstructElement<Alignment>();
+           for (std::uint32_t j = 0, m = cursor_.Read<std::uint32_t>(); j < m; ++j) {
+               ElementData data = ReadElement();
+               auto phase = std::make_unique<Phase>(std::move(data.name), cursor_.Read<double>());
+               AttachLabelAndAttributes(&data, phase.get());
+               std::vector<SetHouseEvent*> instructions;
+               for (Instruction* instruction : GetInstructions(cursor_.ReadIndices())) {
+                   auto* set_house_event = dynamic_cast<SetHouseEvent*>(instruction);
+                   if (!set_house_event)
+                       throw(IOError("Invalid phase instruction in the model snapshot."));
+                   instructions.push_back(set_house_event);
+               }
+               phase->instructions(std::move(instructions));
+               alignment->Add(std::move(phase));
+           }
+           model_->Add(std::move(alignment));
+       }
+
+       for (Index i = 0, n = cursor_.Read<Index>(); i < n; ++i) {
+           auto fault_tree = ConstructElement<FaultTree>();
+           ReadComponent(fault_tree.get());
+           model_->Add(std::move(fault_tree));
+       }
+   }
+
+   /// Reads the members of fault tree components recursively.
+   void ReadComponent(Component* component) {
+       for (Index index : cursor_.ReadIndices())
+           component->Add(Lookup(gates_, index));
+       for (Index index : cursor_.ReadIndices())
+           component->Add(Lookup(basic_events_, index));
+       for (Index index : cursor_.ReadIndices())
+           component->Add(Lookup(house_events_, index));
+       for (Index index : cursor_.ReadIndices())
+           component->Add(Lookup(parameters_, index));
+       for (Index index : cursor_.ReadIndices())
+           component->Add(Lookup(ccf_groups_, index));
+       for (std::uint32_t i = 0, n = cursor_.Read<std::uint32_t>(); i < n; ++i) {
+           auto sub_component = ConstructRole<Component>();
+           ReadComponent(sub_component.get());
+           component->Add(std::move(sub_component));
+       }
+   }
+
+   Cursor& cursor_;  ///< The snapshot data.
+   std::unique_ptr<Model> model_;  ///< The model under construction.
+
+   /// The deserialized records in the snapshot order.
+   /// Event tree members are grouped by their event trees.
+   /// @{
+   std::vector<Expression*> expressions_;
+   std::vector<Instruction*> instructions_;
+   std::vector<HouseEvent*> house_events_;
+   std::vector<BasicEvent*> basic_events_;
+   std::vector<Gate*> gates_;
+   std::vector<Parameter*> parameters_;
+   std::vector<Sequence*> sequences_;
+   std::vector<Rule*> rules_;
+   std::vector<EventTree*> event_trees_;
+   std::vector<std::vector<FunctionalEvent*>> functional_events_;
+   std::vector<std::vector<NamedBranch*>> named_branches_;
+   std::vector<CcfGroup*> ccf_groups_;
+   /// @}
+};
+
+}  // namespace
+
+std::string ModelCache::Key(const std::vector<std::string>& xml_files,
+                            const Settings& settings) {
+   // 64-bit FNV-1a over the file contents and the relevant settings.
+   InputHash hash;
+   hash.MixValue(kVersion);
+   // The mission time participates in the validation of expressions.
+   hash.MixValue(settings.mission_time());
+   // The probability analysis requires expressions for all basic events.
+   hash.MixValue(settings.probability_analysis());
+   for (const std::string& xml_file : xml_files) {
+       if (!hash.MixFile(xml_file))
+           throw(IOError("Cannot read the input file: " + xml_file));
+   }
+
+   std::uint64_t value = hash.value();
+   std::string key(2 * sizeof(value), '0');
+   for (auto it = key.rbegin(); it != key.rend(); ++it, value >>= 4)
+       *it = "0123456789abcdef"[value & 0xF];
+   return key;
+}
+
+std::unique_ptr<Model> ModelCache::Load(const std::string& key) const {
+   namespace fs = boost::filesystem;
+   namespace ipc = boost::interprocess;
+
+   std::string path = GetPath(key);
+   boost::system::error_code error;
+   if (!fs::is_regular_file(path, error) || fs::is_empty(path, error) || error)
+       return nullptr;
+
+   try {
+       ipc::file_mapping mapping(path.c_str(), ipc::read_only);
+       ipc::mapped_region region(mapping, ipc::read_only);
+       const auto* data = static_cast<const char*>(region.get_address());
+       Cursor cursor(data, data + region.get_size());
+       if (cursor.ReadBytes(kMagic.size()) != kMagic ||
+           cursor.Read<std::uint32_t>() != kVersion || cursor.ReadString() != key) {
+           return nullptr;
+       }
+       for (std::uint32_t i = 0, n = cursor.Read<std::uint32_t>(); i < n; ++i) {
+           std::string include = cursor.ReadString();
+           std::optional<std::uint64_t> hash;
+           if (cursor.ReadBool())
+               hash = cursor.Read<std::uint64_t>();
+           else
+               cursor.Read<std::uint64_t>();
+           if (HashFile(include) != hash)
+               return nullptr;  // The included file has changed since the snapshot.
+       }
+       return SnapshotReader(&cursor).Read();
+
+   } catch (const ipc::interprocess_exception&) {
+       return nullptr;
+   } catch (const Error&) {  // Stale or corrupt snapshots are rebuilt.
+       return nullptr;
+   }
+}
+
+void ModelCache::Store(const std::string& key, const Model& model,
+                       const std::vector<std::string>& xml_files) const {
+   namespace fs = boost::filesystem;
+   assert(IsCacheable(model));
+
+   std::vector<std::string> includes;
+   for (const std::string& xml_file : xml_files)
+       CollectIncludes(xml_file, &includes);
+   std::string snapshot = SnapshotWriter(model).Write(key, includes);
+   fs::path path = GetPath(key);
+   // Snapshots are published atomically for concurrent runs.
+   fs::path temp_path = path.parent_path() / fs::unique_path("%%%%-%%%%-%%%%.tmp");
+   try {
+       fs::create_directories(path.parent_path());
+       {
+           std::ofstream stream(temp_path.string(), std::ios::binary | std::ios::trunc);
+           stream.write(snapshot.data(), snapshot.size());
+           if (!stream.flush())
+               throw(IOError("Cannot write the model snapshot: " + temp_path.string()));
+       }
+       fs::rename(temp_path, path);
+
+   } catch (const fs::filesystem_error& err) {
+       boost::system::error_code error;
+       fs::remove(temp_path, error);
+       throw(IOError("Cannot store the model snapshot: " + std::string(err.what())));
+   } catch (const IOError&) {
+       boost::system::error_code error;
+       fs::remove(temp_path, error);
+       throw;
+   }
+}
+
+std::string ModelCache::GetPath(const std::string& key) const {
+   return (boost::filesystem::path(directory_) / (key + ".mef.bin")).string();
+}
+
+}  // namespace mef::openpsa
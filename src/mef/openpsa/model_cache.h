@@ -0,0 +1,96 @@
+/// @file
+/// Binary snapshots of initialized models for warm starts.
+
+#pragma once
+
+#include <cstdint>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mef/openpsa/event/formula.h"
+#include "mef/openpsa/event/gate.h"
+#include "mef/openpsa/model.h"
+#include "mef/openpsa/settings.h"
+
+namespace mef::openpsa {
+
+/// Persistent cache of initialized models in a versioned binary format.
+///
+/// A snapshot captures the model after the validation of the input
+/// (events, formulas, expressions, CCF groups, fault and event trees,
+/// rules, substitutions, and alignments)
+/// but before the setup for analysis;
+/// that is, CCF events and top events are derived again upon loading.
+/// Snapshots are keyed by the content hash of the input files
+/// and the settings that affect the initialization.
+/// The files included with XInclude are unknown before the parsing,
+/// so they are recorded with their content hashes in the snapshot
+/// and checked upon loading instead.
+///
+/// Snapshots are read through memory mapping
+/// and are written in the host byte order;
+/// they are not meant to be portable across platforms.
+///
+/// @note Models with external libraries are not cached
+///       since the libraries must be loaded at run-time.
+class ModelCache {
+ public:
+   /// The format version of snapshots.
+   /// Snapshots with other versions are ignored.
+   static constexpr std::uint32_t kVersion = 2;
+
+   /// @param[in] directory  The directory to keep the snapshots in.
+   explicit ModelCache(std::string directory) : directory_(std::move(directory)) {}
+
+   /// Computes the snapshot key for the input.
+   ///
+   /// @param[in] xml_files  The input files in the order of processing.
+   /// @param[in] settings  The analysis settings.
+   ///
+   /// @returns The hexadecimal content hash of the input.
+   ///
+   /// @throws IOError  The input files cannot be read.
+   static std::string Key(const std::vector<std::string>& xml_files,
+                          const Settings& settings);
+
+   /// @param[in] model  The fully initialized and validated model.
+   ///
+   /// @returns true if the model can be stored in the cache.
+   static bool IsCacheable(const Model& model) {
+       return model.libraries().empty() && model.extern_functions().empty();
+   }
+
+   /// Loads the model snapshot.
+   ///
+   /// @param[in] key  The key of the input.
+   ///
+   /// @returns The model equivalent to the one stored with the key.
+   ///          nullptr if there is no valid snapshot for the key
+   ///          or any file included by the input has changed.
+   std::unique_ptr<Model> Load(const std::string& key) const;
+
+   /// Stores the model snapshot replacing any previous one with the same key.
+   ///
+   /// @param[in] key  The key of the input.
+   /// @param[in] model  The model initialized from the input.
+   /// @param[in] xml_files  The input files with the XInclude elements
+   ///                       to record the included files.
+   ///
+   /// @pre The model is cacheable.
+   /// @pre The model is validated but not yet set up for analysis.
+   ///
+   /// @throws IOError  The snapshot cannot be written.
+   void Store(const std::string& key, const Model& model,
+              const std::vector<std::string>& xml_files = {}) const;
+
+ private:
+   /// @returns The snapshot file path for the key.
+   std::string GetPath(const std::string& key) const;
+
+   std::string directory_;  ///< The directory with the snapshots.
+};
+
+}  // namespace mef::openpsa
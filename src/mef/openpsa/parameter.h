@@ -87,6 +87,10 @@ class Parameter : public Expression, public Id, public NodeMark, public Usage {
        Expression::AddArg(expression);
    }
 
+   /// @returns The expression of this parameter.
+   ///          nullptr if the expression has not been set.
+   Expression* expression() const { return expression_; }
+
    /// @returns The unit of this parameter.
    Units unit() const { return unit_; }
 
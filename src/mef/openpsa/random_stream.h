@@ -0,0 +1,102 @@
+/// @file
+/// Counter-based random number streams for reproducible parallel sampling.
+
+#pragma once
+
+#include <cstdint>
+
+#include <array>
+#include <limits>
+
+namespace mef::openpsa {
+
+/// Random bit stream addressed by (seed, trial, stream id).
+///
+/// The stream is a view on the Philox4x32-10 counter-based generator:
+/// the seed is the key,
+/// and the trial index and the stream id are the high parts of the counter.
+/// Any stream can be constructed and consumed on any thread
+/// in O(1) without synchronization or sequential state,
+/// so the sampled values do not depend on the evaluation order
+/// or the number of threads.
+///
+/// The stream satisfies the UniformRandomBitGenerator requirements
+/// to work with the standard distributions.
+class RandomStream {
+ public:
+   using result_type = std::uint32_t;  ///< The random bits type.
+   using Block = std::array<std::uint32_t, 4>;  ///< The generator counter and output.
+   using Key = std::array<std::uint32_t, 2>;  ///< The generator key.
+
+   /// @param[in] seed  The global seed of the simulation.
+   /// @param[in] trial  The index of the trial.
+   /// @param[in] stream  The id of the random variable within the trial.
+   RandomStream(std::uint64_t seed, std::uint64_t trial, std::uint32_t stream) noexcept
+       : key_(MakeKey(seed)),
+         counter_{0, stream, static_cast<std::uint32_t>(trial),
+                  static_cast<std::uint32_t>(trial >> 32)} {}
+
+   /// The range of the random bits.
+   /// @{
+   static constexpr result_type min() { return 0; }
+   static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+   /// @}
+
+   /// @returns The next 32 random bits of the stream.
+   result_type operator()() noexcept {
+       if (position_ == block_.size()) {
+           block_ = Philox(counter_, key_);
+           ++counter_[0];
+           position_ = 0;
+       }
+       return block_[position_++];
+   }
+
+   /// @returns The next uniform variate in the open interval (0, 1)
+   ///          with 53-bit resolution.
+   double Canonical() noexcept {
+       std::uint32_t high = (*this)();
+       return ToCanonical(high, (*this)());
+   }
+
+   /// @returns The generator key for the seed.
+   static Key MakeKey(std::uint64_t seed) noexcept {
+       return {static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)};
+   }
+
+   /// Converts 64 random bits into a uniform variate in (0, 1).
+   static double ToCanonical(std::uint32_t high, std::uint32_t low) noexcept {
+       std::uint64_t mantissa = (static_cast<std::uint64_t>(high >> 5) << 26) | (low >> 6);
+       return (mantissa + 0.5) * 0x1.0p-53;
+   }
+
+   /// Applies the Philox4x32-10 bijection.
+   ///
+   /// @param[in] counter  The counter block.
+   /// @param[in] key  The key of the generator.
+   ///
+   /// @returns The random block for the counter.
+   static Block Philox(Block counter, Key key) noexcept {
+       for (int round = 0; round < 10; ++round) {
+           if (round) {
+               key[0] += 0x9E3779B9;
+               key[1] += 0xBB67AE85;
+           }
+           std::uint64_t product_zero = std::uint64_t{0xD2511F53} * counter[0];
+           std::uint64_t product_one = std::uint64_t{0xCD9E8D57} * counter[2];
+           counter = {static_cast<std::uint32_t>(product_one >> 32) ^ counter[1] ^ key[0],
+                      static_cast<std::uint32_t>(product_one),
+                      static_cast<std::uint32_t>(product_zero >> 32) ^ counter[3] ^ key[1],
+                      static_cast<std::uint32_t>(product_zero)};
+       }
+       return counter;
+   }
+
+ private:
+   Key key_;  ///< The generator key from the seed.
+   Block counter_;  ///< The position of the stream.
+   Block block_{};  ///< The current block of random bits.
+   std::size_t position_ = block_.size();  ///< The next word in the block.
+};
+
+}  // namespace mef::openpsa
@@ -0,0 +1,147 @@
+/// @file
+/// Implementation of the settings builder with the constraints on the values.
+
+#include "mef/openpsa/settings.h"
+
+#include <algorithm>
+#include <iterator>
+#include <optional>
+
+namespace mef::openpsa {
+
+namespace {
+
+/// Finds the enum value by its string representation.
+///
+/// @tparam T  The enum type with values indexing the strings.
+/// @tparam N  The number of the enum values.
+///
+/// @param[in] strings  The string representations of the enum values.
+/// @param[in] value  The string to find.
+///
+/// @returns The enum value if the string is recognized.
+template <typename T, std::size_t N>
+std::optional<T> FindValue(const char* const (&strings)[N], std::string_view value) {
+   auto it = std::find(std::begin(strings), std::end(strings), value);
+   if (it == std::end(strings))
+       return {};
+   return static_cast<T>(std::distance(std::begin(strings), it));
+}
+
+}  // namespace
+
+Settings& Settings::algorithm(Algorithm value) noexcept {
+   algorithm_ = value;
+   if (algorithm_ == Algorithm::kBdd) {
+       approximation_ = Approximation::kNone;
+   } else {
+       prime_implicants_ = false;
+       if (approximation_ == Approximation::kNone)
+           approximation_ = Approximation::kRareEvent;
+   }
+   return *this;
+}
+
+Settings& Settings::algorithm(std::string_view value) {
+   auto kind = FindValue<Algorithm>(kAlgorithmToString, value);
+   if (!kind)
+       throw(SettingsError("The qualitative analysis algorithm '" + std::string(value) +
+                           "' is not recognized."));
+   return algorithm(*kind);
+}
+
+Settings& Settings::approximation(Approximation value) {
+   if (value != Approximation::kNone && prime_implicants_)
+       throw(SettingsError("Prime implicants require no quantitative approximation."));
+   approximation_ = value;
+   return *this;
+}
+
+Settings& Settings::approximation(std::string_view value) {
+   auto kind = FindValue<Approximation>(kApproximationToString, value);
+   if (!kind)
+       throw(SettingsError("The probability approximation '" + std::string(value) +
+                           "' is not recognized."));
+   return approximation(*kind);
+}
+
+Settings& Settings::prime_implicants(bool flag) {
+   if (flag && algorithm_ != Algorithm::kBdd)
+       throw(SettingsError("Prime implicants can only be calculated with BDD."));
+   prime_implicants_ = flag;
+   if (prime_implicants_)
+       approximation_ = Approximation::kNone;
+   return *this;
+}
+
+Settings& Settings::limit_order(int order) {
+   if (order < 0)
+       throw(SettingsError("The limit on the order of products cannot be less than 0: " +
+                           std::to_string(order)));
+   limit_order_ = order;
+   return *this;
+}
+
+Settings& Settings::cut_off(double prob) {
+   if (prob < 0 || prob > 1)
+       throw(SettingsError("The cut-off probability cannot be negative or more than 1: " +
+                           std::to_string(prob)));
+   cut_off_ = prob;
+   return *this;
+}
+
+Settings& Settings::num_trials(int n) {
+   if (n < 1)
+       throw(SettingsError("The number of trials cannot be less than 1: " + std::to_string(n)));
+   num_trials_ = n;
+   return *this;
+}
+
+Settings& Settings::num_quantiles(int n) {
+   if (n < 1)
+       throw(SettingsError("The number of quantiles cannot be less than 1: " +
+                           std::to_string(n)));
+   num_quantiles_ = n;
+   return *this;
+}
+
+Settings& Settings::num_bins(int n) {
+   if (n < 1)
+       throw(SettingsError("The number of bins cannot be less than 1: " + std::to_string(n)));
+   num_bins_ = n;
+   return *this;
+}
+
+Settings& Settings::seed(int s) {
+   if (s < 0)
+       throw(SettingsError("The seed for PRNG cannot be negative: " + std::to_string(s)));
+   seed_ = s;
+   return *this;
+}
+
+Settings& Settings::mission_time(double time) {
+   if (time < 0)
+       throw(SettingsError("The mission time cannot be negative: " + std::to_string(time)));
+   mission_time_ = time;
+   return *this;
+}
+
+Settings& Settings::time_step(double time) {
+   if (time < 0)
+       throw(SettingsError("The time step cannot be negative: " + std::to_string(time)));
+   if (!time && safety_integrity_levels_)
+       throw(SettingsError("The time step cannot be disabled for the SIL"));
+   time_step_ = time;
+   return *this;
+}
+
+Settings& Settings::safety_integrity_levels(bool flag) {
+   if (flag && !time_step_)
+       throw(SettingsError("The time step is not set for the SIL"));
+   safety_integrity_levels_ = flag;
+   if (safety_integrity_levels_)
+       probability_analysis_ = true;
+   return *this;
+}
+
+}  // namespace mef::openpsa
@@ -5,7 +5,12 @@
 
 #include <cstdint>
 
+#include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
+
+#include "mef/openpsa/error.h"
 
 namespace mef::openpsa {
 
@@ -21,6 +26,13 @@ enum class Approximation : std::uint8_t { kNone = 0, kRareEvent, kMcub, kMonteCa
 /// String representations for approximations.
 const char* const kApproximationToString[] = { "none", "rare-event", "mcub", "monte-carlo" };
 
+/// Static heuristics for the order of BDD variables.
+enum class VariableOrdering : std::uint8_t { kIdentity = 0, kDepthFirst, kFanIn, kForce };
+
+/// String representations for variable ordering heuristics.
+const char* const kVariableOrderingToString[] = { "identity", "depth-first", "fan-in",
+                                                  "force" };
+
 /// Builder for analysis settings.
 /// Analysis facilities are guaranteed not to throw or fail
 /// with an instance of this class.
@@ -186,6 +198,93 @@ class Settings {
    /// @throws SettingsError  The number is negative.
    Settings& seed(int s);
 
+   /// @returns The number of worker threads for parallel stages.
+   ///          0 if all the available hardware threads are to be used.
+   [[nodiscard]] int num_threads() const { return num_threads_; }
+
+   /// Sets the number of worker threads for parallel stages
+   /// like input parsing and analysis.
+   /// 1 keeps all the stages serial.
+   ///
+   /// @param[in] n  A non-negative number of threads
+   ///               or 0 for the hardware concurrency.
+   ///
+   /// @returns Reference to this object.
+   ///
+   /// @throws SettingsError  The number is negative.
+   Settings& num_threads(int n) {
+       if (n < 0)
+           throw(SettingsError("The number of threads cannot be negative: " + std::to_string(n)));
+       num_threads_ = n;
+       return *this;
+   }
+
+   /// @returns The directory for binary model snapshots.
+   ///          Empty if the model cache is disabled.
+   [[nodiscard]] const std::string& model_cache() const { return model_cache_; }
+
+   /// Sets the directory to keep binary snapshots of initialized models.
+   /// Unchanged input files are loaded from the snapshots
+   /// instead of being parsed again.
+   ///
+   /// @param[in] directory  The cache directory or empty to disable caching.
+   ///
+   /// @returns Reference to this object.
+   Settings& model_cache(std::string directory) {
+       model_cache_ = std::move(directory);
+       return *this;
+   }
+
+   /// @returns The static heuristic for the order of BDD variables.
+   [[nodiscard]] VariableOrdering variable_ordering() const { return variable_ordering_; }
+
+   /// Sets the static heuristic for the order of BDD variables.
+   ///
+   /// @param[in] value  The heuristic kind.
+   ///
+   /// @returns Reference to this object.
+   Settings& variable_ordering(VariableOrdering value) {
+       variable_ordering_ = value;
+       return *this;
+   }
+
+   /// @returns The number of BDD vertices triggering the dynamic reordering.
+   ///          0 if the dynamic reordering is disabled.
+   [[nodiscard]] int reorder_threshold() const { return reorder_threshold_; }
+
+   /// Sets the number of BDD vertices
+   /// to trigger the sifting of the variables during the construction.
+   /// The threshold doubles after every reordering.
+   ///
+   /// @param[in] n  A non-negative number of vertices or 0 to disable.
+   ///
+   /// @returns Reference to this object.
+   ///
+   /// @throws SettingsError  The number is negative.
+   Settings& reorder_threshold(int n) {
+       if (n < 0)
+           throw(SettingsError("The reorder threshold cannot be negative: " + std::to_string(n)));
+       reorder_threshold_ = n;
+       return *this;
+   }
+
+   /// @returns The names of the variables to put first in the BDD order.
+   [[nodiscard]] const std::vector<std::string>& variable_order() const {
+       return variable_order_;
+   }
+
+   /// Sets the order of the variables reported by an earlier analysis
+   /// for reuse instead of the heuristic order.
+   /// The variables missing from the names follow in the heuristic order.
+   ///
+   /// @param[in] names  The names of the variables from the first level.
+   ///
+   /// @returns Reference to this object.
+   Settings& variable_order(std::vector<std::string> names) {
+       variable_order_ = std::move(names);
+       return *this;
+   }
+
    /// @returns The length time of the system under risk.
    double mission_time() const { return mission_time_; }
 
@@ -322,6 +421,7 @@ class Settings {
    bool skip_products_ = false;                        ///< Do not compute the products.
    int limit_order_ = 20;                              ///< Limit on the order of products.
    int seed_ = 0;                                      ///< The seed for the pseudo-random number generator.
+   int num_threads_ = 1;                               ///< The number of worker threads (0 for all).
    int num_trials_  = 1e3;                             ///< The number of trials for Monte Carlo simulations.
    int batch_size_  = 1;                               ///< Batch size for Monte Carlo simulations.
    int sample_size_ = 1;                               ///< Sample size for Monte Carlo simulations.
@@ -330,6 +430,10 @@ class Settings {
    double mission_time_ = 8760;                        ///< System mission time.
    double time_step_ = 0;                              ///< The time step for probability analyses.
    double cut_off_ = 1e-8;                             ///< The cut-off probability for products.
+   std::string model_cache_;                           ///< The directory for model snapshots.
+   VariableOrdering variable_ordering_ = VariableOrdering::kDepthFirst;  ///< The order heuristic.
+   int reorder_threshold_ = 0;                         ///< The BDD size for the dynamic reordering.
+   std::vector<std::string> variable_order_;           ///< The given BDD order of variables.
 };
 
 }  // namespace scram::core
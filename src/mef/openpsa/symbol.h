@@ -0,0 +1,288 @@
+/// @file
+/// Interned strings for names, ids, and paths of model elements.
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace mef::openpsa {
+
+/// Table of unique strings with 32-bit ids
+/// shared by the models alive at the same time.
+///
+/// The table is owned by its users, i.e., the models,
+/// and is released with the last of them;
+/// the next model starts a new table,
+/// so a long-running process holds only the strings of its live models.
+/// Symbols interned outside of any model, e.g., of elements named
+/// before their model, are kept until the next model adopts the table.
+///
+/// The names and paths of the house-event literals are reserved
+/// with the same ids in every table,
+/// so the static literals outlive the tables.
+/// The other ids are unique across the tables,
+/// so the symbols held after the release of their table
+/// never alias the symbols of the next tables.
+///
+/// The strings are stored in blocks of doubling sizes
+/// that are never reallocated,
+/// so the strings are read by ids without locking
+/// while other threads intern new strings.
+/// The ids are found in shards by the string hash,
+/// which is computed once per lookup,
+/// and the lookups only take the shard lock for reading.
+class SymbolTable {
+ public:
+   /// The shared ownership of the table.
+   using Lease = std::shared_ptr<SymbolTable>;
+
+   /// The strings with the fixed ids in every table:
+   /// the empty string and the names and paths of the house-event literals.
+   static constexpr std::array<std::string_view, 5> kReserved = {
+       "", "__true__", "__false__", ".__true__", ".__false__"};
+
+   /// Shares the ownership of the current table, which is created if there is none,
+   /// and adopts the symbols interned outside of any owner.
+   ///
+   /// @returns The current table.
+   static Lease Acquire() {
+       std::lock_guard lock(current_mutex_);
+       Lease table = Current();
+       detached_.reset();  // The owner keeps the detached symbols.
+       return table;
+   }
+
+   /// @returns The current table for the symbols.
+   static SymbolTable& instance() {
+       if (SymbolTable* table = current_table_.load(std::memory_order_acquire))
+           return *table;
+       std::lock_guard lock(current_mutex_);
+       detached_ = Current();  // No owner holds the symbols yet.
+       return *detached_;
+   }
+
+   SymbolTable(const SymbolTable&) = delete;
+   SymbolTable& operator=(const SymbolTable&) = delete;
+
+   ~SymbolTable() {
+       {
+           std::lock_guard lock(current_mutex_);
+           SymbolTable* table = this;
+           current_table_.compare_exchange_strong(table, nullptr);
+       }
+       for (std::atomic<std::string*>& block : blocks_)
+           delete[] block.load(std::memory_order_relaxed);
+   }
+
+   /// @returns The id of the string, which is added if new.
+   std::uint32_t Intern(std::string_view text) {
+       Key key{text, std::hash<std::string_view>()(text)};
+       Shard& shard = shards_[GetShard(key.hash)];
+       {
+           std::shared_lock lock(shard.mutex);
+           if (auto it = shard.ids.find(key); it != shard.ids.end())
+               return it->second;
+       }
+       std::lock_guard lock(shard.mutex);
+       if (auto it = shard.ids.find(key); it != shard.ids.end())
+           return it->second;
+       std::uint32_t id = next_id_.fetch_add(1, std::memory_order_relaxed);
+       assert(id != std::numeric_limits<std::uint32_t>::max() && "Symbol ids are exhausted.");
+       Insert(&shard, key, id);
+       return id;
+   }
+
+   /// @returns The id of the string if it is in the table.
+   std::optional<std::uint32_t> Find(std::string_view text) const {
+       Key key{text, std::hash<std::string_view>()(text)};
+       const Shard& shard = shards_[GetShard(key.hash)];
+       std::shared_lock lock(shard.mutex);
+       if (auto it = shard.ids.find(key); it != shard.ids.end())
+           return it->second;
+       return {};
+   }
+
+   /// @returns The string with the id.
+   ///
+   /// @pre The id is reserved or from this table.
+   const std::string& str(std::uint32_t id) const {
+       assert((id < kReserved.size() || id >= first_id_) &&
+              "The symbol outlives its table.");
+       auto [block, offset] = Locate(Slot(id));
+       std::string* strings = blocks_[block].load(std::memory_order_acquire);
+       assert(strings && "Unknown symbol.");
+       return strings[offset];
+   }
+
+ private:
+   static constexpr int kFirstBlockShift = 8;  ///< Log2 of the first block size.
+   static constexpr std::uint64_t kFirstBlockSize = 1 << kFirstBlockShift;
+   /// The number of blocks to cover all 32-bit ids.
+   static constexpr int kNumBlocks = 32 - kFirstBlockShift + 1;
+   static constexpr int kShardBits = 4;  ///< Log2 of the number of shards.
+
+   /// The string with its hash for the lookups.
+   struct Key {
+       std::string_view text;  ///< The string.
+       std::size_t hash;  ///< The hash of the string.
+
+       /// Equality by the strings.
+       bool operator==(const Key& other) const { return text == other.text; }
+   };
+
+   /// The precomputed hash of the keys.
+   struct KeyHash {
+       std::size_t operator()(const Key& key) const noexcept { return key.hash; }
+   };
+
+   /// The ids of the strings with the same hash bits.
+   struct Shard {
+       mutable std::shared_mutex mutex;  ///< The guard of the ids.
+       std::unordered_map<Key, std::uint32_t, KeyHash> ids;  ///< The ids of the strings.
+   };
+
+   /// Reserves the fixed ids and starts the ids after the ids of the previous tables.
+   SymbolTable() : first_id_(next_id_.load(std::memory_order_relaxed)) {
+       for (std::uint32_t id = 0; id < kReserved.size(); ++id) {
+           Key key{kReserved[id], std::hash<std::string_view>()(kReserved[id])};
+           Insert(&shards_[GetShard(key.hash)], key, id);
+       }
+   }
+
+   /// Stores the new string with its id.
+   ///
+   /// @pre The shard of the string is locked for writing.
+   void Insert(Shard* shard, const Key& key, std::uint32_t id) {
+       auto [block, offset] = Locate(Slot(id));
+       std::string* strings = blocks_[block].load(std::memory_order_acquire);
+       if (!strings) {
+           auto* new_strings = new std::string[kFirstBlockSize << block];
+           if (blocks_[block].compare_exchange_strong(strings, new_strings,
+                                                      std::memory_order_acq_rel)) {
+               strings = new_strings;
+           } else {
+               delete[] new_strings;  // Another thread has allocated the block.
+           }
+       }
+       strings[offset] = key.text;
+       shard->ids.emplace(Key{strings[offset], key.hash}, id);
+   }
+
+   /// @returns The position of the string with the id in the storage of this table.
+   std::uint32_t Slot(std::uint32_t id) const {
+       return id < kReserved.size() ? id : id - first_id_ + kReserved.size();
+   }
+
+   /// @returns The current table, which is created if there is none.
+   ///
+   /// @pre The current table mutex is locked.
+   static Lease Current() {
+       Lease table = current_.lock();
+       if (!table) {
+           table.reset(new SymbolTable);
+           current_ = table;
+           current_table_.store(table.get(), std::memory_order_release);
+       }
+       return table;
+   }
+
+   /// @returns The shard of the strings with the hash.
+   static std::size_t GetShard(std::size_t hash) {
+       return hash >> (std::numeric_limits<std::size_t>::digits - kShardBits);
+   }
+
+   /// @returns The block and offset of the string with the id.
+   static std::pair<int, std::uint64_t> Locate(std::uint32_t id) {
+       std::uint64_t index = id + kFirstBlockSize;
+       int block = std::bit_width(index) - 1 - kFirstBlockShift;
+       return {block, index - (kFirstBlockSize << block)};
+   }
+
+   std::array<Shard, 1 << kShardBits> shards_;  ///< The ids by the string hashes.
+   const std::uint32_t first_id_;  ///< The first id of the strings that are not reserved.
+   std::array<std::atomic<std::string*>, kNumBlocks> blocks_{};  ///< The string storage.
+
+   inline static std::mutex current_mutex_;  ///< The guard of the current table.
+   inline static std::weak_ptr<SymbolTable> current_;  ///< The table of the live owners.
+   /// The current table for the symbol access without locking.
+   inline static std::atomic<SymbolTable*> current_table_ = nullptr;
+   inline static Lease detached_;  ///< The table of the symbols without owners.
+   /// The id of the next string in any table.
+   inline static std::atomic<std::uint32_t> next_id_ = kReserved.size();
+};
+
+/// The base of the symbol table owners, e.g., models,
+/// that holds the table at least as long as the derived object.
+class SymbolOwner {
+ protected:
+   SymbolOwner() : symbol_table_(SymbolTable::Acquire()) {}
+
+ private:
+   SymbolTable::Lease symbol_table_;  ///< The owned table.
+};
+
+/// Interned string with O(1) equality and hashing.
+///
+/// Symbols of equal strings have equal ids;
+/// the default symbol is the empty string.
+/// The symbols held after the release of their table
+/// are unequal to the symbols of the next tables,
+/// but their strings are gone with the table.
+class Symbol {
+ public:
+   Symbol() = default;
+
+   /// Interns the string.
+   explicit Symbol(std::string_view text) : id_(SymbolTable::instance().Intern(text)) {}
+
+   /// @returns The symbol of the string
+   ///          only if the string has been interned,
+   ///          so failed lookups do not grow the table.
+   static std::optional<Symbol> Find(std::string_view text) {
+       std::optional<std::uint32_t> id = SymbolTable::instance().Find(text);
+       if (!id)
+           return {};
+       Symbol symbol;
+       symbol.id_ = *id;
+       return symbol;
+   }
+
+   /// @returns The unique id of the string.
+   std::uint32_t id() const { return id_; }
+
+   /// @returns The interned string with the lifetime of the symbol table.
+   const std::string& str() const { return SymbolTable::instance().str(id_); }
+
+   /// @returns true if the symbol is the empty string.
+   bool empty() const { return id_ == 0; }
+
+   /// Equality by ids.
+   bool operator==(const Symbol&) const = default;
+
+ private:
+   std::uint32_t id_ = 0;  ///< The id in the symbol table.
+};
+
+}  // namespace mef::openpsa
+
+/// Hash of symbols by their ids.
+template <>
+struct std::hash<mef::openpsa::Symbol> {
+   std::size_t operator()(const mef::openpsa::Symbol& symbol) const noexcept {
+       return std::hash<std::uint32_t>()(symbol.id());
+   }
+};
@@ -0,0 +1,202 @@
+/// @file
+/// Tests of the BDD probabilities and semantics under the dynamic variable reordering.
+
+#include "core/bdd.h"
+
+#include <cstdint>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "core/modules.h"
+#include "core/pdag.h"
+#include "core/variable_ordering.h"
+#include "mef/openpsa/settings.h"
+#include "random_graph.h"
+#include "testing.h"
+
+namespace canopy::core {
+
+namespace {
+
+/// Checks the values against the expected ones.
+void CheckValues(const std::vector<double>& values, const std::vector<double>& expected) {
+   CANOPY_CHECK(values.size() == expected.size());
+   for (std::size_t i = 0; i < std::min(values.size(), expected.size()); ++i)
+       CANOPY_CHECK_NEAR(values[i], expected[i], 1e-10);
+}
+
+/// The root probabilities equal the sums of the probabilities of the variable states
+/// with the true root over all the states
+/// for the AND, OR, ATLEAST, and XOR gates with complement args and roots.
+void TestProbability() {
+   for (std::uint32_t seed = 1; seed <= 30; ++seed) {
+       RandomGraph random;
+       Generate(seed, &random, {.min_variables = 6, .min_gates = 12});
+       Pdag& graph = random.graph;
+       Pdag::Index xor_gate = graph.AddGate(mef::openpsa::Connective::kXor,
+                                            {graph.roots().front(), -graph.variable_node(0)});
+       graph.AddRoot(xor_gate);
+       graph.AddRoot(-xor_gate);
+       graph.AddRoot(-graph.variable_node(1));
+       std::vector<double> expected(graph.roots().size(), 0);
+       for (std::uint64_t states = 0; states < (std::uint64_t{1} << graph.num_variables());
+            ++states) {
+           double p = 1;
+           for (int variable = 0; variable < graph.num_variables(); ++variable)
+               p *= states >> variable & 1 ? random.p[variable] : 1 - random.p[variable];
+           std::vector<bool> values = Evaluate(graph, states);
+           for (std::size_t i = 0; i < graph.roots().size(); ++i) {
+               if (Value(values, graph.roots()[i]))
+                   expected[i] += p;
+           }
+       }
+       Bdd bdd(graph);
+       CheckValues(bdd.Probabilities(random.p), expected);
+       for (std::size_t i = 0; i < bdd.roots().size(); ++i)
+           CANOPY_CHECK_NEAR(bdd.Probability(bdd.roots()[i], random.p), expected[i], 1e-10);
+       Bdd sifted(graph, {}, /*reorder_threshold=*/8);
+       CheckValues(sifted.Probabilities(random.p), expected);
+   }
+}
+
+/// The sifting changes the order but not the functions of the roots.
+void TestSifting() {
+   int num_reorderings = 0;
+   for (std::uint32_t seed = 1; seed <= 50; ++seed) {
+       RandomGraph random;
+       Generate(seed, &random);
+       Bdd bdd(random.graph);
+       Bdd sifted(random.graph, {}, /*reorder_threshold=*/8);
+       num_reorderings += sifted.num_reorderings();
+       CheckValues(sifted.Probabilities(random.p), bdd.Probabilities(random.p));
+       CheckValues(sifted.Derivatives(sifted.roots().front(), random.p),
+                   bdd.Derivatives(bdd.roots().front(), random.p));
+       Bdd reordered(random.graph, sifted.order());
+       CheckValues(reordered.Probabilities(random.p), bdd.Probabilities(random.p));
+   }
+   CANOPY_CHECK(num_reorderings > 0);
+}
+
+/// The FORCE order with a variable root outside of any gate
+/// covers every variable once and keeps the root functions.
+void TestForceOrdering() {
+   for (std::uint32_t seed = 1; seed <= 20; ++seed) {
+       RandomGraph random;
+       Generate(seed, &random);
+       random.expressions.emplace_back(0.5);  // Not an arg of any gate.
+       random.p.push_back(0.5);
+       random.graph.AddRoot(random.graph.AddVariable(random.expressions.back()));
+       mef::openpsa::Settings settings;
+       settings.variable_ordering(mef::openpsa::VariableOrdering::kForce);
+       std::vector<int> order = OrderVariables(random.graph, settings);
+       std::vector<int> variables = order;
+       std::sort(variables.begin(), variables.end());
+       CANOPY_CHECK(variables.size() == static_cast<std::size_t>(random.graph.num_variables()));
+       CANOPY_CHECK(std::adjacent_find(variables.begin(), variables.end()) == variables.end());
+       Bdd bdd(random.graph);
+       Bdd ordered(random.graph, std::move(order));
+       CheckValues(ordered.Probabilities(random.p), bdd.Probabilities(random.p));
+   }
+}
+
+/// The modules are exactly the reachable gates
+/// whose descendants have no parents or root references
+/// outside of the gate sub-graph.
+void TestFindModules() {
+   int num_modules = 0;
+   for (std::uint32_t seed = 1; seed <= 50; ++seed) {
+       RandomGraph random;
+       Generate(seed, &random);
+       const Pdag& graph = random.graph;
+       Pdag::Index size = graph.size();
+       std::vector<bool> modules = FindModules(graph);
+       CANOPY_CHECK(modules.size() == graph.size());
+
+       // The descendants of every gate in the ascending topological order.
+       std::vector<std::vector<bool>> descendants(size, std::vector<bool>(size, false));
+       for (Pdag::Index gate = 1; gate < size; ++gate) {
+           if (!graph.IsGate(gate))
+               continue;
+           for (Pdag::Index arg : graph.args(gate)) {
+               descendants[gate][std::abs(arg)] = true;
+               for (Pdag::Index node = 1; node < size; ++node) {
+                   if (descendants[std::abs(arg)][node])
+                       descendants[gate][node] = true;
+               }
+           }
+       }
+       std::vector<bool> reachable(size, false);
+       for (Pdag::Index root : graph.roots()) {
+           reachable[std::abs(root)] = true;
+           for (Pdag::Index node = 1; node < size; ++node) {
+               if (descendants[std::abs(root)][node])
+                   reachable[node] = true;
+           }
+       }
+
+       for (Pdag::Index gate = 1; gate < size; ++gate) {
+           bool module = reachable[gate] && graph.IsGate(gate);
+           for (Pdag::Index root : graph.roots()) {
+               if (std::abs(root) != gate && descendants[gate][std::abs(root)])
+                   module = false;
+           }
+           for (Pdag::Index parent = 1; module && parent < size; ++parent) {
+               if (parent == gate || descendants[gate][parent] || !reachable[parent] ||
+                   !graph.IsGate(parent)) {
+                   continue;
+               }
+               for (Pdag::Index arg : graph.args(parent)) {
+                   if (descendants[gate][std::abs(arg)])
+                       module = false;
+               }
+           }
+           CANOPY_CHECK(modules[gate] == module);
+           num_modules += module;
+       }
+   }
+   CANOPY_CHECK(num_modules > 0);
+}
+
+/// The modular quantification matches the whole diagram,
+/// and the combined module orders cover every variable once.
+void TestModules() {
+   int num_separated = 0;
+   for (std::uint32_t seed = 1; seed <= 50; ++seed) {
+       RandomGraph random;
+       Generate(seed, &random);
+       mef::openpsa::Settings settings;
+       settings.num_threads(2).reorder_threshold(8);
+       Bdd bdd(random.graph);
+       ModularBdd modular_bdd(random.graph, settings);
+       num_separated += modular_bdd.num_modules() - 1;
+       CheckValues(modular_bdd.Probabilities(random.p), bdd.Probabilities(random.p));
+       CANOPY_CHECK_NEAR(modular_bdd.Probability(random.p),
+                         bdd.Probabilities(random.p).front(), 1e-10);
+       CheckValues(modular_bdd.Derivatives(random.p),
+                   bdd.Derivatives(bdd.roots().front(), random.p));
+
+       std::vector<int> order = modular_bdd.order();
+       std::vector<int> variables = order;
+       std::sort(variables.begin(), variables.end());
+       CANOPY_CHECK(variables.size() == static_cast<std::size_t>(random.graph.num_variables()));
+       CANOPY_CHECK(std::adjacent_find(variables.begin(), variables.end()) == variables.end());
+       Bdd reordered(random.graph, std::move(order));
+       CheckValues(reordered.Probabilities(random.p), bdd.Probabilities(random.p));
+   }
+   CANOPY_CHECK(num_separated > 0);
+}
+
+}  // namespace
+
+}  // namespace canopy::core
+
+int main() {
+   canopy::core::TestProbability();
+   canopy::core::TestSifting();
+   canopy::core::TestForceOrdering();
+   canopy::core::TestFindModules();
+   canopy::core::TestModules();
+   return canopy::testing::num_failures;
+}
@@ -0,0 +1,337 @@
+/// @file
+/// Tests of the event-tree programs against the recursive walk of the event trees
+/// and the enumeration of the event states.
+
+#include "core/event_tree_analysis.h"
+
+#include <cstdint>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "mef/openpsa/event/event.h"
+#include "mef/openpsa/event/formula.h"
+#include "mef/openpsa/event/gate.h"
+#include "mef/openpsa/event_tree.h"
+#include "mef/openpsa/expr/test_event.h"
+#include "mef/openpsa/instruction.h"
+#include "mef/openpsa/model.h"
+#include "mef/openpsa/settings.h"
+#include "sample_model.h"
+#include "testing.h"
+
+namespace canopy::core {
+
+namespace {
+
+using namespace mef::openpsa;
+
+/// The instructions collected on a path of the reference walk.
+struct ReferencePath {
+   std::unordered_map<std::string, bool> house_events;  ///< The last states by names.
+   std::vector<const Formula*> formulas;  ///< The conjunction of the path.
+   double p_expression = 1;  ///< The product of the collected expressions.
+   const EventTree* link = nullptr;  ///< The tree to continue the path.
+};
+
+/// Collects the instructions into the path.
+class PathCollector : public InstructionVisitor {
+ public:
+   /// @param[in,out] path  The path to collect into.
+   explicit PathCollector(ReferencePath* path) : path_(*path) {}
+
+   using InstructionVisitor::Visit;
+
+   void Visit(const SetHouseEvent* instruction) override {
+       path_.house_events[instruction->name()] = instruction->state();
+   }
+   void Visit(const CollectExpression* instruction) override {
+       path_.p_expression *= instruction->expression().value();
+   }
+   void Visit(const CollectFormula* instruction) override {
+       path_.formulas.push_back(&instruction->formula());
+   }
+   void Visit(const Link* instruction) override { path_.link = &instruction->event_tree(); }
+
+ private:
+   ReferencePath& path_;  ///< The path under collection.
+};
+
+/// The recursive walk of the event tree interpreting the instructions
+/// on every branch in the context of the walk.
+class ReferenceWalk {
+ public:
+   /// Walks the event tree of the initiating event.
+   ReferenceWalk(const InitiatingEvent& initiating_event, Context* context)
+       : context_(*context) {
+       context_.Clear();
+       context_.initiating_event(Symbol(initiating_event.name()));
+       Walk(initiating_event.event_tree()->initial_state(), {});
+       context_.Clear();
+   }
+
+   /// @returns The paths of the reached sequences by the sequence names.
+   const std::map<std::string, std::vector<ReferencePath>>& sequences() const {
+       return sequences_;
+   }
+
+ private:
+   /// Applies the instructions to the path.
+   static void Apply(const std::vector<Instruction*>& instructions, ReferencePath* path) {
+       PathCollector collector(path);
+       for (const Instruction* instruction : instructions)
+           instruction->Accept(&collector);
+   }
+
+   /// Walks the branch with the path collected before the branch.
+   void Walk(const Branch& branch, ReferencePath path) {
+       Apply(branch.instructions(), &path);
+       if (auto* sequence = std::get_if<Sequence*>(&branch.target())) {
+           Apply((*sequence)->instructions(), &path);
+           if (const EventTree* link = std::exchange(path.link, nullptr)) {
+               Walk(link->initial_state(), std::move(path));
+           } else {
+               sequences_[(*sequence)->name()].push_back(std::move(path));
+           }
+       } else if (auto* fork = std::get_if<Fork*>(&branch.target())) {
+           int slot = context_.Register(Symbol((*fork)->functional_event().name()));
+           for (const Path& fork_path : (*fork)->paths()) {
+               context_.state(slot, fork_path.state_symbol());
+               Walk(fork_path, path);
+           }
+           context_.state(slot, Symbol());
+       } else {
+           Walk(*std::get<NamedBranch*>(branch.target()), std::move(path));
+       }
+   }
+
+   Context& context_;  ///< The context of the test events.
+   std::map<std::string, std::vector<ReferencePath>> sequences_;  ///< The reached paths.
+};
+
+/// @returns The value of the formula in the states of the basic and house events.
+bool Evaluate(const Formula& formula,
+             const std::unordered_map<const BasicEvent*, bool>& basic_events,
+             const std::unordered_map<std::string, bool>& house_events) {
+   int num_true = 0;
+   std::vector<bool> values;
+   for (const Formula::Arg& arg : formula.args()) {
+       bool value = false;
+       if (auto* gate = std::get_if<Gate*>(&arg.event)) {
+           value = Evaluate((*gate)->formula(), basic_events, house_events);
+       } else if (auto* event = std::get_if<BasicEvent*>(&arg.event)) {
+           value = basic_events.at(*event);
+       } else {
+           const HouseEvent* house_event = std::get<HouseEvent*>(arg.event);
+           auto it = house_events.find(house_event->name());
+           value = it == house_events.end() ? house_event->state() : it->second;
+       }
+       value ^= arg.complement;
+       num_true += value;
+       values.push_back(value);
+   }
+   int num_args = values.size();
+   switch (formula.connective()) {
+       case kAnd:
+           return num_true == num_args;
+       case kOr:
+           return num_true > 0;
+       case kAtleast:
+           return num_true >= *formula.min_number();
+       case kCardinality:
+           return num_true >= *formula.min_number() && num_true <= *formula.max_number();
+       case kXor:
+           return num_true % 2;
+       case kNot:
+           return !values.front();
+       case kNand:
+           return num_true < num_args;
+       case kNor:
+           return num_true == 0;
+       case kNull:
+           return values.front();
+       case kIff:
+           return values[0] == values[1];
+       case kImply:
+           return !values[0] || values[1];
+   }
+   return false;
+}
+
+/// @returns The probability of the disjunction of the paths
+///          with the independent basic events and path expressions.
+double Enumerate(const std::vector<ReferencePath>& paths,
+                 const std::vector<const BasicEvent*>& basic_events) {
+   int num_events = basic_events.size() + paths.size();
+   double p_total = 0;
+   std::unordered_map<const BasicEvent*, bool> states;
+   for (std::uint32_t mask = 0; mask < (1u << num_events); ++mask) {
+       double p_state = 1;
+       for (std::size_t i = 0; i < basic_events.size(); ++i) {
+           bool state = mask >> i & 1;
+           double p = basic_events[i]->expression().value();
+           p_state *= state ? p : 1 - p;
+           states[basic_events[i]] = state;
+       }
+       bool occurs = false;
+       for (std::size_t i = 0; i < paths.size(); ++i) {
+           bool state = mask >> (basic_events.size() + i) & 1;
+           p_state *= state ? paths[i].p_expression : 1 - paths[i].p_expression;
+           if (!state || occurs)
+               continue;
+           occurs = true;
+           for (const Formula* formula : paths[i].formulas)
+               occurs &= Evaluate(*formula, states, paths[i].house_events);
+       }
+       if (occurs)
+           p_total += p_state;
+   }
+   return p_total;
+}
+
+/// Adds the initiating event "Loop" with the event tree "ET2" into the sample model.
+/// The initial state applies the block of the frequency and the rule
+/// that tests the initiating event with the else instruction.
+/// The success of cooling collects the formula and links the tree "ET",
+/// and its failure sets the house event and collects only expressions.
+void AddLinkedTree(Model* model) {
+   auto add_instruction = [&model](auto instruction) {
+       Instruction* address = instruction.get();
+       model->Add(std::unique_ptr<Instruction>(std::move(instruction)));
+       return address;
+   };
+   auto add_expression = [&model](auto expression) {
+       Expression* address = expression.get();
+       model->Add(std::unique_ptr<Expression>(std::move(expression)));
+       return address;
+   };
+   auto collect = [&](double value) {
+       return add_instruction(std::make_unique<CollectExpression>(model->AddConstant(value)));
+   };
+
+   auto rule = std::make_unique<Rule>("Severity");
+   rule->instructions({add_instruction(std::make_unique<IfThenElse>(
+       add_expression(std::make_unique<TestInitiatingEvent>("Trip", model->context())),
+       collect(0.3), collect(0.6)))});
+   Branch initial_state;
+   initial_state.instructions(
+       {add_instruction(std::make_unique<Block>(std::vector<Instruction*>{collect(0.01)})),
+        rule.get()});
+   model->Add(std::move(rule));
+
+   auto event_tree = std::make_unique<EventTree>("ET2");
+   auto linked = std::make_unique<Sequence>("Linked");
+   linked->instructions(
+       {add_instruction(std::make_unique<Link>(*model->event_trees().find("ET")))});
+   auto expression = std::make_unique<Sequence>("Expression");
+   expression->instructions({add_instruction(std::make_unique<IfThenElse>(
+       add_expression(std::make_unique<TestFunctionalEvent>("Cooling", "failure",
+                                                            model->context())),
+       collect(0.2)))});
+   event_tree->Add(linked.get());
+   event_tree->Add(expression.get());
+
+   auto cooling = std::make_unique<FunctionalEvent>("Cooling");
+   cooling->order(1);
+   std::vector<Path> paths;
+   paths.emplace_back("success");
+   paths.back().instructions({add_instruction(std::make_unique<CollectFormula>(
+       std::make_unique<Formula>(kNot, Formula::ArgSet{&*model->table<Gate>().find("Valves")})))});
+   paths.back().target(linked.get());
+   paths.emplace_back("failure");
+   paths.back().instructions(
+       {add_instruction(std::make_unique<SetHouseEvent>("maintenance", true))});
+   paths.back().target(expression.get());
+   auto fork = std::make_unique<Fork>(*cooling, std::move(paths));
+   initial_state.target(fork.get());
+   event_tree->initial_state(std::move(initial_state));
+   event_tree->Add(std::move(cooling));
+   event_tree->Add(std::move(fork));
+
+   auto loop = std::make_unique<InitiatingEvent>("Loop");
+   loop->event_tree(event_tree.get());
+   model->Add(std::move(linked));
+   model->Add(std::move(expression));
+   model->Add(std::move(event_tree));
+   model->Add(std::move(loop));
+}
+
+/// The compiled programs give the sequences and probabilities
+/// of the recursive walk of the trees with the forks, the formulas,
+/// the expressions, the house events, the conditional instructions, and the links.
+void TestSequences() {
+   std::unique_ptr<Model> model = canopy::testing::BuildSampleModel();
+   AddLinkedTree(model.get());
+   canopy::testing::SetUpForAnalysis(model.get());
+   std::vector<const BasicEvent*> basic_events;
+   for (const BasicEvent& event : model->basic_events())
+       basic_events.push_back(&event);
+
+   Settings settings;
+   settings.ccf_analysis(false);
+   int num_sequences = 0;
+   for (const InitiatingEvent& initiating_event : model->initiating_events()) {
+       ReferenceWalk reference(initiating_event, model->context());
+       EventTreeAnalysis analysis(initiating_event, settings, model->context());
+       analysis.Analyze();
+       CANOPY_CHECK(analysis.results().size() == reference.sequences().size());
+       for (const EventTreeAnalysis::Result& result : analysis.results()) {
+           auto it = reference.sequences().find(result.sequence->name());
+           CANOPY_CHECK(it != reference.sequences().end());
+           if (it == reference.sequences().end())
+               continue;
+           bool expression_only = true;
+           for (const ReferencePath& path : it->second)
+               expression_only &= path.formulas.empty();
+           CANOPY_CHECK(result.expression_only == expression_only);
+           double p_expected = 0;
+           if (expression_only) {
+               for (const ReferencePath& path : it->second)
+                   p_expected += path.p_expression;
+           } else {
+               p_expected = Enumerate(it->second, basic_events);
+           }
+           CANOPY_CHECK_NEAR(result.p_sequence, p_expected, 1e-12);
+           ++num_sequences;
+       }
+   }
+   // OK and Failure of Trip; OK, Failure, and Expression of Loop.
+   CANOPY_CHECK(num_sequences == 5);
+}
+
+/// The walk leaves the context clear for the next analysis.
+void TestContext() {
+   std::unique_ptr<Model> model = canopy::testing::BuildSampleModel();
+   AddLinkedTree(model.get());
+   canopy::testing::SetUpForAnalysis(model.get());
+   Settings settings;
+   settings.ccf_analysis(false);
+   const InitiatingEvent& loop = *model->initiating_events().find("Loop");
+   EventTreeAnalysis first(loop, settings, model->context());
+   first.Analyze();
+   CANOPY_CHECK(model->context()->initiating_event() == Symbol());
+   for (Symbol state : model->context()->states())
+       CANOPY_CHECK(state == Symbol());
+   EventTreeAnalysis second(loop, settings, model->context());
+   second.Analyze();
+   CANOPY_CHECK(second.results().size() == first.results().size());
+   for (std::size_t i = 0; i < first.results().size(); ++i) {
+       CANOPY_CHECK(second.results()[i].sequence == first.results()[i].sequence);
+       CANOPY_CHECK(second.results()[i].p_sequence == first.results()[i].p_sequence);
+   }
+}
+
+}  // namespace
+
+}  // namespace canopy::core
+
+int main() {
+   canopy::core::TestSequences();
+   canopy::core::TestContext();
+   return canopy::testing::num_failures;
+}
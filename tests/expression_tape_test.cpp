@@ -0,0 +1,151 @@
+/// @file
+/// Tests of the expression tape against the expression graph.
+
+#include "mef/openpsa/expression_tape.h"
+
+#include <span>
+#include <vector>
+
+#include "mef/openpsa/expr/constant.h"
+#include "mef/openpsa/expr/exponential.h"
+#include "mef/openpsa/expr/numerical.h"
+#include "mef/openpsa/expr/random_deviate.h"
+#include "mef/openpsa/parameter.h"
+#include "testing.h"
+
+namespace mef::openpsa {
+
+namespace {
+
+/// The shared sub-expressions are compiled once,
+/// and the tape evaluates to the values of the graph.
+void TestEvaluate() {
+   MissionTime mission_time(1000);
+   ConstantExpression lambda(2e-4);
+   ConstantExpression half(0.5);
+   Exponential exponential(&lambda, &mission_time);
+   Mul product({&exponential, &half});
+   Add sum({&product, &exponential});
+
+   ExpressionTape tape;
+   ExpressionTape::Slot slot = tape.Compile(&sum);
+   std::size_t size = tape.size();
+   CANOPY_CHECK(tape.Compile(&exponential) != slot);
+   CANOPY_CHECK(tape.size() == size);  // Already compiled.
+   tape.Evaluate();
+   CANOPY_CHECK_NEAR(tape[slot], sum.value(), 1e-15);
+   CANOPY_CHECK_NEAR(tape[tape.Compile(&product)], product.value(), 1e-15);
+
+   mission_time.value(2000);
+   tape.Evaluate();
+   CANOPY_CHECK_NEAR(tape[slot], sum.value(), 1e-15);
+}
+
+/// The sampling re-evaluates the deviate-dependent slots in a new epoch
+/// with the deviate streams of the current trial.
+void TestSample() {
+   ConstantExpression min(1);
+   ConstantExpression max(3);
+   ConstantExpression half(0.5);
+   UniformDeviate deviate(&min, &max);
+   deviate.stream_id(0);
+   Mul product({&deviate, &half});
+   Add sum({&product, &half});
+
+   ExpressionTape tape;
+   ExpressionTape::Slot slot = tape.Compile(&sum);
+   tape.Evaluate();
+   CANOPY_CHECK_NEAR(tape[slot], sum.value(), 1e-15);
+
+   RandomDeviate::trial(1);
+   tape.Sample();
+   double first = tape[slot];
+   CANOPY_CHECK(first >= 1 && first <= 2);
+   CANOPY_CHECK_NEAR(first, sum.Sample(), 1e-15);  // The graph shares the epoch.
+   tape.Sample();
+   CANOPY_CHECK(tape[slot] == first);  // The same trial in a new epoch.
+
+   RandomDeviate::trial(2);
+   tape.Sample();
+   CANOPY_CHECK(tape[slot] != first);
+   CANOPY_CHECK_NEAR(tape[slot], sum.Sample(), 1e-15);
+
+   RandomDeviate::trial(1);
+   tape.Sample();
+   CANOPY_CHECK(tape[slot] == first);
+}
+
+/// The batch sampling gives every trial the values of the scalar sampling,
+/// including the deviates with uncertain parameters,
+/// and keeps the single values of the deviate-independent slots.
+void TestSampleBatch() {
+   ConstantExpression min(1);
+   ConstantExpression max(3);
+   ConstantExpression half(0.5);
+   UniformDeviate deviate(&min, &max);
+   UniformDeviate nested(&half, &deviate);  // Uncertain upper bound.
+   deviate.stream_id(0);
+   nested.stream_id(1);
+   Mul product({&deviate, &nested});
+   Add sum({&product, &half});
+   Neg constant(&half);
+
+   ExpressionTape tape;
+   ExpressionTape::Slot slot = tape.Compile(&sum);
+   ExpressionTape::Slot constant_slot = tape.Compile(&constant);
+   tape.Evaluate();
+
+   constexpr int kNumTrials = 100;
+   constexpr int kFirstTrial = 7;
+   ExpressionTape::Batch batch;
+   tape.SampleBatch(kFirstTrial, kNumTrials, &batch);
+   CANOPY_CHECK(batch.size() == kNumTrials);
+   CANOPY_CHECK(batch[constant_slot].size() == 1);
+   CANOPY_CHECK(batch[constant_slot][0] == -0.5);
+   std::span<const double> values = batch[slot];
+   CANOPY_CHECK(values.size() == kNumTrials);
+   CANOPY_CHECK(RandomDeviate::trial() == kFirstTrial);
+   for (int i = 0; i < kNumTrials; ++i) {
+       RandomDeviate::trial(kFirstTrial + i);
+       tape.Sample();
+       CANOPY_CHECK_NEAR(values[i], tape[slot], 1e-12);
+       CANOPY_CHECK_NEAR(values[i], deviate.Sample() * nested.Sample() + 0.5, 1e-12);
+   }
+}
+
+/// The sweep computes the series of the time-dependent slots only
+/// and restores the mission time.
+void TestSweep() {
+   MissionTime mission_time(1000);
+   ConstantExpression lambda(1e-3);
+   ConstantExpression weight(0.25);
+   Exponential exponential(&lambda, &mission_time);
+   Mul product({&exponential, &weight});
+
+   ExpressionTape tape;
+   ExpressionTape::Slot slot = tape.Compile(&product);
+   ExpressionTape::Slot weight_slot = tape.Compile(&weight);
+   std::vector<double> times = {0, 10, 100, 1000, 5000};
+   tape.Sweep(times);
+
+   CANOPY_CHECK(mission_time.value() == 1000);
+   CANOPY_CHECK(tape.series(weight_slot).size() == 1);
+   CANOPY_CHECK_NEAR(tape.series(weight_slot).front(), 0.25, 1e-15);
+   CANOPY_CHECK(tape.series(slot).size() == times.size());
+   for (std::size_t i = 0; i < std::min(times.size(), tape.series(slot).size()); ++i) {
+       mission_time.value(times[i]);
+       CANOPY_CHECK_NEAR(tape.series(slot)[i], product.value(), 1e-15);
+   }
+}
+
+}  // namespace
+
+}  // namespace mef::openpsa
+
+int main() {
+   mef::openpsa::TestEvaluate();
+   mef::openpsa::TestSample();
+   mef::openpsa::TestSampleBatch();
+   mef::openpsa::TestSweep();
+   return canopy::testing::num_failures;
+}
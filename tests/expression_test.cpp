@@ -0,0 +1,75 @@
+/// @file
+/// Tests of the expression sampling in trial epochs and contexts.
+
+#include "mef/openpsa/expression.h"
+
+#include <cstdint>
+
+#include <initializer_list>
+#include <thread>
+#include <vector>
+
+#include "mef/openpsa/expr/constant.h"
+#include "mef/openpsa/expr/numerical.h"
+#include "mef/openpsa/expr/random_deviate.h"
+#include "mef/openpsa/expression_tape.h"
+#include "testing.h"
+
+namespace mef::openpsa {
+
+namespace {
+
+/// Threads sampling concurrently in their own contexts
+/// get the samples of the single-threaded trials,
+/// and the tape sizes the contexts for its opaque leaves.
+void TestContexts() {
+   ConstantExpression min(1);
+   ConstantExpression max(3);
+   UniformDeviate deviate(&min, &max);
+   Mul square({&deviate, &deviate});
+   deviate.stream_id(0);
+   std::uint32_t size = 0;
+   for (Expression* expression : std::initializer_list<Expression*>{&min, &max, &deviate, &square})
+       expression->index(size++);
+
+   ExpressionTape tape;
+   tape.Compile(&square);
+   CANOPY_CHECK(tape.context_size() == deviate.index() + 1);
+
+   constexpr int kNumTrials = 1000;
+   constexpr int kNumThreads = 4;
+   std::vector<double> expected(kNumTrials);
+   for (int trial = 0; trial < kNumTrials; ++trial) {
+       RandomDeviate::trial(trial);
+       Expression::StartTrial();
+       expected[trial] = square.Sample();
+       CANOPY_CHECK_NEAR(expected[trial], deviate.Sample() * deviate.Sample(), 1e-15);
+   }
+
+   std::vector<double> results(kNumTrials);
+   {
+       std::vector<std::jthread> threads;
+       for (int first = 0; first < kNumThreads; ++first) {
+           threads.emplace_back([&, first] {
+               SamplingContext context(size);
+               Expression::context(&context);
+               for (int trial = first; trial < kNumTrials; trial += kNumThreads) {
+                   RandomDeviate::trial(trial);
+                   Expression::StartTrial();
+                   results[trial] = square.Sample();
+               }
+               Expression::context(nullptr);
+           });
+       }
+   }  // Joins the threads.
+   CANOPY_CHECK(results == expected);
+}
+
+}  // namespace
+
+}  // namespace mef::openpsa
+
+int main() {
+   mef::openpsa::TestContexts();
+   return canopy::testing::num_failures;
+}
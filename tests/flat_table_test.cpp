@@ -0,0 +1,88 @@
+/// @file
+/// Tests of the flat open-addressing hash table.
+
+#include "mef/openpsa/flat_table.h"
+
+#include <functional>
+#include <string>
+#include <utility>
+
+#include "testing.h"
+
+namespace mef::openpsa {
+
+namespace {
+
+/// The table of strings keyed by themselves.
+using StringTable = FlatTable<std::string, std::identity, std::hash<std::string>>;
+
+/// @returns The unique test string for the number.
+std::string Key(int number) { return "key-" + std::to_string(number); }
+
+/// Checks that the table holds exactly the keys in [first, last).
+void CheckKeys(const StringTable& table, int first, int last) {
+   CANOPY_CHECK(table.size() == static_cast<std::size_t>(last - first));
+   CANOPY_CHECK(table.empty() == (first == last));
+   std::size_t num_values = 0;
+   for (const std::string& value : table) {
+       CANOPY_CHECK(table.count(value));
+       ++num_values;
+   }
+   CANOPY_CHECK(num_values == table.size());
+   for (int i = first; i < last; ++i)
+       CANOPY_CHECK(table.count(Key(i)));
+}
+
+/// The moved-from tables are empty and reusable.
+void TestMove() {
+   StringTable table;
+   for (int i = 0; i < 100; ++i)
+       table.insert(Key(i));
+   for (int i = 0; i < 50; ++i)
+       table.extract(table.find(Key(i)));  // Leaves tombstones.
+
+   StringTable moved(std::move(table));
+   CheckKeys(moved, 50, 100);
+   CheckKeys(table, 0, 0);
+   CANOPY_CHECK(table.begin() == table.end());
+   CANOPY_CHECK(table.find(Key(60)) == table.end());
+   CANOPY_CHECK(table.insert(Key(0)).second);
+   CheckKeys(table, 0, 1);
+
+   StringTable assigned;
+   assigned.insert(Key(-1));
+   assigned = std::move(moved);
+   CheckKeys(assigned, 50, 100);
+   CANOPY_CHECK(!assigned.count(Key(-1)));
+   CheckKeys(moved, 0, 0);
+   for (int i = 0; i < 20; ++i)
+       CANOPY_CHECK(moved.insert(Key(i)).second);
+   CheckKeys(moved, 0, 20);
+}
+
+/// The slots of the erased values are reused without losing the values.
+void TestTombstoneReuse() {
+   StringTable table;
+   constexpr int kWindow = 10;
+   for (int i = 0; i < 10000; ++i) {
+       CANOPY_CHECK(table.insert(Key(i)).second);
+       CANOPY_CHECK(!table.insert(Key(i)).second);
+       if (i >= kWindow) {
+           std::string value = table.extract(table.find(Key(i - kWindow)));
+           CANOPY_CHECK(value == Key(i - kWindow));
+       }
+   }
+   CheckKeys(table, 10000 - kWindow, 10000);
+   for (int i = 0; i < 10000 - kWindow; ++i)
+       CANOPY_CHECK(!table.count(Key(i)));
+}
+
+}  // namespace
+
+}  // namespace mef::openpsa
+
+int main() {
+   mef::openpsa::TestMove();
+   mef::openpsa::TestTombstoneReuse();
+   return canopy::testing::num_failures;
+}
@@ -0,0 +1,163 @@
+/// @file
+/// Tests of the importance measures against the exact conditional probabilities
+/// and the finite differences of the approximations.
+
+#include "core/importance.h"
+
+#include <cmath>
+#include <cstdint>
+
+#include <algorithm>
+#include <span>
+#include <vector>
+
+#include "core/bdd.h"
+#include "core/pdag.h"
+#include "core/zbdd.h"
+#include "mef/openpsa/settings.h"
+#include "random_graph.h"
+#include "testing.h"
+
+namespace canopy::core {
+
+namespace {
+
+/// Checks the values equal within the relative tolerance.
+void CheckRelative(double value, double expected) {
+   CANOPY_CHECK_NEAR(value, expected, 1e-9 * std::max(1.0, std::abs(expected)));
+}
+
+/// The factors derived from the BDD derivatives are
+/// the ratios of the exact conditional probabilities of the root.
+void TestCalculateImportance() {
+   int num_checked = 0;
+   for (std::uint32_t seed = 1; seed <= 30; ++seed) {
+       RandomGraph random;
+       Generate(seed, &random);
+       Bdd bdd(random.graph);
+       double p_total = bdd.Probabilities(random.p).front();
+       std::vector<double> mif = bdd.Derivatives(bdd.roots().front(), random.p);
+       std::vector<ImportanceFactors> factors =
+           CalculateImportance(random.p, p_total, mif);
+       CANOPY_CHECK(factors.size() == random.p.size());
+       if (p_total < 1e-6)
+           continue;
+       for (std::size_t i = 0; i < factors.size(); ++i) {
+           std::vector<double> p = random.p;
+           p[i] = 1;
+           double p_true = bdd.Probabilities(p).front();
+           p[i] = 0;
+           double p_false = bdd.Probabilities(p).front();
+           CheckRelative(factors[i].mif, p_true - p_false);
+           CheckRelative(factors[i].cif, random.p[i] * (p_true - p_false) / p_total);
+           CheckRelative(factors[i].dif, random.p[i] * p_true / p_total);
+           CheckRelative(factors[i].raw, p_true / p_total);
+           if (p_false > 1e-6)
+               CheckRelative(factors[i].rrw, p_total / p_false);
+           ++num_checked;
+       }
+   }
+   CANOPY_CHECK(num_checked > 0);
+}
+
+/// @returns The rare-event approximation or the MCUB of the products.
+double Approximate(const std::vector<Zbdd::Product>& products, std::span<const double> p_vars,
+                   bool mcub) {
+   double sum = 0;
+   double none = 1;
+   for (const Zbdd::Product& product : products) {
+       double p_product = 1;
+       for (int literal : product)
+           p_product *= literal < 0 ? 1 - p_vars[~literal] : p_vars[literal];
+       sum += p_product;
+       none *= 1 - p_product;
+   }
+   return mcub ? 1 - none : sum;
+}
+
+/// @returns The derivatives of the approximation accumulated over the products.
+std::vector<double> Accumulate(const std::vector<Zbdd::Product>& products,
+                               std::span<const double> p_vars, bool mcub) {
+   ProductImportance importance(p_vars, mcub);
+   if (mcub) {
+       for (const Zbdd::Product& product : products)
+           importance.Prepare(product);
+   }
+   for (const Zbdd::Product& product : products)
+       importance.Add(product);
+   return importance.mif();
+}
+
+/// Checks the accumulated derivatives against the central differences.
+void CheckDerivatives(const std::vector<Zbdd::Product>& products,
+                      const std::vector<double>& p_vars) {
+   constexpr double kStep = 1e-6;
+   for (bool mcub : {false, true}) {
+       std::vector<double> mif = Accumulate(products, p_vars, mcub);
+       CANOPY_CHECK(mif.size() == p_vars.size());
+       for (std::size_t i = 0; i < p_vars.size(); ++i) {
+           std::vector<double> p = p_vars;
+           p[i] = p_vars[i] + kStep;
+           double upper = Approximate(products, p, mcub);
+           p[i] = p_vars[i] - kStep;
+           double lower = Approximate(products, p, mcub);
+           CANOPY_CHECK_NEAR(mif[i], (upper - lower) / (2 * kStep), 1e-6);
+       }
+   }
+}
+
+/// The rare-event and MCUB derivatives of the minimal cut sets
+/// and the prime implicants with complements.
+void TestProductImportance() {
+   int num_complements = 0;
+   for (std::uint32_t seed = 1; seed <= 30; ++seed) {
+       RandomGraph random;
+       Generate(seed, &random, {.min_variables = 10, .min_gates = 14, .coherent = true});
+       mef::openpsa::Settings settings;
+       settings.cut_off(0);
+       Zbdd zbdd(random.graph, random.p, settings);
+       std::vector<Zbdd::Product> products = zbdd.products(zbdd.roots().front());
+       CANOPY_CHECK_NEAR(Approximate(products, random.p, false),
+                         zbdd.RareEvent(zbdd.roots().front()), 1e-10);
+       CANOPY_CHECK_NEAR(Approximate(products, random.p, true),
+                         zbdd.Mcub(zbdd.roots().front()), 1e-10);
+       CheckDerivatives(products, random.p);
+
+       RandomGraph non_coherent;
+       Generate(seed, &non_coherent, {.min_variables = 8, .min_gates = 10});
+       Bdd bdd(non_coherent.graph);
+       settings.prime_implicants(true);
+       Zbdd prime_implicants(&bdd, non_coherent.p, settings);
+       products = prime_implicants.products(prime_implicants.roots().front());
+       for (const Zbdd::Product& product : products)
+           num_complements += std::count_if(product.begin(), product.end(),
+                                            [](int literal) { return literal < 0; });
+       CheckDerivatives(products, non_coherent.p);
+   }
+   CANOPY_CHECK(num_complements > 0);
+}
+
+/// The MCUB derivatives stay exact with a certain product.
+void TestCertainProduct() {
+   std::vector<double> p_vars = {1, 0.5, 0.2};
+   std::vector<Zbdd::Product> products = {{0}, {1, 2}};
+   std::vector<double> mif = Accumulate(products, p_vars, /*mcub=*/true);
+   CANOPY_CHECK_NEAR(mif[0], 1 - 0.5 * 0.2, 1e-15);
+   CANOPY_CHECK_NEAR(mif[1], 0, 1e-15);
+   CANOPY_CHECK_NEAR(mif[2], 0, 1e-15);
+   mif = Accumulate(products, p_vars, /*mcub=*/false);
+   CANOPY_CHECK_NEAR(mif[0], 1, 1e-15);
+   CANOPY_CHECK_NEAR(mif[1], 0.2, 1e-15);
+   CANOPY_CHECK_NEAR(mif[2], 0.5, 1e-15);
+}
+
+}  // namespace
+
+}  // namespace canopy::core
+
+int main() {
+   canopy::core::TestCalculateImportance();
+   canopy::core::TestProductImportance();
+   canopy::core::TestCertainProduct();
+   return canopy::testing::num_failures;
+}
@@ -0,0 +1,181 @@
+/// @file
+/// Tests of the parallel parsing of the input files.
+
+#include "mef/openpsa/initializer.h"
+
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#include "core/bdd.h"
+#include "core/pdag.h"
+#include "testing.h"
+
+namespace mef::openpsa {
+
+namespace {
+
+/// The number of the input files.
+constexpr int kNumFiles = 8;
+
+/// The input files in a temporary directory removed with the fixture.
+class InputFiles {
+ public:
+   InputFiles()
+       : directory_(std::filesystem::temp_directory_path() / "canopy_initializer_test") {
+       std::filesystem::create_directories(directory_);
+       for (int i = 0; i < kNumFiles; ++i)
+           Write(i, Valid(i));
+   }
+
+   ~InputFiles() { std::filesystem::remove_all(directory_); }
+
+   /// Overwrites the file with the content.
+   void Write(int index, const std::string& content) const {
+       std::ofstream(paths()[index]) << content;
+   }
+
+   /// @returns The file paths in the input order.
+   std::vector<std::string> paths() const {
+       std::vector<std::string> result;
+       for (int i = 0; i < kNumFiles; ++i)
+           result.push_back((directory_ / ("input_" + std::to_string(i) + ".xml")).string());
+       return result;
+   }
+
+   /// @returns The fault tree of the file
+   ///          with the events and gates defined in the other files.
+   static std::string Valid(int index) {
+       std::string i = std::to_string(index);
+       std::string next = std::to_string((index + 1) % kNumFiles);
+       std::string after = std::to_string((index + 2) % kNumFiles);
+       return "<?xml version=\"1.0\"?>\n"
+              "<opsa-mef>\n"
+              "  <define-fault-tree name=\"FT" + i + "\">\n"
+              "    <define-gate name=\"Top" + i + "\">\n"
+              "      <or>\n"
+              "        <basic-event name=\"E" + i + "\"/>\n"
+              "        <gate name=\"Pair" + i + "\"/>\n"
+              "      </or>\n"
+              "    </define-gate>\n"
+              "    <define-gate name=\"Pair" + i + "\">\n"
+              "      <atleast min=\"2\">\n"
+              "        <basic-event name=\"E" + next + "\"/>\n"
+              "        <basic-event name=\"E" + after + "\"/>\n"
+              "        <basic-event name=\"E" + i + "\"/>\n"
+              "      </atleast>\n"
+              "    </define-gate>\n"
+              "  </define-fault-tree>\n"
+              "  <model-data>\n"
+              "    <define-parameter name=\"p" + i + "\">\n"
+              "      <float value=\"0.0" + std::to_string(index + 1) + "\"/>\n"
+              "    </define-parameter>\n"
+              "    <define-basic-event name=\"E" + i + "\">\n"
+              "      <mul><parameter name=\"p" + i + "\"/><float value=\"2\"/></mul>\n"
+              "    </define-basic-event>\n"
+              "  </model-data>\n"
+              "</opsa-mef>\n";
+   }
+
+ private:
+   std::filesystem::path directory_;  ///< The temporary directory of the files.
+};
+
+/// @returns The model of the files initialized with the number of threads.
+std::unique_ptr<Model> Initialize(const std::vector<std::string>& paths, int num_threads) {
+   Settings settings;
+   settings.num_threads(num_threads);
+   return Initializer(paths, settings).model();
+}
+
+/// @returns The probability of the top event of the fault tree.
+double Analyze(const FaultTree& fault_tree) {
+   canopy::core::Pdag graph(*fault_tree.top_events().front());
+   std::vector<double> p_vars;
+   for (int variable = 0; variable < graph.num_variables(); ++variable)
+       p_vars.push_back(graph.p(variable));
+   return canopy::core::Bdd(graph).Probabilities(p_vars).front();
+}
+
+/// The parallel parsing gives the same model as the sequential parsing.
+void TestParallelModel() {
+   InputFiles files;
+   std::unique_ptr<Model> sequential = Initialize(files.paths(), 1);
+   for (int num_threads : {2, 4, kNumFiles + 1}) {
+       std::unique_ptr<Model> parallel = Initialize(files.paths(), num_threads);
+       CANOPY_CHECK(parallel->basic_events().size() == sequential->basic_events().size());
+       CANOPY_CHECK(parallel->gates().size() == sequential->gates().size());
+       CANOPY_CHECK(parallel->fault_trees().size() == sequential->fault_trees().size());
+       // The elements are registered in the input order.
+       auto event = parallel->basic_events().begin();
+       for (const BasicEvent& expected : sequential->basic_events()) {
+           CANOPY_CHECK(event->id() == expected.id());
+           CANOPY_CHECK(event->expression().value() == expected.expression().value());
+           ++event;
+       }
+       auto fault_tree = parallel->fault_trees().begin();
+       for (const FaultTree& expected : sequential->fault_trees()) {
+           CANOPY_CHECK(fault_tree->name() == expected.name());
+           CANOPY_CHECK(Analyze(*fault_tree) == Analyze(expected));
+           ++fault_tree;
+       }
+   }
+}
+
+/// The error of the first failing file in the input order is reported
+/// regardless of the number of threads.
+void TestFirstError() {
+   InputFiles files;
+   files.Write(3, "<?xml version=\"1.0\"?>\n<opsa-mef>\n  <define-fault-tree name=\"FT3\">\n");
+   files.Write(6, "<?xml version=\"1.0\"?>\n<opsa-mef>\n  <undefined-element/>\n</opsa-mef>\n");
+   files.Write(7, "not xml");
+
+   auto capture = [&files](int num_threads) -> std::exception_ptr {
+       try {
+           Initialize(files.paths(), num_threads);
+       } catch (...) {
+           return std::current_exception();
+       }
+       return nullptr;
+   };
+   auto message = [](const std::exception_ptr& error) -> std::string {
+       try {
+           std::rethrow_exception(error);
+       } catch (const std::exception& err) {
+           return std::string(typeid(err).name()) + ": " + err.what();
+       } catch (...) {
+           return "unknown";
+       }
+   };
+   std::exception_ptr expected = capture(1);
+   CANOPY_CHECK(expected);
+   if (!expected)
+       return;
+   // The scheduling of the files varies between the runs.
+   for (int run = 0; run < 10; ++run) {
+       for (int num_threads : {2, 4, kNumFiles}) {
+           std::exception_ptr error = capture(num_threads);
+           CANOPY_CHECK(error);
+           if (error)
+               CANOPY_CHECK(message(error) == message(expected));
+       }
+   }
+   // The errors of the files are distinct.
+   files.Write(3, InputFiles::Valid(3));
+   std::exception_ptr next = capture(1);
+   CANOPY_CHECK(next && message(next) != message(expected));
+}
+
+}  // namespace
+
+}  // namespace mef::openpsa
+
+int main() {
+   mef::openpsa::TestParallelModel();
+   mef::openpsa::TestFirstError();
+   return canopy::testing::num_failures;
+}
@@ -0,0 +1,108 @@
+/// @file
+/// Tests of the MOCUS products against the bottom-up ZBDD construction.
+
+#include "core/mocus.h"
+
+#include <cstdint>
+
+#include <algorithm>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "core/pdag.h"
+#include "core/zbdd.h"
+#include "mef/openpsa/settings.h"
+#include "random_graph.h"
+#include "testing.h"
+
+namespace canopy::core {
+
+namespace {
+
+/// @returns The products in the lexicographic order.
+std::vector<std::vector<int>> Sort(std::vector<std::vector<int>> products) {
+   for (std::vector<int>& product : products)
+       std::sort(product.begin(), product.end());
+   std::sort(products.begin(), products.end());
+   return products;
+}
+
+/// @returns The products of the arena in the lexicographic order.
+std::vector<std::vector<int>> Sort(const ProductArena& arena) {
+   std::vector<std::vector<int>> products;
+   for (std::size_t i = 0; i < arena.size(); ++i) {
+       std::span<const int> product = arena[i];
+       products.emplace_back(product.begin(), product.end());
+   }
+   return Sort(std::move(products));
+}
+
+/// Checks the MOCUS products and approximations against the ZBDD of the first root.
+void CheckProducts(const RandomGraph& random, const mef::openpsa::Settings& settings) {
+   Zbdd zbdd(random.graph, random.p, settings);
+   Zbdd::VertexIndex root = zbdd.roots().front();
+   std::vector<std::vector<int>> expected = Sort(zbdd.products(root));
+   for (int num_threads : {1, 4}) {
+       mef::openpsa::Settings threaded = settings;
+       threaded.num_threads(num_threads);
+       Mocus mocus(random.graph, random.p, threaded);
+       CANOPY_CHECK(Sort(mocus.products()) == expected);
+       for (std::size_t i = 1; i < mocus.products().size(); ++i)
+           CANOPY_CHECK(mocus.products()[i - 1].size() <= mocus.products()[i].size());
+       CANOPY_CHECK_NEAR(mocus.RareEvent(), zbdd.RareEvent(root), 1e-10);
+       CANOPY_CHECK_NEAR(mocus.Mcub(), zbdd.Mcub(root), 1e-10);
+   }
+}
+
+/// The small fault-tree-like graphs for the top-down expansion
+/// that does not share the expansions of the common gates.
+constexpr GraphShape kSmallGraph = {.min_variables = 10, .min_gates = 14, .coherent = true};
+
+/// The products are the minimal cut sets of the ZBDD
+/// regardless of the number of threads.
+void TestProducts() {
+   int num_products = 0;
+   for (std::uint32_t seed = 1; seed <= 50; ++seed) {
+       RandomGraph random;
+       Generate(seed, &random, kSmallGraph);
+       mef::openpsa::Settings settings;
+       settings.cut_off(0);
+       CheckProducts(random, settings);
+       num_products += Mocus(random.graph, random.p, settings).products().size();
+   }
+   CANOPY_CHECK(num_products > 50);
+}
+
+/// The complements are Unity in both constructions.
+void TestNonCoherent() {
+   for (std::uint32_t seed = 1; seed <= 50; ++seed) {
+       RandomGraph random;
+       Generate(seed, &random, {.min_variables = 8, .min_gates = 10});
+       mef::openpsa::Settings settings;
+       settings.cut_off(0);
+       CheckProducts(random, settings);
+   }
+}
+
+/// The order limit and the cut-off prune the same products.
+void TestPruning() {
+   for (std::uint32_t seed = 1; seed <= 50; ++seed) {
+       RandomGraph random;
+       Generate(seed, &random, kSmallGraph);
+       mef::openpsa::Settings settings;
+       settings.limit_order(2).cut_off(1e-2);
+       CheckProducts(random, settings);
+   }
+}
+
+}  // namespace
+
+}  // namespace canopy::core
+
+int main() {
+   canopy::core::TestProducts();
+   canopy::core::TestNonCoherent();
+   canopy::core::TestPruning();
+   return canopy::testing::num_failures;
+}
@@ -0,0 +1,194 @@
+/// @file
+/// Tests of the round trip of models through the binary snapshots
+/// and of the invalidation of the snapshots by the included files.
+
+#include "mef/openpsa/model_cache.h"
+
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+#include "core/bdd.h"
+#include "core/event_tree_analysis.h"
+#include "core/pdag.h"
+#include "sample_model.h"
+#include "testing.h"
+
+namespace mef::openpsa {
+
+namespace {
+
+/// The one-to-one correspondence of the expressions of two models.
+class ExpressionMatcher {
+ public:
+   /// Matches the expressions and their arguments recursively.
+   ///
+   /// @returns true if the expression graphs are isomorphic
+   ///          with the same static constants and values.
+   bool Match(Expression* expected, Expression* actual) {
+       auto [forward, inserted] = forward_.emplace(expected, actual);
+       auto [backward, reverse_inserted] = backward_.emplace(actual, expected);
+       if (forward->second != actual || backward->second != expected)
+           return false;
+       if (!inserted)
+           return true;
+       if (IsStatic(expected) || IsStatic(actual))
+           return expected == actual;
+       if (typeid(*expected) != typeid(*actual) || expected->value() != actual->value() ||
+           expected->args().size() != actual->args().size()) {
+           return false;
+       }
+       for (std::size_t i = 0; i < expected->args().size(); ++i) {
+           if (!Match(expected->args()[i], actual->args()[i]))
+               return false;
+       }
+       return true;
+   }
+
+ private:
+   /// @returns true for the constants shared by all the models.
+   static bool IsStatic(Expression* expression) {
+       return expression == &ConstantExpression::kOne ||
+              expression == &ConstantExpression::kZero ||
+              expression == &ConstantExpression::kPi;
+   }
+
+   std::unordered_map<Expression*, Expression*> forward_;  ///< The expected to actual.
+   std::unordered_map<Expression*, Expression*> backward_;  ///< The actual to expected.
+};
+
+/// @returns The probability of the top event of the fault tree with the CCF events.
+double AnalyzeFaultTree(Model* model) {
+   const Gate& top = *model->Get<FaultTree>("FT").top_events().front();
+   canopy::core::Pdag graph(top, /*ccf=*/true);
+   std::vector<double> p_vars;
+   for (int variable = 0; variable < graph.num_variables(); ++variable)
+       p_vars.push_back(graph.p(variable));
+   return canopy::core::Bdd(graph).Probabilities(p_vars).front();
+}
+
+/// @returns The sequence probabilities of the initiating event by the sequence names.
+std::map<std::string, double> AnalyzeEventTree(Model* model) {
+   Settings settings;
+   settings.ccf_analysis(true);
+   canopy::core::EventTreeAnalysis analysis(model->Get<InitiatingEvent>("Trip"), settings,
+                                            model->context());
+   analysis.Analyze();
+   std::map<std::string, double> results;
+   for (const canopy::core::EventTreeAnalysis::Result& result : analysis.results())
+       results[result.sequence->name()] = result.p_sequence;
+   return results;
+}
+
+/// The loaded model gives the same analysis results
+/// with the same sharing of the expressions as the stored one.
+void TestRoundTrip() {
+   namespace fs = std::filesystem;
+   fs::path directory = fs::temp_directory_path() / "canopy_model_cache_test";
+   ModelCache cache(directory.string());
+   std::unique_ptr<Model> model = canopy::testing::BuildSampleModel();
+   cache.Store("sample", *model);
+   std::unique_ptr<Model> loaded = cache.Load("sample");
+   fs::remove_all(directory);
+   CANOPY_CHECK(loaded);
+   if (!loaded)
+       return;
+   CANOPY_CHECK(!cache.Load("other"));
+   // The mission time comes from the settings like upon the initialization.
+   loaded->mission_time().value(model->mission_time().value());
+
+   ExpressionMatcher matcher;
+   for (const BasicEvent& event : model->basic_events()) {
+       const BasicEvent& loaded_event = loaded->Get<BasicEvent>(event.id());
+       CANOPY_CHECK(matcher.Match(&event.expression(), &loaded_event.expression()));
+   }
+   for (const Parameter& parameter : model->parameters()) {
+       CANOPY_CHECK(matcher.Match(const_cast<Parameter*>(&parameter),
+                                  &loaded->Get<Parameter>(parameter.id())));
+   }
+   const CcfGroup& group = model->Get<CcfGroup>("Pumps");
+   const CcfGroup& loaded_group = loaded->Get<CcfGroup>("Pumps");
+   CANOPY_CHECK(matcher.Match(group.distribution(), loaded_group.distribution()));
+   CANOPY_CHECK(group.factors().size() == loaded_group.factors().size());
+   for (std::size_t i = 0; i < group.factors().size(); ++i) {
+       CANOPY_CHECK(group.factors()[i].first == loaded_group.factors()[i].first);
+       CANOPY_CHECK(matcher.Match(group.factors()[i].second, loaded_group.factors()[i].second));
+   }
+   // The restored literals are the shared constants of the model.
+   CANOPY_CHECK(loaded_group.factors().front().second == loaded->AddConstant(0.1));
+   CANOPY_CHECK(&loaded->Get<BasicEvent>("ValveA").expression() ==
+                &loaded->Get<BasicEvent>("ValveB").expression());
+
+   canopy::testing::SetUpForAnalysis(model.get());
+   canopy::testing::SetUpForAnalysis(loaded.get());
+   CANOPY_CHECK(loaded->Get<FaultTree>("FT").top_events().size() == 1);
+   CANOPY_CHECK_NEAR(AnalyzeFaultTree(loaded.get()), AnalyzeFaultTree(model.get()), 1e-15);
+   std::map<std::string, double> sequences = AnalyzeEventTree(model.get());
+   std::map<std::string, double> loaded_sequences = AnalyzeEventTree(loaded.get());
+   CANOPY_CHECK(sequences.size() == 2);
+   CANOPY_CHECK(loaded_sequences.size() == sequences.size());
+   for (const auto& [name, p] : sequences)
+       CANOPY_CHECK_NEAR(loaded_sequences[name], p, 1e-15);
+}
+
+/// Writes the file with the contents.
+void WriteFile(const std::filesystem::path& path, const std::string& contents) {
+   std::ofstream(path, std::ios::binary | std::ios::trunc) << contents;
+}
+
+/// The snapshot of the input with XInclude elements is missed
+/// after any included file changes while the input files stay the same.
+void TestIncludes() {
+   namespace fs = std::filesystem;
+   fs::path directory = fs::temp_directory_path() / "canopy_model_cache_includes_test";
+   fs::remove_all(directory);
+   fs::create_directories(directory / "data");
+   const char* xinclude = R"(xmlns:xi="http://www.w3.org/2001/XInclude")";
+   WriteFile(directory / "input.xml", std::string("<opsa-mef ") + xinclude +
+                                          R"(><xi:include href="data/tree.xml"/></opsa-mef>)");
+   WriteFile(directory / "data" / "tree.xml",
+             std::string("<define-fault-tree name=\"FT\" ") + xinclude +
+                 R"(><xi:include href="gates.xml"/><label><xi:include href="label.txt" )"
+                 R"(parse="text"/></label></define-fault-tree>)");
+   WriteFile(directory / "data" / "gates.xml", R"(<define-gate name="Top"/>)");
+   WriteFile(directory / "data" / "label.txt", "Pumps");
+
+   std::vector<std::string> xml_files = {(directory / "input.xml").string()};
+   Settings settings;
+   std::string key = ModelCache::Key(xml_files, settings);
+   ModelCache cache((directory / "cache").string());
+   std::unique_ptr<Model> model = canopy::testing::BuildSampleModel();
+   auto store = [&] { cache.Store(key, *model, xml_files); };
+
+   store();
+   CANOPY_CHECK(cache.Load(key));
+   WriteFile(directory / "data" / "gates.xml", R"(<define-gate name="Top "/>)");
+   CANOPY_CHECK(ModelCache::Key(xml_files, settings) == key);
+   CANOPY_CHECK(!cache.Load(key));  // The nested include has changed.
+
+   store();
+   CANOPY_CHECK(cache.Load(key));
+   WriteFile(directory / "data" / "label.txt", "Valves");
+   CANOPY_CHECK(!cache.Load(key));  // The text include has changed.
+
+   store();
+   CANOPY_CHECK(cache.Load(key));
+   fs::remove(directory / "data" / "label.txt");
+   CANOPY_CHECK(!cache.Load(key));  // The text include is missing.
+   fs::remove_all(directory);
+}
+
+}  // namespace
+
+}  // namespace mef::openpsa
+
+int main() {
+   mef::openpsa::TestRoundTrip();
+   mef::openpsa::TestIncludes();
+   return canopy::testing::num_failures;
+}
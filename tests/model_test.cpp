@@ -0,0 +1,144 @@
+/// @file
+/// Tests of the structural sharing and constant folding of the model expressions.
+
+#include "mef/openpsa/model.h"
+
+#include <cmath>
+
+#include <memory>
+#include <vector>
+
+#include "mef/openpsa/error.h"
+#include "mef/openpsa/expr/constant.h"
+#include "mef/openpsa/expr/exponential.h"
+#include "mef/openpsa/expr/numerical.h"
+#include "mef/openpsa/expr/random_deviate.h"
+#include "mef/openpsa/expr/test_event.h"
+#include "mef/openpsa/parameter.h"
+#include "testing.h"
+
+namespace mef::openpsa {
+
+namespace {
+
+/// @returns The parameter added into the model.
+Parameter* AddParameter(Model* model, const char* name, Expression* expression) {
+   auto parameter = std::make_unique<Parameter>(name);
+   parameter->expression(expression);
+   Parameter* address = parameter.get();
+   model->Add(std::move(parameter));
+   return address;
+}
+
+/// Equal literals are one constant.
+void TestAddConstant() {
+   Model model;
+   Expression* half = model.AddConstant(0.5);
+   CANOPY_CHECK(model.AddConstant(0.5) == half);
+   CANOPY_CHECK(model.AddConstant(0.25) != half);
+   CANOPY_CHECK(dynamic_cast<ConstantExpression*>(half));
+   CANOPY_CHECK(half->value() == 0.5);
+   CANOPY_CHECK(model.AddConstant(0.25)->value() == 0.25);
+}
+
+/// Expressions with identical types and arguments are one node.
+void TestSharing() {
+   Model model;
+   Parameter* lambda = AddParameter(&model, "lambda", model.AddConstant(1e-3));
+   Parameter* time = AddParameter(&model, "time", model.AddConstant(100));
+   auto exponential = std::make_unique<Exponential>(lambda, time);
+   Expression* first = exponential.get();
+   CANOPY_CHECK(model.Intern(std::move(exponential)) == first);
+   CANOPY_CHECK(model.Intern(std::make_unique<Exponential>(lambda, time)) == first);
+   CANOPY_CHECK(model.Intern(std::make_unique<Exponential>(time, lambda)) != first);
+
+   Expression* sum = model.Intern(std::make_unique<Add>(std::vector<Expression*>{lambda, time}));
+   CANOPY_CHECK(model.Intern(std::make_unique<Add>(std::vector<Expression*>{lambda, time})) ==
+                sum);
+   CANOPY_CHECK(model.Intern(std::make_unique<Mul>(std::vector<Expression*>{lambda, time})) !=
+                sum);
+   // The shared nodes are the arguments of the sharing on the next level.
+   Expression* neg = model.Intern(std::make_unique<Neg>(sum));
+   CANOPY_CHECK(model.Intern(std::make_unique<Neg>(
+                    model.Intern(std::make_unique<Add>(
+                        std::vector<Expression*>{lambda, time})))) == neg);
+   CANOPY_CHECK_NEAR(neg->value(), -100.001, 1e-12);
+}
+
+/// Expressions with only literal constant arguments fold into the equal constants.
+void TestFolding() {
+   Model model;
+   Expression* product = model.Intern(std::make_unique<Mul>(
+       std::vector<Expression*>{model.AddConstant(2), model.AddConstant(3)}));
+   CANOPY_CHECK(product == model.AddConstant(6));
+
+   Expression* p = model.Intern(
+       std::make_unique<Exponential>(model.AddConstant(1e-3), model.AddConstant(100)));
+   CANOPY_CHECK(dynamic_cast<ConstantExpression*>(p));
+   CANOPY_CHECK_NEAR(p->value(), 1 - std::exp(-1e-3 * 100), 1e-15);
+   CANOPY_CHECK(p == model.AddConstant(p->value()));
+
+   // The static constants are literals too.
+   Expression* complement = model.Intern(std::make_unique<Sub>(
+       std::vector<Expression*>{&ConstantExpression::kOne, model.AddConstant(0.25)}));
+   CANOPY_CHECK(complement == model.AddConstant(0.75));
+
+   // The folded constants are shared by the formulas above them.
+   Expression* twice = model.Intern(std::make_unique<Mul>(
+       std::vector<Expression*>{complement, model.AddConstant(2)}));
+   CANOPY_CHECK(twice == model.AddConstant(1.5));
+
+   bool thrown = false;
+   try {
+       model.Intern(
+           std::make_unique<Exponential>(model.AddConstant(-1), model.AddConstant(100)));
+   } catch (const ValidityError&) {
+       thrown = true;
+   }
+   CANOPY_CHECK(thrown);
+}
+
+/// Every deviate and test event is a distinct node even with the same arguments.
+void TestUnshared() {
+   Model model;
+   Expression* min = model.AddConstant(0.1);
+   Expression* max = model.AddConstant(0.2);
+   Expression* uniform = model.Intern(std::make_unique<UniformDeviate>(min, max));
+   CANOPY_CHECK(dynamic_cast<UniformDeviate*>(uniform));
+   Expression* other = model.Intern(std::make_unique<UniformDeviate>(min, max));
+   CANOPY_CHECK(other != uniform);
+   CANOPY_CHECK(dynamic_cast<UniformDeviate*>(other));
+
+   Expression* success = model.Intern(
+       std::make_unique<TestFunctionalEvent>("Cooling", "success", model.context()));
+   Expression* failure = model.Intern(
+       std::make_unique<TestFunctionalEvent>("Cooling", "failure", model.context()));
+   CANOPY_CHECK(dynamic_cast<TestFunctionalEvent*>(success));
+   CANOPY_CHECK(dynamic_cast<TestFunctionalEvent*>(failure));
+   CANOPY_CHECK(success != failure);
+   Expression* initiating = model.Intern(
+       std::make_unique<TestInitiatingEvent>("Trip", model.context()));
+   CANOPY_CHECK(dynamic_cast<TestInitiatingEvent*>(initiating));
+   CANOPY_CHECK(model.Intern(std::make_unique<TestInitiatingEvent>(
+                    "Trip", model.context())) != initiating);
+
+   // The formulas over the unshared nodes are shared.
+   Expression* scaled = model.Intern(
+       std::make_unique<Mul>(std::vector<Expression*>{uniform, success}));
+   CANOPY_CHECK(model.Intern(std::make_unique<Mul>(
+                    std::vector<Expression*>{uniform, success})) == scaled);
+   CANOPY_CHECK(model.Intern(std::make_unique<Mul>(
+                    std::vector<Expression*>{other, success})) != scaled);
+}
+
+}  // namespace
+
+}  // namespace mef::openpsa
+
+int main() {
+   mef::openpsa::TestAddConstant();
+   mef::openpsa::TestSharing();
+   mef::openpsa::TestFolding();
+   mef::openpsa::TestUnshared();
+   return canopy::testing::num_failures;
+}
@@ -0,0 +1,71 @@
+/// @file
+/// Tests of the bit-parallel Monte Carlo simulation against the exact BDD probability.
+
+#include "core/monte_carlo.h"
+
+#include <cmath>
+#include <cstdint>
+
+#include <utility>
+
+#include "core/bdd.h"
+#include "core/pdag.h"
+#include "mef/openpsa/settings.h"
+#include "random_graph.h"
+#include "testing.h"
+
+namespace canopy::core {
+
+namespace {
+
+/// The estimate is within a few standard errors of the exact probability
+/// of the first root of non-coherent graphs.
+void TestEstimate() {
+   for (std::uint32_t seed = 1; seed <= 30; ++seed) {
+       RandomGraph random;
+       Generate(seed, &random);
+       double p_exact = Bdd(random.graph).Probabilities(random.p).front();
+       mef::openpsa::Settings settings;
+       settings.num_trials(100'003).seed(seed);  // The last word is incomplete.
+       MonteCarlo monte_carlo(random.graph, random.p, settings);
+       CANOPY_CHECK(monte_carlo.num_trials() == 100'003);
+       CANOPY_CHECK(monte_carlo.num_failures() <= monte_carlo.num_trials());
+       // The error of the estimate around the exact probability.
+       double sigma = std::sqrt(p_exact * (1 - p_exact) / monte_carlo.num_trials());
+       CANOPY_CHECK_NEAR(monte_carlo.p_total(), p_exact, 5 * sigma + 1e-12);
+       CANOPY_CHECK_NEAR(monte_carlo.standard_error(), sigma, sigma / 2 + 1e-5);
+   }
+}
+
+/// The trials of a seed are the same for any batching and number of threads.
+void TestReproducibility() {
+   int num_different_seeds = 0;
+   for (std::uint32_t seed = 1; seed <= 10; ++seed) {
+       RandomGraph random;
+       Generate(seed, &random);
+       mef::openpsa::Settings settings;
+       settings.num_trials(20'000).seed(seed);
+       MonteCarlo sequential(random.graph, random.p, settings);
+       for (auto [num_threads, batch_size] : {std::pair{1, 7}, {4, 1}, {4, 5}, {3, 64}}) {
+           mef::openpsa::Settings parallel = settings;
+           parallel.num_threads(num_threads).batch_size(batch_size);
+           CANOPY_CHECK(MonteCarlo(random.graph, random.p, parallel).num_failures() ==
+                        sequential.num_failures());
+       }
+       settings.seed(seed + 100);
+       num_different_seeds +=
+           MonteCarlo(random.graph, random.p, settings).num_failures() !=
+           sequential.num_failures();
+   }
+   CANOPY_CHECK(num_different_seeds > 0);
+}
+
+}  // namespace
+
+}  // namespace canopy::core
+
+int main() {
+   canopy::core::TestEstimate();
+   canopy::core::TestReproducibility();
+   return canopy::testing::num_failures;
+}
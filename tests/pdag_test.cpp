@@ -0,0 +1,339 @@
+/// @file
+/// Tests of the graph construction from the MEF gates
+/// and of the substitution of CCF group members with the CCF events in the graph.
+
+#include "core/pdag.h"
+
+#include <cstdint>
+
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "core/bdd.h"
+#include "mef/openpsa/ccf_group.h"
+#include "mef/openpsa/event/formula.h"
+#include "mef/openpsa/event/gate.h"
+#include "mef/openpsa/expr/constant.h"
+#include "random_graph.h"
+#include "testing.h"
+
+namespace canopy::core {
+
+namespace {
+
+using mef::openpsa::BasicEvent;
+using mef::openpsa::ConstantExpression;
+using mef::openpsa::Formula;
+using mef::openpsa::Gate;
+using mef::openpsa::HouseEvent;
+
+/// The MEF gates with every connective over the basic events,
+/// the house events, and the complement args.
+struct MefSetup {
+   MefSetup() {
+       for (const char* name : {"A", "B", "C", "D", "E"}) {
+           events.push_back(std::make_unique<BasicEvent>(name));
+           events.back()->expression(&p);
+       }
+       on.state(true);
+   }
+
+   /// @returns The arg of the basic event by its index.
+   Formula::Arg Event(int index, bool complement = false) const {
+       return {complement, events[index].get()};
+   }
+
+   /// @returns The new gate with the formula.
+   Gate* AddGate(mef::openpsa::Connective connective, std::initializer_list<Formula::Arg> args,
+                 std::optional<int> min_number = {}, std::optional<int> max_number = {}) {
+       gates.push_back(std::make_unique<Gate>("G" + std::to_string(gates.size())));
+       gates.back()->formula(
+           std::make_unique<Formula>(connective, Formula::ArgSet(args), min_number, max_number));
+       return gates.back().get();
+   }
+
+   /// @returns The value of the MEF formula arg with the states of the basic events
+   ///          as the bits of the event indices.
+   bool Evaluate(const Formula::Arg& arg, std::uint32_t states) const {
+       bool value = false;
+       if (auto* const* gate = std::get_if<Gate*>(&arg.event)) {
+           value = Evaluate(**gate, states);
+       } else if (auto* const* house_event = std::get_if<HouseEvent*>(&arg.event)) {
+           value = (*house_event)->state();
+       } else {
+           for (std::size_t i = 0; i < events.size(); ++i) {
+               if (std::get<BasicEvent*>(arg.event) == events[i].get())
+                   value = states >> i & 1;
+           }
+       }
+       return value != arg.complement;
+   }
+
+   /// @returns The value of the MEF gate by the definitions of the connectives.
+   bool Evaluate(const Gate& gate, std::uint32_t states) const {
+       const Formula& formula = gate.formula();
+       std::vector<bool> args;
+       for (const Formula::Arg& arg : formula.args())
+           args.push_back(Evaluate(arg, states));
+       int num_true = std::count(args.begin(), args.end(), true);
+       int num_args = args.size();
+       switch (formula.connective()) {
+       case mef::openpsa::kAnd:
+           return num_true == num_args;
+       case mef::openpsa::kOr:
+           return num_true > 0;
+       case mef::openpsa::kAtleast:
+           return num_true >= *formula.min_number();
+       case mef::openpsa::kXor:
+           return args[0] != args[1];
+       case mef::openpsa::kNot:
+           return !args[0];
+       case mef::openpsa::kNand:
+           return num_true < num_args;
+       case mef::openpsa::kNor:
+           return num_true == 0;
+       case mef::openpsa::kNull:
+           return args[0];
+       case mef::openpsa::kIff:
+           return args[0] == args[1];
+       case mef::openpsa::kImply:
+           return !args[0] || args[1];
+       case mef::openpsa::kCardinality:
+           return num_true >= *formula.min_number() && num_true <= *formula.max_number();
+       }
+       return false;
+   }
+
+   ConstantExpression p{0.1};  ///< The probability of the basic events.
+   std::vector<std::unique_ptr<BasicEvent>> events;  ///< The basic events A to E.
+   HouseEvent on{"On"};  ///< The house event in the true state.
+   HouseEvent off{"Off"};  ///< The house event in the default false state.
+   std::vector<std::unique_ptr<Gate>> gates;  ///< The gates in the order of definition.
+};
+
+/// The graph of every MEF gate has the truth table of the gate
+/// with only AND, OR, ATLEAST, and XOR gates
+/// and with the house events folded into the gates.
+void TestTruthTable() {
+   using namespace mef::openpsa;
+   MefSetup setup;
+   Gate* and_gate = setup.AddGate(kAnd, {setup.Event(0), setup.Event(1, true), setup.Event(2)});
+   Gate* or_gate = setup.AddGate(kOr, {setup.Event(0, true), setup.Event(3), {false, &setup.off}});
+   Gate* atleast_gate = setup.AddGate(
+       kAtleast, {setup.Event(0), setup.Event(1), setup.Event(2, true), setup.Event(4)}, 2);
+   Gate* xor_gate = setup.AddGate(kXor, {{false, and_gate}, setup.Event(3)});
+   Gate* not_gate = setup.AddGate(kNot, {{false, or_gate}});
+   Gate* nand_gate =
+       setup.AddGate(kNand, {setup.Event(1), {false, atleast_gate}, {false, &setup.on}});
+   Gate* nor_gate = setup.AddGate(kNor, {setup.Event(2), setup.Event(4, true)});
+   Gate* null_gate = setup.AddGate(kNull, {{false, xor_gate}});
+   Gate* iff_gate = setup.AddGate(kIff, {{false, nand_gate}, setup.Event(0, true)});
+   Gate* imply_gate = setup.AddGate(kImply, {{false, nor_gate}, {true, null_gate}});
+   Gate* cardinality_gate = setup.AddGate(
+       kCardinality, {setup.Event(0), setup.Event(3, true), {false, not_gate}, setup.Event(4)},
+       1, 2);
+   Gate* at_most_gate = setup.AddGate(
+       kCardinality, {setup.Event(1), setup.Event(2), {false, &HouseEvent::kTrue}}, 0, 1);
+   setup.AddGate(kOr, {{false, iff_gate},
+                       {false, imply_gate},
+                       {true, cardinality_gate},
+                       {false, at_most_gate},
+                       {true, xor_gate}});
+   setup.AddGate(kAnd, {{true, &HouseEvent::kFalse}, {false, nand_gate}, setup.Event(4)});
+
+   for (const std::unique_ptr<Gate>& gate : setup.gates) {
+       Pdag graph(*gate);
+       CANOPY_CHECK(graph.roots().size() == 1);
+       for (Pdag::Index index = 1; index < static_cast<Pdag::Index>(graph.size()); ++index) {
+           if (!graph.IsGate(index))
+               continue;
+           Connective connective = graph.node(index).connective;
+           CANOPY_CHECK(connective == kAnd || connective == kOr || connective == kAtleast ||
+                        connective == kXor);
+       }
+       for (std::uint32_t states = 0; states < (1u << setup.events.size()); ++states) {
+           std::uint64_t variable_states = 0;
+           for (int variable = 0; variable < graph.num_variables(); ++variable) {
+               for (std::size_t i = 0; i < setup.events.size(); ++i) {
+                   if (graph.basic_event(variable) == setup.events[i].get() && states >> i & 1)
+                       variable_states |= std::uint64_t{1} << variable;
+               }
+           }
+           CANOPY_CHECK(Value(Evaluate(graph, variable_states), graph.roots().front()) ==
+                        setup.Evaluate(*gate, states));
+       }
+   }
+   // The shared gates and events are converted once.
+   Pdag graph(*setup.gates.back());
+   CANOPY_CHECK(graph.num_variables() == 4);
+   CANOPY_CHECK(!graph.coherent());
+}
+
+/// The applied MGL group of four pumps with the factors on every level.
+struct CcfSetup {
+   CcfSetup() {
+       for (const char* name : {"PumpA", "PumpB", "PumpC", "PumpD"}) {
+           members.push_back(std::make_unique<BasicEvent>(name));
+           group.AddMember(members.back().get());
+       }
+       group.AddDistribution(&q);
+       group.AddFactor(&beta, 2);
+       group.AddFactor(&gamma, 3);
+       group.AddFactor(&delta, 4);
+       group.Validate();
+       group.ApplyModel();
+   }
+
+   /// @returns The gate over the members by their indices in the group.
+   Gate* AddGate(mef::openpsa::Connective connective, const std::vector<int>& indices,
+                 std::optional<int> min_number = {}) {
+       Formula::ArgSet args;
+       for (int index : indices)
+           args.Add(members[index].get());
+       gates.push_back(std::make_unique<Gate>("G" + std::to_string(gates.size())));
+       gates.back()->formula(std::make_unique<Formula>(connective, std::move(args), min_number));
+       return gates.back().get();
+   }
+
+   ConstantExpression q{0.05};  ///< The total failure probability of a member.
+   ConstantExpression beta{0.2};  ///< The MGL factor of level 2.
+   ConstantExpression gamma{0.3};  ///< The MGL factor of level 3.
+   ConstantExpression delta{0.4};  ///< The MGL factor of level 4.
+   std::vector<std::unique_ptr<BasicEvent>> members;  ///< The members in the group order.
+   mef::openpsa::MglModel group{"Pumps"};  ///< The group with the applied model.
+   std::vector<std::unique_ptr<Gate>> gates;  ///< The gates over the members.
+};
+
+/// @returns The failure probabilities of the CCF events of the group
+///          with the member masks enumerated explicitly.
+std::vector<std::pair<std::uint32_t, double>> EnumerateCcfEvents(
+    const mef::openpsa::CcfGroup& group) {
+   std::vector<std::pair<std::uint32_t, double>> events;
+   group.ForEachCcfEvent([&events](std::span<const int> members, mef::openpsa::Expression* p) {
+       std::uint32_t mask = 0;
+       for (int member : members)
+           mask |= 1u << member;
+       events.emplace_back(mask, p->value());
+   });
+   return events;
+}
+
+/// @returns The mask of the members present in the graph.
+std::uint32_t PresentMembers(const Pdag& graph) {
+   std::uint32_t present = 0;
+   for (int variable = 0; variable < graph.num_variables(); ++variable) {
+       for (int member : graph.ccf_members(variable))
+           present |= 1u << member;
+   }
+   return present;
+}
+
+/// Every lumped CCF variable has the probability of any event
+/// with exactly its members among the present ones:
+/// 1 - prod_k (1 - Q_k)^C(n-m, k-t).
+void CheckLumping(const CcfSetup& setup, const Gate& root, int num_present) {
+   Pdag graph(root, /*ccf=*/true);
+   std::vector<std::pair<std::uint32_t, double>> events = EnumerateCcfEvents(setup.group);
+   std::uint32_t present = PresentMembers(graph);
+   CANOPY_CHECK(std::popcount(present) == num_present);
+   int num_lumped = 0;
+   for (int variable = 0; variable < graph.num_variables(); ++variable) {
+       CANOPY_CHECK(graph.ccf_group(variable) == &setup.group);
+       CANOPY_CHECK(!graph.basic_event(variable));
+       std::uint32_t mask = 0;
+       for (int member : graph.ccf_members(variable))
+           mask |= 1u << member;
+       double none = 1;
+       for (const std::pair<std::uint32_t, double>& event : events) {
+           if ((event.first & present) == mask)
+               none *= 1 - event.second;
+       }
+       CANOPY_CHECK_NEAR(graph.p(variable), 1 - none, 1e-15);
+       ++num_lumped;
+   }
+   // All the non-empty combinations of the present members are lumped.
+   CANOPY_CHECK(num_lumped == (1 << num_present) - 1);
+}
+
+/// The exact probability of the root over the CCF events
+/// by the enumeration of all the event states.
+double Enumerate(const CcfSetup& setup,
+                 const std::function<bool(std::uint32_t failed)>& root) {
+   std::vector<std::pair<std::uint32_t, double>> events = EnumerateCcfEvents(setup.group);
+   double p_total = 0;
+   for (std::uint32_t state = 0; state < (1u << events.size()); ++state) {
+       double p = 1;
+       std::uint32_t failed = 0;
+       for (std::size_t i = 0; i < events.size(); ++i) {
+           if (state & (1u << i)) {
+               p *= events[i].second;
+               failed |= events[i].first;
+           } else {
+               p *= 1 - events[i].second;
+           }
+       }
+       if (root(failed))
+           p_total += p;
+   }
+   return p_total;
+}
+
+/// @returns The exact probability of the graph root with the CCF events.
+double Analyze(const Gate& root) {
+   Pdag graph(root, /*ccf=*/true);
+   std::vector<double> p_vars;
+   for (int variable = 0; variable < graph.num_variables(); ++variable)
+       p_vars.push_back(graph.p(variable));
+   return Bdd(graph).Probabilities(p_vars).front();
+}
+
+void TestCcfLumping() {
+   CcfSetup setup;
+   using mef::openpsa::kAnd;
+   using mef::openpsa::kAtleast;
+   using mef::openpsa::kOr;
+   CheckLumping(setup, *setup.AddGate(kOr, {0, 1, 2, 3}), 4);
+   CheckLumping(setup, *setup.AddGate(kAtleast, {0, 2, 3}, 2), 3);
+   CheckLumping(setup, *setup.AddGate(kAnd, {1, 3}), 2);
+   CheckLumping(setup, *setup.AddGate(mef::openpsa::kNull, {2}), 1);
+}
+
+void TestCcfProbability() {
+   CcfSetup setup;
+   using mef::openpsa::kAnd;
+   using mef::openpsa::kAtleast;
+   using mef::openpsa::kOr;
+   CANOPY_CHECK_NEAR(Analyze(*setup.AddGate(kOr, {0, 1, 2, 3})),
+                     Enumerate(setup, [](std::uint32_t failed) { return failed != 0; }), 1e-14);
+   CANOPY_CHECK_NEAR(
+       Analyze(*setup.AddGate(kAtleast, {0, 2, 3}, 2)),
+       Enumerate(setup, [](std::uint32_t failed) { return std::popcount(failed & 0b1101) >= 2; }),
+       1e-14);
+   CANOPY_CHECK_NEAR(
+       Analyze(*setup.AddGate(kAnd, {1, 3})),
+       Enumerate(setup, [](std::uint32_t failed) { return (failed & 0b1010) == 0b1010; }),
+       1e-14);
+   CANOPY_CHECK_NEAR(Analyze(*setup.AddGate(kOr, {0, 1})),
+                     Enumerate(setup, [](std::uint32_t failed) { return failed & 0b0011; }),
+                     1e-14);
+}
+
+}  // namespace
+
+}  // namespace canopy::core
+
+int main() {
+   canopy::core::TestTruthTable();
+   canopy::core::TestCcfLumping();
+   canopy::core::TestCcfProbability();
+   return canopy::testing::num_failures;
+}
@@ -0,0 +1,204 @@
+/// @file
+/// Tests of the Boolean preprocessing against the functions of the graphs.
+
+#include "core/preprocessor.h"
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "core/bdd.h"
+#include "core/pdag.h"
+#include "core/zbdd.h"
+#include "mef/openpsa/settings.h"
+#include "random_graph.h"
+#include "testing.h"
+
+namespace canopy::core {
+
+namespace {
+
+using mef::openpsa::Connective;
+
+/// Generates the graph with the constructs for the preprocessing to simplify:
+/// the constant args, the nested gates with the same connective,
+/// the gates repeated with the same args, and the shared module
+/// under many gates.
+/// The non-coherent graphs have the complements and XOR, NAND, NOR, and IFF gates.
+///
+/// @param[in] seed  The seed of the generation.
+/// @param[out] result  The generated graph.
+/// @param[in] coherent  The flag to generate only AND, OR, and ATLEAST without complements.
+void GenerateRedundant(std::uint32_t seed, RandomGraph* result, bool coherent) {
+   std::mt19937 rng(seed);
+   std::uniform_real_distribution<double> probability(0.01, 0.9);
+   std::vector<Pdag::Index> nodes;
+   for (int num_variables = 8 + rng() % 5; num_variables; --num_variables) {
+       result->expressions.emplace_back(probability(rng));
+       nodes.push_back(result->graph.AddVariable(result->expressions.back()));
+       result->p.push_back(result->expressions.back().value());
+   }
+   Pdag::Index module = result->graph.AddGate(
+       Connective::kOr, {nodes[0], result->graph.AddGate(Connective::kAnd, {nodes[1], nodes[2]})});
+
+   struct Gate {
+       Connective connective;
+       std::vector<Pdag::Index> args;
+       int min_number;
+   };
+   std::vector<Gate> gates;
+   std::vector<Connective> connectives = {Connective::kAnd, Connective::kOr,
+                                          Connective::kAtleast};
+   if (!coherent) {
+       connectives.insert(connectives.end(), {Connective::kXor, Connective::kNand,
+                                              Connective::kNor, Connective::kIff});
+   }
+   for (int num_gates = 20 + rng() % 20; num_gates; --num_gates) {
+       if (!gates.empty() && rng() % 4 == 0) {  // The same structure again.
+           const Gate& gate = gates[rng() % gates.size()];
+           nodes.push_back(result->graph.AddGate(gate.connective, gate.args, gate.min_number));
+           continue;
+       }
+       std::vector<Pdag::Index> args;
+       for (int num_args = 2 + rng() % 3; num_args; --num_args) {
+           Pdag::Index arg;
+           switch (rng() % 8) {
+           case 0:
+               arg = module;
+               break;
+           case 1:
+               arg = rng() % 2 ? Pdag::kTrue : Pdag::kFalse;
+               break;
+           default:
+               arg = nodes[nodes.size() - 1 - rng() % std::min<std::size_t>(nodes.size(), 8)];
+           }
+           args.push_back(coherent || rng() % 4 || std::abs(arg) == Pdag::kTrue ? arg : -arg);
+       }
+       std::sort(args.begin(), args.end());
+       args.erase(std::unique(args.begin(), args.end()), args.end());
+       if (args.size() < 2 ||
+           std::adjacent_find(args.begin(), args.end(), [](Pdag::Index lhs, Pdag::Index rhs) {
+               return lhs == -rhs;
+           }) != args.end()) {
+           continue;
+       }
+       Connective connective = connectives[rng() % connectives.size()];
+       if (connective == Connective::kIff && args.size() > 2)
+           args.resize(2);
+       int min_number = connective == Connective::kAtleast ? 2 : 0;
+       gates.push_back({connective, args, min_number});
+       nodes.push_back(result->graph.AddGate(connective, std::move(args), min_number));
+   }
+   for (int num_roots = 1 + rng() % 3; num_roots; --num_roots) {
+       Pdag::Index root = nodes[nodes.size() - 1 - rng() % 10];
+       result->graph.AddRoot(coherent || rng() % 4 ? root : -root);
+   }
+}
+
+/// @returns The number of the gates reachable from the roots.
+int CountGates(const Pdag& graph) {
+   std::vector<bool> visited(graph.size());
+   std::vector<Pdag::Index> stack(graph.roots().begin(), graph.roots().end());
+   int num_gates = 0;
+   while (!stack.empty()) {
+       Pdag::Index index = std::abs(stack.back());
+       stack.pop_back();
+       if (visited[index] || !graph.IsGate(index))
+           continue;
+       visited[index] = true;
+       ++num_gates;
+       stack.insert(stack.end(), graph.args(index).begin(), graph.args(index).end());
+   }
+   return num_gates;
+}
+
+/// @returns The products of the roots in the lexicographic order.
+std::vector<std::vector<Zbdd::Product>> Sort(const Zbdd& zbdd) {
+   std::vector<std::vector<Zbdd::Product>> result;
+   for (Zbdd::VertexIndex root : zbdd.roots()) {
+       std::vector<Zbdd::Product> products = zbdd.products(root);
+       for (Zbdd::Product& product : products)
+           std::sort(product.begin(), product.end());
+       std::sort(products.begin(), products.end());
+       result.push_back(std::move(products));
+   }
+   return result;
+}
+
+/// @returns The minimal cut sets of the coherent graph
+///          or the prime implicants from the BDD of the non-coherent graph.
+std::vector<std::vector<Zbdd::Product>> Products(const RandomGraph& random, bool coherent) {
+   mef::openpsa::Settings settings;
+   settings.cut_off(0);
+   if (coherent)
+       return Sort(Zbdd(random.graph, random.p, settings));
+   Bdd bdd(random.graph);
+   settings.prime_implicants(true);
+   return Sort(Zbdd(&bdd, random.p, settings));
+}
+
+/// The preprocessing keeps the variables, the roots,
+/// the exact probabilities, and the products of the roots
+/// while the graphs shrink.
+void TestRootFunctions() {
+   int num_removed = 0;
+   for (std::uint32_t seed = 1; seed <= 40; ++seed) {
+       for (bool coherent : {true, false}) {
+           RandomGraph random;
+           GenerateRedundant(seed, &random, coherent);
+           int num_variables = random.graph.num_variables();
+           std::size_t num_roots = random.graph.roots().size();
+           std::vector<double> p_roots = Bdd(random.graph).Probabilities(random.p);
+           std::vector<std::vector<Zbdd::Product>> products = Products(random, coherent);
+           int num_gates = CountGates(random.graph);
+
+           Preprocessor(&random.graph).Run();
+           CANOPY_CHECK(random.graph.num_variables() == num_variables);
+           CANOPY_CHECK(random.graph.roots().size() == num_roots);
+           std::vector<double> p_preprocessed = Bdd(random.graph).Probabilities(random.p);
+           CANOPY_CHECK(p_preprocessed.size() == p_roots.size());
+           for (std::size_t i = 0; i < std::min(p_roots.size(), p_preprocessed.size()); ++i)
+               CANOPY_CHECK_NEAR(p_preprocessed[i], p_roots[i], 1e-12);
+           CANOPY_CHECK(Products(random, coherent) == products);
+           int num_preprocessed = CountGates(random.graph);
+           CANOPY_CHECK(num_preprocessed <= num_gates);
+           num_removed += num_gates - num_preprocessed;
+       }
+   }
+   CANOPY_CHECK(num_removed > 0);
+}
+
+/// The single pass can be repeated on the preprocessed graph
+/// for the simplifications exposed by the previous pass.
+void TestRepeatedRuns() {
+   for (std::uint32_t seed = 1; seed <= 20; ++seed) {
+       RandomGraph random;
+       Generate(seed, &random);
+       std::vector<double> p_roots = Bdd(random.graph).Probabilities(random.p);
+       int num_gates = CountGates(random.graph);
+       for (int run = 0; run < 3; ++run) {
+           Preprocessor(&random.graph).Run();
+           int num_preprocessed = CountGates(random.graph);
+           CANOPY_CHECK(num_preprocessed <= num_gates);
+           num_gates = num_preprocessed;
+           std::vector<double> p_preprocessed = Bdd(random.graph).Probabilities(random.p);
+           CANOPY_CHECK(p_preprocessed.size() == p_roots.size());
+           for (std::size_t i = 0; i < std::min(p_roots.size(), p_preprocessed.size()); ++i)
+               CANOPY_CHECK_NEAR(p_preprocessed[i], p_roots[i], 1e-12);
+       }
+   }
+}
+
+}  // namespace
+
+}  // namespace canopy::core
+
+int main() {
+   canopy::core::TestRootFunctions();
+   canopy::core::TestRepeatedRuns();
+   return canopy::testing::num_failures;
+}
@@ -0,0 +1,111 @@
+/// @file
+/// Tests of the scalar and batch sampling of the random deviates.
+
+#include "mef/openpsa/expr/random_deviate.h"
+
+#include <cstdint>
+
+#include <vector>
+
+#include "mef/openpsa/expr/constant.h"
+#include "testing.h"
+
+namespace mef::openpsa {
+
+namespace {
+
+/// The number of sampled trials.
+constexpr int kNumTrials = 300;
+
+/// The scalar sampling in every trial gives the batch sample of the trial.
+///
+/// @param[in] deviate  The deviate with the assigned stream id.
+void CheckSampleBatch(RandomDeviate* deviate) {
+   constexpr std::uint64_t kFirstTrial = 1000;
+   std::vector<double> samples(kNumTrials);
+   RandomDeviate::trial(kFirstTrial);
+   deviate->SampleBatch(samples);
+   CANOPY_CHECK(RandomDeviate::trial() == kFirstTrial);
+   for (int i = 0; i < kNumTrials; ++i) {
+       RandomDeviate::trial(kFirstTrial + i);
+       Expression::StartTrial();
+       CANOPY_CHECK(deviate->Sample() == samples[i]);
+   }
+   CANOPY_CHECK(samples.front() != samples.back());
+}
+
+/// All the deviates sample the same values in the scalar and batch paths,
+/// including the fallback for the uncertain parameters.
+void TestSampleBatch() {
+   RandomDeviate::seed(42);
+   ConstantExpression zero(0);
+   ConstantExpression one(1);
+   ConstantExpression two(2);
+   ConstantExpression three(3);
+   ConstantExpression mean(1e-3);
+   ConstantExpression ef(5);
+   ConstantExpression level(0.95);
+
+   UniformDeviate uniform(&one, &three);
+   NormalDeviate normal(&one, &two);
+   LognormalDeviate lognormal(&mean, &ef, &level);
+   LognormalDeviate lognormal_normal(&one, &two);
+   GammaDeviate gamma(&two, &three);
+   BetaDeviate beta(&two, &three);
+   Histogram histogram({&zero, &one, &three}, {&two, &one});
+   UniformDeviate uncertain(&zero, &uniform);  // Falls back to the scalar sampling.
+   std::vector<RandomDeviate*> deviates = {&uniform, &normal, &lognormal, &lognormal_normal,
+                                           &gamma, &beta, &histogram, &uncertain};
+   for (std::uint32_t i = 0; i < deviates.size(); ++i)
+       deviates[i]->stream_id(i);
+   for (RandomDeviate* deviate : deviates)
+       CheckSampleBatch(deviate);
+
+   // The uncertain parameter takes its own value of the trial.
+   for (int trial = 0; trial < kNumTrials; ++trial) {
+       RandomDeviate::trial(trial);
+       Expression::StartTrial();
+       double value = uncertain.Sample();
+       CANOPY_CHECK(value >= 0 && value <= uniform.Sample());
+   }
+}
+
+/// The samples depend on the seed, trial, and stream only.
+void TestStreams() {
+   ConstantExpression zero(0);
+   ConstantExpression one(1);
+   UniformDeviate first(&zero, &one);
+   UniformDeviate second(&zero, &one);
+   first.stream_id(0);
+   second.stream_id(1);
+
+   RandomDeviate::seed(7);
+   RandomDeviate::trial(5);
+   Expression::StartTrial();
+   double value = first.Sample();
+   CANOPY_CHECK(value > 0 && value < 1);
+   CANOPY_CHECK(second.Sample() != value);
+
+   RandomDeviate::trial(6);
+   Expression::StartTrial();
+   CANOPY_CHECK(first.Sample() != value);
+
+   RandomDeviate::seed(8);
+   RandomDeviate::trial(5);
+   Expression::StartTrial();
+   CANOPY_CHECK(first.Sample() != value);
+
+   RandomDeviate::seed(7);
+   Expression::StartTrial();
+   CANOPY_CHECK(first.Sample() == value);
+}
+
+}  // namespace
+
+}  // namespace mef::openpsa
+
+int main() {
+   mef::openpsa::TestSampleBatch();
+   mef::openpsa::TestStreams();
+   return canopy::testing::num_failures;
+}
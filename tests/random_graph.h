@@ -0,0 +1,132 @@
+/// @file
+/// The random graphs and their evaluation
+/// shared by the tests of the analysis algorithms.
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+
+#include <algorithm>
+#include <deque>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "core/pdag.h"
+#include "mef/openpsa/expr/constant.h"
+
+namespace canopy::core {
+
+/// The random graph with its variable probabilities.
+struct RandomGraph {
+   std::deque<mef::openpsa::ConstantExpression> expressions;  ///< The stable variable expressions.
+   Pdag graph;  ///< The graph with the roots.
+   std::vector<double> p;  ///< The variable probabilities by variable ids.
+};
+
+/// The size and kind of the random graphs.
+struct GraphShape {
+   int min_variables = 20;  ///< The variables are up to twice this number.
+   int min_gates = 40;  ///< The gates are up to 2.5 times this number.
+   bool coherent = false;  ///< The flag to generate no complements.
+};
+
+/// Generates the graph with mostly local gates for modules to appear.
+///
+/// @param[in] seed  The seed of the generation.
+/// @param[out] result  The generated graph.
+/// @param[in] shape  The size and kind of the graph.
+inline void Generate(std::uint32_t seed, RandomGraph* result, const GraphShape& shape = {}) {
+   using mef::openpsa::Connective;
+   std::mt19937 rng(seed);
+   std::uniform_real_distribution<double> probability(0.01, 0.9);
+   std::vector<Pdag::Index> nodes;
+   int num_variables = shape.min_variables + rng() % shape.min_variables;
+   for (int i = 0; i < num_variables; ++i) {
+       result->expressions.emplace_back(probability(rng));
+       nodes.push_back(result->graph.AddVariable(result->expressions.back()));
+       result->p.push_back(result->expressions.back().value());
+   }
+   int num_gates = shape.min_gates + rng() % (shape.min_gates * 3 / 2);
+   for (int i = 0; i < num_gates; ++i) {
+       std::vector<Pdag::Index> args;
+       for (int num_args = 2 + rng() % 3; num_args; --num_args) {
+           std::size_t first = nodes.size() > 12 ? nodes.size() - 12 : 0;
+           std::size_t pick = rng() % 4 ? first + rng() % (nodes.size() - first)
+                                        : rng() % nodes.size();
+           args.push_back(rng() % 5 || shape.coherent ? nodes[pick] : -nodes[pick]);
+       }
+       std::sort(args.begin(), args.end());
+       args.erase(std::unique(args.begin(), args.end()), args.end());
+       if (args.size() < 2 ||
+           std::adjacent_find(args.begin(), args.end(), [](Pdag::Index lhs, Pdag::Index rhs) {
+               return lhs == -rhs;
+           }) != args.end()) {
+           continue;
+       }
+       switch (rng() % 3) {
+       case 0:
+           nodes.push_back(result->graph.AddGate(Connective::kAnd, std::move(args)));
+           break;
+       case 1:
+           nodes.push_back(result->graph.AddGate(Connective::kOr, std::move(args)));
+           break;
+       default:
+           nodes.push_back(result->graph.AddGate(Connective::kAtleast, std::move(args), 2));
+       }
+   }
+   for (int num_roots = 1 + rng() % 3; num_roots; --num_roots) {
+       Pdag::Index root = nodes[nodes.size() - 1 - rng() % 10];
+       result->graph.AddRoot(rng() % 4 || shape.coherent ? root : -root);
+   }
+}
+
+/// @returns The value of the signed node index among the node values.
+inline bool Value(const std::vector<bool>& values, Pdag::Index index) {
+   return values[std::abs(index)] != (index < 0);
+}
+
+/// Evaluates all the graph nodes in the topological order.
+///
+/// @param[in] graph  The graph with the nodes to evaluate.
+/// @param[in] states  The states of the variables as the bits of the variable ids.
+///
+/// @returns The values of the nodes by node indices.
+inline std::vector<bool> Evaluate(const Pdag& graph, std::uint64_t states) {
+   std::vector<bool> values(graph.size(), false);
+   for (Pdag::Index index = 1; index < static_cast<Pdag::Index>(graph.size()); ++index) {
+       if (graph.IsConstant(index)) {
+           values[index] = true;
+           continue;
+       }
+       if (graph.IsVariable(index)) {
+           values[index] = states >> graph.variable(index) & 1;
+           continue;
+       }
+       std::size_t num_true = 0;
+       for (Pdag::Index arg : graph.args(index))
+           num_true += Value(values, arg);
+       const Pdag::Node& node = graph.node(index);
+       switch (node.connective) {
+       case mef::openpsa::Connective::kAnd:
+           values[index] = num_true == node.size;
+           break;
+       case mef::openpsa::Connective::kOr:
+           values[index] = num_true > 0;
+           break;
+       case mef::openpsa::Connective::kAtleast:
+           values[index] = num_true >= node.min_number;
+           break;
+       case mef::openpsa::Connective::kXor:
+           values[index] = num_true == 1;
+           break;
+       default:
+           assert(false && "Unexpected connective in the PDAG.");
+       }
+   }
+   return values;
+}
+
+}  // namespace canopy::core
@@ -0,0 +1,129 @@
+/// @file
+/// Tests of the SIL metrics on the known probability curves.
+
+#include "core/safety_integrity.h"
+
+#include <cmath>
+#include <cstddef>
+
+#include <array>
+#include <utility>
+#include <vector>
+
+#include "testing.h"
+
+namespace canopy::core {
+
+namespace {
+
+/// The bounds of the PFD and PFH bands.
+constexpr std::array<double, 7> kPfdBounds = {0, 1e-5, 1e-4, 1e-3, 1e-2, 1e-1, 1};
+constexpr std::array<double, 7> kPfhBounds = {0, 1e-9, 1e-8, 1e-7, 1e-6, 1e-5, 1};
+
+/// Checks the fractions of the histogram.
+void CheckFractions(const SafetyIntegrity::Histogram& histogram,
+                    const std::array<double, 6>& fractions) {
+   for (std::size_t i = 0; i < histogram.size(); ++i)
+       CANOPY_CHECK_NEAR(histogram[i].fraction, fractions[i], 1e-15);
+}
+
+/// @returns The histogram with the whole time in the band.
+std::array<double, 6> OnlyIn(std::size_t band) {
+   std::array<double, 6> fractions = {};
+   fractions[band] = 1;
+   return fractions;
+}
+
+/// The bands are the exact decades of the SIL bounds.
+void TestBands() {
+   std::vector<std::pair<double, double>> p_time = {{0, 0.1}, {1, 0.1}};
+   SafetyIntegrity sil = ComputeSafetyIntegrity(p_time);
+   for (std::size_t i = 0; i < sil.pfd_fractions.size(); ++i) {
+       CANOPY_CHECK(sil.pfd_fractions[i].lower == kPfdBounds[i]);
+       CANOPY_CHECK(sil.pfd_fractions[i].upper == kPfdBounds[i + 1]);
+       CANOPY_CHECK(sil.pfh_fractions[i].lower == kPfhBounds[i]);
+       CANOPY_CHECK(sil.pfh_fractions[i].upper == kPfhBounds[i + 1]);
+   }
+}
+
+/// The sawtooth of the periodic tests with the drop of the probability.
+void TestSawtooth() {
+   std::vector<std::pair<double, double>> p_time = {
+       {0, 0}, {1, 0.01}, {2, 0.02}, {3, 0}, {5, 0.02}};
+   SafetyIntegrity sil = ComputeSafetyIntegrity(p_time);
+   // The average PFD of the steps: 0.005, 0.015, 0.01, and 0.01 over 2 hours.
+   CANOPY_CHECK_NEAR(sil.pfd_avg, (0.005 + 0.015 + 0.01 + 0.01 * 2) / 5, 1e-15);
+   // The PFH of the steps: 0.01, 0.01 / 0.99, none on the drop, and 0.01.
+   CANOPY_CHECK_NEAR(sil.pfh_avg, (0.01 + 0.01 / 0.99 + 0.01 * 2) / 5, 1e-15);
+   // The PFD of 0.01 is on the lower bound of its band.
+   CheckFractions(sil.pfd_fractions, {0, 0, 0, 0.2, 0.8, 0});
+   CheckFractions(sil.pfh_fractions, {0.2, 0, 0, 0, 0, 0.8});
+}
+
+/// The PFD on the bounds is in the band above,
+/// and the PFD just below the bound is in the band below.
+void TestPfdBoundaries() {
+   for (std::size_t i = 1; i < kPfdBounds.size() - 1; ++i) {
+       double bound = kPfdBounds[i];
+       SafetyIntegrity sil = ComputeSafetyIntegrity(
+           std::vector<std::pair<double, double>>{{0, bound}, {4, bound}});
+       CANOPY_CHECK(sil.pfd_avg == bound);
+       CheckFractions(sil.pfd_fractions, OnlyIn(i));
+       CheckFractions(sil.pfh_fractions, OnlyIn(0));
+       double below = std::nextafter(bound, 0.0);
+       sil = ComputeSafetyIntegrity(
+           std::vector<std::pair<double, double>>{{0, below}, {4, below}});
+       CheckFractions(sil.pfd_fractions, OnlyIn(i - 1));
+   }
+   // The failure for certain is above all the bands.
+   SafetyIntegrity sil =
+       ComputeSafetyIntegrity(std::vector<std::pair<double, double>>{{0, 1}, {4, 1}});
+   CheckFractions(sil.pfd_fractions, OnlyIn(5));
+}
+
+/// The PFH on the bounds is in the band above,
+/// and the PFH just below the bound is in the band below.
+void TestPfhBoundaries() {
+   for (std::size_t i = 1; i < kPfhBounds.size() - 1; ++i) {
+       double bound = kPfhBounds[i];
+       SafetyIntegrity sil = ComputeSafetyIntegrity(
+           std::vector<std::pair<double, double>>{{0, 0}, {1, bound}});
+       CANOPY_CHECK(sil.pfh_avg == bound);
+       CheckFractions(sil.pfh_fractions, OnlyIn(i));
+       double below = std::nextafter(bound, 0.0);
+       sil = ComputeSafetyIntegrity(std::vector<std::pair<double, double>>{{0, 0}, {1, below}});
+       CheckFractions(sil.pfh_fractions, OnlyIn(i - 1));
+   }
+   // The PFH per hour is not bounded by 1.
+   SafetyIntegrity sil =
+       ComputeSafetyIntegrity(std::vector<std::pair<double, double>>{{0, 0}, {0.5, 0.9}});
+   CANOPY_CHECK_NEAR(sil.pfh_avg, 1.8, 1e-15);
+   CheckFractions(sil.pfh_fractions, OnlyIn(5));
+}
+
+/// The curves shorter than a time step have no metrics.
+void TestShortCurves() {
+   for (const std::vector<std::pair<double, double>>& p_time :
+        {std::vector<std::pair<double, double>>{},
+         std::vector<std::pair<double, double>>{{0, 0.5}},
+         std::vector<std::pair<double, double>>{{0, 0.1}, {0, 0.2}}}) {
+       SafetyIntegrity sil = ComputeSafetyIntegrity(p_time);
+       CANOPY_CHECK(sil.pfd_avg == 0);
+       CANOPY_CHECK(sil.pfh_avg == 0);
+       CheckFractions(sil.pfd_fractions, {});
+       CheckFractions(sil.pfh_fractions, {});
+   }
+}
+
+}  // namespace
+
+}  // namespace canopy::core
+
+int main() {
+   canopy::core::TestBands();
+   canopy::core::TestSawtooth();
+   canopy::core::TestPfdBoundaries();
+   canopy::core::TestPfhBoundaries();
+   canopy::core::TestShortCurves();
+   return canopy::testing::num_failures;
+}
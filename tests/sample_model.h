@@ -0,0 +1,200 @@
+/// @file
+/// The representative model shared by the tests of the model consumers.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mef/openpsa/ccf_group.h"
+#include "mef/openpsa/event/formula.h"
+#include "mef/openpsa/event/gate.h"
+#include "mef/openpsa/event_tree.h"
+#include "mef/openpsa/expr/constant.h"
+#include "mef/openpsa/expr/exponential.h"
+#include "mef/openpsa/expr/numerical.h"
+#include "mef/openpsa/expr/random_deviate.h"
+#include "mef/openpsa/expr/test_event.h"
+#include "mef/openpsa/fault_tree.h"
+#include "mef/openpsa/instruction.h"
+#include "mef/openpsa/model.h"
+
+namespace canopy::testing {
+
+/// Builds the model with every kind of the shared and unique constructs:
+///   - the fault tree "FT" with the top gate "Top"
+///     over the MGL CCF group "Pumps" of three pumps,
+///     the valves sharing one interned probability expression,
+///     and the house event "maintenance" (false) under the gate "Power",
+///   - the parameters shared by the events and the CCF group,
+///     the random deviates, and the static constants in the expressions,
+///   - the initiating event "Trip" with the event tree "ET"
+///     that forks on "Injection" and "Cooling" into the sequences "OK" and "Failure".
+///     The fork paths collect the gate formulas,
+///     the initial state collects the frequency expression,
+///     the failure of cooling sets the house event "maintenance",
+///     and the sequence "Failure" collects the recovery factor
+///     only if the injection succeeded.
+///
+/// @returns The model before the setup for analysis.
+inline std::unique_ptr<mef::openpsa::Model> BuildSampleModel() {
+   using namespace mef::openpsa;
+   auto model = std::make_unique<Model>("Sample");
+   model->mission_time().value(1000);
+
+   auto add_parameter = [&model](std::string name, Expression* expression) {
+       auto parameter = std::make_unique<Parameter>(std::move(name));
+       parameter->expression(expression);
+       Parameter* address = parameter.get();
+       model->Add(std::move(parameter));
+       return address;
+   };
+   Parameter* lambda = add_parameter("lambda", model->AddConstant(1e-4));
+   Parameter* p_pump = add_parameter(
+       "p_pump", model->Intern(std::make_unique<Exponential>(lambda, &model->mission_time())));
+   Parameter* p_valve = add_parameter(
+       "p_valve", model->Intern(std::make_unique<UniformDeviate>(model->AddConstant(0.001),
+                                                                 model->AddConstant(0.003))));
+   Parameter* r_grid = add_parameter("r_grid", model->AddConstant(0.99));
+
+   auto add_event = [&model](std::string name, Expression* expression) {
+       auto event = std::make_unique<BasicEvent>(std::move(name));
+       event->expression(expression);
+       BasicEvent* address = event.get();
+       model->Add(std::move(event));
+       return address;
+   };
+   std::vector<BasicEvent*> pumps;
+   for (const char* name : {"PumpA", "PumpB", "PumpC"})
+       pumps.push_back(add_event(name, nullptr));
+   // The valves share the interned expression.
+   BasicEvent* valve_a = add_event(
+       "ValveA", model->Intern(std::make_unique<Mul>(
+                     std::vector<Expression*>{&ConstantExpression::kPi, p_valve})));
+   BasicEvent* valve_b = add_event(
+       "ValveB", model->Intern(std::make_unique<Mul>(
+                     std::vector<Expression*>{&ConstantExpression::kPi, p_valve})));
+   BasicEvent* grid = add_event(
+       "Grid", model->Intern(std::make_unique<Sub>(
+                   std::vector<Expression*>{&ConstantExpression::kOne, r_grid})));
+   BasicEvent* diesel = add_event(
+       "Diesel", model->Intern(std::make_unique<LognormalDeviate>(
+                     model->AddConstant(0.02), model->AddConstant(3), model->AddConstant(0.95))));
+
+   auto group = std::make_unique<MglModel>("Pumps");
+   for (BasicEvent* pump : pumps)
+       group->AddMember(pump);
+   group->AddDistribution(p_pump);
+   group->AddFactor(model->AddConstant(0.1), 2);
+   group->AddFactor(model->AddConstant(0.3), 3);
+   CcfGroup* ccf_group = group.get();
+   model->Add(std::unique_ptr<CcfGroup>(std::move(group)));
+
+   auto maintenance = std::make_unique<HouseEvent>("maintenance");
+   HouseEvent* house_event = maintenance.get();
+   model->Add(std::move(maintenance));
+
+   auto add_gate = [&model](std::string name, Connective connective,
+                            Formula::ArgSet args, std::optional<int> min_number = {}) {
+       auto gate = std::make_unique<Gate>(std::move(name));
+       gate->formula(std::make_unique<Formula>(connective, std::move(args), min_number));
+       Gate* address = gate.get();
+       model->Add(std::move(gate));
+       return address;
+   };
+   Gate* pumps_fail = add_gate("PumpsFail", kAtleast, {pumps[0], pumps[1], pumps[2]}, 2);
+   Gate* valves = add_gate("Valves", kAnd, {valve_a, valve_b});
+   Gate* grid_diesel = add_gate("GridDiesel", kAnd, {grid, diesel});
+   Gate* power = add_gate("Power", kOr, {grid_diesel, house_event});
+   Gate* top = add_gate("Top", kOr, {pumps_fail, valves, power});
+
+   auto fault_tree = std::make_unique<FaultTree>("FT");
+   for (Gate* gate : {pumps_fail, valves, grid_diesel, power, top})
+       fault_tree->Add(gate);
+   for (BasicEvent* event : {valve_a, valve_b, grid, diesel})
+       fault_tree->Add(event);
+   fault_tree->Add(house_event);
+   fault_tree->Add(ccf_group);
+   model->Add(std::move(fault_tree));
+
+   auto add_instruction = [&model](auto instruction) {
+       Instruction* address = instruction.get();
+       model->Add(std::unique_ptr<Instruction>(std::move(instruction)));
+       return address;
+   };
+   auto collect = [&add_instruction](Connective connective, Gate* gate) {
+       return add_instruction(std::make_unique<CollectFormula>(
+           std::make_unique<Formula>(connective, Formula::ArgSet{gate})));
+   };
+
+   auto event_tree = std::make_unique<EventTree>("ET");
+   auto ok = std::make_unique<Sequence>("OK");
+   auto failure = std::make_unique<Sequence>("Failure");
+   auto test_injection = std::make_unique<TestFunctionalEvent>("Injection", "success",
+                                                               model->context());
+   Expression* injected = test_injection.get();
+   model->Add(std::unique_ptr<Expression>(std::move(test_injection)));
+   failure->instructions({add_instruction(std::make_unique<IfThenElse>(
+       injected, add_instruction(std::make_unique<CollectExpression>(
+                     model->AddConstant(0.5)))))});
+   event_tree->Add(ok.get());
+   event_tree->Add(failure.get());
+
+   auto injection = std::make_unique<FunctionalEvent>("Injection");
+   auto cooling = std::make_unique<FunctionalEvent>("Cooling");
+   injection->order(1);
+   cooling->order(2);
+
+   std::vector<Path> cooling_paths;
+   cooling_paths.emplace_back("success");
+   cooling_paths.back().instructions({collect(kNot, power)});
+   cooling_paths.back().target(ok.get());
+   cooling_paths.emplace_back("failure");
+   cooling_paths.back().instructions(
+       {add_instruction(std::make_unique<SetHouseEvent>("maintenance", true)),
+        collect(kNull, power)});
+   cooling_paths.back().target(failure.get());
+   auto cooling_fork = std::make_unique<Fork>(*cooling, std::move(cooling_paths));
+
+   std::vector<Path> injection_paths;
+   injection_paths.emplace_back("success");
+   injection_paths.back().instructions({collect(kNot, pumps_fail)});
+   injection_paths.back().target(cooling_fork.get());
+   injection_paths.emplace_back("failure");
+   injection_paths.back().instructions({collect(kNull, pumps_fail)});
+   injection_paths.back().target(failure.get());
+   auto injection_fork = std::make_unique<Fork>(*injection, std::move(injection_paths));
+
+   Branch initial_state;
+   initial_state.instructions(
+       {add_instruction(std::make_unique<CollectExpression>(model->AddConstant(0.1)))});
+   initial_state.target(injection_fork.get());
+   event_tree->initial_state(std::move(initial_state));
+   event_tree->Add(std::move(injection));
+   event_tree->Add(std::move(cooling));
+   event_tree->Add(std::move(cooling_fork));
+   event_tree->Add(std::move(injection_fork));
+
+   auto trip = std::make_unique<InitiatingEvent>("Trip");
+   trip->event_tree(event_tree.get());
+   model->Add(std::move(ok));
+   model->Add(std::move(failure));
+   model->Add(std::move(event_tree));
+   model->Add(std::move(trip));
+   return model;
+}
+
+/// Sets up the model for analysis like the initializer
+/// with the top events of the fault trees and the applied CCF models.
+///
+/// @param[in,out] model  The model built or loaded but not yet set up.
+inline void SetUpForAnalysis(mef::openpsa::Model* model) {
+   for (mef::openpsa::FaultTree& fault_tree : model->table<mef::openpsa::FaultTree>())
+       fault_tree.CollectTopEvents();
+   for (mef::openpsa::CcfGroup& group : model->table<mef::openpsa::CcfGroup>())
+       group.ApplyModel();
+}
+
+}  // namespace canopy::testing
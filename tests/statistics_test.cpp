@@ -0,0 +1,140 @@
+/// @file
+/// Tests of the streaming estimators against the exact sample statistics.
+
+#include "core/statistics.h"
+
+#include <cmath>
+#include <cstdint>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "testing.h"
+
+namespace canopy::core {
+
+namespace {
+
+/// @returns A skewed sample of the given size.
+std::vector<double> MakeSample(int size, std::uint64_t seed) {
+   std::mt19937_64 generator(seed);
+   std::lognormal_distribution<double> distribution(-5, 1);
+   std::vector<double> sample(size);
+   for (double& value : sample)
+       value = distribution(generator);
+   return sample;
+}
+
+/// @returns The exact quantile of the sorted sample at the level.
+double ExactQuantile(const std::vector<double>& sorted, double q) {
+   std::size_t rank = std::min<std::size_t>(q * sorted.size(), sorted.size() - 1);
+   return sorted[rank];
+}
+
+/// @returns The fraction of the sorted sample not greater than the value.
+double ExactCdf(const std::vector<double>& sorted, double value) {
+   return static_cast<double>(std::upper_bound(sorted.begin(), sorted.end(), value) -
+                              sorted.begin()) /
+          sorted.size();
+}
+
+/// The merged moments equal the moments of the whole sample.
+void TestMoments() {
+   std::vector<double> sample = MakeSample(10000, 1);
+   double mean = 0;
+   for (double value : sample)
+       mean += value;
+   mean /= sample.size();
+   double variance = 0;
+   for (double value : sample)
+       variance += (value - mean) * (value - mean);
+   variance /= sample.size() - 1;
+
+   std::vector<RunningMoments> parts(3);
+   for (std::size_t i = 0; i < sample.size(); ++i)
+       parts[i % 1000 < 100 ? 0 : i % 2 + 1].Add(sample[i]);  // Uneven parts.
+   RunningMoments merged;
+   merged.Merge(RunningMoments());  // Empty on both sides.
+   for (const RunningMoments& part : parts)
+       merged.Merge(part);
+   merged.Merge(RunningMoments());
+   CANOPY_CHECK(merged.count() == static_cast<std::int64_t>(sample.size()));
+   CANOPY_CHECK_NEAR(merged.mean(), mean, 1e-12 * mean);
+   CANOPY_CHECK_NEAR(merged.variance(), variance, 1e-9 * variance);
+}
+
+/// The quantiles of the single and merged sketches
+/// are close in rank to the exact quantiles of the sorted sample,
+/// and the extremes are exact.
+void TestQuantiles() {
+   std::vector<double> sample = MakeSample(100000, 2);
+   std::vector<double> sorted = sample;
+   std::sort(sorted.begin(), sorted.end());
+
+   QuantileSketch single;
+   std::vector<QuantileSketch> parts(4);
+   for (std::size_t i = 0; i < sample.size(); ++i) {
+       single.Add(sample[i]);
+       parts[i % parts.size()].Add(sample[i]);
+   }
+   single.Compress();
+   QuantileSketch merged = parts.front();
+   for (std::size_t i = 1; i < parts.size(); ++i)
+       merged.Merge(parts[i]);
+
+   for (const QuantileSketch* sketch : {&single, &merged}) {
+       CANOPY_CHECK(sketch->count() == sample.size());
+       CANOPY_CHECK(sketch->min() == sorted.front());
+       CANOPY_CHECK(sketch->max() == sorted.back());
+       CANOPY_CHECK(sketch->Quantile(0) == sorted.front());
+       CANOPY_CHECK(sketch->Quantile(1) == sorted.back());
+       for (double q : {0.001, 0.01, 0.05, 0.25, 0.5, 0.75, 0.95, 0.99, 0.999}) {
+           double estimate = sketch->Quantile(q);
+           // The rank error is bounded tighter at the tails.
+           double tolerance = 0.01 * std::sqrt(q * (1 - q)) + 1e-4;
+           CANOPY_CHECK_NEAR(ExactCdf(sorted, estimate), q, tolerance);
+           CANOPY_CHECK_NEAR(sketch->Cdf(ExactQuantile(sorted, q)), q, tolerance);
+       }
+   }
+}
+
+/// The merged bin counts equal the exact counts of the sample,
+/// and the values out of the range go into the end bins.
+void TestHistogram() {
+   std::vector<double> sample = MakeSample(10000, 3);
+   auto [min, max] = std::minmax_element(sample.begin(), sample.begin() + 1000);
+   constexpr int kNumBins = 10;
+   double width = (*max - *min) / kNumBins;
+   std::vector<std::int64_t> expected(kNumBins);
+   for (double value : sample) {
+       int bin = std::clamp(static_cast<int>(std::floor((value - *min) / width)), 0, kNumBins - 1);
+       ++expected[bin];
+   }
+
+   std::vector<Histogram> parts(3, Histogram(*min, *max, kNumBins));
+   for (std::size_t i = 0; i < sample.size(); ++i)
+       parts[i % parts.size()].Add(sample[i]);
+   Histogram merged = parts.front();
+   for (std::size_t i = 1; i < parts.size(); ++i)
+       merged.Merge(parts[i]);
+   CANOPY_CHECK(merged.counts() == expected);
+
+   Histogram point(1, 1, 3);  // The range of a constant sample.
+   point.Add(1);
+   point.Add(0.5);
+   point.Add(2);
+   CANOPY_CHECK(point.counts().front() == 2);
+   CANOPY_CHECK(point.counts().back() == 1);
+}
+
+}  // namespace
+
+}  // namespace canopy::core
+
+int main() {
+   canopy::core::TestMoments();
+   canopy::core::TestQuantiles();
+   canopy::core::TestHistogram();
+   return canopy::testing::num_failures;
+}
@@ -0,0 +1,118 @@
+/// @file
+/// Tests of the interned symbols and their lifetime with the owners of the table.
+
+#include "mef/openpsa/symbol.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mef/openpsa/event/event.h"
+#include "mef/openpsa/model.h"
+#include "testing.h"
+
+namespace mef::openpsa {
+
+namespace {
+
+/// @returns The unique test string for the number.
+std::string Name(int number) { return "symbol-" + std::to_string(number); }
+
+/// Equal strings are interned into equal symbols.
+void TestIntern() {
+   Symbol gate("gate");
+   CANOPY_CHECK(gate == Symbol(std::string("ga") + "te"));
+   CANOPY_CHECK(gate.str() == "gate");
+   CANOPY_CHECK(!(gate == Symbol("Gate")));
+   CANOPY_CHECK(Symbol().empty() && Symbol("").empty());
+   CANOPY_CHECK(Symbol::Find("gate") == gate);
+   CANOPY_CHECK(!Symbol::Find("missing"));
+   CANOPY_CHECK(!Symbol::Find("missing"));  // The failed lookup does not intern.
+}
+
+/// Concurrent interning gives a single id per string across all the blocks.
+void TestConcurrentIntern() {
+   constexpr int kNumThreads = 4;
+   constexpr int kNumStrings = 5000;
+   std::vector<std::vector<Symbol>> symbols(kNumThreads);
+   std::vector<std::jthread> threads;
+   for (int i = 0; i < kNumThreads; ++i) {
+       threads.emplace_back([&symbols, i] {
+           for (int j = 0; j < kNumStrings; ++j)
+               symbols[i].emplace_back(Name((j * (i + 1)) % kNumStrings));
+       });
+   }
+   threads.clear();
+   for (int j = 0; j < kNumStrings; ++j) {
+       CANOPY_CHECK(Symbol(Name(j)).str() == Name(j));
+       for (int i = 0; i < kNumThreads; ++i)
+           CANOPY_CHECK(symbols[i][j] == Symbol(Name((j * (i + 1)) % kNumStrings)));
+   }
+}
+
+/// The table is released with its last owner
+/// after it adopts the symbols interned without owners.
+void TestRelease() {
+   Symbol detached("detached");
+   {
+       SymbolTable::Lease table = SymbolTable::Acquire();
+       Symbol symbol("released");
+       CANOPY_CHECK(SymbolTable::Acquire() == table);
+       CANOPY_CHECK(Symbol::Find("detached") == detached);
+       {
+           HouseEvent event("pump");
+           CANOPY_CHECK(Symbol::Find("pump") == event.name_symbol());
+       }
+       CANOPY_CHECK(Symbol::Find("pump") && Symbol::Find("pump")->str() == "pump");
+   }
+   SymbolTable::Lease table = SymbolTable::Acquire();
+   CANOPY_CHECK(!Symbol::Find("released"));
+   CANOPY_CHECK(!Symbol::Find("detached"));
+   CANOPY_CHECK(!Symbol::Find("pump"));
+}
+
+/// The symbols held after the release of their table
+/// do not alias the symbols of the next tables.
+void TestGenerations() {
+   Symbol first("first");
+   Symbol named;
+   {
+       Model model("m");
+       named = model.name_symbol();
+       CANOPY_CHECK(Symbol::Find("first") == first);
+   }
+   Symbol second("second");
+   CANOPY_CHECK(!(first == second));
+   CANOPY_CHECK(!(named == second));
+   CANOPY_CHECK(second.str() == "second");
+   CANOPY_CHECK(!(Symbol("first") == first));
+   CANOPY_CHECK(Symbol("first").str() == "first");
+   CANOPY_CHECK(Symbol("").empty() && Symbol("__true__") == HouseEvent::kTrue.name_symbol());
+}
+
+/// The static house-event literals keep their reserved symbols
+/// across the released tables.
+void TestLiterals() {
+   for (int i = 0; i < 2; ++i) {
+       SymbolTable::Lease table = SymbolTable::Acquire();
+       CANOPY_CHECK(HouseEvent::kTrue.name() == "__true__");
+       CANOPY_CHECK(HouseEvent::kFalse.name() == "__false__");
+       CANOPY_CHECK(HouseEvent::kTrue.id() == "__true__");
+       CANOPY_CHECK(HouseEvent::kFalse.full_path() == ".__false__");
+       CANOPY_CHECK(HouseEvent::kTrue.name_symbol() == Symbol("__true__"));
+       CANOPY_CHECK(HouseEvent::kFalse.name_symbol() == Symbol("__false__"));
+   }
+}
+
+}  // namespace
+
+}  // namespace mef::openpsa
+
+int main() {
+   mef::openpsa::TestIntern();
+   mef::openpsa::TestConcurrentIntern();
+   mef::openpsa::TestRelease();
+   mef::openpsa::TestGenerations();
+   mef::openpsa::TestLiterals();
+   return canopy::testing::num_failures;
+}
@@ -0,0 +1,39 @@
+/// @file
+/// Minimal checks for the unit tests.
+///
+/// Every test is an executable that runs its cases from main
+/// and returns the number of the failed checks.
+
+#pragma once
+
+#include <cmath>
+
+#include <iostream>
+
+namespace canopy::testing {
+
+/// The number of the failed checks in the test executable.
+inline int num_failures = 0;
+
+/// Reports the failed check.
+///
+/// @param[in] condition  The result of the check.
+/// @param[in] expression  The text of the checked expression.
+/// @param[in] file  The source file of the check.
+/// @param[in] line  The source line of the check.
+inline void Check(bool condition, const char* expression, const char* file, int line) {
+   if (condition)
+       return;
+   ++num_failures;
+   std::cerr << file << ":" << line << ": check failed: " << expression << std::endl;
+}
+
+}  // namespace canopy::testing
+
+/// Checks the condition without stopping the test.
+#define CANOPY_CHECK(condition) \
+   ::canopy::testing::Check(static_cast<bool>(condition), #condition, __FILE__, __LINE__)
+
+/// Checks that the values are equal within the absolute tolerance.
+#define CANOPY_CHECK_NEAR(lhs, rhs, tolerance) \
+   CANOPY_CHECK(std::abs((lhs) - (rhs)) <= (tolerance))
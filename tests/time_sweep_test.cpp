@@ -0,0 +1,60 @@
+/// @file
+/// Tests of the time sweep of the top-event probability.
+
+#include "core/time_sweep.h"
+
+#include <algorithm>
+#include <span>
+#include <vector>
+
+#include "core/pdag.h"
+#include "mef/openpsa/expr/constant.h"
+#include "mef/openpsa/expr/exponential.h"
+#include "mef/openpsa/parameter.h"
+#include "mef/openpsa/settings.h"
+#include "testing.h"
+
+namespace canopy::core {
+
+namespace {
+
+using namespace mef::openpsa;
+
+/// The mission time under the opaque periodic test
+/// must vary over the sweep instead of staying at the model mission time.
+void TestPeriodicTest() {
+   MissionTime mission_time(500);
+   ConstantExpression lambda(1e-3);
+   ConstantExpression tau(100);
+   ConstantExpression theta(50);
+   PeriodicTest periodic_test(&lambda, &tau, &theta, &mission_time);
+
+   Pdag graph;
+   graph.AddRoot(graph.AddVariable(periodic_test));
+   Quantifier quantifier = [](std::span<const double> p_vars, std::vector<double>*) {
+       return p_vars.front();
+   };
+   Settings settings;
+   settings.mission_time(500).time_step(10).num_threads(2);
+   TimeSweep sweep(graph, quantifier, settings);
+
+   CANOPY_CHECK(sweep.p_time().size() == 51);
+   double min_p = 1;
+   double max_p = 0;
+   for (auto [time, p] : sweep.p_time()) {
+       mission_time.value(time);
+       CANOPY_CHECK_NEAR(p, periodic_test.value(), 1e-12);
+       min_p = std::min(min_p, p);
+       max_p = std::max(max_p, p);
+   }
+   CANOPY_CHECK(max_p - min_p > 0.05);  // Not flat.
+}
+
+}  // namespace
+
+}  // namespace canopy::core
+
+int main() {
+   canopy::core::TestPeriodicTest();
+   return canopy::testing::num_failures;
+}
@@ -0,0 +1,136 @@
+/// @file
+/// Tests of the uncertainty analysis against the known log-normal distribution.
+
+#include "core/uncertainty_analysis.h"
+
+#include <cmath>
+
+#include <vector>
+
+#include <boost/math/special_functions/erf.hpp>
+
+#include "core/bdd.h"
+#include "core/pdag.h"
+#include "mef/openpsa/expr/constant.h"
+#include "mef/openpsa/expr/random_deviate.h"
+#include "mef/openpsa/settings.h"
+#include "testing.h"
+
+namespace canopy::core {
+
+namespace {
+
+using mef::openpsa::ConstantExpression;
+using mef::openpsa::LognormalDeviate;
+
+/// The graph of the top event failing with a log-normal basic event
+/// and a basic event of the constant probability.
+struct LognormalSetup {
+   LognormalSetup() {
+       deviate.stream_id(0);
+       Pdag::Index variable = graph.AddVariable(deviate);
+       Pdag::Index constant = graph.AddVariable(half);
+       graph.AddRoot(graph.AddGate(mef::openpsa::Connective::kAnd, {variable, constant}));
+   }
+
+   /// @returns The exact cumulative distribution of the top-event probability.
+   double Cdf(double value) const {
+       return boost::math::erfc((mu - std::log(value)) / (sigma * std::sqrt(2))) / 2;
+   }
+
+   double mu = std::log(1e-3) + std::log(0.5);  ///< The location of the top-event probability.
+   double sigma = 0.5;  ///< The scale of the top-event probability.
+   ConstantExpression mu_variable{std::log(1e-3)};  ///< The location of the basic event.
+   ConstantExpression sigma_variable{sigma};  ///< The scale of the basic event.
+   LognormalDeviate deviate{&mu_variable, &sigma_variable};  ///< The uncertain probability.
+   ConstantExpression half{0.5};  ///< The probability of the certain basic event.
+   Pdag graph;  ///< The graph with the top event.
+};
+
+/// @returns The analysis of the top event with the BDD quantification.
+UncertaintyAnalysis Analyze(const Pdag& graph, const mef::openpsa::Settings& settings) {
+   Bdd bdd(graph);
+   Bdd::Edge root = bdd.roots().front();
+   return UncertaintyAnalysis(
+       graph,
+       [&bdd, root, vertices = bdd.Collect(root)](std::span<const double> p,
+                                                  std::vector<double>* scratch) {
+           scratch->resize(bdd.size());
+           return bdd.Probability(root, vertices, p, *scratch);
+       },
+       settings);
+}
+
+/// The moments, quantiles, and histogram agree with the log-normal distribution
+/// of the top-event probability.
+void TestLognormal() {
+   constexpr int kNumTrials = 50'000;  // Several rounds of trials.
+   LognormalSetup setup;
+   mef::openpsa::Settings settings;
+   settings.num_trials(kNumTrials).seed(7).num_quantiles(20).num_bins(10);
+   UncertaintyAnalysis analysis = Analyze(setup.graph, settings);
+   CANOPY_CHECK(analysis.num_trials() == kNumTrials);
+
+   double spread = std::exp(setup.sigma * setup.sigma);
+   double mean = std::exp(setup.mu) * std::sqrt(spread);
+   double sigma = mean * std::sqrt(spread - 1);
+   CANOPY_CHECK_NEAR(analysis.mean(), mean, 5 * sigma / std::sqrt(kNumTrials));
+   CANOPY_CHECK_NEAR(analysis.sigma(), sigma, 0.05 * sigma);
+   auto [lower, upper] = analysis.confidence_interval();
+   CANOPY_CHECK(lower < analysis.mean() && analysis.mean() < upper);
+
+   const std::vector<double>& quantiles = analysis.quantiles();
+   CANOPY_CHECK(quantiles.size() == 20);
+   for (std::size_t i = 0; i + 1 < quantiles.size(); ++i)
+       CANOPY_CHECK_NEAR(setup.Cdf(quantiles[i]), (i + 1) / 20.0, 0.01);
+
+   const std::vector<UncertaintyAnalysis::Bin>& histogram = analysis.histogram();
+   CANOPY_CHECK(histogram.size() == 10);
+   double num_counted = 0;
+   for (std::size_t i = 0; i < histogram.size(); ++i) {
+       const UncertaintyAnalysis::Bin& bin = histogram[i];
+       CANOPY_CHECK(bin.lower < bin.upper);
+       CANOPY_CHECK(i == 0 || bin.lower == histogram[i - 1].upper);
+       double count = bin.fraction * kNumTrials;
+       CANOPY_CHECK_NEAR(count, std::round(count), 1e-6);
+       num_counted += std::round(count);
+       CANOPY_CHECK_NEAR(bin.fraction, setup.Cdf(bin.upper) - setup.Cdf(bin.lower), 0.01);
+   }
+   CANOPY_CHECK(num_counted == kNumTrials);
+   CANOPY_CHECK(histogram.front().lower > 0);
+   CANOPY_CHECK(histogram.back().upper == quantiles.back());  // The max value.
+}
+
+/// The results are the same for any number of threads.
+void TestThreads() {
+   LognormalSetup setup;
+   mef::openpsa::Settings settings;
+   settings.num_trials(40'001).seed(11).num_quantiles(10).num_bins(8);
+   UncertaintyAnalysis serial = Analyze(setup.graph, settings);
+   for (int num_threads : {2, 3, 8}) {
+       mef::openpsa::Settings parallel = settings;
+       parallel.num_threads(num_threads);
+       UncertaintyAnalysis analysis = Analyze(setup.graph, parallel);
+       CANOPY_CHECK(analysis.num_trials() == serial.num_trials());
+       CANOPY_CHECK(analysis.mean() == serial.mean());
+       CANOPY_CHECK(analysis.sigma() == serial.sigma());
+       CANOPY_CHECK(analysis.quantiles() == serial.quantiles());
+       CANOPY_CHECK(analysis.histogram().size() == serial.histogram().size());
+       for (std::size_t i = 0; i < serial.histogram().size(); ++i) {
+           const UncertaintyAnalysis::Bin& bin = analysis.histogram()[i];
+           const UncertaintyAnalysis::Bin& expected = serial.histogram()[i];
+           CANOPY_CHECK(bin.lower == expected.lower && bin.upper == expected.upper &&
+                        bin.fraction == expected.fraction);
+       }
+   }
+}
+
+}  // namespace
+
+}  // namespace canopy::core
+
+int main() {
+   canopy::core::TestLognormal();
+   canopy::core::TestThreads();
+   return canopy::testing::num_failures;
+}
@@ -0,0 +1,189 @@
+/// @file
+/// Tests of the ZBDD products of the graphs and of the BDD conversion.
+
+#include "core/zbdd.h"
+
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "core/bdd.h"
+#include "core/mocus.h"
+#include "core/pdag.h"
+#include "mef/openpsa/expr/constant.h"
+#include "mef/openpsa/settings.h"
+#include "random_graph.h"
+#include "testing.h"
+
+namespace canopy::core {
+
+namespace {
+
+using mef::openpsa::Connective;
+
+/// @returns The products in the lexicographic order.
+std::vector<Zbdd::Product> Sort(std::vector<Zbdd::Product> products) {
+   for (Zbdd::Product& product : products)
+       std::sort(product.begin(), product.end());
+   std::sort(products.begin(), products.end());
+   return products;
+}
+
+/// The fault tree with the variables a, b, c, d, e (ids 0 to 4):
+/// Top = a * (b + c) + atleast(2; b, c, d) + a * b * e.
+struct KnownTree {
+   KnownTree() {
+       for (double p : {0.1, 0.2, 0.3, 0.01, 0.5}) {
+           expressions.emplace_back(p);
+           nodes.push_back(graph.AddVariable(expressions.back()));
+           p_vars.push_back(p);
+       }
+       auto [a, b, c, d, e] = std::array{nodes[0], nodes[1], nodes[2], nodes[3], nodes[4]};
+       Pdag::Index either = graph.AddGate(Connective::kOr, {b, c});
+       graph.AddRoot(graph.AddGate(
+           Connective::kOr,
+           {graph.AddGate(Connective::kAnd, {a, either}),
+            graph.AddGate(Connective::kAtleast, {b, c, d}, 2),
+            graph.AddGate(Connective::kAnd, {a, b, e})}));
+   }
+
+   std::deque<mef::openpsa::ConstantExpression> expressions;  ///< The probabilities.
+   std::vector<Pdag::Index> nodes;  ///< The variable nodes.
+   std::vector<double> p_vars;  ///< The probabilities by the variable ids.
+   Pdag graph;  ///< The graph with the top event.
+};
+
+/// The minimal cut sets of the known tree with and without the pruning.
+void TestKnownProducts() {
+   KnownTree tree;
+   mef::openpsa::Settings settings;
+   settings.cut_off(0);
+   Zbdd zbdd(tree.graph, tree.p_vars, settings);
+   Zbdd::VertexIndex root = zbdd.roots().front();
+   CANOPY_CHECK(Sort(zbdd.products(root)) ==
+                (std::vector<Zbdd::Product>{{0, 1}, {0, 2}, {1, 2}, {1, 3}, {2, 3}}));
+   CANOPY_CHECK(zbdd.CountProducts(root) == 5);
+   CANOPY_CHECK_NEAR(zbdd.RareEvent(root), 0.02 + 0.03 + 0.06 + 0.002 + 0.003, 1e-15);
+   CANOPY_CHECK_NEAR(zbdd.Mcub(root), 1 - 0.98 * 0.97 * 0.94 * 0.998 * 0.997, 1e-15);
+
+   settings.cut_off(0.005);
+   Zbdd pruned(tree.graph, tree.p_vars, settings);
+   CANOPY_CHECK(Sort(pruned.products(pruned.roots().front())) ==
+                (std::vector<Zbdd::Product>{{0, 1}, {0, 2}, {1, 2}}));
+
+   settings.cut_off(0).limit_order(1);
+   Zbdd limited(tree.graph, tree.p_vars, settings);
+   CANOPY_CHECK(limited.products(limited.roots().front()).empty());
+   CANOPY_CHECK(limited.roots().front() == Zbdd::kEmpty);
+}
+
+/// The minimal cut sets and the prime implicants of the non-coherent function
+/// a * ~b + b * c with the variables a, b, c (ids 0 to 2).
+void TestNonCoherentProducts() {
+   std::deque<mef::openpsa::ConstantExpression> expressions;
+   std::vector<Pdag::Index> nodes;
+   std::vector<double> p_vars = {0.1, 0.2, 0.3};
+   Pdag graph;
+   for (double p : p_vars) {
+       expressions.emplace_back(p);
+       nodes.push_back(graph.AddVariable(expressions.back()));
+   }
+   graph.AddRoot(graph.AddGate(Connective::kOr,
+                               {graph.AddGate(Connective::kAnd, {nodes[0], -nodes[1]}),
+                                graph.AddGate(Connective::kAnd, {nodes[1], nodes[2]})}));
+   mef::openpsa::Settings settings;
+   settings.cut_off(0);
+   Zbdd cut_sets(graph, p_vars, settings);
+   CANOPY_CHECK(Sort(cut_sets.products(cut_sets.roots().front())) ==
+                (std::vector<Zbdd::Product>{{0}, {1, 2}}));
+
+   Bdd bdd(graph);
+   settings.prime_implicants(true);
+   Zbdd prime_implicants(&bdd, p_vars, settings);
+   CANOPY_CHECK(Sort(prime_implicants.products(prime_implicants.roots().front())) ==
+                Sort({{0, ~1}, {1, 2}, {0, 2}}));
+}
+
+/// The minimal cut sets converted from the BDD
+/// are the products of the graph construction and of MOCUS.
+void TestBddConversion() {
+   int num_products = 0;
+   for (std::uint32_t seed = 1; seed <= 50; ++seed) {
+       RandomGraph random;
+       Generate(seed, &random, {.min_variables = 10, .min_gates = 14, .coherent = true});
+       for (int limit_order : {20, 3}) {
+           mef::openpsa::Settings settings;
+           settings.cut_off(0).limit_order(limit_order);
+           Bdd bdd(random.graph);
+           Zbdd converted(&bdd, random.p, settings);
+           Zbdd zbdd(random.graph, random.p, settings);
+           Mocus mocus(random.graph, random.p, settings);
+           std::vector<Zbdd::Product> products =
+               Sort(converted.products(converted.roots().front()));
+           CANOPY_CHECK(products == Sort(zbdd.products(zbdd.roots().front())));
+           std::vector<Zbdd::Product> mocus_products;
+           for (std::size_t i = 0; i < mocus.products().size(); ++i) {
+               mocus_products.emplace_back(mocus.products()[i].begin(),
+                                           mocus.products()[i].end());
+           }
+           CANOPY_CHECK(products == Sort(std::move(mocus_products)));
+           CANOPY_CHECK_NEAR(converted.RareEvent(converted.roots().front()), mocus.RareEvent(),
+                             1e-10);
+           CANOPY_CHECK(converted.CountProducts(converted.roots().front()) == products.size());
+           num_products += products.size();
+       }
+   }
+   CANOPY_CHECK(num_products > 100);
+}
+
+/// The products pruned with the cut-off during the graph construction
+/// and after the BDD conversion are the unpruned products above the cut-off,
+/// and the sums over every root family cover only its products.
+void TestCutOff() {
+   int num_pruned = 0;
+   for (std::uint32_t seed = 1; seed <= 50; ++seed) {
+       RandomGraph random;
+       Generate(seed, &random, {.min_variables = 10, .min_gates = 14, .coherent = true});
+       mef::openpsa::Settings settings;
+       settings.cut_off(0);
+       Zbdd zbdd(random.graph, random.p, settings);
+       settings.cut_off(0.01);
+       Zbdd pruned(random.graph, random.p, settings);
+       Bdd bdd(random.graph);
+       Zbdd converted(&bdd, random.p, settings);
+       for (std::size_t i = 0; i < zbdd.roots().size(); ++i) {
+           std::vector<Zbdd::Product> expected;
+           for (Zbdd::Product& product : zbdd.products(zbdd.roots()[i])) {
+               double p_product = 1;
+               for (int id : product)
+                   p_product *= random.p[id];
+               if (p_product >= 0.01)
+                   expected.push_back(std::move(product));
+           }
+           num_pruned += zbdd.CountProducts(zbdd.roots()[i]) - expected.size();
+           expected = Sort(std::move(expected));
+           CANOPY_CHECK(Sort(pruned.products(pruned.roots()[i])) == expected);
+           CANOPY_CHECK(Sort(converted.products(converted.roots()[i])) == expected);
+           CANOPY_CHECK(pruned.CountProducts(pruned.roots()[i]) == expected.size());
+           CANOPY_CHECK_NEAR(pruned.RareEvent(pruned.roots()[i]),
+                             converted.RareEvent(converted.roots()[i]), 1e-12);
+       }
+   }
+   CANOPY_CHECK(num_pruned > 0);
+}
+
+}  // namespace
+
+}  // namespace canopy::core
+
+int main() {
+   canopy::core::TestKnownProducts();
+   canopy::core::TestNonCoherentProducts();
+   canopy::core::TestBddConversion();
+   canopy::core::TestCutOff();
+   return canopy::testing::num_failures;
+}